@@ -21,6 +21,38 @@ typedef enum {
     AD9833_WAVEFORM_SQUARE = 2     ///< Onda cuadrada (MSB del DAC)
 } ad9833_waveform_t;
 
+/**
+ * @brief Aviso de fin de un lote enviado de forma asíncrona
+ */
+typedef void (*ad9833_done_cb_t)(void *ctx);
+
+/**
+ * @brief Transporte de palabras de 16 bits hacia el chip
+ * 
+ * Por defecto es el SPI de la HAL (bloqueante por palabra y DMA para los
+ * lotes). Reemplazarlo permite registrar la secuencia exacta de palabras
+ * (verificación en el host) o encolarla. write_async, is_busy y wait son
+ * opcionales; sin write_async los lotes salen palabra por palabra, y si
+ * se define write_async también debe definirse wait.
+ */
+typedef struct {
+    void (*write16)(void *ctx, uint16_t word);  ///< Envía una palabra con FSYNC activo
+    bool (*write_async)(void *ctx, const uint16_t *words, uint32_t count,
+                        ad9833_done_cb_t done, void *done_ctx);  ///< Lanza un lote; false si está ocupado
+    bool (*is_busy)(void *ctx);                 ///< Lote todavía en curso
+    void (*wait)(void *ctx);                    ///< Espera a que el lote salga completo
+    void *ctx;                                  ///< Contexto opaco para las funciones
+} ad9833_transport_t;
+
+/**
+ * @brief Cambia el transporte usado por el driver
+ * 
+ * Con un transporte propio, ad9833_init() no inicializa el SPI de la HAL.
+ * 
+ * @param transport Transporte a usar (debe seguir vivo), NULL = SPI de la HAL
+ */
+void ad9833_set_transport(const ad9833_transport_t *transport);
+
 /**
  * @brief Inicializa el módulo AD9833
  * 
@@ -37,13 +69,46 @@ bool ad9833_init(void);
 /**
  * @brief Configura la frecuencia de salida del AD9833
  * 
- * Calcula la palabra de frecuencia de 28 bits y la programa en el chip.
- * La frecuencia se configura con precisión de ~0.09 Hz.
+ * Calcula la palabra de frecuencia de 28 bits, la programa en el registro
+ * inactivo y conmuta FSELECT: el cambio es de fase continua. Descarta
+ * cualquier precarga pendiente. La frecuencia se configura con precisión
+ * de ~0.09 Hz.
  * 
  * @param freq_hz Frecuencia deseada en Hz (rango: 0 - 12.5 MHz)
  */
 void ad9833_set_frequency(float freq_hz);
 
+/**
+ * @brief Precarga una frecuencia en el registro inactivo
+ * 
+ * No altera la salida (dos palabras SPI al registro que no está
+ * seleccionado). Pensado para cargar el punto k+1 mientras se mide el k.
+ * 
+ * @param freq_hz Frecuencia a precargar en Hz
+ */
+void ad9833_preload_frequency(float freq_hz);
+
+/**
+ * @brief Pasa a la frecuencia precargada con una sola palabra de control
+ * 
+ * @return true si había una precarga pendiente, false si no se cambió nada
+ */
+bool ad9833_switch_preloaded(void);
+
+/**
+ * @brief Consulta la precarga pendiente
+ * 
+ * @param freq_hz Salida: frecuencia precargada (puede ser NULL)
+ * @return true si hay una precarga pendiente
+ */
+bool ad9833_get_preloaded(float *freq_hz);
+
+/**
+ * @brief Frecuencia que está generando el chip
+ * @return Frecuencia en Hz
+ */
+float ad9833_get_frequency(void);
+
 /**
  * @brief Configura el tipo de forma de onda
  * 
@@ -58,9 +123,66 @@ void ad9833_set_waveform(ad9833_waveform_t waveform);
  */
 void ad9833_enable_output(bool enable);
 
+/**
+ * @brief Indica si la salida está habilitada
+ * 
+ * @return false si quedó deshabilitada con ad9833_enable_output()
+ */
+bool ad9833_is_output_enabled(void);
+
+/**
+ * @brief Configura el desfase del registro PHASE0
+ * 
+ * Resolución de 2π/4096 (~0.088°).
+ * 
+ * @param phase_deg Desfase en grados (se reduce a 0-360)
+ */
+void ad9833_set_phase(float phase_deg);
+
 /**
  * @brief Resetea el AD9833 a estado inicial
  */
 void ad9833_reset(void);
 
+/**
+ * @brief Empieza a acumular comandos en el lote en vez de enviarlos
+ * 
+ * Las llamadas posteriores (frecuencia, precarga, fase, control) solo
+ * actualizan el estado del driver y encolan sus palabras, en el mismo
+ * orden en que saldrían de a una. Si el lote se llena se envía lo
+ * acumulado y se sigue encolando.
+ */
+void ad9833_batch_begin(void);
+
+/**
+ * @brief Envía el lote acumulado y retorna sin esperar al bus
+ * 
+ * Con el transporte de la HAL las palabras salen por DMA mientras el CPU
+ * sigue trabajando. Solo hay un lote en vuelo: si el anterior no terminó,
+ * espera a que termine antes de lanzar este. Mientras tanto puede armarse
+ * el siguiente lote (doble buffer).
+ */
+void ad9833_batch_commit(void);
+
+/**
+ * @brief Indica si el último lote sigue en vuelo
+ * @return true si todavía no se recibió el aviso de fin
+ */
+bool ad9833_is_busy(void);
+
+/**
+ * @brief Espera a que el último lote salga completo por el bus
+ */
+void ad9833_wait_idle(void);
+
+/**
+ * @brief Registra el aviso de fin de lote
+ * 
+ * Con el transporte de la HAL se invoca en contexto de interrupción.
+ * 
+ * @param cb Callback (NULL = sin aviso)
+ * @param ctx Contexto para cb
+ */
+void ad9833_set_batch_callback(ad9833_done_cb_t cb, void *ctx);
+
 #endif // AD9833_H
@@ -5,6 +5,11 @@
  * Este módulo maneja la configuración del ADC para muestreo a 48 kHz
  * y utiliza DMA para transferir automáticamente las muestras a un buffer
  * en memoria sin carga significativa del CPU.
+ * 
+ * Con ADC_CHANNELS = 2 cada instante de muestreo ocupa dos códigos
+ * consecutivos, referencia y respuesta: los largos de esta API cuentan
+ * instantes (muestras por canal) y los buffers tienen que alojar
+ * ADC_CHANNELS códigos por instante.
  */
 
 #ifndef ADC_DMA_H
@@ -14,53 +19,194 @@
 #include <stdbool.h>
 #include "config.h"
 
+// Desfase de muestreo de la respuesta respecto de la referencia: el
+// round-robin convierte un canal por vez, así que la respuesta llega una
+// conversión más tarde. En f medir H exige restar 2π·f·skew a la fase
+#define ADC_DMA_CHANNEL_SKEW_S ((float)(ADC_CHANNELS - 1) / (SAMPLE_RATE * ADC_CHANNELS))
+
 // Buffer de muestras ADC (global, accesible desde otros módulos)
-extern uint16_t adc_sample_buffer[WINDOW_SIZE];
+extern uint16_t adc_sample_buffer[ADC_CAPTURE_MAX_SAMPLES * ADC_CHANNELS];
+
+/**
+ * @brief Bloque de captura continua cedido al consumidor
+ * 
+ * Mientras el consumidor lo tiene, el DMA no vuelve a escribir en samples.
+ */
+typedef struct {
+    const uint16_t *samples;    // num_samples instantes, ADC_CHANNELS códigos cada uno
+    uint16_t num_samples;       // WINDOW_SIZE
+    uint32_t sequence;          // Número de bloque desde el arranque (sin huecos salvo overrun)
+    uint8_t index;              // Buffer del anillo (uso interno)
+} adc_dma_block_t;
+
+/**
+ * @brief Contadores de la captura continua
+ */
+typedef struct {
+    uint32_t blocks_captured;   // Bloques completados por el DMA
+    uint32_t blocks_dropped;    // Bloques listos descartados por overrun
+    uint8_t max_ready_depth;    // Máximo de bloques en espera del consumidor
+} adc_dma_ring_stats_t;
 
 /**
  * @brief Inicializa el sistema ADC+DMA
  * 
  * Configura:
- * - ADC en modo free-running a 48 kHz
+ * - ADC en modo free-running a 48 kHz por canal (round-robin si hay dos)
  * - FIFO del ADC para DMA
- * - Canal DMA para transferir WINDOW_SIZE muestras
+ * - Canal DMA para transferir las capturas
  * 
  * @return true si la inicialización fue exitosa, false en caso contrario
  */
 bool adc_dma_init(void);
 
 /**
- * @brief Inicia la captura de un bloque de datos
+ * @brief Inicia la captura de un bloque de datos en adc_sample_buffer
+ * 
+ * Reinicia el canal DMA y comienza la adquisición de num_samples muestras
+ * por canal.
+ * El largo se elige por llamada (ver sweep_plan.h): ventanas cortas en
+ * alta frecuencia, largas donde hace falta SNR. Esta función retorna
+ * inmediatamente; usar adc_dma_wait_complete() para esperar la
+ * finalización.
+ * 
+ * @param num_samples Muestras a capturar (1 a ADC_CAPTURE_MAX_SAMPLES)
+ * @return false si num_samples está fuera de rango (no se captura nada)
+ */
+bool adc_dma_start_capture(uint16_t num_samples);
+
+/**
+ * @brief Captura en adc_sample_buffer las num_samples muestras que siguen a
+ *        la captura anterior, sin hueco entre las dos
+ * 
+ * Sirve para integrar varias ventanas coherentes seguidas sin alojarlas
+ * todas: la fase de la señal continúa de una captura a la otra. Hay que
+ * llamarla apenas la anterior completa (adc_dma_samples_ready() igual a su
+ * largo) y sin adc_dma_wait_complete() de por medio; las muestras que
+ * queden de la anterior en el buffer se pisan.
+ * 
+ * @param num_samples Muestras a capturar (1 a ADC_CAPTURE_MAX_SAMPLES)
+ * @return false si num_samples está fuera de rango o el rearme llegó
+ *         tarde y se perdieron conversiones (no se captura nada)
+ */
+bool adc_dma_continue_capture(uint16_t num_samples);
+
+/**
+ * @brief Inicia la captura de num_samples muestras hacia un buffer propio
  * 
- * Reinicia el canal DMA y comienza la adquisición de WINDOW_SIZE muestras.
- * Esta función retorna inmediatamente; usar adc_dma_wait_complete() para
- * esperar la finalización.
+ * Igual que adc_dma_start_capture() pero sin pasar por adc_sample_buffer,
+ * para que el llamador pueda alternar entre varios buffers.
+ * 
+ * @param buffer Destino de num_samples·ADC_CHANNELS códigos (vivo hasta completar)
+ * @param num_samples Número de muestras por canal a capturar
  */
-void adc_dma_start_capture(void);
+void adc_dma_start_capture_into(uint16_t *buffer, uint16_t num_samples);
 
 /**
  * @brief Espera a que se complete la captura actual
  * 
  * Función bloqueante que espera hasta que el DMA haya transferido
- * todas las WINDOW_SIZE muestras al buffer.
+ * todas las muestras pedidas al buffer.
  */
 void adc_dma_wait_complete(void);
 
+/**
+ * @brief Corta la captura actual antes de completarla
+ * 
+ * Las muestras indicadas por adc_dma_samples_ready() siguen siendo válidas.
+ */
+void adc_dma_abort_capture(void);
+
+/**
+ * @brief Muestras de la captura actual ya disponibles en adc_sample_buffer
+ * 
+ * Las muestras [0, valor) pueden procesarse mientras el DMA completa el
+ * resto de la ventana.
+ * 
+ * @return Instantes completos escritos, todos sus canales (0 al largo pedido)
+ */
+uint16_t adc_dma_samples_ready(void);
+
 /**
  * @brief Verifica si hay captura en progreso
  * @return true si el DMA está activo, false si completó
  */
 bool adc_dma_is_busy(void);
 
+/**
+ * @brief Inicia la captura continua sobre el anillo de ADC_DMA_RING_BUFFERS
+ * 
+ * Dos canales DMA encadenados se alternan sin huecos entre bloques. Cada
+ * bloque completo queda en cola hasta que el consumidor lo toma con
+ * adc_dma_acquire_ready_buffer(). Si el consumidor se atrasa y no quedan
+ * buffers libres, se descarta el bloque listo más antiguo (overrun).
+ * 
+ * @return true si la captura arrancó, false en caso contrario
+ */
+bool adc_dma_start_continuous(void);
+
+/**
+ * @brief Detiene la captura continua
+ * 
+ * Los bloques que el consumidor todavía tiene siguen siendo válidos hasta
+ * que los libere.
+ */
+void adc_dma_stop_continuous(void);
+
+/**
+ * @brief Toma el bloque listo más antiguo sin copiarlo
+ * 
+ * El buffer queda en propiedad del llamador hasta adc_dma_release_buffer().
+ * 
+ * @param block Descriptor de salida
+ * @return true si había un bloque listo, false si la cola estaba vacía
+ */
+bool adc_dma_acquire_ready_buffer(adc_dma_block_t *block);
+
+/**
+ * @brief Devuelve al anillo un bloque obtenido con adc_dma_acquire_ready_buffer()
+ * 
+ * @param block Descriptor del bloque a liberar
+ */
+void adc_dma_release_buffer(const adc_dma_block_t *block);
+
+/**
+ * @brief Lee los contadores de la captura continua
+ * 
+ * @param stats Estructura de salida
+ */
+void adc_dma_get_ring_stats(adc_dma_ring_stats_t *stats);
+
 /**
  * @brief Valida la calidad de las muestras capturadas
  * 
  * Verifica que no haya saturación excesiva (valores en 0 o 4095)
  * 
- * @param samples Buffer de muestras a validar
- * @param n Número de muestras
+ * @param samples Buffer de muestras a validar (todos los canales)
+ * @param n Número de muestras por canal
  * @return true si las muestras son válidas, false si hay problemas
  */
 bool adc_dma_validate_samples(const uint16_t *samples, uint16_t n);
 
+/**
+ * @brief Cuenta los códigos saturados de un tramo
+ * 
+ * Permite validar una captura por bloques, a medida que se consume
+ * (adc_dma_saturation_valid() con las sumas).
+ * 
+ * @param samples Tramo a contar (todos los canales)
+ * @param n Número de muestras por canal
+ * @return Códigos saturados entre los n·ADC_CHANNELS
+ */
+uint32_t adc_dma_count_saturated(const uint16_t *samples, uint16_t n);
+
+/**
+ * @brief Criterio de adc_dma_validate_samples() sobre una cuenta ya hecha
+ * 
+ * @param saturated Códigos saturados (adc_dma_count_saturated())
+ * @param n Muestras por canal contadas
+ * @return true si la saturación no es excesiva
+ */
+bool adc_dma_saturation_valid(uint32_t saturated, uint32_t n);
+
 #endif // ADC_DMA_H
@@ -0,0 +1,199 @@
+/**
+ * @file command.h
+ * @brief Control remoto del barrido por MQTT_TOPIC_COMMAND
+ *
+ * Cambia el perfil del barrido, mide puntos sueltos, arranca y corta
+ * barridos y ajusta el ritmo de publicación sin recompilar. Cada comando
+ * es un objeto JSON con "cmd" y, opcional, un "id" que se devuelve en la
+ * confirmación:
+ *
+ *   {"cmd":"profile","id":1,"grid":"log","start":20,"stop":20000,"points":120,
+ *    "averages":2,"window":1920,"snr":50,"max_windows":8,"stderr_db":0.01,
+ *    "stderr_deg":0.1}
+ *   {"cmd":"profile","grid":"list","list":[50,60,1000]}
+ *   {"cmd":"point","freq":1000}
+ *   {"cmd":"start"}            barrido ya y barridos periódicos
+ *   {"cmd":"stop"}             corta el barrido en curso, sin periódicos
+ *   {"cmd":"rate","interval_ms":2000,"frame_points":50}
+ *   {"cmd":"monitor","freq":1000,"window":4,"hop":1,"batch":10}
+ *                              tono fijo en modo monitor (monitor.h)
+ *
+ * Un perfil o un monitor parte del vigente: los campos que no vienen no
+ * cambian. "stop" también detiene el monitor, y mientras el monitor está
+ * activo "point" y "start" se rechazan como ocupados. Las
+ * claves que no corresponden al comando lo invalidan, así un error de
+ * tipeo no se ignora en silencio.
+ *
+ * El contexto de red entrega el payload con command_deliver(), que solo
+ * lo copia a una bandeja de COMMAND_QUEUE_SLOTS slots (pool y dos colas
+ * SPSC, como el pipeline del barrido). command_poll(), desde el loop
+ * principal, los interpreta con json_reader.h (acotado y sin heap), los
+ * ejecuta y publica la confirmación en MQTT_TOPIC_STATUS:
+ *
+ *   {"status":"ack","cmd":"profile","id":1,"ok":true,"points":120}
+ *   {"status":"ack","cmd":"point","ok":false,"error":"busy"}
+ *   {"status":"ack","cmd":"monitor","ok":true,"freq":1000.0}
+ */
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "config.h"
+#include "monitor.h"
+#include "sweep_plan.h"
+
+// Tamaño de la confirmación en JSON (command_format_ack())
+#define COMMAND_ACK_JSON_MAX 96
+
+// Cota de interval_ms (un día)
+#define COMMAND_INTERVAL_MAX_MS 86400000u
+
+/**
+ * @brief Comandos
+ */
+typedef enum {
+    COMMAND_NONE = 0,           ///< Sin "cmd" reconocible
+    COMMAND_PROFILE,            ///< Nuevo perfil de barrido
+    COMMAND_POINT,              ///< Medir y publicar un punto suelto
+    COMMAND_START,              ///< Barrido inmediato y barridos periódicos
+    COMMAND_STOP,               ///< Cortar el barrido y detener los periódicos
+    COMMAND_RATE,               ///< Pausa entre barridos y puntos por trama
+    COMMAND_MONITOR             ///< Arrancar o reconfigurar el modo monitor
+} command_type_t;
+
+/**
+ * @brief Resultado de un comando
+ */
+typedef enum {
+    COMMAND_OK = 0,
+    COMMAND_ERR_PARSE,          ///< JSON inválido o demasiado largo
+    COMMAND_ERR_UNKNOWN,        ///< "cmd" ausente o desconocido
+    COMMAND_ERR_INVALID,        ///< Clave ajena al comando o valor fuera de rango
+    COMMAND_ERR_BUSY,           ///< Rechazado por un barrido en curso
+    COMMAND_ERR_FAILED          ///< Aceptado pero no se pudo ejecutar
+} command_error_t;
+
+/**
+ * @brief Comando interpretado
+ */
+typedef struct {
+    command_type_t type;
+    uint32_t id;                ///< "id" del pedido
+    bool has_id;
+    sweep_plan_spec_t spec;     ///< PROFILE: perfil completo (vigente + cambios)
+    float list_hz[SWEEP_NUM_POINTS]; ///< PROFILE: lista de la grilla LIST
+    float freq_hz;              ///< POINT: frecuencia pedida
+    uint32_t interval_ms;       ///< RATE: pausa entre barridos
+    uint16_t frame_points;      ///< RATE: puntos por trama (0 = una por barrido)
+    monitor_spec_t monitor;     ///< MONITOR: parámetros completos (vigentes + cambios)
+    bool has_interval;
+    bool has_frame_points;
+} command_t;
+
+/**
+ * @brief Confirmación de un comando
+ */
+typedef struct {
+    command_type_t type;        ///< COMMAND_NONE: se omite "cmd"
+    uint32_t id;
+    bool has_id;
+    command_error_t error;
+    uint16_t points;            ///< PROFILE aceptado: puntos del plan nuevo
+    float freq_hz;              ///< MONITOR aceptado: frecuencia coherente
+} command_ack_t;
+
+/**
+ * @brief Estadísticas de la bandeja
+ */
+typedef struct {
+    uint32_t received;          ///< Comandos entregados por la red
+    uint32_t executed;          ///< Confirmados con ok
+    uint32_t rejected;          ///< Confirmados con error
+    uint32_t dropped;           ///< Descartados con la bandeja llena
+} command_stats_t;
+
+/**
+ * @brief Vacía la bandeja y toma como vigentes el perfil de config.h,
+ *        SWEEP_INTERVAL_MS y los barridos periódicos habilitados
+ *
+ * Llamarla antes de que la red pueda entregar comandos.
+ */
+void command_init(void);
+
+/**
+ * @brief Copia un payload recibido a la bandeja (contexto de red)
+ *
+ * No interpreta nada. Un payload de más de COMMAND_PAYLOAD_MAX bytes se
+ * guarda marcado y se confirma como error de parseo.
+ *
+ * @return false si la bandeja estaba llena (el comando se descarta)
+ */
+bool command_deliver(const uint8_t *payload, size_t len);
+
+/**
+ * @brief Ejecuta los comandos de la bandeja y publica sus confirmaciones
+ *
+ * Desde el loop principal. "point" mide con frequency_sweep_single_point()
+ * y bloquea lo que dura ese punto.
+ *
+ * @return Comandos procesados
+ */
+uint32_t command_poll(void);
+
+/**
+ * @brief Interpreta un payload sin ejecutarlo
+ *
+ * Los campos del perfil, del ritmo y del monitor que no vienen en el
+ * payload quedan con los valores vigentes.
+ *
+ * @param payload JSON (sin terminador)
+ * @param len Bytes del payload
+ * @param cmd Comando de salida; type e id quedan cargados aun con error si
+ *            se llegaron a leer
+ * @return COMMAND_OK o el error de parseo/validación
+ */
+command_error_t command_parse(const char *payload, size_t len, command_t *cmd);
+
+/**
+ * @brief Serializa una confirmación para MQTT_TOPIC_STATUS
+ *
+ * @return Largo escrito, 0 si no alcanzó el buffer
+ */
+size_t command_format_ack(const command_ack_t *ack, char *buf, size_t capacity);
+
+/**
+ * @brief Nombre del comando ("profile", "point"...; NULL para COMMAND_NONE)
+ */
+const char *command_name(command_type_t type);
+
+/**
+ * @brief Nombre del error ("parse", "busy"...; NULL para COMMAND_OK)
+ */
+const char *command_error_name(command_error_t error);
+
+/**
+ * @brief Indica si corresponden barridos periódicos (false tras "stop")
+ */
+bool command_sweeps_enabled(void);
+
+/**
+ * @brief Pausa vigente entre barridos (ms)
+ */
+uint32_t command_interval_ms(void);
+
+/**
+ * @brief Consume el pedido de barrido inmediato de "start"
+ *
+ * @return true una vez por cada "start" aceptado
+ */
+bool command_take_start(void);
+
+/**
+ * @brief Copia las estadísticas de la bandeja
+ */
+void command_get_stats(command_stats_t *stats);
+
+#endif // COMMAND_H
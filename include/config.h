@@ -35,14 +35,73 @@
 // Topic para publicar mediciones
 #define MQTT_TOPIC_MEASUREMENTS "fra/measurements"
 
+// Topic para publicar barridos completos en trama binaria (sweep_frame.h)
+#define MQTT_TOPIC_SWEEP "fra/sweep"
+
+// Puntos por trama de barrido: 0 = una trama por barrido, N = publicar
+// cada N puntos (menos latencia hasta el primer dato, más mensajes)
+#define SWEEP_FRAME_POINTS 0
+
 // Topic para publicar estado del sistema
 #define MQTT_TOPIC_STATUS "fra/status"
 
+// Topic para publicar el reporte de la traza de etapas (trace.h)
+#define MQTT_TOPIC_TRACE "fra/trace"
+
+// Topic de comandos (perfil de barrido, punto suelto, start/stop, ritmo de
+// publicación); las confirmaciones salen por MQTT_TOPIC_STATUS (command.h)
+#define MQTT_TOPIC_COMMAND "fra/cmd"
+
+// Topic del modo monitor: magnitud y fase de un tono fijo, varias
+// actualizaciones por mensaje (monitor.h)
+#define MQTT_TOPIC_MONITOR "fra/monitor"
+
+// Topic de la excitación multitono: factor de cresta y SNR por tono de
+// cada medición; la respuesta sale como trama por MQTT_TOPIC_SWEEP
+// (multitone.h)
+#define MQTT_TOPIC_MULTITONE "fra/multitone"
+
 // QoS para mensajes MQTT (0, 1 o 2)
 // 0 = At most once (sin confirmación)
 // 1 = At least once (con confirmación)
 #define MQTT_QOS 0
 
+// Cola de publicación: mensajes ya serializados que drena el contexto de
+// red, así el barrido nunca espera a TCP (ver publish_queue.h)
+#define PUBLISH_QUEUE_SLOTS 8
+
+// Política con la cola llena: PUBLISH_DROP_OLDEST, PUBLISH_DROP_NEWEST o
+// PUBLISH_BLOCK (el barrido espera a la red)
+#define PUBLISH_QUEUE_POLICY PUBLISH_DROP_OLDEST
+
+// Período con que el contexto de red drena la cola (ms) y mensajes por pasada
+#define MQTT_POLL_INTERVAL_MS 5
+#define MQTT_POLL_BATCH 4
+
+// Espera entre intentos de reconexión al broker (ms): arranca en el mínimo,
+// se duplica con cada intento fallido hasta el máximo y vuelve al mínimo
+// al reconectar
+#define MQTT_RECONNECT_MIN_MS 1000
+#define MQTT_RECONNECT_MAX_MS 30000
+
+// Comandos recibidos que esperan al loop principal y tamaño máximo de cada
+// payload; con la bandeja llena el comando se descarta
+#define COMMAND_QUEUE_SLOTS 4
+#define COMMAND_PAYLOAD_MAX 1024
+
+// ============================================================================
+// ALMACÉN DE BARRIDOS EN FLASH
+// ============================================================================
+
+// Sectores de 4 KB reservados para los barridos que no llegaron al broker;
+// se reenvían al reconectar (ver sweep_store.h). Un sector guarda 4
+// barridos completos de 200 puntos
+#define SWEEP_STORE_SECTORS 16
+
+// Inicio de la región dentro de la flash: los últimos sectores de los 4 MB
+// del Pico 2 W, lejos de la imagen del firmware
+#define SWEEP_STORE_FLASH_OFFSET (4u * 1024u * 1024u - SWEEP_STORE_SECTORS * 4096u)
+
 // ============================================================================
 // PARÁMETROS DEL SISTEMA DSP
 // ============================================================================
@@ -50,9 +109,15 @@
 // Frecuencia de muestreo del ADC (Hz)
 #define SAMPLE_RATE 48000.0f
 
-// Tamaño de ventana para Goertzel (muestras)
+// Tamaño de ventana para Goertzel (muestras): ventana nominal de la grilla
+// lineal y bloque de la captura continua
 #define WINDOW_SIZE 480
 
+// Máximo de muestras por captura (tamaño de adc_sample_buffer y de cada
+// buffer del barrido pipeline): el plan elige por punto una ventana de
+// hasta este largo (40 ms a 48 kHz)
+#define ADC_CAPTURE_MAX_SAMPLES 1920
+
 // Resolución en frecuencia (Hz) - derivada de SAMPLE_RATE/WINDOW_SIZE
 #define FREQ_RESOLUTION 100.0f
 
@@ -60,9 +125,174 @@
 #define SWEEP_FREQ_MIN 100.0f
 #define SWEEP_FREQ_MAX 20000.0f
 
-// Número de puntos de medición en el barrido
+// Número de puntos de medición en el barrido: capacidad del plan y de la
+// trama; la grilla lineal los usa todos
 #define SWEEP_NUM_POINTS 200
 
+// Grilla del barrido (ver sweep_plan.h)
+// SWEEP_GRID_LINEAR = SWEEP_FREQ_MIN..SWEEP_FREQ_MAX cada FREQ_RESOLUTION
+// SWEEP_GRID_LOG    = SWEEP_LOG_POINTS_PER_DECADE puntos por década
+#define SWEEP_GRID SWEEP_GRID_LINEAR
+#define SWEEP_LOG_POINTS_PER_DECADE 20
+
+// Ventanas coherentes consecutivas integradas por punto; todas tienen que
+// entrar en ADC_CAPTURE_MAX_SAMPLES muestras
+#define SWEEP_AVERAGES 1
+
+// Desvío relativo máximo entre la frecuencia pedida y la coherente (ciclos
+// enteros en la ventana)
+#define SWEEP_PLAN_FREQ_TOL 0.001f
+
+// Largo de ventana por punto: la coherente más corta cuyo SNR estimado
+// alcanza SWEEP_PLAN_TARGET_SNR_DB para una señal de
+// SWEEP_PLAN_MIN_AMPLITUDE (pico, fracción del fondo de escala) sobre
+// ruido blanco de SWEEP_PLAN_NOISE_RMS, con al menos SWEEP_PLAN_MIN_CYCLES
+// ciclos. Con objetivo 0 se usa la ventana más larga que entre en
+// ADC_CAPTURE_MAX_SAMPLES (ventana fija)
+#define SWEEP_PLAN_TARGET_SNR_DB 50.0f
+#define SWEEP_PLAN_MIN_AMPLITUDE 0.02f
+#define SWEEP_PLAN_NOISE_RMS 0.0007f    // ENOB ~8.8 (docs/implementation_notes.md)
+#define SWEEP_PLAN_MIN_CYCLES 1
+
+// Promedio coherente con corte anticipado: cada punto repite su captura
+// hasta SWEEP_AVG_MAX_WINDOWS veces seguidas, sin huecos entre ventanas, y
+// corta en cuanto el error estándar de magnitud y fase queda bajo las
+// cotas (con al menos SWEEP_AVG_MIN_WINDOWS ventanas para estimarlo).
+// 1 = una sola captura por punto
+#define SWEEP_AVG_MAX_WINDOWS 1
+#define SWEEP_AVG_MIN_WINDOWS 3
+#define SWEEP_AVG_STDERR_DB 0.01f
+#define SWEEP_AVG_STDERR_DEG 0.1f
+
+// Kernel de Goertzel al arrancar (seleccionable luego con goertzel_set_kernel)
+// GOERTZEL_KERNEL_FLOAT = float32 con FPU
+// GOERTZEL_KERNEL_FIXED = enteros sobre códigos crudos del ADC
+#define GOERTZEL_DEFAULT_KERNEL GOERTZEL_KERNEL_FLOAT
+
+// Cruce Goertzel/FFT de la detección multi-bin (fft_crossover_bins()): la
+// FFT de un bloque de N pares conviene desde
+// FFT_CROSSOVER_BINS_PER_STAGE·log2(N) + FFT_CROSSOVER_BINS_OFFSET bines
+// exactos. Valores medidos con fra_bench_fft; en el Cortex-M33 conviene
+// volver a medirlos
+#define FFT_CROSSOVER_BINS_PER_STAGE 0.25f
+#define FFT_CROSSOVER_BINS_OFFSET 5.0f
+
+// Ventanas en vuelo en el barrido pipeline (captura en core 0, Goertzel y
+// publicación en core 1); 2 alcanza para solapar, más absorbe variaciones
+// de latencia del lado de MQTT
+#define SWEEP_PIPELINE_BUFFERS 4
+
+// 1 = el loop principal mide cada barrido repartido entre los dos núcleos
+// (frequency_sweep_execute_pipelined()): una captura por punto, sin
+// promedio y sin "stop" a mitad de barrido. Excluyente con
+// SWEEP_ADAPTIVE y SWEEP_MULTITONE
+#define SWEEP_PIPELINED 0
+
+// Pausa entre barridos del loop principal (ms); el núcleo duerme (WFE)
+// entre consultas, también durante el barrido
+#define SWEEP_INTERVAL_MS 10000
+
+// ============================================================================
+// ASENTAMIENTO ADAPTATIVO
+// ============================================================================
+
+// Largo mínimo de cada pre-ventana de asentamiento (muestras); se extiende
+// hasta un número entero de ciclos de la frecuencia medida. Las
+// pre-ventanas son tramos contiguos de una misma captura.
+#define SETTLE_PRE_WINDOW_MIN 96
+
+// Convergencia entre estimaciones sucesivas de Goertzel
+#define SETTLE_MAG_TOL 0.005f       // Variación relativa de magnitud
+#define SETTLE_MAG_FLOOR 0.001f     // Variación absoluta (1.0 = media escala, ~2 LSB)
+#define SETTLE_PHASE_TOL_DEG 0.5f   // Variación de fase
+#define SETTLE_CONSECUTIVE 2        // Comparaciones seguidas dentro de tolerancia
+
+// Constante de tiempo esperada del DUT (ms) y cuántas τ se admiten como
+// techo de espera (7τ deja un residuo de 0.1 %)
+#define SETTLE_DUT_TAU_MS 2.0f
+#define SETTLE_TAU_MULTIPLE 7.0f
+
+// τ por banda (settle_tau_ms()): SETTLE_TAU_BAND_COUNT filas {hasta_hz,
+// tau_ms} en frecuencia creciente. Cada punto usa la primera fila que lo
+// cubre; por encima de la última, SETTLE_DUT_TAU_MS. Sirve para DUTs con
+// un polo lento en una banda y rápidos en el resto (0 = τ único). Ejemplo:
+// #define SETTLE_TAU_BAND_COUNT 2
+// #define SETTLE_TAU_BANDS { {300.0f, 8.0f}, {3000.0f, 4.0f} }
+#define SETTLE_TAU_BAND_COUNT 0
+
+// Techo absoluto por punto en muestras (100 ms a 48 kHz, la espera fija
+// que se usaba antes); dimensiona el buffer de asentamiento
+#define SETTLE_MAX_SAMPLES 4800
+
+// ============================================================================
+// BARRIDO ADAPTATIVO
+// ============================================================================
+
+// 1 = el loop principal usa el barrido adaptativo (sweep_adaptive.h) en
+// lugar del plan fijo
+#define SWEEP_ADAPTIVE 0
+
+// Puntos de la pasada gruesa logarítmica entre SWEEP_FREQ_MIN y SWEEP_FREQ_MAX
+#define SWEEP_ADAPTIVE_COARSE_POINTS 10
+
+// Error de interpolación estimado por encima del cual se inserta un punto
+// (0 = no usar ese criterio). La fase se mide contra la referencia del
+// segundo canal; con ADC_CHANNELS en 1 es relativa al inicio de la captura
+// y el criterio de fase no se usa. 0.5° es del orden de 0.1 dB (1.2 %)
+#define SWEEP_ADAPTIVE_MAG_TOL_DB 0.1f
+#define SWEEP_ADAPTIVE_PHASE_TOL_DEG 0.5f
+
+// Intervalo relativo mínimo que se sigue partiendo (f2/f1 - 1) y tope de
+// tiempo por barrido en ms (0 = sin tope; el de puntos es SWEEP_NUM_POINTS)
+#define SWEEP_ADAPTIVE_MIN_STEP 0.005f
+#define SWEEP_ADAPTIVE_MAX_MS 0
+
+// ============================================================================
+// MODO MONITOR
+// ============================================================================
+
+// Parámetros por defecto del monitor (monitor.h), que arranca con el
+// comando "monitor". Cada bloque de la captura continua dura
+// WINDOW_SIZE / SAMPLE_RATE (10 ms): la ventana es de MONITOR_WINDOW_BLOCKS
+// bloques (40 ms, tonos coherentes cada 25 Hz), sale una actualización
+// cada MONITOR_HOP_BLOCKS (100 por segundo) y MONITOR_BATCH actualizaciones
+// por mensaje (10 mensajes por segundo)
+#define MONITOR_FREQ_HZ 1000.0f
+#define MONITOR_WINDOW_BLOCKS 4
+#define MONITOR_HOP_BLOCKS 1
+#define MONITOR_BATCH 10
+
+// Cotas de los pedidos: bloques por ventana y actualizaciones por mensaje
+#define MONITOR_WINDOW_BLOCKS_MAX 16
+#define MONITOR_BATCH_MAX 25
+
+// ============================================================================
+// EXCITACIÓN MULTITONO
+// ============================================================================
+
+// 1 = el loop principal mide todos los tonos a la vez (multitone.h) en
+// lugar del barrido tono a tono. La multiseno la aplica un generador
+// externo en la entrada del DUT: el AD9833 da un solo tono
+#define SWEEP_MULTITONE 0
+
+// Tonos por defecto: MULTITONE_TONES en grilla logarítmica entre
+// SWEEP_FREQ_MIN y SWEEP_FREQ_MAX, corregidos a los bines del período
+#define MULTITONE_TONES 40
+
+// Período de la multiseno en bloques de la captura continua: resolución
+// SAMPLE_RATE / (MULTITONE_PERIOD_BLOCKS * WINDOW_SIZE) (25 Hz)
+#define MULTITONE_PERIOD_BLOCKS 4
+
+// Períodos promediados por medición, después del asentamiento
+#define MULTITONE_PERIODS 8
+
+// Pico de la suma en fracción del fondo de escala (como la amplitud del DDS)
+#define MULTITONE_PEAK 0.4f
+
+// Cotas: tonos por multiseno y bloques por período
+#define MULTITONE_TONES_MAX SWEEP_NUM_POINTS
+#define MULTITONE_PERIOD_BLOCKS_MAX 16
+
 // ============================================================================
 // CONFIGURACIÓN HARDWARE AD9833
 // ============================================================================
@@ -71,7 +301,11 @@
 #define AD9833_SPI_INSTANCE spi0
 #define AD9833_PIN_SCK  2
 #define AD9833_PIN_MOSI 3
-#define AD9833_PIN_CS   5
+#define AD9833_PIN_CS   5   // SPI0 CSn: FSYNC lo pulsa el periférico entre palabras
+
+// Canal DMA que vuelca los lotes de comandos al FIFO TX del SPI
+// (0 y 1 son de la captura ADC)
+#define AD9833_DMA_CHANNEL 2
 
 // Frecuencia del cristal del AD9833 (Hz)
 #define AD9833_MCLK 25000000.0f
@@ -80,15 +314,30 @@
 // CONFIGURACIÓN ADC
 // ============================================================================
 
-// Pin ADC para canal de referencia
+// Pin ADC para canal de referencia (salida del DDS, entrada del DUT)
 #define ADC_PIN_REFERENCE 26  // ADC0
 
-// Pin ADC para canal de respuesta (futuro, para 2 canales)
+// Pin ADC para canal de respuesta (salida del DUT)
 #define ADC_PIN_RESPONSE 27   // ADC1
 
+// Canales adquiridos por captura:
+// 2 = referencia y respuesta en round-robin, intercaladas muestra a muestra;
+//     cada punto se mide como H = respuesta/referencia (el ADC convierte a
+//     SAMPLE_RATE·2 y cada canal queda muestreado a SAMPLE_RATE)
+// 1 = solo la respuesta; magnitud absoluta y fase relativa al inicio de la
+//     captura
+#define ADC_CHANNELS 2
+
 // Canal DMA para transferencias ADC
 #define ADC_DMA_CHANNEL 0
 
+// Segundo canal DMA, encadenado al primero en captura continua (ping-pong)
+#define ADC_DMA_CHANNEL_PONG 1
+
+// Buffers del anillo de captura continua (mínimo 3: dos en llenado por
+// los canales DMA y al menos uno en manos del consumidor)
+#define ADC_DMA_RING_BUFFERS 4
+
 // ============================================================================
 // DEBUGGING
 // ============================================================================
@@ -101,9 +350,22 @@
 // 1 = Errores + warnings
 // 2 = Errores + warnings + info
 // 3 = Todo (incluye debug detallado)
+#ifndef DEBUG_LEVEL
 #define DEBUG_LEVEL 2
+#endif
+
+// Traza de etapas del camino caliente (trace.h): la duración de cada
+// escritura al DDS, asentamiento, captura, validación, Goertzel y
+// publicación queda en un anillo en RAM, con p50/p95/máx por etapa al
+// final del barrido. 0 = sin traza
+#define TRACE_ENABLED 1
+
+// Eventos del anillo (potencia de 2): unos 6 por punto, alcanza para un
+// barrido de SWEEP_NUM_POINTS
+#define TRACE_RING_EVENTS 2048
 
-// Habilitar instrumentación con GPIO para osciloscopio
+// Habilitar instrumentación con GPIO para osciloscopio: cada pin sigue una
+// etapa de la traza (captura, Goertzel, publicación y barrido completo)
 // #define DEBUG_GPIO_ENABLED
 
 #ifdef DEBUG_GPIO_ENABLED
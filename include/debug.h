@@ -0,0 +1,26 @@
+/**
+ * @file debug.h
+ * @brief Macros de debug compartidas por todos los módulos
+ *
+ * El nivel de verbosidad se toma de DEBUG_LEVEL (config.h). El target de
+ * simulación nativa lo fuerza a 0 desde CMake para que los barridos
+ * masivos no queden dominados por printf.
+ */
+
+#ifndef DEBUG_H
+#define DEBUG_H
+
+#include <stdio.h>
+#include "config.h"
+
+#ifdef DEBUG_ENABLED
+    #define DEBUG_PRINT(level, ...) do { \
+        if (level <= DEBUG_LEVEL) { \
+            printf(__VA_ARGS__); \
+        } \
+    } while(0)
+#else
+    #define DEBUG_PRINT(level, ...)
+#endif
+
+#endif // DEBUG_H
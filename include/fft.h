@@ -0,0 +1,128 @@
+/**
+ * @file fft.h
+ * @brief FFT in-place con tablas en flash: detector alternativo a Goertzel
+ *
+ * Radix-2 iterativa (decimación en el tiempo) sobre potencias de dos de
+ * FFT_MIN_SIZE a FFT_MAX_SIZE puntos. Los factores de giro salen de una
+ * tabla const de un cuarto de onda del seno (en el RP2350 queda en flash,
+ * leída por la caché XIP) y no se usa heap: cada transformada trabaja
+ * sobre el buffer del llamador. La real de N puntos es una compleja de N/2
+ * más una pasada de separación.
+ *
+ * Goertzel cuesta O(N) por bin y la FFT O(N·log2 N) por todos los bines:
+ * con pocos bines gana Goertzel y con muchos la FFT. fft_choose_detector()
+ * elige por cantidad de bines con el cruce de fft_crossover_bins()
+ * (fra_bench_fft lo mide). La FFT solo sirve si cada bin cae exacto en
+ * k·fs/N; Goertzel evalúa cualquier frecuencia.
+ *
+ * Convención de goertzel_stream_bin(): X[k] = Σ x[n]·e^(-j·2π·k·n/N), sin
+ * normalizar.
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Largos admitidos (potencias de dos); la tabla de giros es de FFT_MAX_SIZE
+#define FFT_MIN_SIZE 2
+#define FFT_MAX_SIZE 4096
+
+// Verdadero si n es un largo admitido (sirve en #if)
+#define FFT_SIZE_SUPPORTED(n) \
+    ((n) >= FFT_MIN_SIZE && (n) <= FFT_MAX_SIZE && ((n) & ((n) - 1)) == 0)
+
+// Desvío máximo (en bines) para tomar una frecuencia como bin exacto
+#define FFT_BIN_TOL 1e-3f
+
+/**
+ * @brief Detector multi-bin
+ */
+typedef enum {
+    FFT_DETECTOR_GOERTZEL = 0,  ///< goertzel_pair_bins(): O(N) por bin, cualquier frecuencia
+    FFT_DETECTOR_FFT = 1        ///< fft_pair_bins(): O(N·log2 N) para todos los bines exactos
+} fft_detector_t;
+
+/**
+ * @brief FFT compleja directa in-place
+ *
+ * @param data n puntos complejos intercalados (re, im), 2·n floats
+ * @param n Número de puntos (FFT_SIZE_SUPPORTED)
+ * @return false si n no es un largo admitido (data queda sin tocar)
+ */
+bool fft_complex(float *data, uint32_t n);
+
+/**
+ * @brief FFT real directa in-place
+ *
+ * Salida empaquetada en los mismos n floats: data[0] = X[0], data[1] =
+ * X[n/2] (los dos son reales) y (data[2k], data[2k+1]) = X[k] para
+ * 0 < k < n/2. El resto del espectro es el conjugado.
+ *
+ * @param data n muestras reales
+ * @param n Número de muestras (FFT_SIZE_SUPPORTED)
+ * @return false si n no es un largo admitido (data queda sin tocar)
+ */
+bool fft_real(float *data, uint32_t n);
+
+/**
+ * @brief Bin de una FFT de n puntos que cae en una frecuencia
+ *
+ * @param freq_hz Frecuencia (Hz)
+ * @param sample_rate_hz Frecuencia de muestreo (Hz)
+ * @param n Largo de la FFT
+ * @param bin Salida: k con k·fs/n = freq_hz, 0 <= k <= n/2
+ * @return false si la frecuencia cae entre bines (más de FFT_BIN_TOL)
+ */
+bool fft_bin_index(float freq_hz, float sample_rate_hz, uint32_t n, uint16_t *bin);
+
+/**
+ * @brief Bines desde los que la FFT de n pares es más barata que Goertzel
+ *
+ * Modelo FFT_CROSSOVER_BINS_PER_STAGE·log2(n) + FFT_CROSSOVER_BINS_OFFSET
+ * (config.h): la FFT paga un costo fijo por etapa y Goertzel uno por bin.
+ *
+ * @param n Pares por bloque (FFT_SIZE_SUPPORTED)
+ * @return Cantidad de bines, 0 si n no es un largo admitido
+ */
+uint32_t fft_crossover_bins(uint32_t n);
+
+/**
+ * @brief Elige el detector multi-bin de un bloque
+ *
+ * @param num_frames Pares por bloque
+ * @param num_bins Bines a evaluar
+ * @param bins_exact Todos los bines caen en k·fs/num_frames (fft_bin_index())
+ * @return FFT_DETECTOR_FFT si se puede usar y num_bins alcanza el cruce
+ */
+fft_detector_t fft_choose_detector(uint32_t num_frames, size_t num_bins, bool bins_exact);
+
+/**
+ * @brief Bines de varias frecuencias sobre pares intercalados, por FFT
+ *
+ * Misma salida que goertzel_pair_bins() en bines exactos: los dos canales
+ * van juntos en una FFT compleja (referencia + j·respuesta) y se separan
+ * por simetría en cada bin pedido.
+ *
+ * @param frames Códigos ADC, 2·num_frames (referencia primero)
+ * @param num_frames Número de pares (FFT_SIZE_SUPPORTED)
+ * @param bins Índice k de cada bin, num_bins elementos (<= num_frames/2)
+ * @param num_bins Número de bins
+ * @param scratch Trabajo del llamador, 2·num_frames floats
+ * @param reference Salida: 2·num_bins valores, (re, im) de cada bin de la referencia
+ * @param response Salida: ídem para la respuesta
+ * @return false si num_frames no es un largo admitido
+ */
+bool fft_pair_bins(
+    const uint16_t *frames,
+    uint32_t num_frames,
+    const uint16_t *bins,
+    size_t num_bins,
+    float *scratch,
+    float *reference,
+    float *response
+);
+
+#endif // FFT_H
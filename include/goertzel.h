@@ -3,24 +3,118 @@
  * @brief Módulo de procesamiento DSP - Algoritmo de Goertzel
  * 
  * Implementa el algoritmo de Goertzel en punto flotante de 32 bits
- * para detección eficiente de tonos individuales.
+ * para detección eficiente de tonos individuales, con un kernel
+ * alternativo en punto fijo que opera sobre los códigos crudos del ADC.
  */
 
 #ifndef GOERTZEL_H
 #define GOERTZEL_H
 
 #include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Bins procesados juntos por goertzel_compute_bins()
+ *
+ * 8 bins = 16 variables de estado + 8 coeficientes, que entran en los
+ * 32 registros de precisión simple de la FPU del Cortex-M33.
+ */
+#define GOERTZEL_BINS_PER_PASS 8
+
+/**
+ * @brief Bins procesados juntos por goertzel_pair_bins()
+ *
+ * 4 bins en los dos canales = 16 variables de estado + 4 coeficientes:
+ * el mismo presupuesto de registros que GOERTZEL_BINS_PER_PASS con uno.
+ */
+#define GOERTZEL_PAIR_BINS_PER_PASS 4
+
+/**
+ * @brief Bits fraccionarios del estado del kernel en punto fijo
+ *
+ * El estado se guarda en int32 como códigos ADC en Q4. Con entrada de
+ * ±2048 códigos el estado queda acotado por 2048*N/(2*sin(omega)), por lo
+ * que el kernel fijo es seguro mientras N/sin(omega) < 131072 (en 480
+ * muestras a 48 kHz: f > 28 Hz). Fuera de ese rango se usa el kernel float.
+ */
+#define GOERTZEL_FIXED_STATE_FRAC_BITS 4
+
+/**
+ * @brief Kernel usado por goertzel_compute() y el Goertzel incremental
+ */
+typedef enum {
+    GOERTZEL_KERNEL_FLOAT = 0,  ///< float32 sobre muestras normalizadas (FPU)
+    GOERTZEL_KERNEL_FIXED = 1   ///< int32/int64 sobre códigos crudos (coef. Q30)
+} goertzel_kernel_t;
 
 /**
  * @brief Estructura de resultado del análisis de Goertzel
  */
 typedef struct {
-    float magnitude;        ///< Magnitud absoluta
+    float magnitude;        ///< Amplitud de pico normalizada (1.0 = fondo de escala)
     float magnitude_db;     ///< Magnitud en dB (20*log10)
     float phase_rad;        ///< Fase en radianes
     float phase_deg;        ///< Fase en grados
 } goertzel_result_t;
 
+/**
+ * @brief Coeficientes precalculados de un bin
+ */
+typedef struct {
+    float freq_hz;          ///< Frecuencia objetivo (Hz)
+    float coeff;            ///< 2*cos(omega), coeficiente del lazo IIR
+    float cos_omega;        ///< cos(omega), usado al cerrar el cálculo
+    float sin_omega;        ///< sin(omega), usado al cerrar el cálculo
+    int32_t coeff_q30;      ///< 2*cos(omega) en Q2.30 (kernel fijo)
+    int32_t cos_q31;        ///< cos(omega) en Q1.31 (kernel fijo)
+    int32_t sin_q31;        ///< sin(omega) en Q1.31 (kernel fijo)
+} goertzel_coeffs_t;
+
+/**
+ * @brief Estado incremental de Goertzel para procesar mientras se adquiere
+ * 
+ * Permite consumir la ventana en bloques a medida que el DMA los completa.
+ * El resultado es idéntico bit a bit al de goertzel_compute() sobre el
+ * mismo buffer completo, para cualquier partición en bloques.
+ */
+typedef struct {
+    const goertzel_coeffs_t *coeffs;    ///< Coeficientes del bin (no se copian)
+    goertzel_kernel_t kernel;           ///< Kernel fijado al inicializar
+    uint32_t count;                     ///< Muestras consumidas
+    float s_prev;                       ///< Estado float s[n-1]
+    float s_prev2;                      ///< Estado float s[n-2]
+    int32_t q_prev;                     ///< Estado fijo s[n-1] (Q4)
+    int32_t q_prev2;                    ///< Estado fijo s[n-2] (Q4)
+} goertzel_stream_t;
+
+/**
+ * @brief Goertzel incremental sobre una captura de dos canales intercalados
+ * 
+ * Consume los códigos tal como los deja el ADC en round-robin (referencia,
+ * respuesta, referencia, ...) y actualiza los dos estados en la misma
+ * pasada por memoria, sin desintercalar a buffers aparte. Cada canal da el
+ * mismo resultado que un goertzel_stream_t sobre sus muestras solas.
+ */
+typedef struct {
+    goertzel_stream_t reference;        ///< Canal 0 de cada par
+    goertzel_stream_t response;         ///< Canal 1 de cada par
+} goertzel_pair_t;
+
+/**
+ * @brief Selecciona el kernel de Goertzel en tiempo de ejecución
+ * 
+ * El valor inicial es GOERTZEL_DEFAULT_KERNEL (config.h). El camino
+ * multi-bin (goertzel_compute_bins) usa siempre el kernel float.
+ * 
+ * @param kernel Kernel a usar en las próximas llamadas
+ */
+void goertzel_set_kernel(goertzel_kernel_t kernel);
+
+/**
+ * @brief Kernel de Goertzel actualmente seleccionado
+ */
+goertzel_kernel_t goertzel_get_kernel(void);
+
 /**
  * @brief Ejecuta el algoritmo de Goertzel sobre un buffer de muestras
  * 
@@ -30,6 +124,7 @@ typedef struct {
  * IMPORTANTE: 
  * - Usar sufijo 'f' en todos los literales para forzar precisión simple
  * - Las muestras se normalizan internamente de [0, 4095] a [-1, +1]
+ * - La fase sigue la convención de la DFT (coseno = 0°, seno = -90°)
  * 
  * @param samples Buffer de muestras ADC (uint16_t, rango 0-4095)
  * @param num_samples Número de muestras en el buffer (típicamente 480)
@@ -45,6 +140,189 @@ void goertzel_compute(
     goertzel_result_t *result
 );
 
+/**
+ * @brief Calcula los coeficientes de un bin
+ * 
+ * @param coeffs Estructura a completar
+ * @param target_freq_hz Frecuencia objetivo (Hz)
+ * @param sample_rate_hz Frecuencia de muestreo (Hz)
+ */
+void goertzel_coeffs_init(
+    goertzel_coeffs_t *coeffs,
+    float target_freq_hz,
+    float sample_rate_hz
+);
+
+/**
+ * @brief Inicializa un Goertzel incremental
+ * 
+ * El kernel se fija en este momento según goertzel_get_kernel() y la
+ * longitud prevista de la ventana.
+ * 
+ * @param stream Estado a inicializar
+ * @param coeffs Coeficientes del bin (deben sobrevivir al stream)
+ * @param expected_samples Longitud total prevista de la ventana
+ */
+void goertzel_stream_init(
+    goertzel_stream_t *stream,
+    const goertzel_coeffs_t *coeffs,
+    uint32_t expected_samples
+);
+
+/**
+ * @brief Consume un bloque de muestras
+ * 
+ * @param stream Estado inicializado
+ * @param block Muestras ADC (rango 0-4095)
+ * @param num_samples Número de muestras del bloque (puede ser 0)
+ */
+void goertzel_stream_push(
+    goertzel_stream_t *stream,
+    const uint16_t *block,
+    uint32_t num_samples
+);
+
+/**
+ * @brief Calcula magnitud y fase con lo consumido hasta el momento
+ * 
+ * No modifica el estado: se puede seguir empujando muestras después.
+ * 
+ * @param stream Estado con al menos una muestra consumida
+ * @param result Puntero a estructura donde se almacenará el resultado
+ */
+void goertzel_stream_result(
+    const goertzel_stream_t *stream,
+    goertzel_result_t *result
+);
+
+/**
+ * @brief Bin de la DFT con lo consumido hasta el momento, sin normalizar
+ * 
+ * X = Σ x[n]·e^(-jωn) sobre las muestras normalizadas a [-1, +1]; el
+ * resultado de goertzel_stream_result() es |X|·2/count y arg X. El estado
+ * no se reinicia: si las dos llamadas caen en un número entero de ciclos,
+ * su diferencia es el bin del tramo entre ellas con la misma referencia de
+ * fase que el primer tramo.
+ * 
+ * @param stream Estado inicializado
+ * @param real Parte real de X
+ * @param imag Parte imaginaria de X
+ */
+void goertzel_stream_bin(
+    const goertzel_stream_t *stream,
+    float *real,
+    float *imag
+);
+
+/**
+ * @brief Inicializa un Goertzel de dos canales
+ * 
+ * @param pair Estado a inicializar
+ * @param coeffs Coeficientes del bin, comunes a los dos canales
+ * @param expected_frames Pares previstos en la ventana
+ */
+void goertzel_pair_init(
+    goertzel_pair_t *pair,
+    const goertzel_coeffs_t *coeffs,
+    uint32_t expected_frames
+);
+
+/**
+ * @brief Consume un bloque de pares intercalados
+ * 
+ * @param pair Estado inicializado
+ * @param frames Códigos ADC, 2·num_frames (referencia primero)
+ * @param num_frames Número de pares del bloque (puede ser 0)
+ */
+void goertzel_pair_push(
+    goertzel_pair_t *pair,
+    const uint16_t *frames,
+    uint32_t num_frames
+);
+
+/**
+ * @brief Magnitud y fase de cada canal con lo consumido hasta el momento
+ * 
+ * @param pair Estado con al menos un par consumido
+ * @param reference Resultado del canal de referencia
+ * @param response Resultado del canal de respuesta
+ */
+void goertzel_pair_result(
+    const goertzel_pair_t *pair,
+    goertzel_result_t *reference,
+    goertzel_result_t *response
+);
+
+/**
+ * @brief Transferencia H = respuesta / referencia de un bin
+ * 
+ * La magnitud resulta adimensional (|H|, 0 dB = ganancia unitaria) y la
+ * fase es la diferencia entre canales más phase_offset_rad, acotada a
+ * [-pi, pi]. El offset corrige un desfase conocido entre canales, como el
+ * del muestreo round-robin (-2π·f·ADC_DMA_CHANNEL_SKEW_S).
+ * 
+ * @param reference Resultado del canal de referencia
+ * @param response Resultado del canal de respuesta
+ * @param phase_offset_rad Corrección de fase a sumar
+ * @param h Resultado de la transferencia (puede ser reference o response)
+ */
+void goertzel_transfer(
+    const goertzel_result_t *reference,
+    const goertzel_result_t *response,
+    float phase_offset_rad,
+    goertzel_result_t *h
+);
+
+/**
+ * @brief Ejecuta Goertzel para varias frecuencias en una sola pasada
+ * 
+ * Equivalente a llamar goertzel_compute() una vez por frecuencia, pero
+ * recorre el buffer una vez por cada grupo de GOERTZEL_BINS_PER_PASS bins
+ * actualizando todos los estados juntos por muestra. Útil para medir
+ * fundamental + armónicos (THD) o varios tonos simultáneos.
+ * 
+ * @param samples Buffer de muestras ADC (uint16_t, rango 0-4095)
+ * @param num_samples Número de muestras en el buffer
+ * @param freqs_hz Frecuencias objetivo (Hz), num_bins elementos
+ * @param num_bins Número de frecuencias a evaluar
+ * @param sample_rate_hz Frecuencia de muestreo del ADC
+ * @param results Arreglo de num_bins resultados, en el orden de freqs_hz
+ */
+void goertzel_compute_bins(
+    const uint16_t *samples,
+    uint16_t num_samples,
+    const float *freqs_hz,
+    size_t num_bins,
+    float sample_rate_hz,
+    goertzel_result_t *results
+);
+
+/**
+ * @brief Bins sin normalizar de varias frecuencias sobre pares intercalados
+ * 
+ * Da lo mismo que un goertzel_pair_t por bin seguido de
+ * goertzel_stream_bin() en cada canal, pero recorre la captura una vez por
+ * grupo de GOERTZEL_PAIR_BINS_PER_PASS bins y usa coeficientes ya
+ * calculados. Siempre con el kernel float. Es la detección de la
+ * excitación multitono (multitone.h): cada bloque del anillo deja el bin
+ * complejo de cada tono en los dos canales.
+ * 
+ * @param frames Códigos ADC, 2·num_frames (referencia primero)
+ * @param num_frames Número de pares
+ * @param coeffs Coeficientes de cada bin, num_bins elementos
+ * @param num_bins Número de bins
+ * @param reference Salida: 2·num_bins valores, (re, im) de cada bin de la referencia
+ * @param response Salida: ídem para la respuesta
+ */
+void goertzel_pair_bins(
+    const uint16_t *frames,
+    uint32_t num_frames,
+    const goertzel_coeffs_t *coeffs,
+    size_t num_bins,
+    float *reference,
+    float *response
+);
+
 /**
  * @brief Versión de testing con señal sintética
  * 
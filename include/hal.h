@@ -0,0 +1,352 @@
+/**
+ * @file hal.h
+ * @brief Capa de abstracción de hardware (HAL)
+ *
+ * Reúne las primitivas de hardware que usan los módulos del FRA (tiempo,
+ * GPIO de debug, SPI del AD9833, captura ADC+DMA y flash). El firmware las
+ * implementa sobre el Pico SDK en src/hal_pico.c; el target fra_host_sim
+ * las implementa en src/host/hal_host.c con un DDS, un ADC y un reloj
+ * simulados, de modo que sweep/Goertzel/MQTT compilan sin cambios en ambos.
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+// ============================================================================
+// TIEMPO
+// ============================================================================
+
+/**
+ * @brief Tiempo monotónico desde el arranque en milisegundos
+ */
+uint32_t hal_time_ms(void);
+
+/**
+ * @brief Tiempo monotónico desde el arranque en microsegundos
+ */
+uint64_t hal_time_us(void);
+
+/**
+ * @brief Espera bloqueante en milisegundos
+ *
+ * En el simulador no duerme: avanza el reloj virtual.
+ */
+void hal_sleep_ms(uint32_t ms);
+
+/**
+ * @brief Espera bloqueante en microsegundos
+ */
+void hal_sleep_us(uint64_t us);
+
+/**
+ * @brief Duerme el núcleo hasta un evento o hasta deadline_us (hal_time_us())
+ *
+ * En el firmware es WFE con alarma de respaldo: vuelve antes con cualquier
+ * interrupción o evento, así que el llamador debe volver a consultar qué
+ * terminó. En el simulador avanza el reloj virtual hasta deadline_us.
+ */
+void hal_wait_event_until_us(uint64_t deadline_us);
+
+// ============================================================================
+// CONTADOR DE CICLOS (TRAZA)
+// ============================================================================
+
+/**
+ * @brief Habilita el contador de alta resolución en el núcleo actual
+ *
+ * En el firmware es el CYCCNT del DWT del Cortex-M33, que es propio de
+ * cada núcleo: el core 1 lo habilita al arrancar cada trabajo de
+ * hal_core1_launch(). En el simulador es clock_gettime(CLOCK_MONOTONIC),
+ * tiempo real del host y no el reloj virtual.
+ */
+void hal_cycle_counter_init(void);
+
+/**
+ * @brief Lectura del contador del núcleo actual
+ *
+ * Da la vuelta (cada ~28 s a 150 MHz, ~4 s en el simulador): las
+ * duraciones se calculan restando lecturas en uint32_t.
+ */
+uint32_t hal_cycle_counter(void);
+
+/**
+ * @brief Cuentas del contador por microsegundo
+ */
+uint32_t hal_cycle_counter_per_us(void);
+
+// ============================================================================
+// SECCIÓN CRÍTICA
+// ============================================================================
+
+/**
+ * @brief Entra a la sección crítica compartida con las IRQ de DMA
+ *
+ * Excluye tanto a la otra CPU como a las interrupciones del núcleo
+ * actual. No es reentrante; mantenerla solo unos pocos ciclos.
+ */
+void hal_critical_enter(void);
+
+/**
+ * @brief Sale de la sección crítica
+ */
+void hal_critical_exit(void);
+
+// ============================================================================
+// SEGUNDO NÚCLEO
+// ============================================================================
+
+/**
+ * @brief Ejecuta entry en el core 1 (en el simulador, en un hilo aparte)
+ *
+ * Solo puede haber un trabajo en el core 1 a la vez.
+ *
+ * @param entry Función a ejecutar; el trabajo termina cuando retorna
+ * @return true si el trabajo arrancó, false en caso contrario
+ */
+bool hal_core1_launch(void (*entry)(void));
+
+/**
+ * @brief Espera a que retorne la función lanzada con hal_core1_launch()
+ */
+void hal_core1_join(void);
+
+/**
+ * @brief Pausa breve dentro de una espera activa entre núcleos
+ */
+void hal_cpu_relax(void);
+
+// ============================================================================
+// GPIO DE DEBUG
+// ============================================================================
+
+/**
+ * @brief Escribe un pin de instrumentación (DEBUG_PIN_*)
+ *
+ * @param pin Número de GPIO
+ * @param value Nivel a escribir
+ */
+void hal_debug_pin_put(uint32_t pin, bool value);
+
+// ============================================================================
+// SPI (AD9833)
+// ============================================================================
+
+/**
+ * @brief Inicializa el SPI y el pin CS del AD9833
+ *
+ * Modo 2 (CPOL=1, CPHA=0), palabras de 16 bits, MSB primero.
+ *
+ * @return true si la inicialización fue exitosa, false en caso contrario
+ */
+bool hal_spi_init(void);
+
+/**
+ * @brief Escribe una palabra de 16 bits con CS (FSYNC) activo
+ *
+ * Bloquea hasta que la palabra salió completa por el bus. Si hay un envío
+ * asíncrono en curso, primero espera a que termine.
+ *
+ * @param word Palabra a transmitir
+ */
+void hal_spi_write16(uint16_t word);
+
+/**
+ * @brief Aviso de fin de un envío asíncrono
+ *
+ * En el firmware se invoca desde la IRQ de DMA cuando la última palabra
+ * entró al FIFO TX (puede seguir saliendo por el bus; hal_spi_wait()
+ * espera también eso). En el simulador se invoca en la primera consulta
+ * al SPI posterior al instante de fin.
+ *
+ * @param ctx Contexto pasado a hal_spi_write16_async()
+ */
+typedef void (*hal_spi_done_cb_t)(void *ctx);
+
+/**
+ * @brief Envía un bloque de palabras por DMA sin bloquear al CPU
+ *
+ * Cada palabra sale con su propio pulso de FSYNC. El bloque debe seguir
+ * vivo hasta el aviso de fin.
+ *
+ * @param words Palabras a transmitir
+ * @param count Número de palabras
+ * @param done Callback de fin (puede ser NULL)
+ * @param ctx Contexto para done
+ * @return true si el envío arrancó, false si había otro en curso
+ */
+bool hal_spi_write16_async(const uint16_t *words, uint32_t count,
+                           hal_spi_done_cb_t done, void *ctx);
+
+/**
+ * @brief Indica si queda un envío asíncrono en el DMA o en el bus
+ * @return true si el SPI está ocupado
+ */
+bool hal_spi_is_busy(void);
+
+/**
+ * @brief Espera a que la última palabra enviada salga completa por el bus
+ */
+void hal_spi_wait(void);
+
+// ============================================================================
+// ADC + DMA
+// ============================================================================
+
+// Conversiones por segundo: con ADC_CHANNELS canales en round-robin cada
+// canal sigue muestreado a SAMPLE_RATE
+#define HAL_ADC_CONVERSION_RATE (SAMPLE_RATE * ADC_CHANNELS)
+
+/**
+ * @brief Configura el ADC a HAL_ADC_CONVERSION_RATE con FIFO y canal DMA
+ *
+ * Con ADC_CHANNELS = 2 habilita el round-robin entre ADC_PIN_REFERENCE y
+ * ADC_PIN_RESPONSE; con 1 convierte solo ADC_PIN_RESPONSE.
+ *
+ * @return true si la inicialización fue exitosa, false en caso contrario
+ */
+bool hal_adc_init(void);
+
+/**
+ * @brief Lanza la captura de num_samples conversiones hacia dst
+ *
+ * La captura empieza siempre por el primer canal: con dos canales, dst
+ * queda intercalado referencia, respuesta, referencia... Retorna
+ * inmediatamente; el DMA escribe en dst en segundo plano. Las cantidades
+ * de muestras de esta sección cuentan conversiones (códigos en memoria).
+ *
+ * @param dst Buffer destino (debe vivir hasta que termine la captura)
+ * @param num_samples Número de conversiones a capturar
+ */
+void hal_adc_start(uint16_t *dst, uint32_t num_samples);
+
+/**
+ * @brief Lanza una captura que sigue a la anterior sin perder conversiones
+ *
+ * A diferencia de hal_adc_start() no detiene el ADC: la primera conversión
+ * de dst es la siguiente a la última de la captura anterior, y el
+ * round-robin sigue alineado. Hay que llamarla cuando la anterior completó
+ * (hal_adc_samples_done() igual al largo) y sin pasar por hal_adc_wait(),
+ * que detiene el ADC; entre las dos, la FIFO del ADC absorbe unas pocas
+ * conversiones.
+ *
+ * @param dst Buffer destino (debe vivir hasta que termine la captura)
+ * @param num_samples Número de conversiones a capturar
+ * @return false si la FIFO desbordó antes del rearme (no se captura nada)
+ */
+bool hal_adc_continue(uint16_t *dst, uint32_t num_samples);
+
+/**
+ * @brief Indica si la captura lanzada sigue en curso
+ * @return true si el DMA está activo, false si completó
+ */
+bool hal_adc_is_busy(void);
+
+/**
+ * @brief Número de muestras de la captura en curso ya escritas en memoria
+ * 
+ * Permite procesar la ventana por bloques mientras el DMA sigue llenándola.
+ * 
+ * @return Muestras disponibles desde el inicio del buffer destino
+ */
+uint32_t hal_adc_samples_done(void);
+
+/**
+ * @brief Espera bloqueante hasta que la captura en curso termine
+ */
+void hal_adc_wait(void);
+
+/**
+ * @brief Corta la captura en curso
+ *
+ * Las muestras ya escritas (hal_adc_samples_done()) siguen siendo válidas.
+ */
+void hal_adc_abort(void);
+
+/**
+ * @brief Callback de bloque completo en captura continua
+ *
+ * Se invoca en contexto de interrupción cada vez que un canal DMA termina
+ * de llenar un buffer. Debe retornar el buffer donde ese mismo canal
+ * escribirá su próximo bloque.
+ *
+ * @param filled Buffer recién completado
+ * @return Próximo buffer destino para el canal
+ */
+typedef uint16_t *(*hal_adc_block_cb_t)(uint16_t *filled);
+
+/**
+ * @brief Inicia captura continua con dos canales DMA encadenados
+ *
+ * El canal A llena first, al terminar dispara al canal B que llena second
+ * y viceversa, sin huecos entre bloques. Cada finalización invoca on_block
+ * para rearmar el canal que terminó.
+ *
+ * @param first Primer buffer destino (canal A)
+ * @param second Segundo buffer destino (canal B)
+ * @param num_samples Muestras por bloque
+ * @param on_block Callback de bloque completo
+ * @return true si la captura arrancó, false en caso contrario
+ */
+bool hal_adc_stream_start(uint16_t *first, uint16_t *second, uint32_t num_samples,
+                          hal_adc_block_cb_t on_block);
+
+/**
+ * @brief Detiene la captura continua y libera los canales
+ */
+void hal_adc_stream_stop(void);
+
+// ============================================================================
+// FLASH (ALMACÉN DE BARRIDOS)
+// ============================================================================
+
+// Geometría de la flash NOR: se borra por sector y se programa por página
+#define HAL_FLASH_SECTOR_SIZE 4096u
+#define HAL_FLASH_PAGE_SIZE 256u
+
+// Tamaño de la región reservada (SWEEP_STORE_SECTORS sectores)
+#define HAL_FLASH_REGION_SIZE (SWEEP_STORE_SECTORS * HAL_FLASH_SECTOR_SIZE)
+
+/**
+ * @brief Lee de la región reservada
+ *
+ * @param offset Offset dentro de la región
+ * @param dst Buffer destino
+ * @param len Bytes a leer
+ * @return true si el rango está dentro de la región
+ */
+bool hal_flash_read(uint32_t offset, void *dst, uint32_t len);
+
+/**
+ * @brief Borra un sector de la región (todos sus bytes quedan en 0xFF)
+ *
+ * Bloquea mientras dura el borrado (decenas de ms) y, en el firmware, con
+ * las interrupciones deshabilitadas y el core 1 detenido: llamarla solo
+ * fuera del barrido. El core 1 se detiene solo si corre un trabajo de
+ * hal_core1_launch(); cualquier otro código en ese núcleo tiene que estar
+ * fuera de la flash.
+ *
+ * @param offset Offset del sector, múltiplo de HAL_FLASH_SECTOR_SIZE
+ * @return true si el borrado se completó
+ */
+bool hal_flash_erase(uint32_t offset);
+
+/**
+ * @brief Programa páginas completas de la región
+ *
+ * Programar solo puede bajar bits de 1 a 0: los bytes en 0xFF dejan el
+ * contenido previo intacto, así una página ya escrita admite que se le
+ * agreguen datos en la parte todavía borrada. Mismas restricciones de
+ * contexto que hal_flash_erase().
+ *
+ * @param offset Offset de la primera página, múltiplo de HAL_FLASH_PAGE_SIZE
+ * @param src Datos a programar
+ * @param len Bytes, múltiplo de HAL_FLASH_PAGE_SIZE
+ * @return true si la programación se completó
+ */
+bool hal_flash_program(uint32_t offset, const void *src, uint32_t len);
+
+#endif // HAL_H
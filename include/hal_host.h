@@ -0,0 +1,66 @@
+/**
+ * @file hal_host.h
+ * @brief Extensiones de la HAL disponibles solo en el simulador nativo
+ */
+
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sim_dut.h"
+
+/**
+ * @brief Escala de tiempo del motor DMA simulado en captura continua
+ *
+ * 1.0 entrega bloques a ritmo real (WINDOW_SIZE / SAMPLE_RATE), 10.0 diez
+ * veces más rápido y 0 sin espera (tan rápido como se pueda sintetizar).
+ * Debe configurarse antes de hal_adc_stream_start().
+ *
+ * @param speedup Factor de aceleración respecto del tiempo real
+ */
+void hal_host_set_stream_speedup(double speedup);
+
+/**
+ * @brief Cambia el DUT simulado con la captura continua en marcha
+ *
+ * Como sim_dut_configure(), pero excluido del hilo DMA: los bloques ya
+ * sintetizados quedan con el DUT anterior y los siguientes salen con el
+ * nuevo. Sirve para simular una deriva durante el modo monitor.
+ *
+ * @param cfg Configuración a aplicar
+ */
+void hal_host_configure_dut(const sim_dut_config_t *cfg);
+
+/**
+ * @brief Respalda la región de flash con un archivo
+ *
+ * Crea el archivo (borrado, todo 0xFF) si no existe o es más corto que la
+ * región; cada borrado o programación se escribe en él al momento. Volver
+ * a abrirlo equivale a un reinicio: levanta el corte de energía pendiente.
+ * Sin llamarla, la flash vive solo en memoria.
+ *
+ * @param path Ruta del archivo, NULL para volver a la flash en memoria
+ * @return true si el archivo se pudo abrir
+ */
+bool hal_host_flash_open(const char *path);
+
+/**
+ * @brief Programa un corte de energía durante una escritura de flash
+ *
+ * Tras budget_bytes bytes más borrados o programados, la operación en
+ * curso queda a medias y todas las siguientes fallan hasta el próximo
+ * hal_host_flash_open().
+ *
+ * @param budget_bytes Bytes que todavía se escriben completos
+ */
+void hal_host_flash_power_cut(uint32_t budget_bytes);
+
+/**
+ * @brief Borrados de un sector desde el arranque del proceso
+ *
+ * @param sector Índice del sector dentro de la región
+ */
+uint32_t hal_host_flash_erase_count(uint32_t sector);
+
+#endif // HAL_HOST_H
@@ -0,0 +1,109 @@
+/**
+ * @file json_reader.h
+ * @brief Lector JSON sin heap para los comandos que llegan por MQTT
+ *
+ * Recorre el payload en orden sin armar un árbol: quien llama pide lo que
+ * espera (objeto, clave, número, string...) y el lector lo consume o marca
+ * error. Acepta solo la gramática estricta de RFC 8259. Nunca lee fuera
+ * de [buf, buf + len), así el payload no necesita terminador, y nunca
+ * reserva memoria: los strings se copian a buffers del llamador con
+ * tamaño explícito. json_reader_skip() descarta valores desconocidos con
+ * el anidamiento limitado a JSON_READER_MAX_DEPTH.
+ *
+ * Después del primer error todas las llamadas fallan; alcanza con revisar
+ * json_reader_end() al final.
+ */
+
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Anidamiento máximo que atraviesa json_reader_skip()
+#define JSON_READER_MAX_DEPTH 8
+
+/**
+ * @brief Estado del lector
+ */
+typedef struct {
+    const char *buf;            ///< Payload
+    size_t len;                 ///< Bytes del payload
+    size_t pos;                 ///< Próximo byte a leer
+    bool error;                 ///< Payload inválido o fuera de lo esperado
+    bool opened;                ///< Recién se abrió un objeto o arreglo
+} json_reader_t;
+
+/**
+ * @brief Prepara el lector sobre buf
+ */
+void json_reader_init(json_reader_t *r, const char *buf, size_t len);
+
+/**
+ * @brief Consume '{'
+ */
+bool json_reader_begin_object(json_reader_t *r);
+
+/**
+ * @brief Lee la clave siguiente del objeto abierto
+ *
+ * @param r Lector
+ * @param key Destino de la clave (con terminador)
+ * @param capacity Tamaño de key; una clave más larga es error
+ * @return true con una clave lista para leer su valor, false al cerrar el
+ *         objeto (consume '}') o ante un error
+ */
+bool json_reader_next_key(json_reader_t *r, char *key, size_t capacity);
+
+/**
+ * @brief Consume '['
+ */
+bool json_reader_begin_array(json_reader_t *r);
+
+/**
+ * @brief Avanza al elemento siguiente del arreglo abierto
+ *
+ * @return true con un elemento listo para leer, false al cerrar el
+ *         arreglo (consume ']') o ante un error
+ */
+bool json_reader_next_element(json_reader_t *r);
+
+/**
+ * @brief Lee un string (con escapes, \\u incluido, a UTF-8)
+ *
+ * @param r Lector
+ * @param out Destino (con terminador)
+ * @param capacity Tamaño de out; un string más largo es error
+ */
+bool json_reader_string(json_reader_t *r, char *out, size_t capacity);
+
+/**
+ * @brief Lee un número; fuera del rango de float es error
+ */
+bool json_reader_float(json_reader_t *r, float *value);
+
+/**
+ * @brief Lee un número entero entre 0 y UINT32_MAX (sin fracción ni
+ *        exponente)
+ */
+bool json_reader_uint(json_reader_t *r, uint32_t *value);
+
+/**
+ * @brief Lee true o false
+ */
+bool json_reader_bool(json_reader_t *r, bool *value);
+
+/**
+ * @brief Descarta el valor siguiente, sea cual sea
+ */
+bool json_reader_skip(json_reader_t *r);
+
+/**
+ * @brief Verifica que después del documento solo quede espacio en blanco
+ *
+ * @return true si todo el payload fue JSON válido y leído sin errores
+ */
+bool json_reader_end(json_reader_t *r);
+
+#endif // JSON_READER_H
@@ -0,0 +1,126 @@
+/**
+ * @file json_writer.h
+ * @brief Serializador JSON sin heap para los payloads de medición y estado
+ *
+ * Escribe sobre un buffer del llamador y nunca reserva memoria. Los números
+ * se formatean en punto fijo con aritmética entera (parte entera y
+ * fracción escalada a 10^decimales), sin pasar por el printf de punto
+ * flotante de newlib. Los valores no finitos se emiten como null, ya que
+ * JSON no admite NaN ni infinito.
+ *
+ * Si el buffer no alcanza, el escritor deja de escribir y
+ * json_writer_finish() retorna 0; el contenido parcial no debe usarse.
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Decimales del esquema de medición (los mismos que el formato anterior)
+#define JSON_FREQ_DECIMALS 1
+#define JSON_MAG_DECIMALS 2
+#define JSON_PHASE_DECIMALS 1
+
+// Máximo de decimales admitido por json_writer_fixed()
+#define JSON_MAX_DECIMALS 6
+
+/**
+ * @brief Estado del escritor
+ */
+typedef struct {
+    char *buf;                  ///< Buffer destino
+    size_t capacity;            ///< Tamaño de buf (incluye el terminador)
+    size_t len;                 ///< Bytes escritos
+    bool overflow;              ///< No alcanzó el buffer
+    bool need_comma;            ///< El próximo elemento lleva separador
+} json_writer_t;
+
+/**
+ * @brief Punto de medición del esquema
+ */
+typedef struct {
+    float frequency_hz;
+    float magnitude_db;
+    float phase_deg;
+} json_point_t;
+
+/**
+ * @brief Prepara el escritor sobre buf
+ *
+ * @param w Escritor
+ * @param buf Buffer destino
+ * @param capacity Tamaño de buf en bytes (se reserva uno para '\0')
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t capacity);
+
+void json_writer_begin_object(json_writer_t *w);
+void json_writer_end_object(json_writer_t *w);
+void json_writer_begin_array(json_writer_t *w);
+void json_writer_end_array(json_writer_t *w);
+
+/**
+ * @brief Escribe una clave de objeto (sin escapar: debe ser ASCII simple)
+ */
+void json_writer_key(json_writer_t *w, const char *key);
+
+/**
+ * @brief Escribe un número con decimals cifras decimales
+ *
+ * Redondea al más cercano (mitades hacia afuera del cero). Un valor que
+ * redondea a cero se escribe sin signo. Valores no finitos o con parte
+ * entera mayor que UINT32_MAX se escriben como null.
+ *
+ * @param w Escritor
+ * @param value Valor
+ * @param decimals Cifras decimales (0 a JSON_MAX_DECIMALS)
+ */
+void json_writer_fixed(json_writer_t *w, float value, uint8_t decimals);
+
+/**
+ * @brief Escribe un entero sin signo
+ */
+void json_writer_uint(json_writer_t *w, uint32_t value);
+
+/**
+ * @brief Escribe true o false
+ */
+void json_writer_bool(json_writer_t *w, bool value);
+
+/**
+ * @brief Escribe un string con escapes JSON (comillas, barra invertida y
+ *        caracteres de control); los bytes UTF-8 pasan sin cambios
+ */
+void json_writer_string(json_writer_t *w, const char *str);
+
+/**
+ * @brief Termina el payload con '\0'
+ *
+ * @return Largo del payload sin el terminador, 0 si no alcanzó el buffer
+ */
+size_t json_writer_finish(json_writer_t *w);
+
+/**
+ * @brief {"freq":1000.0,"mag":-3.45,"phase":-87.3}
+ *
+ * @return Largo escrito, 0 si no alcanzó el buffer
+ */
+size_t json_format_measurement(char *buf, size_t capacity, const json_point_t *point);
+
+/**
+ * @brief Arreglo de puntos en un solo payload: [{...},{...}]
+ *
+ * @return Largo escrito, 0 si no alcanzó el buffer
+ */
+size_t json_format_points(char *buf, size_t capacity, const json_point_t *points, uint16_t count);
+
+/**
+ * @brief {"status":"..."}
+ *
+ * @return Largo escrito, 0 si no alcanzó el buffer
+ */
+size_t json_format_status(char *buf, size_t capacity, const char *status);
+
+#endif // JSON_WRITER_H
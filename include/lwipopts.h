@@ -53,6 +53,11 @@
 // --- DHCP ---
 #define LWIP_DHCP_CHECK_LINK_UP     1
 
+// --- MQTT ---
+// Una trama de barrido completo (200 puntos) ocupa 824 bytes más el topic;
+// el valor por defecto de lwIP (256) no alcanza
+#define MQTT_OUTPUT_RINGBUF_SIZE    2048
+
 // --- Estadísticas y debug (deshabilitado para producción) ---
 #define LWIP_STATS                  0
 #define LWIP_STATS_DISPLAY          0
@@ -0,0 +1,147 @@
+/**
+ * @file monitor.h
+ * @brief Modo monitor: seguimiento continuo de una frecuencia fija
+ *
+ * Deja el AD9833 en un tono fijo y mide H = respuesta/referencia sobre la
+ * captura continua del DMA (adc_dma_start_continuous()), sin huecos entre
+ * ventanas: sirve para seguir, por ejemplo, la deriva de un corte con la
+ * temperatura a decenas o cientos de actualizaciones por segundo.
+ *
+ * Cada bloque del anillo (WINDOW_SIZE instantes) pasa una vez por
+ * Goertzel y deja su bin complejo. La ventana de medición son los últimos
+ * window_blocks bloques: el tono se corrige a la frecuencia coherente con
+ * esa ventana completa y el bin de cada bloque se rota a una referencia
+ * común (e^{-j·2π·m·k/K}, periódica en K, sin acumular error), así la suma
+ * es exactamente la DFT de la ventana larga. Cada hop_blocks bloques sale
+ * una actualización: hop = window da ventanas contiguas (back-to-back),
+ * hop < window ventanas deslizantes que se solapan.
+ *
+ * Las actualizaciones se juntan de a batch por mensaje en MQTT_TOPIC_MONITOR:
+ *
+ *   {"freq":1000.0,"rate":100.0,"window":4,"hop":1,"block":812,
+ *    "mag_db":[-3.01,-3.01,...],"phase_deg":[-45.0,-45.0,...]}
+ *
+ * "block" es el último bloque de la primera actualización; las siguientes
+ * del mensaje están hop bloques más adelante cada una. Si el anillo pierde
+ * bloques (overrun) la ventana vuelve a llenarse desde cero y el mensaje
+ * en curso sale antes, así ninguna ventana publicada cruza un hueco y el
+ * receptor lo ve como un salto de "block".
+ *
+ * Comparte el ADC con el barrido: no arranca con un trabajo del motor en
+ * curso, y mientras el monitor está activo no hay que arrancar barridos.
+ */
+
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "config.h"
+
+// Tamaño máximo de un mensaje en JSON (monitor_format_json())
+#define MONITOR_JSON_MAX 640
+
+/**
+ * @brief Parámetros del monitor
+ */
+typedef struct {
+    float freq_hz;              ///< Tono pedido (se corrige al coherente)
+    uint8_t window_blocks;      ///< K: bloques por ventana (1 a MONITOR_WINDOW_BLOCKS_MAX)
+    uint8_t hop_blocks;         ///< Bloques entre actualizaciones (1 a K)
+    uint8_t batch;              ///< Actualizaciones por mensaje (1 a MONITOR_BATCH_MAX)
+} monitor_spec_t;
+
+/**
+ * @brief Actualizaciones consecutivas de un mensaje
+ */
+typedef struct {
+    float freq_hz;              ///< Frecuencia coherente medida
+    float update_hz;            ///< Actualizaciones por segundo
+    uint8_t window_blocks;
+    uint8_t hop_blocks;
+    uint32_t block;             ///< Último bloque de la primera actualización
+    uint8_t count;              ///< Actualizaciones cargadas
+    float magnitude_db[MONITOR_BATCH_MAX];
+    float phase_deg[MONITOR_BATCH_MAX];
+} monitor_batch_t;
+
+/**
+ * @brief Contadores desde monitor_start()
+ */
+typedef struct {
+    uint32_t blocks;            ///< Bloques del DMA procesados
+    uint32_t settle_blocks;     ///< Bloques descartados mientras asienta el DUT
+    uint32_t updates;           ///< Actualizaciones calculadas
+    uint32_t messages;          ///< Mensajes encolados
+    uint32_t publish_failures;  ///< Mensajes que no entraron en la cola
+    uint32_t gaps;              ///< Huecos en la secuencia del DMA
+    uint32_t blocks_lost;       ///< Bloques perdidos en esos huecos
+} monitor_stats_t;
+
+/**
+ * @brief Parámetros de config.h (MONITOR_*)
+ */
+void monitor_default_spec(monitor_spec_t *spec);
+
+/**
+ * @brief Valida un pedido y calcula la frecuencia coherente que mediría
+ *
+ * @param spec Parámetros pedidos
+ * @param freq_hz Salida opcional: frecuencia coherente
+ * @return false si algún campo está fuera de rango o el tono no tiene un
+ *         bin coherente entre DC y Nyquist
+ */
+bool monitor_check_spec(const monitor_spec_t *spec, float *freq_hz);
+
+/**
+ * @brief Programa el tono y arranca la captura continua
+ *
+ * Con el monitor ya activo lo reinicia con los parámetros nuevos. Los
+ * primeros bloques, hasta la cota de asentamiento de settle.h para el
+ * tono, se descartan.
+ *
+ * @return false si el pedido no es válido, hay un trabajo del barrido en
+ *         curso o la captura no arranca (el monitor queda detenido)
+ */
+bool monitor_start(const monitor_spec_t *spec);
+
+/**
+ * @brief Publica el mensaje a medio llenar y detiene la captura continua
+ */
+void monitor_stop(void);
+
+/**
+ * @brief Indica si el monitor está activo
+ */
+bool monitor_active(void);
+
+/**
+ * @brief Procesa los bloques que ya completó el DMA y publica los
+ *        mensajes que se completan
+ *
+ * Desde el loop principal, sin esperar: los bloques que todavía no
+ * llegaron quedan para la próxima llamada.
+ *
+ * @return Bloques procesados
+ */
+uint32_t monitor_poll(void);
+
+/**
+ * @brief Parámetros vigentes (los del último monitor_start() aceptado)
+ */
+void monitor_get_spec(monitor_spec_t *spec);
+
+/**
+ * @brief Copia los contadores
+ */
+void monitor_get_stats(monitor_stats_t *stats);
+
+/**
+ * @brief Serializa un mensaje para MQTT_TOPIC_MONITOR
+ *
+ * @return Largo escrito, 0 si no alcanzó el buffer
+ */
+size_t monitor_format_json(const monitor_batch_t *batch, char *buf, size_t capacity);
+
+#endif // MONITOR_H
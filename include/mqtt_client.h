@@ -3,7 +3,9 @@
  * @brief Módulo de cliente MQTT para transmisión de datos
  * 
  * Implementa cliente MQTT sobre lwIP para transmisión inalámbrica
- * de mediciones al servidor de visualización.
+ * de mediciones al servidor de visualización. Publicar solo encola el
+ * mensaje serializado (publish_queue.h); la red lo envía desde
+ * mqtt_client_poll().
  */
 
 #ifndef MQTT_CLIENT_H
@@ -11,6 +13,12 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "sweep_frame.h"
+#include "publish_queue.h"
+#include "trace.h"
+#include "command.h"
+#include "monitor.h"
+#include "multitone.h"
 
 /**
  * @brief Estructura de configuración MQTT
@@ -33,13 +41,14 @@ bool mqtt_init(const mqtt_config_t *config);
 /**
  * @brief Publica una medición en formato JSON
  * 
- * Serializa los datos de medición a JSON y los publica en el topic configurado.
+ * Serializa los datos de medición a JSON (json_writer.h, sin heap ni printf
+ * de floats) directo en un slot de la cola para el topic configurado.
  * Formato: {"freq":1000.0,"mag":-3.45,"phase":-87.3}
  * 
  * @param frequency_hz Frecuencia medida (Hz)
  * @param magnitude_db Magnitud en dB
  * @param phase_deg Fase en grados
- * @return true si la publicación fue exitosa, false en caso contrario
+ * @return true si el mensaje quedó encolado, false si se rechazó
  */
 bool mqtt_publish_measurement(
     float frequency_hz,
@@ -47,14 +56,110 @@ bool mqtt_publish_measurement(
     float phase_deg
 );
 
+/**
+ * @brief Publica una trama binaria de barrido en MQTT_TOPIC_SWEEP
+ * 
+ * Un solo mensaje por barrido (o por tramo de SWEEP_FRAME_POINTS puntos)
+ * en lugar de un JSON por frecuencia.
+ * 
+ * @param frame Trama a serializar y publicar
+ * @return true si el mensaje quedó encolado, false si se rechazó
+ */
+bool mqtt_publish_sweep_frame(const sweep_frame_t *frame);
+
 /**
  * @brief Publica mensaje de estado del sistema
  * 
+ * Formato: {"status":"sweep_complete"} (el mensaje se escapa como string
+ * JSON).
+ * 
  * @param status_msg Mensaje de estado a publicar
- * @return true si la publicación fue exitosa, false en caso contrario
+ * @return true si el mensaje quedó encolado, false si se rechazó
  */
 bool mqtt_publish_status(const char *status_msg);
 
+/**
+ * @brief Publica el reporte de la traza de etapas en MQTT_TOPIC_TRACE
+ * 
+ * Formato: ver trace_format_json().
+ * 
+ * @param report Reporte de trace_report()
+ * @return true si el mensaje quedó encolado, false si se rechazó
+ */
+bool mqtt_publish_trace(const trace_report_t *report);
+
+/**
+ * @brief Publica la confirmación de un comando en MQTT_TOPIC_STATUS
+ * 
+ * Formato: ver command_format_ack().
+ * 
+ * @param ack Confirmación de command_poll()
+ * @return true si el mensaje quedó encolado, false si se rechazó
+ */
+bool mqtt_publish_command_ack(const command_ack_t *ack);
+
+/**
+ * @brief Publica un mensaje del modo monitor en MQTT_TOPIC_MONITOR
+ * 
+ * Formato: ver monitor_format_json().
+ * 
+ * @param batch Actualizaciones consecutivas de monitor_poll()
+ * @return true si el mensaje quedó encolado, false si se rechazó
+ */
+bool mqtt_publish_monitor(const monitor_batch_t *batch);
+
+/**
+ * @brief Publica el detalle de una medición multitono en MQTT_TOPIC_MULTITONE
+ * 
+ * Formato: ver multitone_format_json().
+ * 
+ * @param plan Multiseno medida
+ * @param result Resultado de multitone_measure()
+ * @param sweep_id Número de la trama con la respuesta
+ * @return true si el mensaje quedó encolado, false si se rechazó
+ */
+bool mqtt_publish_multitone(const multitone_plan_t *plan, const multitone_result_t *result,
+                            uint32_t sweep_id);
+
+/**
+ * @brief Entrega un mensaje recibido del broker
+ * 
+ * Lo llama el callback de datos entrantes (contexto de red) con el
+ * payload completo. MQTT_TOPIC_COMMAND va a la bandeja de comandos
+ * (command_deliver()); el resto se ignora.
+ * 
+ * @param topic Topic del mensaje
+ * @param payload Payload (sin terminador)
+ * @param len Bytes del payload
+ * @return true si el mensaje quedó en la bandeja
+ */
+bool mqtt_client_incoming(const char *topic, const uint8_t *payload, size_t len);
+
+/**
+ * @brief Drena la cola de publicación hacia el broker
+ * 
+ * Se llama desde el contexto de red (en el firmware, un worker periódico
+ * del async_context de cyw43). Sin conexión no envía nada y los mensajes
+ * esperan en la cola.
+ * 
+ * @param max_messages Máximo de mensajes a enviar en esta pasada
+ * @return Mensajes enviados
+ */
+uint32_t mqtt_client_poll(uint32_t max_messages);
+
+/**
+ * @brief Reenvía los barridos guardados en flash (sweep_store.h)
+ * 
+ * Con conexión, encola el registro pendiente más antiguo en
+ * MQTT_TOPIC_SWEEP y, cuando la red confirma su entrega, lo marca como
+ * entregado en la flash; de a un registro en vuelo, así el reenvío
+ * respeta el orden de guardado. Toca la flash: llamarla desde el hilo
+ * principal entre barridos, nunca desde el contexto de red.
+ * 
+ * @return Barridos que siguen pendientes en la flash
+ */
+uint32_t mqtt_client_replay(void);
+
 /**
  * @brief Verifica si el cliente está conectado al broker
  * @return true si está conectado, false en caso contrario
@@ -0,0 +1,186 @@
+/**
+ * @file multitone.h
+ * @brief Excitación multitono: todos los puntos del barrido en una medición
+ *
+ * En lugar de recorrer la grilla tono a tono (programar, asentar, capturar
+ * cada punto), la entrada del DUT recibe la suma de todos los tonos y cada
+ * bloque de la captura continua (adc_dma_start_continuous()) se analiza en
+ * todos los bines a la vez. El asentamiento se paga una sola vez.
+ *
+ * Plan (multitone_plan_build()): la multiseno es periódica en
+ * N = period_blocks·WINDOW_SIZE muestras, así que cada tono se corrige a
+ * un bin m_i·fs/N (los que caen en el mismo bin que el anterior se
+ * descartan, como en sweep_plan.h). Las fases arrancan de Schroeder, que
+ * reparte la energía en el tiempo como un chirp (con bines consecutivos,
+ * φ_i = -π·i·(i+1)/K), y se refinan por descenso de gradiente sobre la
+ * norma L16 de un período sintetizado, que sigue de cerca al pico. El
+ * factor de cresta de la señal reconstruida queda en 1.6 a 1.7 con bines
+ * equiespaciados y 2.3 a 2.9 con grillas logarítmicas, contra √(2K) con
+ * fases iguales. La amplitud
+ * por tono sale de repartir el pico admitido, buscado también entre
+ * muestras porque el generador reconstruye una señal continua: cada tono
+ * queda 20·log10(pico de la suma unitaria) dB (tone_db) por debajo de un
+ * tono solo con el mismo pico, y la SNR por bin baja en esa cantidad
+ * frente al barrido tono a tono a igual tiempo de integración.
+ *
+ * Detección (multitone_measure()): el AD9833 da un solo tono, así que la
+ * multiseno la aplica un generador externo (AWG) cargado con
+ * multitone_excitation(); la referencia la mide en la entrada del DUT igual
+ * que al DDS, sin sincronismo con el ADC. Cada bloque pasa por
+ * goertzel_pair_bins(), o por fft_pair_bins() si todos los tonos caen en
+ * bines exactos del bloque (WINDOW_SIZE potencia de dos y m_i múltiplo de
+ * B) y son más que el cruce de fft_crossover_bins(); el bin de cada tono
+ * se rota a la referencia del
+ * período (e^{-j·2π·m_i·(k mod B)/B}, como el monitor): B bloques seguidos
+ * dan la DFT exacta de un período, sin fuga entre tonos. De cada período
+ * sale H_p = Y/X por tono; los períodos se promedian (sweep_average.h) y la
+ * dispersión entre ellos da la SNR de cada bin. Un hueco del anillo
+ * descarta el período incompleto.
+ *
+ * El resultado sale como una trama con lista de frecuencias por
+ * MQTT_TOPIC_SWEEP (como el adaptativo) y el detalle de la excitación en
+ * JSON por MQTT_TOPIC_MULTITONE:
+ *
+ *   {"id":12,"tones":39,"period":4,"periods":8,"crest":2.28,
+ *    "tone_db":-20.1,"snr_db":[61.2,60.8,...]}
+ */
+
+#ifndef MULTITONE_H
+#define MULTITONE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "config.h"
+#include "fft.h"
+#include "goertzel.h"
+#include "sweep_plan.h"
+
+// Tamaño máximo del JSON de una medición (multitone_format_json())
+#define MULTITONE_JSON_MAX (128 + 6 * MULTITONE_TONES_MAX)
+
+// Rango publicado de la SNR por bin (dB); fuera de él se recorta
+#define MULTITONE_SNR_MIN_DB -99.9f
+#define MULTITONE_SNR_MAX_DB 199.9f
+
+/**
+ * @brief Pedido de la excitación
+ */
+typedef struct {
+    sweep_grid_t grid;          ///< Forma de la grilla de tonos
+    float start_hz;             ///< Primer tono (LINEAR, LOG)
+    float stop_hz;              ///< Último tono (LINEAR, LOG)
+    uint16_t tones;             ///< Tonos pedidos (largo de list_hz en LIST)
+    const float *list_hz;       ///< Tonos explícitos, crecientes (solo LIST)
+    uint8_t period_blocks;      ///< B: bloques por período (1 a MULTITONE_PERIOD_BLOCKS_MAX)
+    uint16_t periods;           ///< Períodos promediados (>= 1; >= 2 para la SNR)
+    float peak;                 ///< Pico de la suma, también entre muestras (fracción del fondo de escala)
+} multitone_params_t;
+
+/**
+ * @brief Multiseno planificada
+ */
+typedef struct {
+    uint16_t count;                                 ///< Tonos válidos
+    uint8_t period_blocks;                          ///< B
+    uint32_t period_samples;                        ///< N = B·WINDOW_SIZE
+    float amplitude;                                ///< Amplitud de pico de cada tono
+    float crest_factor;                             ///< Pico / valor eficaz de la suma
+    float tone_db;                                  ///< Nivel de cada tono frente a uno solo con el mismo pico
+    uint16_t cycles[MULTITONE_TONES_MAX];           ///< m_i: ciclos por período
+    float freq_hz[MULTITONE_TONES_MAX];             ///< m_i·fs/N
+    float phase_rad[MULTITONE_TONES_MAX];           ///< Fase de cada tono (cresta mínima)
+    float skew_rad[MULTITONE_TONES_MAX];            ///< Corrección por el desfase entre canales
+    goertzel_coeffs_t coeffs[MULTITONE_TONES_MAX];  ///< Coeficientes de cada bin
+    uint16_t fft_bins[MULTITONE_TONES_MAX];         ///< m_i/B: bin de cada tono en un bloque (FFT)
+    fft_detector_t detector;                        ///< Detector de cada bloque (fft_choose_detector())
+} multitone_plan_t;
+
+/**
+ * @brief Resultado de una medición
+ */
+typedef struct {
+    uint16_t count;                                 ///< Tonos medidos
+    float frequency_hz[MULTITONE_TONES_MAX];
+    float magnitude_db[MULTITONE_TONES_MAX];        ///< 20·log10|H|
+    float phase_deg[MULTITONE_TONES_MAX];           ///< arg H
+    float snr_db[MULTITONE_TONES_MAX];              ///< SNR de la H promediada (NAN con un período)
+    uint16_t periods;                               ///< Períodos promediados
+    uint32_t settle_blocks;                         ///< Bloques descartados al asentar
+    uint32_t gaps;                                  ///< Huecos en la secuencia del DMA
+    uint32_t total_time_ms;                         ///< Duración de la medición
+} multitone_result_t;
+
+/**
+ * @brief Carga el pedido por defecto de config.h (MULTITONE_*)
+ */
+void multitone_default_params(multitone_params_t *params);
+
+/**
+ * @brief Construye el plan de la multiseno
+ *
+ * El refinamiento de las fases recorre el período unas 60 veces: se
+ * planifica una vez y se mide muchas.
+ *
+ * @param plan Plan de salida
+ * @param params Pedido
+ * @return false si el pedido es inválido o algún tono no tiene bin entre
+ *         DC y Nyquist
+ */
+bool multitone_plan_build(multitone_plan_t *plan, const multitone_params_t *params);
+
+/**
+ * @brief Sintetiza muestras de la excitación
+ *
+ * x[n] = Σ amplitude·sin(2π·m_i·n/N + φ_i), sin el offset del ADC. El
+ * índice es módulo N: first puede ser cualquiera.
+ *
+ * @param plan Plan construido
+ * @param first Índice de la primera muestra
+ * @param dst Salida (fracción del fondo de escala)
+ * @param num_samples Muestras a generar
+ */
+void multitone_excitation(const multitone_plan_t *plan, uint32_t first, float *dst,
+                          uint32_t num_samples);
+
+/**
+ * @brief Mide con la multiseno ya aplicada, sin publicar
+ *
+ * Apaga la salida del AD9833 y arranca la captura continua; al terminar,
+ * bien o mal, detiene la captura y deja la salida como estaba. Bloquea
+ * unos (asentamiento + periods·B) bloques.
+ *
+ * @param plan Plan construido
+ * @param periods Períodos a promediar (>= 1)
+ * @param result Tonos medidos
+ * @return false si hay un trabajo del barrido o el monitor en curso, la
+ *         captura no arranca o el ADC no tiene canal de referencia
+ */
+bool multitone_measure(const multitone_plan_t *plan, uint16_t periods,
+                       multitone_result_t *result);
+
+/**
+ * @brief Planifica, mide y publica en MQTT_TOPIC_SWEEP y MQTT_TOPIC_MULTITONE
+ *
+ * Corre en el hilo principal, como sweep_adaptive_execute(). El plan se
+ * rehace solo si cambia el pedido. Si la trama no llega al broker se
+ * guarda en el almacén en flash.
+ *
+ * @param params Pedido
+ * @param result Tonos medidos
+ * @return true si la medición quedó en la cola de publicación
+ */
+bool multitone_execute(const multitone_params_t *params, multitone_result_t *result);
+
+/**
+ * @brief Serializa el detalle de una medición para MQTT_TOPIC_MULTITONE
+ *
+ * @param plan Plan medido
+ * @param result Resultado
+ * @param sweep_id Número de la trama con la respuesta
+ * @return Largo escrito, 0 si no alcanzó el buffer
+ */
+size_t multitone_format_json(const multitone_plan_t *plan, const multitone_result_t *result,
+                             uint32_t sweep_id, char *buf, size_t capacity);
+
+#endif // MULTITONE_H
@@ -0,0 +1,136 @@
+/**
+ * @file publish_queue.h
+ * @brief Cola de publicación MQTT con mensajes ya serializados
+ *
+ * Desacopla el barrido de la red: quien publica serializa directamente en
+ * un slot de la cola y retorna, y el contexto de red (mqtt_client_poll())
+ * drena los mensajes en orden. Una caída o un atasco de TCP solo llena la
+ * cola; qué pasa entonces lo decide la política de desborde.
+ *
+ * Cada slot pasa por FREE -> FILLING (productor) -> READY -> SENDING
+ * (contexto de red) -> FREE. Los cambios de estado se hacen en la sección
+ * crítica de la HAL; el contenido del slot lo toca solo su dueño, fuera de
+ * ella. Admite un productor y un consumidor a la vez.
+ */
+
+#ifndef PUBLISH_QUEUE_H
+#define PUBLISH_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "sweep_frame.h"
+
+// Tamaño máximo de un mensaje: una trama de barrido completa
+#define PUBLISH_QUEUE_MSG_MAX SWEEP_FRAME_MAX_SIZE
+
+/**
+ * @brief Qué hacer cuando no queda slot libre
+ */
+typedef enum {
+    PUBLISH_DROP_OLDEST = 0,    ///< Descartar el mensaje listo más antiguo
+    PUBLISH_DROP_NEWEST,        ///< Rechazar el mensaje nuevo
+    PUBLISH_BLOCK               ///< Esperar a que la red libere un slot
+} publish_overflow_t;
+
+/**
+ * @brief Mensaje en la cola
+ */
+typedef struct {
+    const char *topic;                          ///< Topic (debe ser estático)
+    uint32_t receipt;                           ///< Aviso de entrega, 0 = sin aviso
+    uint16_t len;                               ///< Bytes válidos de payload
+    uint8_t payload[PUBLISH_QUEUE_MSG_MAX];
+} publish_msg_t;
+
+/**
+ * @brief Contadores de la cola
+ */
+typedef struct {
+    uint32_t enqueued;          ///< Mensajes aceptados
+    uint32_t sent;              ///< Mensajes entregados por la red
+    uint32_t failed;            ///< Mensajes que la red descartó
+    uint32_t dropped_oldest;    ///< Descartados por PUBLISH_DROP_OLDEST
+    uint32_t dropped_newest;    ///< Rechazados por cola llena
+    uint32_t block_waits;       ///< Publicaciones que esperaron (PUBLISH_BLOCK)
+    uint32_t depth;             ///< Mensajes pendientes ahora (READY + SENDING)
+    uint32_t high_water;        ///< Máximo de depth desde el último reset
+} publish_queue_stats_t;
+
+/**
+ * @brief Vacía la cola y fija la política de desborde
+ *
+ * No debe haber productor ni consumidor activos.
+ */
+void publish_queue_init(publish_overflow_t policy);
+
+/**
+ * @brief Cambia la política de desborde
+ */
+void publish_queue_set_policy(publish_overflow_t policy);
+
+/**
+ * @brief Reserva un slot para serializar un mensaje
+ *
+ * Con cola llena aplica la política: PUBLISH_DROP_OLDEST recicla el
+ * mensaje listo más antiguo, PUBLISH_DROP_NEWEST retorna NULL y
+ * PUBLISH_BLOCK espera. PUBLISH_BLOCK nunca debe usarse desde el contexto
+ * de red, que es quien libera los slots.
+ *
+ * @param topic Topic del mensaje
+ * @return Slot a completar con publish_queue_commit() (receipt en 0), NULL
+ *         si se rechazó
+ */
+publish_msg_t *publish_queue_reserve(const char *topic);
+
+/**
+ * @brief Encola el mensaje reservado
+ *
+ * @param msg Slot devuelto por publish_queue_reserve()
+ * @param len Bytes escritos en msg->payload (0 = descartar el slot)
+ */
+void publish_queue_commit(publish_msg_t *msg, uint16_t len);
+
+/**
+ * @brief Toma el mensaje más antiguo para enviarlo (contexto de red)
+ *
+ * El slot queda en poder del consumidor hasta publish_queue_release();
+ * si la red no puede enviarlo todavía, se reintenta más tarde con el
+ * mismo slot.
+ *
+ * @return Mensaje a enviar, NULL si la cola está vacía
+ */
+publish_msg_t *publish_queue_acquire(void);
+
+/**
+ * @brief Devuelve el slot de un mensaje ya procesado por la red
+ *
+ * @param msg Slot devuelto por publish_queue_acquire()
+ * @param sent true si se entregó, false si se descartó
+ */
+void publish_queue_release(publish_msg_t *msg, bool sent);
+
+/**
+ * @brief Toma el próximo aviso de entrega
+ *
+ * Un mensaje con receipt distinto de cero deja un aviso al liberarse (o al
+ * descartarlo PUBLISH_DROP_OLDEST); así quien lo encoló sabe si llegó. Se
+ * guardan hasta PUBLISH_QUEUE_SLOTS avisos sin tomar.
+ *
+ * @param receipt Valor de msg->receipt
+ * @param sent true si el mensaje se entregó
+ * @return true si había un aviso
+ */
+bool publish_queue_take_receipt(uint32_t *receipt, bool *sent);
+
+/**
+ * @brief Copia los contadores
+ */
+void publish_queue_get_stats(publish_queue_stats_t *stats);
+
+/**
+ * @brief Pone en cero los contadores (depth se conserva)
+ */
+void publish_queue_reset_stats(void);
+
+#endif // PUBLISH_QUEUE_H
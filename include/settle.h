@@ -0,0 +1,136 @@
+/**
+ * @file settle.h
+ * @brief Detector de asentamiento del DUT tras un cambio de frecuencia
+ *
+ * En lugar de esperar un tiempo fijo después de ad9833_set_frequency(),
+ * lanza una captura y estima magnitud y fase con Goertzel sobre tramos
+ * cortos consecutivos (pre-ventanas) a medida que el DMA los completa.
+ * Con dos canales la magnitud es la de la respuesta y la fase se mide
+ * contra la referencia. El punto se considera asentado cuando
+ * SETTLE_CONSECUTIVE comparaciones seguidas quedan dentro de SETTLE_MAG_TOL
+ * y SETTLE_PHASE_TOL_DEG. Si no converge, se corta en una cota derivada de
+ * la constante de tiempo esperada del DUT en esa frecuencia
+ * (settle_tau_ms()); si converge antes, la captura se corta.
+ *
+ * settle_start()/settle_poll()/settle_finish() hacen la misma espera sin
+ * bloquear, para el motor de barrido (sweep.h); settle_wait() las encadena.
+ */
+
+#ifndef SETTLE_H
+#define SETTLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "goertzel.h"
+
+/**
+ * @brief Parámetros de asentamiento precalculados para una frecuencia
+ */
+typedef struct {
+    uint16_t pre_window;        ///< Muestras por estimación (≈ ciclos enteros)
+    float phase_step_rad;       ///< Avance de fase esperado entre pre-ventanas
+    uint16_t max_samples;       ///< Largo máximo de la captura (pre-ventanas enteras)
+    uint32_t max_us;            ///< Cota superior de espera para esta frecuencia
+} settle_params_t;
+
+/**
+ * @brief Resultado de una espera de asentamiento
+ */
+typedef struct {
+    uint32_t elapsed_us;        ///< Tiempo consumido desde el inicio de la espera
+    uint16_t estimates;         ///< Pre-ventanas capturadas
+    bool converged;             ///< false si se alcanzó max_us sin converger
+} settle_report_t;
+
+/**
+ * @brief Espera de asentamiento en curso (settle_start())
+ */
+typedef struct {
+    const settle_params_t *params;
+    const goertzel_coeffs_t *coeffs;
+    uint64_t start_us;          ///< Inicio de la espera
+    uint64_t capture_us;        ///< Arranque de la captura de pre-ventanas
+    goertzel_result_t prev;     ///< Estimación de la pre-ventana anterior
+    uint16_t offset;            ///< Primera muestra de la próxima pre-ventana
+    uint16_t estimates;         ///< Pre-ventanas evaluadas
+    uint8_t streak;             ///< Comparaciones seguidas dentro de tolerancia
+    bool converged;
+    bool done;
+} settle_state_t;
+
+/**
+ * @brief Constante de tiempo esperada del DUT en una frecuencia
+ *
+ * La de la banda de SETTLE_TAU_BANDS que cubre freq_hz, o
+ * SETTLE_DUT_TAU_MS fuera de las bandas (o sin bandas).
+ *
+ * @param freq_hz Frecuencia de excitación (Hz)
+ * @return τ en ms
+ */
+float settle_tau_ms(float freq_hz);
+
+/**
+ * @brief Calcula los parámetros de asentamiento de una frecuencia
+ *
+ * La pre-ventana es el número entero de ciclos de freq_hz que mejor
+ * aproxima un largo entero de al menos SETTLE_PRE_WINDOW_MIN muestras, así
+ * estimaciones sucesivas son comparables. La cota es
+ * SETTLE_TAU_MULTIPLE·settle_tau_ms(freq_hz) más SETTLE_CONSECUTIVE + 1
+ * pre-ventanas, limitada a SETTLE_MAX_SAMPLES; en bajas frecuencias
+ * (pre-ventanas largas) la cota crece.
+ *
+ * @param params Estructura de salida
+ * @param freq_hz Frecuencia de excitación (Hz)
+ * @param sample_rate_hz Frecuencia de muestreo (Hz)
+ */
+void settle_params_init(settle_params_t *params, float freq_hz, float sample_rate_hz);
+
+/**
+ * @brief Espera a que la respuesta del DUT se asiente
+ *
+ * Debe llamarse inmediatamente después de cambiar la frecuencia. Usa el
+ * ADC+DMA, que debe estar libre.
+ *
+ * @param params Parámetros de la frecuencia actual
+ * @param coeffs Coeficientes de Goertzel de la frecuencia actual
+ * @param report Resultado (puede ser NULL)
+ * @return true si convergió, false si se agotó la cota
+ */
+bool settle_wait(const settle_params_t *params, const goertzel_coeffs_t *coeffs,
+                 settle_report_t *report);
+
+/**
+ * @brief Arranca la espera sin bloquear
+ *
+ * Mismas condiciones que settle_wait(); params y coeffs deben seguir vivos
+ * hasta settle_finish().
+ */
+void settle_start(settle_state_t *state, const settle_params_t *params,
+                  const goertzel_coeffs_t *coeffs);
+
+/**
+ * @brief Evalúa las pre-ventanas que ya completó el DMA
+ *
+ * @return true cuando la espera terminó (convergió o agotó la cota)
+ */
+bool settle_poll(settle_state_t *state);
+
+/**
+ * @brief Instante (hal_time_us()) en que estará completa la pre-ventana que
+ *        espera settle_poll()
+ */
+uint64_t settle_wake_us(const settle_state_t *state);
+
+/**
+ * @brief Cierra la espera: corta la captura si convergió antes de la cota
+ *
+ * Llamarla una vez que settle_poll() retornó true, o antes para abandonar
+ * la espera (cuenta como no convergida).
+ *
+ * @param state Espera en curso
+ * @param report Resultado (puede ser NULL)
+ * @return true si convergió
+ */
+bool settle_finish(settle_state_t *state, settle_report_t *report);
+
+#endif // SETTLE_H
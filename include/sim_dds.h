@@ -0,0 +1,60 @@
+/**
+ * @file sim_dds.h
+ * @brief Modelo del AD9833 para el simulador nativo
+ *
+ * Decodifica el mismo flujo de palabras SPI que recibe el chip real
+ * (control, FREQ0/1, PHASE0/1) y mantiene el acumulador de fase de la
+ * salida en función del reloj virtual. Solo se usa en fra_host_sim.
+ */
+
+#ifndef SIM_DDS_H
+#define SIM_DDS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Vuelve el modelo al estado de power-on (en reset, registros en 0)
+ */
+void sim_dds_reset(void);
+
+/**
+ * @brief Procesa una palabra de 16 bits recibida por SPI
+ *
+ * @param word Palabra transmitida por el driver
+ * @param t_us Instante de la escritura (reloj virtual, µs)
+ */
+void sim_dds_write(uint16_t word, uint64_t t_us);
+
+/**
+ * @brief Frecuencia de salida actual (registro seleccionado por FSELECT)
+ * @return Frecuencia en Hz
+ */
+double sim_dds_frequency(void);
+
+/**
+ * @brief Fase de la salida senoidal en un instante dado
+ *
+ * @param t_us Instante (reloj virtual, µs), no anterior a la última escritura
+ * @return Fase en radianes (no acotada)
+ */
+double sim_dds_phase_at(uint64_t t_us);
+
+/**
+ * @brief Indica si el DAC está generando señal (ni en reset ni en sleep)
+ */
+bool sim_dds_output_enabled(void);
+
+/**
+ * @brief Último cambio de la salida (frecuencia o habilitación)
+ *
+ * Solo cuentan escrituras que alteran la salida; las que caen en una misma
+ * ráfaga (p. ej. LSB y MSB del registro activo) son un solo cambio.
+ *
+ * @param t_us Salida: instante del cambio (reloj virtual, µs)
+ * @param prev_freq_hz Salida: frecuencia generada antes del cambio
+ * @return true si antes del cambio había señal, false si estaba en reset
+ */
+bool sim_dds_last_change(uint64_t *t_us, double *prev_freq_hz);
+
+#endif // SIM_DDS_H
@@ -0,0 +1,113 @@
+/**
+ * @file sim_dut.h
+ * @brief Modelo del dispositivo bajo prueba (DUT) y del ADC simulado
+ *
+ * Sintetiza las muestras que vería el ADC con la salida del DDS simulado
+ * pasando por una transferencia H(f) configurable, más ruido gaussiano y
+ * la cuantización equivalente a un ENOB dado. Con ADC_CHANNELS = 2 la
+ * captura intercala la referencia (salida del DDS) y la respuesta,
+ * muestreada una conversión más tarde, igual que el round-robin del
+ * RP2350. Cada cambio del DDS produce un transitorio que decae con la
+ * constante de tiempo del DUT. En lugar del DDS se puede poner una fuente
+ * multiseno externa (sim_dut_set_multisine()). Solo se usa en fra_host_sim.
+ */
+
+#ifndef SIM_DUT_H
+#define SIM_DUT_H
+
+#include <stdint.h>
+
+// Tonos de la fuente multiseno como máximo
+#define SIM_DUT_MULTISINE_MAX 256
+
+/**
+ * @brief Tipo de transferencia del DUT
+ */
+typedef enum {
+    SIM_DUT_FLAT = 0,           ///< H(f) = 1 (lazo directo DDS → ADC)
+    SIM_DUT_RC_LOWPASS = 1,     ///< Pasabajos RC de primer orden (corner_hz = fc)
+    SIM_DUT_RC_HIGHPASS = 2,    ///< Pasaaltos RC de primer orden (corner_hz = fc)
+    SIM_DUT_RLC_BANDPASS = 3,   ///< Pasabanda RLC serie (corner_hz = f0, q = Q)
+    SIM_DUT_NOTCH = 4           ///< Rechazabanda RLC, 1 - pasabanda (corner_hz = f0, q = Q)
+} sim_dut_type_t;
+
+/**
+ * @brief Parámetros del DUT y de la cadena analógica simulada
+ *
+ * Amplitudes y offset expresados en fracción del fondo de escala del ADC.
+ */
+typedef struct {
+    sim_dut_type_t type;        ///< Transferencia del DUT
+    float corner_hz;            ///< Frecuencia de corte o de resonancia (Hz)
+    float q;                    ///< Factor de calidad (RLC y notch)
+    float amplitude;            ///< Amplitud de pico en la entrada del DUT
+    float offset;               ///< Nivel DC en el ADC (0.5 = media escala)
+    float noise_rms;            ///< Ruido gaussiano aditivo (RMS)
+    float enob;                 ///< Bits efectivos del ADC (<= 12)
+    uint32_t seed;              ///< Semilla del generador de ruido
+} sim_dut_config_t;
+
+/**
+ * @brief Carga la configuración por defecto (RC pasabajos de 1 kHz, ideal)
+ *
+ * @param cfg Estructura a completar
+ */
+void sim_dut_default_config(sim_dut_config_t *cfg);
+
+/**
+ * @brief Aplica una configuración y reinicia el generador de ruido
+ *
+ * @param cfg Configuración a aplicar
+ */
+void sim_dut_configure(const sim_dut_config_t *cfg);
+
+/**
+ * @brief Respuesta teórica del DUT
+ *
+ * @param freq_hz Frecuencia (Hz)
+ * @param mag Salida: |H(f)|
+ * @param phase_rad Salida: arg H(f) en radianes
+ */
+void sim_dut_response(float freq_hz, float *mag, float *phase_rad);
+
+/**
+ * @brief Reemplaza el DDS por una fuente multiseno externa
+ *
+ * Simula un generador arbitrario en la entrada del DUT que entrega
+ * offset + Σ amplitude·sin(2π·f_i·t + φ_i), con t el reloj virtual (la
+ * forma de onda no depende de cuándo arranca la captura). Sin transitorio:
+ * el DUT se toma en régimen. Mientras está puesta la salida del DDS no
+ * llega al DUT. No llamar con la captura continua en marcha.
+ *
+ * @param freq_hz Frecuencia de cada tono (Hz)
+ * @param phase_rad Fase de cada tono (rad)
+ * @param count Tonos (hasta SIM_DUT_MULTISINE_MAX); 0 vuelve al DDS
+ * @param amplitude Amplitud de pico de cada tono (fracción del fondo de escala)
+ */
+void sim_dut_set_multisine(const float *freq_hz, const float *phase_rad, uint16_t count,
+                           float amplitude);
+
+/**
+ * @brief Sintetiza una captura del ADC
+ *
+ * Toma frecuencia y fase del DDS simulado en el instante de inicio. Con
+ * dos canales los códigos salen intercalados referencia, respuesta.
+ *
+ * @param dst Buffer destino (códigos de 12 bits)
+ * @param num_samples Número de conversiones
+ * @param t_start_us Instante de la primera muestra (reloj virtual, µs)
+ * @param t_frac_us Fracción de µs a sumar a t_start_us (capturas encadenadas)
+ */
+void sim_dut_capture(uint16_t *dst, uint32_t num_samples, uint64_t t_start_us,
+                     double t_frac_us);
+
+/**
+ * @brief Fase del DDS en la primera conversión de la última captura
+ *
+ * Permite al simulador comparar la fase medida contra la esperada.
+ *
+ * @return Fase en radianes, acotada a [-pi, pi]
+ */
+double sim_dut_last_capture_phase(void);
+
+#endif // SIM_DUT_H
@@ -0,0 +1,79 @@
+/**
+ * @file spsc_queue.h
+ * @brief Cola lock-free de un productor y un consumidor
+ *
+ * Transporta handles de 8 bits (índices a un pool de buffers) entre dos
+ * núcleos o hilos sin secciones críticas: el productor solo escribe head y
+ * el consumidor solo escribe tail. Los índices corren libres y se enmascaran
+ * con la capacidad, que debe ser potencia de 2. La publicación usa
+ * release/acquire, así el consumidor ve el contenido del buffer escrito
+ * antes del push (en el Cortex-M33 se traduce en DMB).
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Capacidad de la cola (potencia de 2)
+#define SPSC_QUEUE_CAPACITY 8
+
+typedef struct {
+    _Atomic uint32_t head;      // Próxima posición a escribir (productor)
+    _Atomic uint32_t tail;      // Próxima posición a leer (consumidor)
+    uint8_t slots[SPSC_QUEUE_CAPACITY];
+} spsc_queue_t;
+
+/**
+ * @brief Deja la cola vacía; no debe haber productor ni consumidor activos
+ */
+static inline void spsc_queue_init(spsc_queue_t *q) {
+    atomic_store_explicit(&q->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->tail, 0, memory_order_relaxed);
+}
+
+/**
+ * @brief Encola un handle (solo desde el productor)
+ * @return false si la cola está llena
+ */
+static inline bool spsc_queue_push(spsc_queue_t *q, uint8_t handle) {
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    
+    if (head - tail >= SPSC_QUEUE_CAPACITY) {
+        return false;
+    }
+    
+    q->slots[head & (SPSC_QUEUE_CAPACITY - 1)] = handle;
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Desencola un handle (solo desde el consumidor)
+ * @return false si la cola está vacía
+ */
+static inline bool spsc_queue_pop(spsc_queue_t *q, uint8_t *handle) {
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    
+    if (head == tail) {
+        return false;
+    }
+    
+    *handle = q->slots[tail & (SPSC_QUEUE_CAPACITY - 1)];
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Elementos en la cola (aproximado si el otro extremo está activo)
+ */
+static inline uint32_t spsc_queue_depth(spsc_queue_t *q) {
+    return atomic_load_explicit(&q->head, memory_order_acquire)
+         - atomic_load_explicit(&q->tail, memory_order_acquire);
+}
+
+#endif // SPSC_QUEUE_H
@@ -3,7 +3,18 @@
  * @brief Módulo orquestador del barrido de frecuencia
  * 
  * Coordina todos los subsistemas para ejecutar el barrido completo
- * de frecuencias desde 100 Hz hasta 20 kHz con resolución de 100 Hz.
+ * sobre los puntos del plan activo (sweep_plan.h): por defecto la grilla
+ * de config.h, de 100 Hz a 20 kHz.
+ * 
+ * Los barridos del plan y los puntos sueltos corren sobre un motor no
+ * bloqueante: frequency_sweep_start() o frequency_sweep_start_point()
+ * arrancan un trabajo y frequency_sweep_poll() lo avanza según terminan el
+ * asentamiento y las capturas del DMA, sin esperar nunca. Entre consultas
+ * el núcleo puede dormir con frequency_sweep_wait() (WFE hasta la próxima
+ * muestra que hace falta; en el simulador, un salto del reloj virtual).
+ * frequency_sweep_execute(), frequency_sweep_execute_with_stats(),
+ * frequency_sweep_measure() y frequency_sweep_single_point() son
+ * envoltorios bloqueantes sobre el mismo motor.
  */
 
 #ifndef SWEEP_H
@@ -11,6 +22,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "sweep_plan.h"
 
 /**
  * @brief Estadísticas del barrido
@@ -21,37 +33,248 @@ typedef struct {
     uint32_t failed_points;         ///< Puntos con error
     uint32_t total_time_ms;         ///< Tiempo total del barrido (ms)
     float avg_time_per_point_ms;    ///< Tiempo promedio por punto (ms)
+    float avg_settle_ms;            ///< Asentamiento promedio por punto (ms)
+    float max_settle_ms;            ///< Asentamiento del punto más lento (ms)
+    uint32_t settle_timeouts;       ///< Puntos que agotaron la cota sin converger
+    uint32_t max_queue_depth;       ///< Pipeline: máximo de ventanas esperando al core 1
+    uint32_t producer_stalls;       ///< Pipeline: puntos en que el core 0 esperó un buffer libre
+    float avg_windows_per_point;    ///< Capturas integradas por punto, en promedio
+    uint32_t max_windows_per_point; ///< Capturas del punto que más integró
+    uint32_t unconverged_points;    ///< Puntos que agotaron max_windows sin llegar a la cota
+    uint32_t saturated_points;      ///< Puntos con saturación excesiva (publicados igual)
 } sweep_stats_t;
 
+/**
+ * @brief Resultado de la medición de un punto aislado
+ */
+typedef struct {
+    float frequency_hz;             ///< Frecuencia coherente medida
+    float magnitude_db;             ///< Magnitud en dB (|H| con ADC_CHANNELS = 2)
+    float phase_deg;                ///< Fase en grados (arg H con ADC_CHANNELS = 2)
+    uint16_t windows;               ///< Capturas integradas
+} sweep_measurement_t;
+
+/**
+ * @brief Estado del motor de barrido
+ */
+typedef enum {
+    SWEEP_IDLE = 0,                 ///< Sin trabajos desde el arranque
+    SWEEP_RUNNING,                  ///< Trabajo en curso: seguir con frequency_sweep_poll()
+    SWEEP_PAUSED,                   ///< Detenido entre dos puntos (frequency_sweep_pause())
+    SWEEP_DONE,                     ///< El último trabajo terminó
+    SWEEP_ABORTED                   ///< El último trabajo se cortó (frequency_sweep_abort() o captura rechazada)
+} sweep_status_t;
+
+/**
+ * @brief Prepara el plan por defecto (grilla de config.h)
+ * 
+ * Precalcula ventana coherente, coeficientes y asentamiento de cada punto
+ * para que el barrido no evalúe funciones trigonométricas por punto. Debe
+ * llamarse una vez antes de cualquier otra función del módulo.
+ * 
+ * @return true si la inicialización fue exitosa, false en caso contrario
+ */
+bool frequency_sweep_init(void);
+
+/**
+ * @brief Reemplaza el plan de los barridos siguientes
+ * 
+ * Se rechaza con un trabajo en curso o en pausa (el plan no cambia). Si
+ * el pedido es inválido se vuelve a la grilla de config.h.
+ * 
+ * @param spec Grilla pedida
+ * @return true si el plan pedido quedó activo
+ */
+bool frequency_sweep_set_plan(const sweep_plan_spec_t *spec);
+
+/**
+ * @brief Plan activo (solo lectura)
+ */
+const sweep_plan_t *frequency_sweep_get_plan(void);
+
+/**
+ * @brief Cambia los puntos por trama publicada (SWEEP_FRAME_POINTS al
+ *        arrancar)
+ * 
+ * @param points 0 = una trama por barrido, N = una trama cada N puntos
+ * @return false con un trabajo en curso o en pausa (no cambia nada)
+ */
+bool frequency_sweep_set_frame_points(uint16_t points);
+
+/**
+ * @brief Puntos por trama vigentes (0 = una trama por barrido)
+ */
+uint16_t frequency_sweep_get_frame_points(void);
+
+/**
+ * @brief Arranca un barrido del plan activo sin bloquear
+ * 
+ * Cada punto pasa por los mismos pasos que frequency_sweep_execute(); el
+ * barrido termina publicando "sweep_complete" en el tópico de estado.
+ * 
+ * @return false si ya hay un trabajo en curso o en pausa
+ */
+bool frequency_sweep_start(void);
+
+/**
+ * @brief Arranca la medición de un punto suelto sin bloquear
+ * 
+ * Como frequency_sweep_measure(); el resultado queda en
+ * frequency_sweep_get_measurement().
+ * 
+ * @param frequency_hz Frecuencia pedida
+ * @param publish true para publicarla como frequency_sweep_single_point()
+ * @return false si hay un trabajo en curso o la frecuencia no es medible
+ */
+bool frequency_sweep_start_point(float frequency_hz, bool publish);
+
+/**
+ * @brief Avanza el trabajo en curso todo lo que se pueda sin esperar
+ * 
+ * Procesa las pre-ventanas de asentamiento y los bloques de captura que ya
+ * completó el DMA, y pasa de paso o de punto cuando corresponde.
+ * 
+ * @return Estado del motor después de avanzar
+ */
+sweep_status_t frequency_sweep_poll(void);
+
+/**
+ * @brief Instante (hal_time_us()) en que el trabajo en curso tendrá algo
+ *        para frequency_sweep_poll()
+ * 
+ * Es el ahora si no hay un trabajo en curso o el paso no espera al DMA.
+ */
+uint64_t frequency_sweep_wake_us(void);
+
+/**
+ * @brief Duerme el núcleo hasta frequency_sweep_wake_us() o hasta un evento
+ *        anterior (hal_wait_event_until_us())
+ */
+void frequency_sweep_wait(void);
+
+/**
+ * @brief Pide una pausa: el trabajo se detiene antes de programar el punto
+ *        siguiente (SWEEP_PAUSED)
+ * 
+ * El punto en curso se completa. El tiempo en pausa cuenta en el total del
+ * barrido.
+ */
+void frequency_sweep_pause(void);
+
+/**
+ * @brief Retoma el trabajo en pausa (o cancela la pausa pedida)
+ */
+void frequency_sweep_resume(void);
+
+/**
+ * @brief Corta el trabajo en curso o en pausa (SWEEP_ABORTED)
+ * 
+ * Corta la captura en vuelo. Del barrido del plan se descarta la trama a
+ * medio armar (no se guarda en flash), las estadísticas quedan con los
+ * puntos medidos y se publica "sweep_aborted". Deja el motor listo para
+ * otro trabajo.
+ */
+void frequency_sweep_abort(void);
+
+/**
+ * @brief Estado del motor
+ */
+sweep_status_t frequency_sweep_status(void);
+
+/**
+ * @brief Estadísticas del último barrido del plan (parciales si se abortó)
+ */
+void frequency_sweep_get_stats(sweep_stats_t *stats);
+
+/**
+ * @brief Resultado del último punto suelto
+ * 
+ * @return false si el último trabajo no fue un punto suelto terminado
+ */
+bool frequency_sweep_get_measurement(sweep_measurement_t *measurement);
+
 /**
  * @brief Ejecuta un barrido completo de frecuencia
  * 
- * Realiza medición secuencial de 200 puntos desde 100 Hz hasta 20 kHz.
+ * Realiza medición secuencial de los puntos del plan activo.
  * Para cada punto:
- * 1. Configura AD9833 a frecuencia objetivo
- * 2. Espera estabilización
- * 3. Adquiere 480 muestras con ADC+DMA
- * 4. Procesa con Goertzel
- * 5. Transmite resultado via MQTT
+ * 1. Configura AD9833 a la frecuencia coherente del punto
+ * 2. Espera a que el DUT se asiente (detector adaptativo, ver settle.h)
+ * 3. Adquiere sus ventanas coherentes con ADC+DMA, procesándolas con
+ *    Goertzel por bloques mientras el DMA completa la captura; con
+ *    promedio (spec.average) repite la captura encadenada hasta que el
+ *    error estándar cae bajo las cotas o se agota max_windows
+ * 4. Transmite resultado via MQTT
  * 
- * Esta función es bloqueante y toma aproximadamente 3-4 segundos.
+ * Esta función es bloqueante: arranca el trabajo con
+ * frequency_sweep_start() y consulta el motor hasta que termina. Con DUTs
+ * rápidos el asentamiento cuesta unos pocos ms por punto en lugar de los
+ * 100 ms fijos de antes.
  */
 void frequency_sweep_execute(void);
 
 /**
  * @brief Ejecuta un barrido con recolección de estadísticas
  * 
- * Igual que frequency_sweep_execute() pero recolecta estadísticas
- * de rendimiento y las almacena en la estructura proporcionada.
+ * Igual que frequency_sweep_execute(); al terminar copia las estadísticas
+ * del motor (frequency_sweep_get_stats()).
  * 
  * @param stats Puntero a estructura donde se almacenarán las estadísticas
  */
 void frequency_sweep_execute_with_stats(sweep_stats_t *stats);
 
+/**
+ * @brief Ejecuta un barrido repartido entre los dos núcleos
+ * 
+ * El core 0 configura el AD9833 y captura el punto k+1 mientras el core 1
+ * calcula Goertzel y publica el punto k. Las ventanas circulan entre
+ * núcleos como handles de un pool de SWEEP_PIPELINE_BUFFERS buffers a
+ * través de dos colas SPSC lock-free (capturadas y libres), sin copias.
+ * Los resultados se publican en el mismo orden que en el barrido
+ * secuencial. Completa stats incluyendo los campos del pipeline.
+ * 
+ * No pasa por el motor (bloquea hasta el final) pero usa su mismo
+ * hardware: con un trabajo del motor en curso (SWEEP_RUNNING o
+ * SWEEP_PAUSED) no arranca y da todos los puntos por fallidos. El loop
+ * principal lo usa con SWEEP_PIPELINED. Mide una sola captura por punto:
+ * el promedio con corte anticipado
+ * necesita el resultado antes de decidir si sigue capturando, y ese
+ * resultado lo calcula el core 1 cuando el core 0 ya pasó al punto
+ * siguiente.
+ * 
+ * @param stats Puntero a estructura donde se almacenarán las estadísticas
+ */
+void frequency_sweep_execute_pipelined(sweep_stats_t *stats);
+
+/**
+ * @brief Mide un punto aislado sin publicarlo
+ * 
+ * Corrige la frecuencia a la coherente más cercana (como el plan),
+ * configura el AD9833, espera el asentamiento y captura (con el promedio
+ * del plan vigente). Bloqueante, sobre frequency_sweep_start_point(); la
+ * usa el barrido adaptativo.
+ * 
+ * @param frequency_hz Frecuencia pedida
+ * @param measurement Resultado
+ * @return false si la frecuencia no es medible o hay un trabajo en curso
+ */
+bool frequency_sweep_measure(float frequency_hz, sweep_measurement_t *measurement);
+
+/**
+ * @brief Numera un barrido nuevo
+ * 
+ * Los barridos del plan y los adaptativos comparten la numeración de sus
+ * tramas.
+ * 
+ * @return sweep_id del barrido que empieza
+ */
+uint32_t frequency_sweep_next_id(void);
+
 /**
  * @brief Ejecuta medición de un solo punto de frecuencia
  * 
- * Útil para testing o mediciones aisladas.
+ * Útil para testing o mediciones aisladas. La frecuencia se corrige a la
+ * coherente más cercana, como en el plan, y se publica la corregida.
  * 
  * @param frequency_hz Frecuencia a medir
  * @return true si la medición fue exitosa, false en caso contrario
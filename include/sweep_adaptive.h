@@ -0,0 +1,83 @@
+/**
+ * @file sweep_adaptive.h
+ * @brief Barrido adaptativo: densifica puntos solo donde la respuesta cambia
+ *
+ * Mide primero una grilla logarítmica gruesa y después inserta puntos, de
+ * a uno, en el punto medio (en log f) del intervalo donde la interpolación
+ * es peor. El error de interpolar linealmente un intervalo de ancho h se
+ * estima como h²·|f''|/8, con la curvatura f'' de magnitud (y fase) sacada
+ * de las diferencias divididas de cada punto con sus dos vecinos. Se
+ * refina mientras algún intervalo supere mag_tol_db (o phase_tol_deg),
+ * hasta agotar max_points o max_time_ms, o hasta que los intervalos
+ * lleguen a min_step. En una respuesta plana o de pendiente constante el
+ * barrido termina con los puntos gruesos; alrededor de un polo, una
+ * resonancia o un notch se concentran los insertados.
+ *
+ * Cada punto se mide con frequency_sweep_measure() (frecuencia coherente,
+ * asentamiento adaptativo). El resultado se publica como una trama con
+ * lista de frecuencias ordenada (SWEEP_FRAME_FLAG_FREQS) y, si no llega al
+ * broker, se guarda en el almacén en flash como cualquier otro barrido.
+ */
+
+#ifndef SWEEP_ADAPTIVE_H
+#define SWEEP_ADAPTIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+
+/**
+ * @brief Parámetros del barrido adaptativo
+ */
+typedef struct {
+    float start_hz;             ///< Primera frecuencia
+    float stop_hz;              ///< Última frecuencia
+    uint16_t coarse_points;     ///< Puntos de la pasada gruesa (logarítmica, >= 3)
+    uint16_t max_points;        ///< Presupuesto de puntos (<= SWEEP_NUM_POINTS)
+    uint32_t max_time_ms;       ///< Presupuesto de tiempo (0 = sin límite)
+    float mag_tol_db;           ///< Error de interpolación de magnitud admitido (dB)
+    float phase_tol_deg;        ///< Error de interpolación de fase admitido (0 = no usar)
+    float min_step;             ///< Intervalo relativo mínimo f2/f1 - 1 que se sigue partiendo
+} sweep_adaptive_params_t;
+
+/**
+ * @brief Puntos medidos, ordenados por frecuencia
+ */
+typedef struct {
+    uint16_t count;                             ///< Puntos medidos
+    uint16_t coarse;                            ///< De ellos, de la pasada gruesa
+    float frequency_hz[SWEEP_NUM_POINTS];
+    float magnitude_db[SWEEP_NUM_POINTS];
+    float phase_deg[SWEEP_NUM_POINTS];
+    uint32_t total_time_ms;                     ///< Duración del barrido
+    bool budget_hit;                            ///< Cortado por puntos o tiempo
+} sweep_adaptive_result_t;
+
+/**
+ * @brief Carga los parámetros por defecto de config.h
+ */
+void sweep_adaptive_default_params(sweep_adaptive_params_t *params);
+
+/**
+ * @brief Mide sin publicar
+ *
+ * @param params Parámetros
+ * @param result Puntos medidos
+ * @return false si los parámetros son inválidos o falló la pasada gruesa
+ */
+bool sweep_adaptive_measure(const sweep_adaptive_params_t *params,
+                            sweep_adaptive_result_t *result);
+
+/**
+ * @brief Mide y publica el barrido en MQTT_TOPIC_SWEEP
+ *
+ * Corre en el hilo principal, como frequency_sweep_execute().
+ *
+ * @param params Parámetros
+ * @param result Puntos medidos
+ * @return true si el barrido se midió y quedó en la cola de publicación
+ */
+bool sweep_adaptive_execute(const sweep_adaptive_params_t *params,
+                            sweep_adaptive_result_t *result);
+
+#endif // SWEEP_ADAPTIVE_H
@@ -0,0 +1,81 @@
+/**
+ * @file sweep_average.h
+ * @brief Promedio coherente de varias ventanas con corte anticipado
+ *
+ * Cada punto puede integrar varias capturas seguidas de la misma ventana
+ * coherente. El Goertzel no se reinicia entre ellas (las muestras no se
+ * guardan): el resultado del punto es el de la integración completa, y de
+ * las diferencias del bin acumulado sale la estimación de cada ventana
+ * (ver goertzel_stream_bin()). Este módulo lleva la media y la dispersión
+ * de esas estimaciones complejas (Welford) y decide cuándo cortar.
+ *
+ * Con ruido circular, la desviación s de las estimaciones se reparte por
+ * igual entre la dirección radial y la tangencial, así que con la media m
+ * de k ventanas y r = s/(|m|·√(2k)):
+ *   error estándar de magnitud = 20·log10(e)·r dB
+ *   error estándar de fase     = r rad
+ */
+
+#ifndef SWEEP_AVERAGE_H
+#define SWEEP_AVERAGE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Parámetros del promedio
+ */
+typedef struct {
+    uint16_t max_windows;       ///< Ventanas por punto como máximo (1 = una sola captura)
+    uint16_t min_windows;       ///< Ventanas antes de evaluar el corte (al menos 2)
+    float stderr_db;            ///< Cota del error estándar de magnitud (dB)
+    float stderr_deg;           ///< Cota del error estándar de fase (grados)
+} sweep_average_params_t;
+
+/**
+ * @brief Acumulador de las estimaciones por ventana
+ */
+typedef struct {
+    uint16_t windows;           ///< Ventanas acumuladas
+    float mean_re;              ///< Media, parte real
+    float mean_im;              ///< Media, parte imaginaria
+    float m2;                   ///< Suma de |x - media|²
+} sweep_average_t;
+
+/**
+ * @brief Carga los parámetros de config.h (SWEEP_AVG_*)
+ */
+void sweep_average_default_params(sweep_average_params_t *params);
+
+/**
+ * @brief Vacía el acumulador
+ */
+void sweep_average_init(sweep_average_t *avg);
+
+/**
+ * @brief Suma la estimación compleja de una ventana
+ *
+ * La escala es libre (H, bin sin normalizar...) mientras sea la misma en
+ * todas las ventanas: el corte usa el error relativo a la media.
+ */
+void sweep_average_add(sweep_average_t *avg, float re, float im);
+
+/**
+ * @brief Error estándar de la media
+ *
+ * @param avg Acumulador
+ * @param mag_db Error estándar de magnitud (dB)
+ * @param phase_deg Error estándar de fase (grados)
+ * @return false con menos de dos ventanas o media nula (sin estimación)
+ */
+bool sweep_average_stderr(const sweep_average_t *avg, float *mag_db, float *phase_deg);
+
+/**
+ * @brief Indica si ya se puede cortar
+ *
+ * @return true con al menos min_windows ventanas y los dos errores
+ *         estándar dentro de sus cotas
+ */
+bool sweep_average_converged(const sweep_average_t *avg, const sweep_average_params_t *params);
+
+#endif // SWEEP_AVERAGE_H
@@ -0,0 +1,167 @@
+/**
+ * @file sweep_frame.h
+ * @brief Trama binaria de barrido para publicación por MQTT
+ *
+ * Agrupa los puntos de un barrido (o de un tramo de N puntos) en un solo
+ * mensaje en lugar de un JSON por frecuencia. Formato v1, little-endian:
+ *
+ *   off  tam  campo
+ *    0    2   magia "FR"
+ *    2    1   versión (SWEEP_FRAME_VERSION)
+ *    3    1   flags (SWEEP_FRAME_FLAG_*)
+ *    4    4   sweep_id (uint32)
+ *    8    4   timestamp_ms (uint32, inicio del barrido)
+ *   12    4   start_hz (float IEEE-754, frecuencia del punto 0 del barrido)
+ *   16    4   step_hz (float IEEE-754)
+ *   20    2   first_index (uint16, índice del primer punto de la trama)
+ *   22    2   count (uint16, puntos en la trama)
+ *   24   2*count  magnitudes (int16, centésimas de dB)
+ *   ...  2*count  fases (int16, centésimas de grado)
+ *   ...  4*count  frecuencias (float IEEE-754, solo con SWEEP_FRAME_FLAG_FREQS)
+ *
+ * En una grilla uniforme la frecuencia del punto i de la trama es
+ * start_hz + (first_index + i) * step_hz. Las grillas logarítmicas o de
+ * lista (sweep_plan.h) no tienen paso: la trama lleva la frecuencia de
+ * cada punto, marca SWEEP_FRAME_FLAG_FREQS y step_hz vale 0. Un punto sin
+ * medición válida se marca con SWEEP_FRAME_INVALID en ambos arreglos.
+ */
+
+#ifndef SWEEP_FRAME_H
+#define SWEEP_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "config.h"
+
+#define SWEEP_FRAME_VERSION 1
+
+// Tamaños del formato en bytes
+#define SWEEP_FRAME_HEADER_SIZE 24
+#define SWEEP_FRAME_POINT_SIZE 4
+#define SWEEP_FRAME_FREQ_SIZE 4
+#define SWEEP_FRAME_SIZE(points) (SWEEP_FRAME_HEADER_SIZE + (points) * SWEEP_FRAME_POINT_SIZE)
+#define SWEEP_FRAME_SIZE_FREQS(points) (SWEEP_FRAME_SIZE(points) + (points) * SWEEP_FRAME_FREQ_SIZE)
+
+// Puntos por trama como máximo (un barrido completo)
+#define SWEEP_FRAME_MAX_POINTS SWEEP_NUM_POINTS
+
+// Trama más grande posible (un barrido completo con lista de frecuencias)
+#define SWEEP_FRAME_MAX_SIZE SWEEP_FRAME_SIZE_FREQS(SWEEP_FRAME_MAX_POINTS)
+
+// Flags del encabezado
+#define SWEEP_FRAME_FLAG_LAST 0x01   ///< Última trama del barrido
+#define SWEEP_FRAME_FLAG_REPLAY 0x02 ///< Reenvío desde la flash (sweep_store.h)
+#define SWEEP_FRAME_FLAG_FREQS 0x04  ///< Lleva la frecuencia de cada punto
+
+// Valor reservado para un punto sin medición
+#define SWEEP_FRAME_INVALID INT16_MIN
+
+/**
+ * @brief Encabezado de la trama
+ */
+typedef struct {
+    uint32_t sweep_id;          ///< Contador de barridos
+    uint32_t timestamp_ms;      ///< hal_time_ms() al iniciar el barrido
+    float start_hz;             ///< Frecuencia del punto 0 del barrido
+    float step_hz;              ///< Paso de la grilla (0 con SWEEP_FRAME_FLAG_FREQS)
+    uint16_t first_index;       ///< Índice en el barrido del primer punto de la trama
+    uint16_t count;             ///< Puntos cargados
+    uint8_t flags;              ///< SWEEP_FRAME_FLAG_*
+} sweep_frame_header_t;
+
+/**
+ * @brief Trama en memoria (ya cuantizada)
+ */
+typedef struct {
+    sweep_frame_header_t header;
+    int16_t magnitude_cdb[SWEEP_FRAME_MAX_POINTS];  ///< Magnitud en 0.01 dB
+    int16_t phase_cdeg[SWEEP_FRAME_MAX_POINTS];     ///< Fase en 0.01°
+    float frequency_hz[SWEEP_FRAME_MAX_POINTS];     ///< Solo con SWEEP_FRAME_FLAG_FREQS
+} sweep_frame_t;
+
+/**
+ * @brief Vacía la trama y carga el encabezado
+ *
+ * @param frame Trama a preparar
+ * @param sweep_id Identificador del barrido
+ * @param timestamp_ms Inicio del barrido
+ * @param start_hz Frecuencia del punto 0 del barrido
+ * @param step_hz Paso de la grilla
+ * @param first_index Índice del primer punto que se agregará
+ */
+void sweep_frame_begin(sweep_frame_t *frame, uint32_t sweep_id, uint32_t timestamp_ms,
+                       float start_hz, float step_hz, uint16_t first_index);
+
+/**
+ * @brief Agrega el punto siguiente
+ *
+ * Cuantiza a centésimas y satura al rango de int16. Una magnitud o fase
+ * no finita marca el punto como inválido.
+ *
+ * @param frame Trama
+ * @param magnitude_db Magnitud en dB
+ * @param phase_deg Fase en grados
+ * @return true si había lugar, false si la trama está llena
+ */
+bool sweep_frame_add(sweep_frame_t *frame, float magnitude_db, float phase_deg);
+
+/**
+ * @brief Agrega el punto siguiente junto con su frecuencia
+ *
+ * Marca la trama con SWEEP_FRAME_FLAG_FREQS; no mezclar con
+ * sweep_frame_add() en una misma trama.
+ *
+ * @param frame Trama
+ * @param frequency_hz Frecuencia del punto
+ * @param magnitude_db Magnitud en dB
+ * @param phase_deg Fase en grados
+ * @return true si había lugar, false si la trama está llena
+ */
+bool sweep_frame_add_at(sweep_frame_t *frame, float frequency_hz,
+                        float magnitude_db, float phase_deg);
+
+/**
+ * @brief Indica si el punto i de la trama tiene medición
+ */
+bool sweep_frame_point_valid(const sweep_frame_t *frame, uint16_t i);
+
+/**
+ * @brief Magnitud del punto i en dB
+ */
+float sweep_frame_magnitude_db(const sweep_frame_t *frame, uint16_t i);
+
+/**
+ * @brief Fase del punto i en grados
+ */
+float sweep_frame_phase_deg(const sweep_frame_t *frame, uint16_t i);
+
+/**
+ * @brief Frecuencia del punto i en Hz
+ */
+float sweep_frame_frequency_hz(const sweep_frame_t *frame, uint16_t i);
+
+/**
+ * @brief Serializa la trama al formato de cable
+ *
+ * @param frame Trama
+ * @param buf Buffer destino
+ * @param capacity Tamaño de buf
+ * @return Bytes escritos, 0 si no entra
+ */
+size_t sweep_frame_encode(const sweep_frame_t *frame, uint8_t *buf, size_t capacity);
+
+/**
+ * @brief Deserializa y valida una trama
+ *
+ * Rechaza magia o versión desconocidas, largo inconsistente con count y
+ * los flags, y count mayor que SWEEP_FRAME_MAX_POINTS.
+ *
+ * @param buf Bytes recibidos
+ * @param len Largo de buf
+ * @param frame Salida
+ * @return true si la trama es válida
+ */
+bool sweep_frame_decode(const uint8_t *buf, size_t len, sweep_frame_t *frame);
+
+#endif // SWEEP_FRAME_H
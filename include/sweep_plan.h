@@ -0,0 +1,127 @@
+/**
+ * @file sweep_plan.h
+ * @brief Planificador de la grilla de frecuencias del barrido
+ *
+ * Construye la lista de puntos que recorre el barrido a partir de una
+ * grilla lineal, logarítmica o de una lista explícita. Cada frecuencia se
+ * corrige al valor coherente m·fs/N más cercano: la ventana de N muestras
+ * contiene exactamente m ciclos, así Goertzel no tiene fuga espectral sin
+ * depender de que la frecuencia sea múltiplo de fs/WINDOW_SIZE.
+ *
+ * El largo N sale de un objetivo de SNR: con ruido blanco de valor eficaz
+ * σ, Goertzel sobre N muestras estima la amplitud A con SNR = A²·N/(2σ²),
+ * así que basta N = 2σ²·10^(SNR/10)/A² (repartido entre las ventanas
+ * promediadas) y al menos min_cycles ciclos. Se toma la ventana coherente
+ * más corta que lo cumpla y cuya frecuencia quede dentro de una tolerancia
+ * relativa de la pedida: en alta frecuencia los puntos se miden en pocos
+ * ms, en baja la ventana crece hasta max_window. Sin objetivo de SNR se
+ * usa la ventana más larga.
+ *
+ * Cada punto lleva además sus coeficientes de Goertzel, sus parámetros de
+ * asentamiento, la corrección de fase del muestreo round-robin entre
+ * referencia y respuesta (ver adc_dma.h) y el número de ventanas coherentes consecutivas que se
+ * integran en la medición (averages): la captura es de N·averages muestras
+ * y tiene que entrar en max_window. Esa captura se puede repetir encadenada
+ * hasta average.max_windows veces, cortando antes si el error estándar de
+ * la media cae bajo las cotas (sweep_average.h); el plan solo las lleva,
+ * la repetición la decide el barrido al medir.
+ */
+
+#ifndef SWEEP_PLAN_H
+#define SWEEP_PLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "config.h"
+#include "goertzel.h"
+#include "settle.h"
+#include "sweep_average.h"
+
+/**
+ * @brief Forma de la grilla
+ */
+typedef enum {
+    SWEEP_GRID_LINEAR = 0,      ///< start_hz..stop_hz en points pasos iguales
+    SWEEP_GRID_LOG = 1,         ///< start_hz..stop_hz en points pasos de razón constante
+    SWEEP_GRID_LIST = 2         ///< Frecuencias de list_hz, en ese orden
+} sweep_grid_t;
+
+/**
+ * @brief Pedido de grilla
+ */
+typedef struct {
+    sweep_grid_t grid;          ///< Forma de la grilla
+    float start_hz;             ///< Primera frecuencia (LINEAR, LOG)
+    float stop_hz;              ///< Última frecuencia (LINEAR, LOG)
+    uint16_t points;            ///< Puntos pedidos (largo de list_hz en LIST)
+    const float *list_hz;       ///< Frecuencias explícitas (solo LIST)
+    uint8_t averages;           ///< Ventanas coherentes integradas por punto (>= 1)
+    uint16_t max_window;        ///< Muestras por captura como máximo (<= ADC_CAPTURE_MAX_SAMPLES)
+    float freq_tol;             ///< Desvío relativo admitido al corregir la frecuencia
+    float target_snr_db;        ///< SNR buscado por punto (<= 0: ventana más larga)
+    float min_amplitude;        ///< Amplitud pico más chica a medir (fracción de fondo de escala)
+    float noise_rms;            ///< Ruido eficaz del ADC (misma escala)
+    uint16_t min_cycles;        ///< Ciclos por ventana como mínimo (>= 1)
+    sweep_average_params_t average; ///< Repeticiones de la captura y corte (ver sweep_average.h)
+} sweep_plan_spec_t;
+
+/**
+ * @brief Punto planificado
+ */
+typedef struct {
+    float freq_hz;              ///< Frecuencia coherente que se mide (m·fs/N)
+    uint16_t window;            ///< N: muestras por ventana coherente
+    uint16_t cycles;            ///< m: ciclos enteros por ventana
+    uint8_t averages;           ///< Ventanas consecutivas integradas
+    float snr_db;               ///< SNR estimado con min_amplitude y noise_rms
+    float skew_rad;             ///< Corrección de fase por el desfase entre canales
+    goertzel_coeffs_t coeffs;   ///< Coeficientes de Goertzel de freq_hz
+    settle_params_t settle;     ///< Parámetros de asentamiento de freq_hz
+} sweep_point_t;
+
+/**
+ * @brief Plan completo del barrido
+ */
+typedef struct {
+    sweep_point_t points[SWEEP_NUM_POINTS];
+    uint16_t count;             ///< Puntos válidos
+    sweep_grid_t grid;          ///< Grilla de origen
+    bool uniform;               ///< Frecuencias en pasos iguales (trama sin lista)
+    float step_hz;              ///< Paso si uniform
+} sweep_plan_t;
+
+/**
+ * @brief Carga el pedido por defecto de config.h
+ *
+ * SWEEP_GRID elige la forma: la lineal recorre SWEEP_FREQ_MIN..SWEEP_FREQ_MAX
+ * cada FREQ_RESOLUTION, la logarítmica usa SWEEP_LOG_POINTS_PER_DECADE.
+ */
+void sweep_plan_default_spec(sweep_plan_spec_t *spec);
+
+/**
+ * @brief Calcula la ventana coherente de un punto
+ *
+ * Usa averages, max_window, freq_tol y los parámetros de SNR del pedido;
+ * la forma de la grilla no interviene.
+ *
+ * @param point Punto a completar (coeficientes y asentamiento incluidos)
+ * @param freq_hz Frecuencia pedida
+ * @param spec Pedido del que sale la ventana
+ * @return false si la frecuencia no entra ni un ciclo en la ventana o
+ *         supera Nyquist
+ */
+bool sweep_plan_point_init(sweep_point_t *point, float freq_hz, const sweep_plan_spec_t *spec);
+
+/**
+ * @brief Construye el plan
+ *
+ * Los puntos que caen en la misma frecuencia coherente que el anterior se
+ * descartan, así que count puede quedar por debajo de spec->points.
+ *
+ * @param plan Plan de salida
+ * @param spec Pedido
+ * @return false si el pedido es inválido o algún punto no es medible
+ */
+bool sweep_plan_build(sweep_plan_t *plan, const sweep_plan_spec_t *spec);
+
+#endif // SWEEP_PLAN_H
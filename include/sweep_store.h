@@ -0,0 +1,111 @@
+/**
+ * @file sweep_store.h
+ * @brief Almacén persistente en flash de barridos no entregados
+ *
+ * Si el broker no está disponible durante un barrido, el barrido completo
+ * se guarda en la región de flash reservada y se reenvía, en orden, cuando
+ * mqtt_is_connected() vuelve a ser true (ver mqtt_client_replay()). Solo se
+ * escriben los barridos que no llegaron: con conexión estable la flash no
+ * se toca. Un barrido que quedó encolado durante el corte puede llegar dos
+ * veces: el reenvío lleva SWEEP_FRAME_FLAG_REPLAY y el mismo sweep_id y
+ * timestamp que el original.
+ *
+ * La región es un log circular de SWEEP_STORE_SECTORS sectores. Cada sector
+ * empieza con un encabezado de 16 bytes:
+ *
+ *   magia u32 "FRSS" | borrados u32 | secuencia del sector u32 | CRC-32 u32
+ *
+ * seguido de registros alineados a 4 bytes, uno por barrido:
+ *
+ *   magia u16 "SR" | largo u16 | número de registro u32 | CRC-32 u32 |
+ *   entregado u8 | 3 reservados | payload
+ *
+ * El payload es la trama de barrido v1 completa (sweep_frame.h) con
+ * SWEEP_FRAME_FLAG_REPLAY, lista para publicarse tal cual. El CRC cubre
+ * magia, largo, número y payload; "entregado" queda en 0xFF al escribir el
+ * registro y se programa a 0x00 cuando el broker lo confirma, sin borrar.
+ *
+ * Un corte de energía a mitad de escritura deja un registro con CRC
+ * inválido: al arrancar se descarta junto con el resto de su sector, que
+ * deja de recibir escrituras. Un sector lleno se reemplaza por el sector
+ * reutilizable (sin registros pendientes) con menos borrados; si todos
+ * tienen pendientes se pisa el más antiguo y sus barridos se cuentan como
+ * perdidos.
+ *
+ * Todas las funciones borran o programan flash: llamarlas desde el hilo
+ * principal y con el core 1 detenido, nunca durante el barrido ni desde el
+ * contexto de red.
+ */
+
+#ifndef SWEEP_STORE_H
+#define SWEEP_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sweep_frame.h"
+
+// Payload máximo de un registro: un barrido completo
+#define SWEEP_STORE_PAYLOAD_MAX SWEEP_FRAME_MAX_SIZE
+
+/**
+ * @brief Contadores del almacén
+ */
+typedef struct {
+    uint32_t appended;      ///< Barridos guardados desde el arranque
+    uint32_t acked;         ///< Barridos confirmados por el broker
+    uint32_t pending;       ///< Barridos guardados sin confirmar
+    uint32_t overwritten;   ///< Pendientes pisados por falta de espacio
+    uint32_t torn;          ///< Registros descartados al arrancar (CRC inválido)
+    uint32_t erases;        ///< Sectores borrados desde el arranque
+    uint32_t write_errors;  ///< Escrituras de flash fallidas
+} sweep_store_stats_t;
+
+/**
+ * @brief Recorre la región y reconstruye el estado del log
+ *
+ * Debe llamarse al arrancar, antes de cualquier otra función del módulo.
+ *
+ * @return true si la región se pudo leer
+ */
+bool sweep_store_init(void);
+
+/**
+ * @brief Guarda un barrido completo como registro pendiente
+ *
+ * @param sweep Trama con los puntos del barrido
+ * @return true si el registro quedó escrito
+ */
+bool sweep_store_append(const sweep_frame_t *sweep);
+
+/**
+ * @brief Lee el registro pendiente más antiguo
+ *
+ * Un registro corrupto o más grande que capacity se confirma como perdido
+ * (y se devuelve 0) para que el siguiente pueda reenviarse.
+ *
+ * @param payload Buffer destino (al menos SWEEP_STORE_PAYLOAD_MAX bytes)
+ * @param capacity Tamaño del buffer
+ * @param record Número de registro, para sweep_store_ack()
+ * @return Bytes de payload, 0 si no hay pendientes
+ */
+uint16_t sweep_store_read_oldest(uint8_t *payload, uint16_t capacity, uint32_t *record);
+
+/**
+ * @brief Marca un registro como entregado
+ *
+ * @param record Número devuelto por sweep_store_read_oldest()
+ * @return true si el registro existía y quedó marcado
+ */
+bool sweep_store_ack(uint32_t record);
+
+/**
+ * @brief Barridos guardados sin confirmar
+ */
+uint32_t sweep_store_pending(void);
+
+/**
+ * @brief Copia los contadores
+ */
+void sweep_store_get_stats(sweep_store_stats_t *stats);
+
+#endif // SWEEP_STORE_H
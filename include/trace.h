@@ -0,0 +1,135 @@
+/**
+ * @file trace.h
+ * @brief Traza de etapas del camino caliente con p50/p95/máx por etapa
+ *
+ * Cada etapa del barrido (escritura al DDS, asentamiento, captura,
+ * validación, Goertzel y publicación) se marca con trace_begin() y
+ * trace_end(). El par queda en un anillo en RAM como un solo evento con la
+ * etapa y su duración, medida con el contador de hal_cycle_counter() (el
+ * CYCCNT del núcleo en el firmware, clock_gettime en el simulador). El
+ * inicio y el fin se aparean en quien llama, así los dos núcleos escriben
+ * el mismo anillo sin tener que emparejar eventos ajenos.
+ *
+ * El anillo es lock-free: cada escritor reserva su posición con un
+ * incremento atómico del índice, que corre libre y se enmascara con la
+ * capacidad. Lleno, sobrescribe los eventos más antiguos. trace_report()
+ * lo lee sin sincronizar: llamarla sin barrido en curso.
+ *
+ * Con DEBUG_GPIO_ENABLED, trace_begin()/trace_end() también suben y bajan
+ * el pin DEBUG_PIN_* de la etapa (si tiene uno), para el osciloscopio.
+ * Con TRACE_ENABLED en 0 solo quedan los pines.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "config.h"
+
+/**
+ * @brief Etapas trazadas
+ */
+typedef enum {
+    TRACE_DDS_WRITE = 0,        ///< Programar o conmutar la frecuencia del AD9833
+    TRACE_SETTLE,               ///< Espera de asentamiento del DUT
+    TRACE_ADC_CAPTURE,          ///< Captura del punto, de arranque a fin del DMA
+    TRACE_VALIDATE,             ///< adc_dma_validate_samples()
+    TRACE_GOERTZEL,             ///< CPU de Goertzel del punto
+    TRACE_PUBLISH,              ///< Serializar y encolar una trama o medición
+    TRACE_SWEEP,                ///< Barrido completo
+    TRACE_STAGE_COUNT
+} trace_stage_t;
+
+/**
+ * @brief Distribución de una etapa
+ */
+typedef struct {
+    uint32_t count;             ///< Eventos de la etapa en el anillo
+    float p50_us;               ///< Mediana (µs)
+    float p95_us;               ///< Percentil 95 (µs)
+    float max_us;               ///< Máximo (µs)
+} trace_stage_stats_t;
+
+/**
+ * @brief Reporte del contenido del anillo
+ */
+typedef struct {
+    uint32_t events;            ///< Eventos evaluados
+    uint32_t overwritten;       ///< Eventos perdidos por anillo lleno
+    trace_stage_stats_t stages[TRACE_STAGE_COUNT];
+} trace_report_t;
+
+// Tamaño del reporte en JSON (trace_format_json())
+#define TRACE_JSON_MAX 768
+
+/**
+ * @brief Habilita el contador del núcleo actual y vacía el anillo
+ */
+void trace_init(void);
+
+/**
+ * @brief Vacía el anillo; no debe haber escritores activos
+ */
+void trace_reset(void);
+
+/**
+ * @brief Marca el inicio de una etapa
+ *
+ * @return Lectura del contador, para trace_end() o trace_lap()
+ */
+uint32_t trace_begin(trace_stage_t stage);
+
+/**
+ * @brief Cierra la etapa abierta en t0 y la registra
+ *
+ * @return Duración en cuentas del contador
+ */
+uint32_t trace_end(trace_stage_t stage, uint32_t t0);
+
+/**
+ * @brief Cierra la etapa abierta en t0 sin registrarla
+ *
+ * Para etapas que corren en tramos (Goertzel bloque a bloque mientras
+ * llega la captura): se suman las vueltas y el total se registra con
+ * trace_record().
+ *
+ * @return Duración en cuentas del contador
+ */
+uint32_t trace_lap(trace_stage_t stage, uint32_t t0);
+
+/**
+ * @brief Registra una duración ya medida (en cuentas del contador)
+ */
+void trace_record(trace_stage_t stage, uint32_t ticks);
+
+/**
+ * @brief Nombre corto de la etapa (clave del reporte)
+ */
+const char *trace_stage_name(trace_stage_t stage);
+
+/**
+ * @brief Calcula p50/p95/máx por etapa sobre los eventos del anillo
+ *
+ * Percentiles por rango más cercano. Llamarla sin barrido en curso.
+ */
+void trace_report(trace_report_t *report);
+
+/**
+ * @brief Imprime el reporte por stdio (USB en el firmware)
+ */
+void trace_print(const trace_report_t *report);
+
+/**
+ * @brief Serializa el reporte para MQTT_TOPIC_TRACE
+ *
+ * {"events":N,"overwritten":N,"stages":[{"stage":"dds_write","n":N,
+ * "p50":12.3,"p95":15.0,"max":20.1},...]} con tiempos en µs; las etapas
+ * sin eventos se omiten.
+ *
+ * @return Largo escrito, 0 si no alcanzó el buffer
+ */
+size_t trace_format_json(const trace_report_t *report, char *buf, size_t capacity);
+
+#endif // TRACE_H
@@ -2,15 +2,27 @@
  * @file ad9833.c
  * @brief Implementación del módulo AD9833
  * 
- * ESTADO: STUB - Implementación mínima para compilación
- * TODO: Implementar protocolo SPI y configuración real del chip
+ * Todas las escrituras pasan por un transporte intercambiable que por
+ * defecto es hal_spi_write16(), de modo que el mismo driver maneja el chip
+ * real, el DDS simulado del target fra_host_sim o un registrador de
+ * palabras para verificar la secuencia.
+ * 
+ * Los cambios de frecuencia nunca escriben el registro activo: la palabra
+ * nueva va al registro inactivo (FREQ0/FREQ1) y luego una sola escritura
+ * de control conmuta FSELECT. El acumulador de fase sigue corriendo, así el
+ * salto es de fase continua y sin la frecuencia intermedia que aparecía
+ * entre la escritura del LSB y la del MSB.
+ * 
+ * Entre ad9833_batch_begin() y ad9833_batch_commit() las palabras no salen
+ * de a una sino que se acumulan en un lote que el transporte envía de una
+ * vez (por DMA con el SPI de la HAL). Hay dos buffers de lote: mientras
+ * uno está en vuelo se puede armar el siguiente.
  */
 
 #include "ad9833.h"
 #include "config.h"
-#include <stdio.h>
-#include "hardware/spi.h"
-#include "hardware/gpio.h"
+#include "debug.h"
+#include "hal.h"
 
 // Registros del AD9833
 #define AD9833_REG_FREQ0  0x4000
@@ -30,66 +42,312 @@
 #define AD9833_DIV2   0x0008
 #define AD9833_MODE   0x0002
 
+// Máscara de 14 bits de las mitades de la palabra de frecuencia
+#define AD9833_FREQ_HALF_MASK 0x3FFF
+
+// Máscara de 12 bits del registro de fase
+#define AD9833_PHASE_MASK 0x0FFF
+
+// Palabras por lote (init completo = 7)
+#define AD9833_BATCH_MAX_WORDS 16
+
 // Estado actual
 static float current_frequency = 0.0f;
 static ad9833_waveform_t current_waveform = AD9833_WAVEFORM_SINE;
+static bool output_enabled = true;
+
+// Registro de frecuencia que sale por el DAC (0 = FREQ0, 1 = FREQ1) y
+// frecuencia precargada en el otro, si la hay
+static uint8_t active_reg = 0;
+static bool preload_valid = false;
+static float preload_frequency = 0.0f;
+
+// Lotes: buffer en armado, palabras acumuladas y lote en vuelo
+static uint16_t batch_words[2][AD9833_BATCH_MAX_WORDS];
+static uint8_t batch_buf = 0;
+static uint16_t batch_len = 0;
+static bool batch_open = false;
+static volatile bool batch_in_flight = false;
+static ad9833_done_cb_t batch_cb = NULL;
+static void *batch_cb_ctx = NULL;
+
+static void ad9833_hal_write16(void *ctx, uint16_t word) {
+    (void)ctx;
+    hal_spi_write16(word);
+}
+
+static bool ad9833_hal_write_async(void *ctx, const uint16_t *words, uint32_t count,
+                                   ad9833_done_cb_t done, void *done_ctx) {
+    (void)ctx;
+    return hal_spi_write16_async(words, count, done, done_ctx);
+}
+
+static bool ad9833_hal_is_busy(void *ctx) {
+    (void)ctx;
+    return hal_spi_is_busy();
+}
+
+static void ad9833_hal_wait(void *ctx) {
+    (void)ctx;
+    hal_spi_wait();
+}
+
+static const ad9833_transport_t ad9833_hal_transport = {
+    .write16 = ad9833_hal_write16,
+    .write_async = ad9833_hal_write_async,
+    .is_busy = ad9833_hal_is_busy,
+    .wait = ad9833_hal_wait,
+    .ctx = NULL
+};
+
+static const ad9833_transport_t *transport = &ad9833_hal_transport;
+
+/**
+ * @brief Fin del lote en vuelo (puede llegar desde una IRQ)
+ */
+static void ad9833_batch_done(void *ctx) {
+    (void)ctx;
+    batch_in_flight = false;
+    if (batch_cb) {
+        batch_cb(batch_cb_ctx);
+    }
+}
 
 /**
- * @brief Escribe una palabra de 16 bits al AD9833 via SPI
+ * @brief Escribe una palabra de 16 bits al AD9833 por el transporte actual
+ *
+ * Dentro de un lote solo la encola. Fuera de él espera al lote en vuelo
+ * para no adelantarse a sus palabras.
  */
 static void ad9833_write_reg(uint16_t data) {
-    // TODO: Implementar escritura SPI real
-    // Por ahora solo simular
-    (void)data;  // Evitar warning de variable no usada
+    if (batch_open) {
+        if (batch_len == AD9833_BATCH_MAX_WORDS) {
+            ad9833_batch_commit();
+            batch_open = true;
+        }
+        batch_words[batch_buf][batch_len++] = data;
+        return;
+    }
+    
+    if (batch_in_flight) {
+        ad9833_wait_idle();
+    }
+    transport->write16(transport->ctx, data);
+}
+
+/**
+ * @brief Arma la palabra de control según el estado actual
+ *
+ * B28 siempre activo: las escrituras de frecuencia van de a pares LSB/MSB.
+ * La salida deshabilitada se implementa con RESET (DAC a media escala).
+ */
+static uint16_t ad9833_control_word(void) {
+    uint16_t control = AD9833_B28;
+    
+    switch (current_waveform) {
+        case AD9833_WAVEFORM_TRIANGLE:
+            control |= AD9833_MODE;
+            break;
+        case AD9833_WAVEFORM_SQUARE:
+            control |= AD9833_OPBITEN | AD9833_DIV2;
+            break;
+        case AD9833_WAVEFORM_SINE:
+        default:
+            break;
+    }
+    
+    if (active_reg) {
+        control |= AD9833_FSELECT;
+    }
+    
+    if (!output_enabled) {
+        control |= AD9833_RESET;
+    }
+    
+    return control;
+}
+
+/**
+ * @brief Calcula la palabra de frecuencia de 28 bits
+ */
+static uint32_t ad9833_freq_word(float freq_hz) {
+    // freq_word = (f_out * 2^28) / f_mclk
+    return (uint32_t)((freq_hz * 268435456.0f) / AD9833_MCLK + 0.5f);
+}
+
+/**
+ * @brief Escribe una palabra de frecuencia completa (LSB y MSB) en un registro
+ */
+static void ad9833_write_freq(uint8_t reg, uint32_t freq_word) {
+    uint16_t addr = reg ? AD9833_REG_FREQ1 : AD9833_REG_FREQ0;
+    
+    ad9833_write_reg(addr | (freq_word & AD9833_FREQ_HALF_MASK));
+    ad9833_write_reg(addr | ((freq_word >> 14) & AD9833_FREQ_HALF_MASK));
+}
+
+/**
+ * @brief Vuelve el estado del driver al de power-on y reprograma el chip
+ */
+static void ad9833_load_defaults(void) {
+    current_frequency = 0.0f;
+    current_waveform = AD9833_WAVEFORM_SINE;
+    output_enabled = true;
+    active_reg = 0;
+    preload_valid = false;
+    
+    // Secuencia del datasheet: reset, registros, salir de reset
+    ad9833_write_reg(AD9833_B28 | AD9833_RESET);
+    ad9833_write_freq(0, 0);
+    ad9833_write_freq(1, 0);
+    ad9833_write_reg(AD9833_REG_PHASE0);
+    ad9833_write_reg(ad9833_control_word());
+}
+
+void ad9833_set_transport(const ad9833_transport_t *new_transport) {
+    if (batch_in_flight) {
+        ad9833_wait_idle();
+    }
+    transport = new_transport ? new_transport : &ad9833_hal_transport;
 }
 
 bool ad9833_init(void) {
-    printf("[AD9833] Inicializando... (STUB)\n");
+    DEBUG_PRINT(2, "[AD9833] Inicializando...\n");
+    
+    if (transport == &ad9833_hal_transport && !hal_spi_init()) {
+        DEBUG_PRINT(0, "[AD9833] ERROR: Fallo al inicializar SPI\n");
+        return false;
+    }
     
-    // TODO: Implementar inicialización real:
-    // - Configurar SPI
-    // - Configurar GPIO CS
-    // - Resetear chip
-    // - Configurar modo senoidal
+    ad9833_load_defaults();
     
-    printf("[AD9833] Inicializado en modo SINE (stub)\n");
+    DEBUG_PRINT(2, "[AD9833] Inicializado en modo SINE\n");
     return true;
 }
 
 void ad9833_set_frequency(float freq_hz) {
-    printf("[AD9833] Configurando frecuencia: %.2f Hz (STUB)\n", freq_hz);
+    DEBUG_PRINT(3, "[AD9833] Configurando frecuencia: %.2f Hz\n", freq_hz);
+    
+    ad9833_preload_frequency(freq_hz);
+    ad9833_switch_preloaded();
+}
+
+void ad9833_preload_frequency(float freq_hz) {
+    DEBUG_PRINT(3, "[AD9833] Precargando FREQ%d: %.2f Hz\n", active_reg ^ 1, freq_hz);
     
-    current_frequency = freq_hz;
+    ad9833_write_freq(active_reg ^ 1, ad9833_freq_word(freq_hz));
+    preload_frequency = freq_hz;
+    preload_valid = true;
+}
+
+bool ad9833_switch_preloaded(void) {
+    if (!preload_valid) {
+        return false;
+    }
     
-    // TODO: Implementar configuración real de frecuencia:
-    // 1. Calcular palabra de frecuencia de 28 bits
-    //    freq_word = (freq_hz * 2^28) / AD9833_MCLK
-    // 2. Extraer LSB (14 bits inferiores)
-    // 3. Extraer MSB (14 bits superiores)
-    // 4. Escribir secuencia SPI:
-    //    - Control word con B28=1
-    //    - LSB con bits de registro FREQ0
-    //    - MSB con bits de registro FREQ0
+    active_reg ^= 1;
+    current_frequency = preload_frequency;
+    preload_valid = false;
+    ad9833_write_reg(ad9833_control_word());
+    return true;
+}
+
+bool ad9833_get_preloaded(float *freq_hz) {
+    if (preload_valid && freq_hz) {
+        *freq_hz = preload_frequency;
+    }
+    return preload_valid;
+}
+
+float ad9833_get_frequency(void) {
+    return current_frequency;
 }
 
 void ad9833_set_waveform(ad9833_waveform_t waveform) {
-    printf("[AD9833] Configurando forma de onda: %d (STUB)\n", waveform);
+    DEBUG_PRINT(3, "[AD9833] Configurando forma de onda: %d\n", waveform);
     
     current_waveform = waveform;
-    
-    // TODO: Implementar cambio de forma de onda
+    ad9833_write_reg(ad9833_control_word());
 }
 
 void ad9833_enable_output(bool enable) {
-    printf("[AD9833] %s salida (STUB)\n", enable ? "Habilitando" : "Deshabilitando");
+    DEBUG_PRINT(3, "[AD9833] %s salida\n", enable ? "Habilitando" : "Deshabilitando");
+    
+    output_enabled = enable;
+    ad9833_write_reg(ad9833_control_word());
+}
+
+bool ad9833_is_output_enabled(void) {
+    return output_enabled;
+}
+
+void ad9833_set_phase(float phase_deg) {
+    DEBUG_PRINT(3, "[AD9833] Configurando fase: %.2f°\n", phase_deg);
     
-    // TODO: Implementar habilitación/deshabilitación de salida
+    // phase_reg = phase * 4096 / 360
+    int32_t phase_reg = (int32_t)(phase_deg * (4096.0f / 360.0f) + (phase_deg < 0.0f ? -0.5f : 0.5f));
+    ad9833_write_reg(AD9833_REG_PHASE0 | ((uint16_t)phase_reg & AD9833_PHASE_MASK));
 }
 
 void ad9833_reset(void) {
-    printf("[AD9833] Reset (STUB)\n");
+    DEBUG_PRINT(3, "[AD9833] Reset\n");
     
-    // TODO: Implementar reset del chip
-    current_frequency = 0.0f;
-    current_waveform = AD9833_WAVEFORM_SINE;
+    ad9833_load_defaults();
+}
+
+void ad9833_batch_begin(void) {
+    batch_open = true;
+}
+
+void ad9833_batch_commit(void) {
+    batch_open = false;
+    if (batch_len == 0) {
+        return;
+    }
+    
+    const uint16_t *words = batch_words[batch_buf];
+    uint16_t count = batch_len;
+    batch_buf ^= 1;
+    batch_len = 0;
+    
+    // Un solo lote en vuelo: el buffer que se libera es el que se arma ahora
+    if (batch_in_flight) {
+        ad9833_wait_idle();
+    }
+    
+    if (transport->write_async) {
+        batch_in_flight = true;
+        if (transport->write_async(transport->ctx, words, count, ad9833_batch_done, NULL)) {
+            return;
+        }
+        // Bus tomado por otro envío: se cae a la escritura bloqueante
+        batch_in_flight = false;
+        transport->wait(transport->ctx);
+    }
+    
+    for (uint16_t i = 0; i < count; i++) {
+        transport->write16(transport->ctx, words[i]);
+    }
+    ad9833_batch_done(NULL);
+}
+
+bool ad9833_is_busy(void) {
+    if (batch_in_flight && transport->is_busy) {
+        // Consultar al transporte permite que entregue un aviso pendiente
+        transport->is_busy(transport->ctx);
+    }
+    return batch_in_flight;
+}
+
+void ad9833_wait_idle(void) {
+    if (transport->wait) {
+        transport->wait(transport->ctx);
+    }
+    while (batch_in_flight) {
+        hal_cpu_relax();
+    }
+}
+
+void ad9833_set_batch_callback(ad9833_done_cb_t cb, void *ctx) {
+    batch_cb = cb;
+    batch_cb_ctx = ctx;
 }
@@ -2,85 +2,275 @@
  * @file adc_dma.c
  * @brief Implementación del módulo ADC+DMA
  * 
- * ESTADO: STUB - Implementación mínima para compilación
- * TODO: Implementar funcionalidad completa
+ * La configuración de registros ADC/DMA vive en la HAL (src/hal_pico.c);
+ * este módulo administra el buffer de muestras y la validación.
+ * 
+ * En captura continua los buffers del anillo pasan por cuatro estados:
+ * FILLING (asignado a un canal DMA), READY (en cola para el consumidor),
+ * OWNED (en manos del consumidor) y FREE. Solo se transfiere la propiedad,
+ * nunca se copian muestras. Con dos canales encadenados siempre hay dos
+ * buffers en FILLING, por eso el anillo necesita al menos tres para que el
+ * consumidor pueda retener uno sin frenar la captura.
  */
 
 #include "adc_dma.h"
-#include <stdio.h>
-#include <math.h>
-#include "hardware/adc.h"
-#include "hardware/dma.h"
-#include "hardware/gpio.h"
+#include "debug.h"
+#include "hal.h"
+
+#if ADC_DMA_RING_BUFFERS < 3
+#error "ADC_DMA_RING_BUFFERS debe ser al menos 3 (dos canales DMA + consumidor)"
+#endif
+
+#if ADC_CAPTURE_MAX_SAMPLES < WINDOW_SIZE || ADC_CAPTURE_MAX_SAMPLES > 65535
+#error "ADC_CAPTURE_MAX_SAMPLES debe estar entre WINDOW_SIZE y 65535"
+#endif
+
+#if ADC_CHANNELS != 1 && ADC_CHANNELS != 2
+#error "ADC_CHANNELS debe ser 1 o 2"
+#endif
 
 // Buffer de muestras (global)
-uint16_t adc_sample_buffer[WINDOW_SIZE];
+uint16_t adc_sample_buffer[ADC_CAPTURE_MAX_SAMPLES * ADC_CHANNELS];
+
+typedef enum {
+    RING_FREE = 0,
+    RING_FILLING,
+    RING_READY,
+    RING_OWNED
+} ring_state_t;
 
-// Variables privadas del módulo
-static int dma_chan;
-static dma_channel_config dma_cfg;
+// Anillo de captura continua; todo el estado se modifica dentro de
+// hal_critical_enter/exit porque lo comparten la IRQ y el consumidor
+static uint16_t ring_buffers[ADC_DMA_RING_BUFFERS][WINDOW_SIZE * ADC_CHANNELS];
+static ring_state_t ring_state[ADC_DMA_RING_BUFFERS];
+static uint32_t ring_sequence[ADC_DMA_RING_BUFFERS];
+
+// Cola FIFO de buffers READY (índices en orden de llegada)
+static uint8_t ready_fifo[ADC_DMA_RING_BUFFERS];
+static uint8_t ready_head = 0;
+static uint8_t ready_count = 0;
+
+static uint32_t next_sequence = 0;
+static adc_dma_ring_stats_t ring_stats;
+static bool ring_running = false;
 
 bool adc_dma_init(void) {
-    printf("[ADC_DMA] Inicializando... (STUB)\n");
-    
-    // TODO: Implementar configuración real del ADC
-    // - Inicializar ADC
-    // - Configurar GPIO del ADC
-    // - Configurar clock divider para 48 kHz
-    // - Configurar FIFO
-    // - Configurar canal DMA
-    // - Configurar interrupciones
-    
-    // Por ahora, solo inicializar el ADC básicamente
-    adc_init();
-    adc_gpio_init(ADC_PIN_REFERENCE);
-    adc_select_input(0);  // ADC0
-    
-    printf("[ADC_DMA] Inicializado (modo stub)\n");
+    DEBUG_PRINT(2, "[ADC_DMA] Inicializando...\n");
+    
+    if (!hal_adc_init()) {
+        DEBUG_PRINT(0, "[ADC_DMA] ERROR: Fallo al configurar ADC/DMA\n");
+        return false;
+    }
+    
+    DEBUG_PRINT(2, "[ADC_DMA] Inicializado (%.0f Hz, %d canal(es), %d muestras/ventana)\n",
+                SAMPLE_RATE, ADC_CHANNELS, WINDOW_SIZE);
+    return true;
+}
+
+bool adc_dma_start_capture(uint16_t num_samples) {
+    if (num_samples == 0 || num_samples > ADC_CAPTURE_MAX_SAMPLES) {
+        DEBUG_PRINT(0, "[ADC_DMA] ERROR: Captura de %d muestras fuera de rango\n", num_samples);
+        return false;
+    }
+    
+    DEBUG_PRINT(3, "[ADC_DMA] Iniciando captura de %d muestras...\n", num_samples);
+    hal_adc_start(adc_sample_buffer, (uint32_t)num_samples * ADC_CHANNELS);
+    return true;
+}
+
+bool adc_dma_continue_capture(uint16_t num_samples) {
+    if (num_samples == 0 || num_samples > ADC_CAPTURE_MAX_SAMPLES) {
+        DEBUG_PRINT(0, "[ADC_DMA] ERROR: Captura de %d muestras fuera de rango\n", num_samples);
+        return false;
+    }
+    
+    if (!hal_adc_continue(adc_sample_buffer, (uint32_t)num_samples * ADC_CHANNELS)) {
+        DEBUG_PRINT(1, "[ADC_DMA] WARNING: Rearme tardío, la captura no sigue a la anterior\n");
+        return false;
+    }
+    DEBUG_PRINT(3, "[ADC_DMA] Continuando con %d muestras...\n", num_samples);
     return true;
 }
 
-void adc_dma_start_capture(void) {
-    // TODO: Implementar inicio de captura DMA real
-    printf("[ADC_DMA] Iniciando captura... (STUB)\n");
+void adc_dma_start_capture_into(uint16_t *buffer, uint16_t num_samples) {
+    DEBUG_PRINT(3, "[ADC_DMA] Iniciando captura de %d muestras...\n", num_samples);
+    hal_adc_start(buffer, (uint32_t)num_samples * ADC_CHANNELS);
 }
 
 void adc_dma_wait_complete(void) {
-    // TODO: Implementar espera real de completitud DMA
-    // Por ahora, generar datos sintéticos para testing
-    printf("[ADC_DMA] Esperando completitud... (STUB)\n");
+    hal_adc_wait();
+    DEBUG_PRINT(3, "[ADC_DMA] Captura completa\n");
+}
+
+void adc_dma_abort_capture(void) {
+    hal_adc_abort();
+    DEBUG_PRINT(3, "[ADC_DMA] Captura cortada\n");
+}
+
+uint16_t adc_dma_samples_ready(void) {
+    return (uint16_t)(hal_adc_samples_done() / ADC_CHANNELS);
+}
+
+bool adc_dma_is_busy(void) {
+    return hal_adc_is_busy();
+}
+
+static uint8_t ring_index_of(const uint16_t *buffer) {
+    return (uint8_t)((buffer - &ring_buffers[0][0]) / (WINDOW_SIZE * ADC_CHANNELS));
+}
+
+/**
+ * @brief Callback de la HAL (contexto IRQ): publica el bloque lleno y elige
+ *        el próximo destino del canal que terminó
+ */
+static uint16_t *adc_dma_ring_on_block(uint16_t *filled) {
+    uint8_t done = ring_index_of(filled);
+    uint8_t next = ADC_DMA_RING_BUFFERS;
     
-    // Generar datos sintéticos (senoide de 1 kHz a 48 kHz)
-    for (int i = 0; i < WINDOW_SIZE; i++) {
-        float t = (float)i / SAMPLE_RATE;
-        float signal = 0.5f + 0.4f * sinf(2.0f * 3.14159265f * 1000.0f * t);
-        adc_sample_buffer[i] = (uint16_t)(signal * 4095.0f);
+    hal_critical_enter();
+    
+    ring_state[done] = RING_READY;
+    ring_sequence[done] = next_sequence++;
+    ready_fifo[(ready_head + ready_count) % ADC_DMA_RING_BUFFERS] = done;
+    ready_count++;
+    ring_stats.blocks_captured++;
+    
+    for (uint8_t i = 0; i < ADC_DMA_RING_BUFFERS; i++) {
+        if (ring_state[i] == RING_FREE) {
+            next = i;
+            break;
+        }
     }
     
-    printf("[ADC_DMA] Captura completa (datos sintéticos)\n");
+    if (next == ADC_DMA_RING_BUFFERS) {
+        // Overrun: el consumidor no devolvió buffers a tiempo. Se recicla
+        // el bloque listo más antiguo (siempre hay al menos uno: done)
+        next = ready_fifo[ready_head];
+        ready_head = (ready_head + 1) % ADC_DMA_RING_BUFFERS;
+        ready_count--;
+        ring_stats.blocks_dropped++;
+    }
+    
+    if (ready_count > ring_stats.max_ready_depth) {
+        ring_stats.max_ready_depth = ready_count;
+    }
+    
+    ring_state[next] = RING_FILLING;
+    
+    hal_critical_exit();
+    
+    return ring_buffers[next];
 }
 
-bool adc_dma_is_busy(void) {
-    // TODO: Implementar verificación real de estado DMA
-    return false;
+bool adc_dma_start_continuous(void) {
+    if (ring_running) {
+        return false;
+    }
+    
+    for (uint8_t i = 0; i < ADC_DMA_RING_BUFFERS; i++) {
+        ring_state[i] = RING_FREE;
+    }
+    ring_state[0] = RING_FILLING;
+    ring_state[1] = RING_FILLING;
+    ready_head = 0;
+    ready_count = 0;
+    next_sequence = 0;
+    ring_stats = (adc_dma_ring_stats_t){0};
+    
+    if (!hal_adc_stream_start(ring_buffers[0], ring_buffers[1], WINDOW_SIZE * ADC_CHANNELS,
+                              adc_dma_ring_on_block)) {
+        DEBUG_PRINT(0, "[ADC_DMA] ERROR: No se pudo iniciar captura continua\n");
+        return false;
+    }
+    
+    ring_running = true;
+    DEBUG_PRINT(2, "[ADC_DMA] Captura continua (%d buffers de %d muestras)\n",
+                ADC_DMA_RING_BUFFERS, WINDOW_SIZE);
+    return true;
 }
 
-bool adc_dma_validate_samples(const uint16_t *samples, uint16_t n) {
-    uint16_t saturated_count = 0;
+void adc_dma_stop_continuous(void) {
+    if (!ring_running) {
+        return;
+    }
+    
+    hal_adc_stream_stop();
+    ring_running = false;
+    
+    // Los buffers que estaban en llenado quedan libres; los READY y OWNED
+    // conservan sus datos
+    for (uint8_t i = 0; i < ADC_DMA_RING_BUFFERS; i++) {
+        if (ring_state[i] == RING_FILLING) {
+            ring_state[i] = RING_FREE;
+        }
+    }
     
-    for (uint16_t i = 0; i < n; i++) {
+    DEBUG_PRINT(2, "[ADC_DMA] Captura continua detenida (%lu bloques, %lu descartados)\n",
+                (unsigned long)ring_stats.blocks_captured,
+                (unsigned long)ring_stats.blocks_dropped);
+}
+
+bool adc_dma_acquire_ready_buffer(adc_dma_block_t *block) {
+    bool found = false;
+    
+    hal_critical_enter();
+    if (ready_count > 0) {
+        uint8_t idx = ready_fifo[ready_head];
+        ready_head = (ready_head + 1) % ADC_DMA_RING_BUFFERS;
+        ready_count--;
+        ring_state[idx] = RING_OWNED;
+        
+        block->samples = ring_buffers[idx];
+        block->num_samples = WINDOW_SIZE;
+        block->sequence = ring_sequence[idx];
+        block->index = idx;
+        found = true;
+    }
+    hal_critical_exit();
+    
+    return found;
+}
+
+void adc_dma_release_buffer(const adc_dma_block_t *block) {
+    hal_critical_enter();
+    if (block->index < ADC_DMA_RING_BUFFERS && ring_state[block->index] == RING_OWNED) {
+        ring_state[block->index] = RING_FREE;
+    }
+    hal_critical_exit();
+}
+
+void adc_dma_get_ring_stats(adc_dma_ring_stats_t *stats) {
+    hal_critical_enter();
+    *stats = ring_stats;
+    hal_critical_exit();
+}
+
+uint32_t adc_dma_count_saturated(const uint16_t *samples, uint16_t n) {
+    uint32_t saturated_count = 0;
+    uint32_t codes = (uint32_t)n * ADC_CHANNELS;
+    
+    for (uint32_t i = 0; i < codes; i++) {
         if (samples[i] <= 10 || samples[i] >= 4085) {
             saturated_count++;
         }
     }
+    return saturated_count;
+}
+
+bool adc_dma_saturation_valid(uint32_t saturated, uint32_t n) {
+    uint32_t codes = n * ADC_CHANNELS;
     
     // Rechazar si >5% de muestras saturadas
-    bool valid = (saturated_count < n / 20);
+    bool valid = (saturated < codes / 20);
     
     if (!valid) {
-        printf("[ADC_DMA] WARNING: %d/%d muestras saturadas\n", 
-               saturated_count, n);
+        DEBUG_PRINT(1, "[ADC_DMA] WARNING: %lu/%lu muestras saturadas\n", 
+                    (unsigned long)saturated, (unsigned long)codes);
     }
     
     return valid;
 }
+
+bool adc_dma_validate_samples(const uint16_t *samples, uint16_t n) {
+    return adc_dma_saturation_valid(adc_dma_count_saturated(samples, n), n);
+}
@@ -0,0 +1,597 @@
+/**
+ * @file command.c
+ * @brief Implementación del control remoto del barrido
+ */
+
+#include "command.h"
+#include "debug.h"
+#include "json_reader.h"
+#include "json_writer.h"
+#include "monitor.h"
+#include "mqtt_client.h"
+#include "spsc_queue.h"
+#include "sweep.h"
+#include <math.h>
+#include <string.h>
+
+#if COMMAND_QUEUE_SLOTS < 1 || COMMAND_QUEUE_SLOTS >= SPSC_QUEUE_CAPACITY
+#error "COMMAND_QUEUE_SLOTS debe estar entre 1 y SPSC_QUEUE_CAPACITY - 1"
+#endif
+
+// Claves y nombres más largos no corresponden a ningún comando
+#define COMMAND_KEY_MAX 32
+
+// Cotas de los campos del perfil
+#define COMMAND_SNR_MAX_DB 120.0f
+#define COMMAND_MAX_WINDOWS_LIMIT 1000u
+
+// Payload recibido esperando al loop principal
+typedef struct {
+    char payload[COMMAND_PAYLOAD_MAX];
+    uint16_t len;
+    bool truncated;                 // Llegó más largo que COMMAND_PAYLOAD_MAX
+} command_slot_t;
+
+static command_slot_t command_slots[COMMAND_QUEUE_SLOTS];
+static spsc_queue_t command_ready;  // red -> loop principal
+static spsc_queue_t command_free;   // loop principal -> red
+
+// Perfil vigente; la lista de la grilla LIST vive acá para que un perfil
+// que solo cambia, por ejemplo, los promedios la siga encontrando
+static sweep_plan_spec_t command_profile;
+static float command_profile_list[SWEEP_NUM_POINTS];
+
+static uint32_t command_interval = SWEEP_INTERVAL_MS;
+static bool command_enabled = true;
+static bool command_start_pending = false;
+
+// Comando en curso (no entra cómodo en la pila: lleva la lista)
+static command_t command_current;
+
+static command_stats_t command_stats;
+
+static const char *const command_names[] = {
+    [COMMAND_NONE] = NULL,
+    [COMMAND_PROFILE] = "profile",
+    [COMMAND_POINT] = "point",
+    [COMMAND_START] = "start",
+    [COMMAND_STOP] = "stop",
+    [COMMAND_RATE] = "rate",
+    [COMMAND_MONITOR] = "monitor",
+};
+
+static const char *const command_error_names[] = {
+    [COMMAND_OK] = NULL,
+    [COMMAND_ERR_PARSE] = "parse",
+    [COMMAND_ERR_UNKNOWN] = "unknown",
+    [COMMAND_ERR_INVALID] = "invalid",
+    [COMMAND_ERR_BUSY] = "busy",
+    [COMMAND_ERR_FAILED] = "failed",
+};
+
+const char *command_name(command_type_t type) {
+    return (unsigned)type < sizeof(command_names) / sizeof(command_names[0]) ? command_names[type] : NULL;
+}
+
+const char *command_error_name(command_error_t error) {
+    return (unsigned)error < sizeof(command_error_names) / sizeof(command_error_names[0])
+        ? command_error_names[error] : NULL;
+}
+
+void command_init(void) {
+    spsc_queue_init(&command_ready);
+    spsc_queue_init(&command_free);
+    for (uint8_t i = 0; i < COMMAND_QUEUE_SLOTS; i++) {
+        spsc_queue_push(&command_free, i);
+    }
+
+    sweep_plan_default_spec(&command_profile);
+    command_interval = SWEEP_INTERVAL_MS;
+    command_enabled = true;
+    command_start_pending = false;
+    memset(&command_stats, 0, sizeof(command_stats));
+}
+
+bool command_deliver(const uint8_t *payload, size_t len) {
+    uint8_t handle;
+    if (!spsc_queue_pop(&command_free, &handle)) {
+        command_stats.dropped++;
+        return false;
+    }
+
+    command_slot_t *slot = &command_slots[handle];
+    slot->truncated = (len > COMMAND_PAYLOAD_MAX);
+    slot->len = slot->truncated ? 0 : (uint16_t)len;
+    if (slot->len > 0) {
+        memcpy(slot->payload, payload, slot->len);
+    }
+    command_stats.received++;
+    spsc_queue_push(&command_ready, handle);
+    return true;
+}
+
+static bool command_key_is(const char *key, const char *name) {
+    return strcmp(key, name) == 0;
+}
+
+static bool command_valid_freq(float freq_hz) {
+    return isfinite(freq_hz) && freq_hz > 0.0f && freq_hz < SAMPLE_RATE / 2.0f;
+}
+
+/**
+ * @brief Primera pasada: valida la sintaxis entera y busca "cmd" e "id"
+ */
+static command_error_t command_parse_header(const char *payload, size_t len, command_t *cmd) {
+    json_reader_t r;
+    char key[COMMAND_KEY_MAX];
+    char name[COMMAND_KEY_MAX];
+    bool has_name = false;
+    bool bad_id = false;
+
+    json_reader_init(&r, payload, len);
+    json_reader_begin_object(&r);
+    while (json_reader_next_key(&r, key, sizeof(key))) {
+        // Un valor del tipo equivocado no es error de sintaxis: se prueba
+        // sobre una copia del lector y, si no es lo esperado, se saltea
+        json_reader_t probe = r;
+        if (command_key_is(key, "cmd") && json_reader_string(&probe, name, sizeof(name))) {
+            has_name = true;
+            r = probe;
+        } else if (command_key_is(key, "id") && json_reader_uint(&probe, &cmd->id)) {
+            cmd->has_id = true;
+            r = probe;
+        } else {
+            bad_id |= command_key_is(key, "id");
+            json_reader_skip(&r);
+        }
+    }
+    if (!json_reader_end(&r)) {
+        return COMMAND_ERR_PARSE;
+    }
+
+    for (int t = COMMAND_PROFILE; t <= COMMAND_MONITOR; t++) {
+        if (has_name && strcmp(name, command_names[t]) == 0) {
+            cmd->type = (command_type_t)t;
+            return bad_id ? COMMAND_ERR_INVALID : COMMAND_OK;
+        }
+    }
+    return COMMAND_ERR_UNKNOWN;
+}
+
+/**
+ * @brief Lee la lista de frecuencias de un perfil
+ */
+static bool command_parse_list(json_reader_t *r, command_t *cmd) {
+    uint16_t count = 0;
+
+    if (!json_reader_begin_array(r)) {
+        return false;
+    }
+    while (json_reader_next_element(r)) {
+        if (count == SWEEP_NUM_POINTS) {
+            return false;
+        }
+        if (!json_reader_float(r, &cmd->list_hz[count]) || !command_valid_freq(cmd->list_hz[count])) {
+            return false;
+        }
+        count++;
+    }
+    if (count == 0) {
+        return false;
+    }
+    cmd->spec.points = count;
+    cmd->spec.list_hz = cmd->list_hz;
+    return true;
+}
+
+/**
+ * @brief Lee un campo de "profile"
+ *
+ * @return false si la clave no es del perfil o el valor no sirve
+ */
+static bool command_parse_profile_field(json_reader_t *r, const char *key, command_t *cmd,
+                                        bool *has_grid, bool *has_points) {
+    sweep_plan_spec_t *spec = &cmd->spec;
+    uint32_t u;
+    float f;
+
+    if (command_key_is(key, "grid")) {
+        char grid[COMMAND_KEY_MAX];
+        if (!json_reader_string(r, grid, sizeof(grid))) {
+            return false;
+        }
+        *has_grid = true;
+        if (strcmp(grid, "lin") == 0) {
+            spec->grid = SWEEP_GRID_LINEAR;
+        } else if (strcmp(grid, "log") == 0) {
+            spec->grid = SWEEP_GRID_LOG;
+        } else if (strcmp(grid, "list") == 0) {
+            spec->grid = SWEEP_GRID_LIST;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (command_key_is(key, "start")) {
+        return json_reader_float(r, &spec->start_hz) && command_valid_freq(spec->start_hz);
+    }
+    if (command_key_is(key, "stop")) {
+        return json_reader_float(r, &spec->stop_hz) && command_valid_freq(spec->stop_hz);
+    }
+    if (command_key_is(key, "points")) {
+        if (!json_reader_uint(r, &u) || u == 0 || u > SWEEP_NUM_POINTS) {
+            return false;
+        }
+        spec->points = (uint16_t)u;
+        *has_points = true;
+        return true;
+    }
+    if (command_key_is(key, "list")) {
+        return command_parse_list(r, cmd);
+    }
+    if (command_key_is(key, "averages")) {
+        if (!json_reader_uint(r, &u) || u == 0 || u > UINT8_MAX) {
+            return false;
+        }
+        spec->averages = (uint8_t)u;
+        return true;
+    }
+    if (command_key_is(key, "window")) {
+        if (!json_reader_uint(r, &u) || u == 0 || u > ADC_CAPTURE_MAX_SAMPLES) {
+            return false;
+        }
+        spec->max_window = (uint16_t)u;
+        return true;
+    }
+    if (command_key_is(key, "snr")) {
+        // <= 0: la ventana más larga
+        if (!json_reader_float(r, &f) || f > COMMAND_SNR_MAX_DB) {
+            return false;
+        }
+        spec->target_snr_db = f;
+        return true;
+    }
+    if (command_key_is(key, "max_windows")) {
+        if (!json_reader_uint(r, &u) || u == 0 || u > COMMAND_MAX_WINDOWS_LIMIT) {
+            return false;
+        }
+        spec->average.max_windows = (uint16_t)u;
+        return true;
+    }
+    if (command_key_is(key, "stderr_db")) {
+        if (!json_reader_float(r, &f) || !(f > 0.0f)) {
+            return false;
+        }
+        spec->average.stderr_db = f;
+        return true;
+    }
+    if (command_key_is(key, "stderr_deg")) {
+        if (!json_reader_float(r, &f) || !(f > 0.0f)) {
+            return false;
+        }
+        spec->average.stderr_deg = f;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Lee un campo de "monitor"
+ *
+ * Solo acota cada campo por su tipo; la combinación (hop <= window, bin
+ * coherente) la valida monitor_check_spec() al final.
+ */
+static bool command_parse_monitor_field(json_reader_t *r, const char *key, command_t *cmd) {
+    monitor_spec_t *spec = &cmd->monitor;
+    uint32_t u;
+
+    if (command_key_is(key, "freq")) {
+        return json_reader_float(r, &spec->freq_hz) && command_valid_freq(spec->freq_hz);
+    }
+    if (command_key_is(key, "window") || command_key_is(key, "hop") || command_key_is(key, "batch")) {
+        if (!json_reader_uint(r, &u) || u > UINT8_MAX) {
+            return false;
+        }
+        if (command_key_is(key, "window")) {
+            spec->window_blocks = (uint8_t)u;
+        } else if (command_key_is(key, "hop")) {
+            spec->hop_blocks = (uint8_t)u;
+        } else {
+            spec->batch = (uint8_t)u;
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Lee un campo de "point" o "rate" ("start" y "stop" no llevan)
+ */
+static bool command_parse_field(json_reader_t *r, const char *key, command_t *cmd) {
+    uint32_t u;
+
+    if (cmd->type == COMMAND_POINT && command_key_is(key, "freq")) {
+        return json_reader_float(r, &cmd->freq_hz) && command_valid_freq(cmd->freq_hz);
+    }
+    if (cmd->type == COMMAND_RATE && command_key_is(key, "interval_ms")) {
+        if (!json_reader_uint(r, &u) || u > COMMAND_INTERVAL_MAX_MS) {
+            return false;
+        }
+        cmd->interval_ms = u;
+        cmd->has_interval = true;
+        return true;
+    }
+    if (cmd->type == COMMAND_RATE && command_key_is(key, "frame_points")) {
+        if (!json_reader_uint(r, &u) || u > SWEEP_NUM_POINTS) {
+            return false;
+        }
+        cmd->frame_points = (uint16_t)u;
+        cmd->has_frame_points = true;
+        return true;
+    }
+    return false;
+}
+
+command_error_t command_parse(const char *payload, size_t len, command_t *cmd) {
+    cmd->type = COMMAND_NONE;
+    cmd->id = 0;
+    cmd->has_id = false;
+    cmd->spec = command_profile;
+    cmd->spec.list_hz = (command_profile.grid == SWEEP_GRID_LIST) ? command_profile_list : NULL;
+    cmd->freq_hz = 0.0f;
+    cmd->interval_ms = command_interval;
+    cmd->frame_points = frequency_sweep_get_frame_points();
+    cmd->has_interval = false;
+    cmd->has_frame_points = false;
+    monitor_get_spec(&cmd->monitor);
+
+    command_error_t error = command_parse_header(payload, len, cmd);
+    if (error != COMMAND_OK) {
+        return error;
+    }
+
+    // Segunda pasada: la sintaxis ya es válida, así que cualquier falla del
+    // lector es un valor del tipo equivocado
+    json_reader_t r;
+    char key[COMMAND_KEY_MAX];
+    bool has_grid = false;
+    bool has_points = false;
+    bool has_freq = false;
+    sweep_grid_t previous_grid = cmd->spec.grid;
+
+    json_reader_init(&r, payload, len);
+    json_reader_begin_object(&r);
+    while (json_reader_next_key(&r, key, sizeof(key))) {
+        bool ok;
+        if (command_key_is(key, "cmd") || command_key_is(key, "id")) {
+            ok = json_reader_skip(&r);
+        } else if (cmd->type == COMMAND_PROFILE) {
+            ok = command_parse_profile_field(&r, key, cmd, &has_grid, &has_points);
+        } else if (cmd->type == COMMAND_MONITOR) {
+            ok = command_parse_monitor_field(&r, key, cmd);
+        } else {
+            ok = command_parse_field(&r, key, cmd);
+            has_freq |= (ok && cmd->type == COMMAND_POINT);
+        }
+        if (!ok) {
+            return COMMAND_ERR_INVALID;
+        }
+    }
+
+    switch (cmd->type) {
+        case COMMAND_PROFILE: {
+            sweep_plan_spec_t *spec = &cmd->spec;
+            bool new_list = (spec->list_hz == cmd->list_hz);
+            if (new_list && !has_grid) {
+                // Mandar la lista alcanza para pasar a la grilla LIST
+                spec->grid = SWEEP_GRID_LIST;
+            }
+            if (spec->grid == SWEEP_GRID_LIST) {
+                // La lista manda sobre "points"; sin lista nueva vale la
+                // vigente solo si ya era una grilla LIST
+                if (has_points || (!new_list && previous_grid != SWEEP_GRID_LIST)) {
+                    return COMMAND_ERR_INVALID;
+                }
+            } else {
+                if (new_list || !(spec->stop_hz > spec->start_hz)) {
+                    return COMMAND_ERR_INVALID;
+                }
+                spec->list_hz = NULL;
+            }
+            if (spec->averages > spec->max_window) {
+                return COMMAND_ERR_INVALID;
+            }
+            break;
+        }
+        case COMMAND_POINT:
+            if (!has_freq) {
+                return COMMAND_ERR_INVALID;
+            }
+            break;
+        case COMMAND_RATE:
+            if (!cmd->has_interval && !cmd->has_frame_points) {
+                return COMMAND_ERR_INVALID;
+            }
+            break;
+        case COMMAND_MONITOR:
+            if (!monitor_check_spec(&cmd->monitor, NULL)) {
+                return COMMAND_ERR_INVALID;
+            }
+            break;
+        default:
+            break;
+    }
+    return COMMAND_OK;
+}
+
+static bool command_sweep_busy(void) {
+    sweep_status_t status = frequency_sweep_status();
+    return status == SWEEP_RUNNING || status == SWEEP_PAUSED;
+}
+
+/**
+ * @brief Aplica un perfil ya validado
+ *
+ * Si el plan no se puede construir (una frecuencia que no entra en la
+ * ventana, por ejemplo) vuelve a aplicar el perfil anterior, que sí se
+ * pudo, en lugar de quedar en la grilla de config.h.
+ */
+static command_error_t command_apply_profile(command_t *cmd, command_ack_t *ack) {
+    if (command_sweep_busy()) {
+        return COMMAND_ERR_BUSY;
+    }
+
+    if (!frequency_sweep_set_plan(&cmd->spec)) {
+        sweep_plan_spec_t previous = command_profile;
+        previous.list_hz = (previous.grid == SWEEP_GRID_LIST) ? command_profile_list : NULL;
+        frequency_sweep_set_plan(&previous);
+        return COMMAND_ERR_FAILED;
+    }
+
+    if (cmd->spec.list_hz == cmd->list_hz) {
+        memcpy(command_profile_list, cmd->list_hz, cmd->spec.points * sizeof(float));
+    }
+    command_profile = cmd->spec;
+    command_profile.list_hz = NULL;
+    ack->points = frequency_sweep_get_plan()->count;
+    return COMMAND_OK;
+}
+
+static command_error_t command_execute(command_t *cmd, command_ack_t *ack) {
+    switch (cmd->type) {
+        case COMMAND_PROFILE:
+            return command_apply_profile(cmd, ack);
+
+        case COMMAND_POINT:
+            if (command_sweep_busy() || monitor_active()) {
+                return COMMAND_ERR_BUSY;
+            }
+            return frequency_sweep_single_point(cmd->freq_hz) ? COMMAND_OK : COMMAND_ERR_FAILED;
+
+        case COMMAND_START:
+            if (command_sweep_busy() || monitor_active()) {
+                return COMMAND_ERR_BUSY;
+            }
+            command_enabled = true;
+            command_start_pending = true;
+            return COMMAND_OK;
+
+        case COMMAND_STOP:
+            command_enabled = false;
+            command_start_pending = false;
+            if (command_sweep_busy()) {
+                frequency_sweep_abort();
+            }
+            monitor_stop();
+            return COMMAND_OK;
+
+        case COMMAND_RATE:
+            if (cmd->has_frame_points && !frequency_sweep_set_frame_points(cmd->frame_points)) {
+                return COMMAND_ERR_BUSY;
+            }
+            if (cmd->has_interval) {
+                command_interval = cmd->interval_ms;
+            }
+            return COMMAND_OK;
+
+        case COMMAND_MONITOR:
+            if (command_sweep_busy()) {
+                return COMMAND_ERR_BUSY;
+            }
+            if (!monitor_start(&cmd->monitor)) {
+                return COMMAND_ERR_FAILED;
+            }
+            monitor_check_spec(&cmd->monitor, &ack->freq_hz);
+            return COMMAND_OK;
+
+        default:
+            return COMMAND_ERR_UNKNOWN;
+    }
+}
+
+uint32_t command_poll(void) {
+    uint32_t processed = 0;
+    uint8_t handle;
+
+    while (spsc_queue_pop(&command_ready, &handle)) {
+        command_slot_t *slot = &command_slots[handle];
+        command_t *cmd = &command_current;
+        command_ack_t ack = { 0 };
+
+        ack.error = slot->truncated ? COMMAND_ERR_PARSE : command_parse(slot->payload, slot->len, cmd);
+        if (slot->truncated) {
+            cmd->type = COMMAND_NONE;
+            cmd->has_id = false;
+        }
+        // El payload ya no hace falta: devolver el slot antes de ejecutar
+        spsc_queue_push(&command_free, handle);
+
+        if (ack.error == COMMAND_OK) {
+            ack.error = command_execute(cmd, &ack);
+        }
+        ack.type = cmd->type;
+        ack.id = cmd->id;
+        ack.has_id = cmd->has_id;
+
+        if (ack.error == COMMAND_OK) {
+            command_stats.executed++;
+            DEBUG_PRINT(2, "[CMD] %s ok\n", command_name(ack.type));
+        } else {
+            command_stats.rejected++;
+            DEBUG_PRINT(1, "[CMD] Comando rechazado: %s (%s)\n",
+                        command_name(ack.type) ? command_name(ack.type) : "?",
+                        command_error_name(ack.error));
+        }
+        mqtt_publish_command_ack(&ack);
+        processed++;
+    }
+    return processed;
+}
+
+size_t command_format_ack(const command_ack_t *ack, char *buf, size_t capacity) {
+    json_writer_t w;
+    json_writer_init(&w, buf, capacity);
+    json_writer_begin_object(&w);
+    json_writer_key(&w, "status");
+    json_writer_string(&w, "ack");
+    if (command_name(ack->type)) {
+        json_writer_key(&w, "cmd");
+        json_writer_string(&w, command_name(ack->type));
+    }
+    if (ack->has_id) {
+        json_writer_key(&w, "id");
+        json_writer_uint(&w, ack->id);
+    }
+    json_writer_key(&w, "ok");
+    json_writer_bool(&w, ack->error == COMMAND_OK);
+    if (ack->error != COMMAND_OK) {
+        json_writer_key(&w, "error");
+        json_writer_string(&w, command_error_name(ack->error));
+    } else if (ack->type == COMMAND_PROFILE) {
+        json_writer_key(&w, "points");
+        json_writer_uint(&w, ack->points);
+    } else if (ack->type == COMMAND_MONITOR) {
+        json_writer_key(&w, "freq");
+        json_writer_fixed(&w, ack->freq_hz, JSON_FREQ_DECIMALS);
+    }
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
+}
+
+bool command_sweeps_enabled(void) {
+    return command_enabled;
+}
+
+uint32_t command_interval_ms(void) {
+    return command_interval;
+}
+
+bool command_take_start(void) {
+    bool pending = command_start_pending;
+    command_start_pending = false;
+    return pending;
+}
+
+void command_get_stats(command_stats_t *stats) {
+    *stats = command_stats;
+}
@@ -2,15 +2,316 @@
  * @file goertzel.c
  * @brief Implementación del algoritmo de Goertzel
  * 
- * ESTADO: STUB - Implementación mínima para compilación
- * TODO: Implementar algoritmo completo en punto flotante
+ * Filtro IIR de segundo orden en punto flotante de 32 bits, o en punto
+ * fijo (coeficientes Q30, estado int32 Q4, productos de 64 bits) sobre
+ * los códigos crudos del ADC. La fase se entrega en la convención de la
+ * DFT, referida a la primera muestra de la ventana.
  */
 
 #include "goertzel.h"
+#include "debug.h"
+#include <stdbool.h>
 #include <stdlib.h>
-#include <stdio.h>
 #include <math.h>
 
+// Piso de magnitud para evitar log10(0)
+#define GOERTZEL_MAG_FLOOR 1e-9f
+
+// Kernel por defecto si config.h no lo define
+#ifndef GOERTZEL_DEFAULT_KERNEL
+#define GOERTZEL_DEFAULT_KERNEL GOERTZEL_KERNEL_FLOAT
+#endif
+
+// Límite de N/sin(omega) para que el estado Q4 no desborde int32
+// (2048 * N / (2*sin) * 2^4 < 2^31)
+#define GOERTZEL_FIXED_MAX_GAIN 131072.0f
+
+static goertzel_kernel_t active_kernel = GOERTZEL_DEFAULT_KERNEL;
+
+/**
+ * @brief Convierte un real en [-2, 2] a Q con saturación
+ */
+static int32_t goertzel_to_q(float value, int frac_bits) {
+    float scaled = ldexpf(value, frac_bits);
+    if (scaled >= 2147483647.0f) {
+        return INT32_MAX;
+    }
+    if (scaled <= -2147483648.0f) {
+        return INT32_MIN;
+    }
+    return (int32_t)lrintf(scaled);
+}
+
+/**
+ * @brief Bin de la DFT a partir del estado final del filtro
+ *
+ * Un paso extra con entrada nula lleva el resultado exactamente al bin
+ * de la DFT: X = s1*cos(w) - s2 + j*s1*sin(w).
+ */
+static void goertzel_bin(
+    float s_prev,
+    float s_prev2,
+    const goertzel_coeffs_t *coeffs,
+    float *real,
+    float *imag
+) {
+    *real = s_prev * coeffs->cos_omega - s_prev2;
+    *imag = s_prev * coeffs->sin_omega;
+}
+
+/**
+ * @brief Bin del kernel fijo: X en acumuladores de 64 bits
+ * 
+ * X = s1*cos - s2 + j*s1*sin en Q(4+31); la conversión a float ocurre
+ * una sola vez por punto.
+ */
+static void goertzel_bin_fixed(
+    int32_t s_prev,
+    int32_t s_prev2,
+    const goertzel_coeffs_t *coeffs,
+    float *real,
+    float *imag
+) {
+    // Escalados con producto: desplazar a izquierda un negativo es UB en C
+    int64_t re = (int64_t)s_prev * coeffs->cos_q31 - (int64_t)s_prev2 * ((int64_t)1 << 31);
+    int64_t im = (int64_t)s_prev * coeffs->sin_q31;
+    
+    // Volver a la escala normalizada del kernel float (códigos/2048)
+    const float to_unit = 1.0f / (2048.0f * (float)(1 << GOERTZEL_FIXED_STATE_FRAC_BITS)
+                                  * 2147483648.0f);
+    *real = (float)re * to_unit;
+    *imag = (float)im * to_unit;
+}
+
+/**
+ * @brief Magnitud y fase de un bin
+ */
+static void goertzel_polar(float real, float imag, float scale, goertzel_result_t *result) {
+    // Amplitud de pico normalizada a fondo de escala
+    result->magnitude = sqrtf(real * real + imag * imag) * scale;
+    result->magnitude_db = 20.0f * log10f(fmaxf(result->magnitude, GOERTZEL_MAG_FLOOR));
+    result->phase_rad = atan2f(imag, real);
+    result->phase_deg = result->phase_rad * (180.0f / (float)M_PI);
+}
+
+/**
+ * @brief Convierte el estado final del filtro en magnitud y fase
+ */
+static void goertzel_finalize(
+    float s_prev,
+    float s_prev2,
+    const goertzel_coeffs_t *coeffs,
+    float scale,
+    goertzel_result_t *result
+) {
+    float real, imag;
+    goertzel_bin(s_prev, s_prev2, coeffs, &real, &imag);
+    goertzel_polar(real, imag, scale, result);
+}
+
+/**
+ * @brief Cierre del kernel fijo
+ */
+static void goertzel_finalize_fixed(
+    int32_t s_prev,
+    int32_t s_prev2,
+    const goertzel_coeffs_t *coeffs,
+    float scale,
+    goertzel_result_t *result
+) {
+    float real, imag;
+    goertzel_bin_fixed(s_prev, s_prev2, coeffs, &real, &imag);
+    goertzel_polar(real, imag, scale, result);
+}
+
+/**
+ * @brief Lazo IIR en float sobre muestras normalizadas a [-1, +1]
+ * 
+ * Continúa desde el estado recibido, de modo que procesar un buffer en
+ * bloques da exactamente el mismo resultado que de una vez.
+ */
+static inline void goertzel_iir_float(
+    const uint16_t *samples,
+    uint32_t num_samples,
+    float coeff,
+    float *state_prev,
+    float *state_prev2
+) {
+    float s_prev = *state_prev;
+    float s_prev2 = *state_prev2;
+    
+    for (uint32_t n = 0; n < num_samples; n++) {
+        float x = ((float)samples[n] - 2048.0f) * (1.0f / 2048.0f);
+        float s = x + coeff * s_prev - s_prev2;
+        s_prev2 = s_prev;
+        s_prev = s;
+    }
+    
+    *state_prev = s_prev;
+    *state_prev2 = s_prev2;
+}
+
+/**
+ * @brief Lazo IIR en punto fijo sobre códigos crudos de 12 bits
+ * 
+ * Solo aritmética entera por muestra (una multiplicación 32x32->64).
+ */
+static inline void goertzel_iir_fixed(
+    const uint16_t *samples,
+    uint32_t num_samples,
+    int32_t coeff,
+    int32_t *state_prev,
+    int32_t *state_prev2
+) {
+    const int64_t round_q30 = (int64_t)1 << 29;
+    int32_t s_prev = *state_prev;
+    int32_t s_prev2 = *state_prev2;
+    
+    for (uint32_t n = 0; n < num_samples; n++) {
+        int32_t x = ((int32_t)samples[n] - 2048) * (1 << GOERTZEL_FIXED_STATE_FRAC_BITS);
+        int32_t feedback = (int32_t)(((int64_t)coeff * s_prev + round_q30) >> 30);
+        int32_t s = x + feedback - s_prev2;
+        s_prev2 = s_prev;
+        s_prev = s;
+    }
+    
+    *state_prev = s_prev;
+    *state_prev2 = s_prev2;
+}
+
+/**
+ * @brief Lazo IIR float de dos canales sobre pares intercalados
+ * 
+ * Las dos recurrencias son independientes: intercaladas en el mismo lazo
+ * el pipeline de la FPU solapa una con la otra.
+ */
+static inline void goertzel_iir_float_pair(
+    const uint16_t *frames,
+    uint32_t num_frames,
+    float coeff,
+    float state[4]
+) {
+    float a_prev = state[0];
+    float a_prev2 = state[1];
+    float b_prev = state[2];
+    float b_prev2 = state[3];
+    
+    for (uint32_t n = 0; n < num_frames; n++) {
+        float xa = ((float)frames[2 * n] - 2048.0f) * (1.0f / 2048.0f);
+        float xb = ((float)frames[2 * n + 1] - 2048.0f) * (1.0f / 2048.0f);
+        float sa = xa + coeff * a_prev - a_prev2;
+        float sb = xb + coeff * b_prev - b_prev2;
+        a_prev2 = a_prev;
+        a_prev = sa;
+        b_prev2 = b_prev;
+        b_prev = sb;
+    }
+    
+    state[0] = a_prev;
+    state[1] = a_prev2;
+    state[2] = b_prev;
+    state[3] = b_prev2;
+}
+
+/**
+ * @brief Lazo IIR fijo de dos canales sobre pares intercalados
+ */
+static inline void goertzel_iir_fixed_pair(
+    const uint16_t *frames,
+    uint32_t num_frames,
+    int32_t coeff,
+    int32_t state[4]
+) {
+    const int64_t round_q30 = (int64_t)1 << 29;
+    int32_t a_prev = state[0];
+    int32_t a_prev2 = state[1];
+    int32_t b_prev = state[2];
+    int32_t b_prev2 = state[3];
+    
+    for (uint32_t n = 0; n < num_frames; n++) {
+        int32_t xa = ((int32_t)frames[2 * n] - 2048) * (1 << GOERTZEL_FIXED_STATE_FRAC_BITS);
+        int32_t xb = ((int32_t)frames[2 * n + 1] - 2048) * (1 << GOERTZEL_FIXED_STATE_FRAC_BITS);
+        int32_t sa = xa + (int32_t)(((int64_t)coeff * a_prev + round_q30) >> 30) - a_prev2;
+        int32_t sb = xb + (int32_t)(((int64_t)coeff * b_prev + round_q30) >> 30) - b_prev2;
+        a_prev2 = a_prev;
+        a_prev = sa;
+        b_prev2 = b_prev;
+        b_prev = sb;
+    }
+    
+    state[0] = a_prev;
+    state[1] = a_prev2;
+    state[2] = b_prev;
+    state[3] = b_prev2;
+}
+
+/**
+ * @brief Kernel efectivo para un bin y una longitud de ventana
+ * 
+ * El kernel fijo solo se usa si el estado Q4 no puede desbordar int32.
+ */
+static goertzel_kernel_t goertzel_effective_kernel(
+    const goertzel_coeffs_t *coeffs,
+    uint32_t num_samples
+) {
+    bool fixed_safe = (float)num_samples < GOERTZEL_FIXED_MAX_GAIN * fabsf(coeffs->sin_omega);
+    
+    if (active_kernel == GOERTZEL_KERNEL_FIXED && fixed_safe) {
+        return GOERTZEL_KERNEL_FIXED;
+    }
+    return GOERTZEL_KERNEL_FLOAT;
+}
+
+/**
+ * @brief Iteración del filtro IIR con el kernel seleccionado
+ */
+static void goertzel_run(
+    const uint16_t *samples,
+    uint16_t num_samples,
+    const goertzel_coeffs_t *coeffs,
+    float scale,
+    goertzel_result_t *result
+) {
+    if (goertzel_effective_kernel(coeffs, num_samples) == GOERTZEL_KERNEL_FIXED) {
+        int32_t s_prev = 0;
+        int32_t s_prev2 = 0;
+        goertzel_iir_fixed(samples, num_samples, coeffs->coeff_q30, &s_prev, &s_prev2);
+        goertzel_finalize_fixed(s_prev, s_prev2, coeffs, scale, result);
+    } else {
+        float s_prev = 0.0f;
+        float s_prev2 = 0.0f;
+        goertzel_iir_float(samples, num_samples, coeffs->coeff, &s_prev, &s_prev2);
+        goertzel_finalize(s_prev, s_prev2, coeffs, scale, result);
+    }
+    
+    DEBUG_PRINT(3, "[GOERTZEL] freq=%.2f Hz: mag=%.4f, mag_db=%.2f dB, phase=%.1f°\n",
+                coeffs->freq_hz, result->magnitude, result->magnitude_db, result->phase_deg);
+}
+
+void goertzel_set_kernel(goertzel_kernel_t kernel) {
+    active_kernel = kernel;
+}
+
+goertzel_kernel_t goertzel_get_kernel(void) {
+    return active_kernel;
+}
+
+void goertzel_coeffs_init(
+    goertzel_coeffs_t *coeffs,
+    float target_freq_hz,
+    float sample_rate_hz
+) {
+    float omega = 2.0f * (float)M_PI * target_freq_hz / sample_rate_hz;
+    
+    coeffs->freq_hz = target_freq_hz;
+    coeffs->cos_omega = cosf(omega);
+    coeffs->sin_omega = sinf(omega);
+    coeffs->coeff = 2.0f * coeffs->cos_omega;
+    coeffs->coeff_q30 = goertzel_to_q(coeffs->coeff, 30);
+    coeffs->cos_q31 = goertzel_to_q(coeffs->cos_omega, 31);
+    coeffs->sin_q31 = goertzel_to_q(coeffs->sin_omega, 31);
+}
+
 void goertzel_compute(
     const uint16_t *samples,
     uint16_t num_samples,
@@ -18,23 +319,225 @@ void goertzel_compute(
     float sample_rate_hz,
     goertzel_result_t *result
 ) {
-    printf("[GOERTZEL] Procesando %d muestras, freq=%.2f Hz (STUB)\n", 
-           num_samples, target_freq_hz);
+    goertzel_coeffs_t coeffs;
+    goertzel_coeffs_init(&coeffs, target_freq_hz, sample_rate_hz);
+    goertzel_run(samples, num_samples, &coeffs, 2.0f / (float)num_samples, result);
+}
+
+void goertzel_stream_init(
+    goertzel_stream_t *stream,
+    const goertzel_coeffs_t *coeffs,
+    uint32_t expected_samples
+) {
+    stream->coeffs = coeffs;
+    stream->kernel = goertzel_effective_kernel(coeffs, expected_samples);
+    stream->count = 0;
+    stream->s_prev = 0.0f;
+    stream->s_prev2 = 0.0f;
+    stream->q_prev = 0;
+    stream->q_prev2 = 0;
+}
+
+void goertzel_stream_push(
+    goertzel_stream_t *stream,
+    const uint16_t *block,
+    uint32_t num_samples
+) {
+    if (stream->kernel == GOERTZEL_KERNEL_FIXED) {
+        goertzel_iir_fixed(block, num_samples, stream->coeffs->coeff_q30,
+                           &stream->q_prev, &stream->q_prev2);
+    } else {
+        goertzel_iir_float(block, num_samples, stream->coeffs->coeff,
+                           &stream->s_prev, &stream->s_prev2);
+    }
+    stream->count += num_samples;
+}
+
+void goertzel_stream_result(
+    const goertzel_stream_t *stream,
+    goertzel_result_t *result
+) {
+    float scale = 2.0f / (float)stream->count;
     
-    // TODO: Implementar algoritmo completo
-    // 1. Precálculo de coeficientes
-    // 2. Iteración del filtro IIR
-    // 3. Cálculo de componentes real e imaginaria
-    // 4. Cálculo de magnitud y fase
+    if (stream->kernel == GOERTZEL_KERNEL_FIXED) {
+        goertzel_finalize_fixed(stream->q_prev, stream->q_prev2, stream->coeffs, scale, result);
+    } else {
+        goertzel_finalize(stream->s_prev, stream->s_prev2, stream->coeffs, scale, result);
+    }
+}
+
+void goertzel_stream_bin(
+    const goertzel_stream_t *stream,
+    float *real,
+    float *imag
+) {
+    if (stream->kernel == GOERTZEL_KERNEL_FIXED) {
+        goertzel_bin_fixed(stream->q_prev, stream->q_prev2, stream->coeffs, real, imag);
+    } else {
+        goertzel_bin(stream->s_prev, stream->s_prev2, stream->coeffs, real, imag);
+    }
+}
+
+void goertzel_pair_init(
+    goertzel_pair_t *pair,
+    const goertzel_coeffs_t *coeffs,
+    uint32_t expected_frames
+) {
+    goertzel_stream_init(&pair->reference, coeffs, expected_frames);
+    goertzel_stream_init(&pair->response, coeffs, expected_frames);
+}
+
+void goertzel_pair_push(
+    goertzel_pair_t *pair,
+    const uint16_t *frames,
+    uint32_t num_frames
+) {
+    goertzel_stream_t *ref = &pair->reference;
+    goertzel_stream_t *resp = &pair->response;
     
-    // Por ahora, generar resultados ficticios razonables
-    result->magnitude = 0.5f;  // Magnitud arbitraria
-    result->magnitude_db = 20.0f * log10f(result->magnitude);
-    result->phase_rad = 0.0f;
-    result->phase_deg = 0.0f;
+    if (ref->kernel == GOERTZEL_KERNEL_FIXED) {
+        int32_t state[4] = { ref->q_prev, ref->q_prev2, resp->q_prev, resp->q_prev2 };
+        goertzel_iir_fixed_pair(frames, num_frames, ref->coeffs->coeff_q30, state);
+        ref->q_prev = state[0];
+        ref->q_prev2 = state[1];
+        resp->q_prev = state[2];
+        resp->q_prev2 = state[3];
+    } else {
+        float state[4] = { ref->s_prev, ref->s_prev2, resp->s_prev, resp->s_prev2 };
+        goertzel_iir_float_pair(frames, num_frames, ref->coeffs->coeff, state);
+        ref->s_prev = state[0];
+        ref->s_prev2 = state[1];
+        resp->s_prev = state[2];
+        resp->s_prev2 = state[3];
+    }
+    ref->count += num_frames;
+    resp->count += num_frames;
+}
+
+void goertzel_pair_result(
+    const goertzel_pair_t *pair,
+    goertzel_result_t *reference,
+    goertzel_result_t *response
+) {
+    goertzel_stream_result(&pair->reference, reference);
+    goertzel_stream_result(&pair->response, response);
+}
+
+void goertzel_transfer(
+    const goertzel_result_t *reference,
+    const goertzel_result_t *response,
+    float phase_offset_rad,
+    goertzel_result_t *h
+) {
+    float magnitude = response->magnitude / fmaxf(reference->magnitude, GOERTZEL_MAG_FLOOR);
+    float phase = remainderf(response->phase_rad - reference->phase_rad + phase_offset_rad,
+                             2.0f * (float)M_PI);
     
-    printf("[GOERTZEL] Resultado: mag=%.3f, mag_db=%.2f dB, phase=%.1f° (stub)\n",
-           result->magnitude, result->magnitude_db, result->phase_deg);
+    h->magnitude = magnitude;
+    h->magnitude_db = 20.0f * log10f(fmaxf(magnitude, GOERTZEL_MAG_FLOOR));
+    h->phase_rad = phase;
+    h->phase_deg = phase * (180.0f / (float)M_PI);
+}
+
+void goertzel_compute_bins(
+    const uint16_t *samples,
+    uint16_t num_samples,
+    const float *freqs_hz,
+    size_t num_bins,
+    float sample_rate_hz,
+    goertzel_result_t *results
+) {
+    for (size_t base = 0; base < num_bins; base += GOERTZEL_BINS_PER_PASS) {
+        size_t active = num_bins - base;
+        if (active > GOERTZEL_BINS_PER_PASS) {
+            active = GOERTZEL_BINS_PER_PASS;
+        }
+        
+        // Estado en estructura de arreglos. Los carriles sobrantes del último
+        // grupo repiten el último bin: el lazo interno mantiene longitud fija
+        // y el compilador lo desenrolla/vectoriza por completo.
+        goertzel_coeffs_t bins[GOERTZEL_BINS_PER_PASS];
+        float coeff[GOERTZEL_BINS_PER_PASS];
+        float s_prev[GOERTZEL_BINS_PER_PASS];
+        float s_prev2[GOERTZEL_BINS_PER_PASS];
+        
+        for (size_t b = 0; b < GOERTZEL_BINS_PER_PASS; b++) {
+            size_t idx = base + (b < active ? b : active - 1);
+            goertzel_coeffs_init(&bins[b], freqs_hz[idx], sample_rate_hz);
+            coeff[b] = bins[b].coeff;
+            s_prev[b] = 0.0f;
+            s_prev2[b] = 0.0f;
+        }
+        
+        // Una sola pasada sobre el buffer para todo el grupo
+        for (uint16_t n = 0; n < num_samples; n++) {
+            float x = ((float)samples[n] - 2048.0f) * (1.0f / 2048.0f);
+            for (size_t b = 0; b < GOERTZEL_BINS_PER_PASS; b++) {
+                float s = x + coeff[b] * s_prev[b] - s_prev2[b];
+                s_prev2[b] = s_prev[b];
+                s_prev[b] = s;
+            }
+        }
+        
+        float scale = 2.0f / (float)num_samples;
+        for (size_t b = 0; b < active; b++) {
+            goertzel_finalize(s_prev[b], s_prev2[b], &bins[b], scale, &results[base + b]);
+        }
+    }
+}
+
+void goertzel_pair_bins(
+    const uint16_t *frames,
+    uint32_t num_frames,
+    const goertzel_coeffs_t *coeffs,
+    size_t num_bins,
+    float *reference,
+    float *response
+) {
+    for (size_t base = 0; base < num_bins; base += GOERTZEL_PAIR_BINS_PER_PASS) {
+        size_t active = num_bins - base;
+        if (active > GOERTZEL_PAIR_BINS_PER_PASS) {
+            active = GOERTZEL_PAIR_BINS_PER_PASS;
+        }
+        
+        // Mismo esquema que goertzel_compute_bins(): carriles de longitud
+        // fija, los sobrantes repiten el último bin
+        float coeff[GOERTZEL_PAIR_BINS_PER_PASS];
+        float a_prev[GOERTZEL_PAIR_BINS_PER_PASS];
+        float a_prev2[GOERTZEL_PAIR_BINS_PER_PASS];
+        float b_prev[GOERTZEL_PAIR_BINS_PER_PASS];
+        float b_prev2[GOERTZEL_PAIR_BINS_PER_PASS];
+        
+        for (size_t b = 0; b < GOERTZEL_PAIR_BINS_PER_PASS; b++) {
+            size_t idx = base + (b < active ? b : active - 1);
+            coeff[b] = coeffs[idx].coeff;
+            a_prev[b] = 0.0f;
+            a_prev2[b] = 0.0f;
+            b_prev[b] = 0.0f;
+            b_prev2[b] = 0.0f;
+        }
+        
+        for (uint32_t n = 0; n < num_frames; n++) {
+            float xa = ((float)frames[2 * n] - 2048.0f) * (1.0f / 2048.0f);
+            float xb = ((float)frames[2 * n + 1] - 2048.0f) * (1.0f / 2048.0f);
+            for (size_t b = 0; b < GOERTZEL_PAIR_BINS_PER_PASS; b++) {
+                float sa = xa + coeff[b] * a_prev[b] - a_prev2[b];
+                float sb = xb + coeff[b] * b_prev[b] - b_prev2[b];
+                a_prev2[b] = a_prev[b];
+                a_prev[b] = sa;
+                b_prev2[b] = b_prev[b];
+                b_prev[b] = sb;
+            }
+        }
+        
+        for (size_t b = 0; b < active; b++) {
+            size_t idx = base + b;
+            goertzel_bin(a_prev[b], a_prev2[b], &coeffs[idx],
+                         &reference[2 * idx], &reference[2 * idx + 1]);
+            goertzel_bin(b_prev[b], b_prev2[b], &coeffs[idx],
+                         &response[2 * idx], &response[2 * idx + 1]);
+        }
+    }
 }
 
 void goertzel_test_synthetic(
@@ -43,14 +546,12 @@ void goertzel_test_synthetic(
     float sample_rate_hz,
     goertzel_result_t *result
 ) {
-    printf("[GOERTZEL] Test sintético con freq=%.2f Hz (STUB)\n", test_freq_hz);
-    
-    // TODO: Implementar generación de senoide sintética y procesamiento
+    DEBUG_PRINT(2, "[GOERTZEL] Test sintético con freq=%.2f Hz\n", test_freq_hz);
     
     // Generar senoide
     uint16_t *test_samples = malloc(num_samples * sizeof(uint16_t));
     if (test_samples == NULL) {
-        printf("[GOERTZEL] ERROR: No se pudo asignar memoria\n");
+        DEBUG_PRINT(0, "[GOERTZEL] ERROR: No se pudo asignar memoria\n");
         return;
     }
     
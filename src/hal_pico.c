@@ -0,0 +1,482 @@
+/**
+ * @file hal_pico.c
+ * @brief Implementación de la HAL sobre el Pico SDK (RP2350)
+ */
+
+#include "hal.h"
+#include "config.h"
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/critical_section.h"
+#include "pico/flash.h"
+#include "pico/multicore.h"
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/spi.h"
+#include "hardware/structs/m33.h"
+
+// Reloj del SPI del AD9833 (el chip admite hasta 40 MHz; 2 MHz es
+// holgado para cables de protoboard)
+#define AD9833_SPI_BAUDRATE 2000000
+
+// La región del almacén de barridos debe caber en la flash de la placa
+#if SWEEP_STORE_FLASH_OFFSET % FLASH_SECTOR_SIZE != 0
+#error "SWEEP_STORE_FLASH_OFFSET debe estar alineado a sector"
+#endif
+#if SWEEP_STORE_FLASH_OFFSET + HAL_FLASH_REGION_SIZE > PICO_FLASH_SIZE_BYTES
+#error "La región del almacén de barridos excede la flash de la placa"
+#endif
+
+// Reloj del ADC del RP2350 (Hz)
+#define ADC_CLOCK_HZ 48000000.0f
+
+// Canal con el que arranca cada captura: la referencia si hay dos
+#if ADC_CHANNELS == 2
+#define HAL_ADC_FIRST_INPUT (ADC_PIN_REFERENCE - 26)
+#else
+#define HAL_ADC_FIRST_INPUT (ADC_PIN_RESPONSE - 26)
+#endif
+
+// En el RP2350 los bits 31:28 de TRANS_COUNT son el campo MODE
+#define DMA_TRANS_COUNT_MASK 0x0FFFFFFFu
+
+// Variables privadas del módulo
+static int dma_chan = -1;
+static dma_channel_config dma_cfg;
+static uint32_t capture_len = 0;
+static critical_section_t hal_crit;
+
+// Captura continua: canales A/B encadenados y destino actual de cada uno
+static int stream_chan[2] = {-1, -1};
+static uint16_t *stream_target[2];
+static uint32_t stream_len = 0;
+static hal_adc_block_cb_t stream_cb = NULL;
+
+// Envío asíncrono de palabras al AD9833
+static bool spi_dma_ready = false;
+static dma_channel_config spi_dma_cfg;
+static hal_spi_done_cb_t spi_done_cb = NULL;
+static void *spi_done_ctx = NULL;
+
+// Trabajo en el core 1 y bandera de fin (la escribe el core 1)
+static void (*core1_entry)(void) = NULL;
+static volatile bool core1_done = true;
+
+// ============================================================================
+// TIEMPO
+// ============================================================================
+
+uint32_t hal_time_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+uint64_t hal_time_us(void) {
+    return time_us_64();
+}
+
+void hal_sleep_ms(uint32_t ms) {
+    sleep_ms(ms);
+}
+
+void hal_sleep_us(uint64_t us) {
+    sleep_us(us);
+}
+
+void hal_wait_event_until_us(uint64_t deadline_us) {
+    best_effort_wfe_or_timeout(from_us_since_boot(deadline_us));
+}
+
+// ============================================================================
+// CONTADOR DE CICLOS (TRAZA)
+// ============================================================================
+
+void hal_cycle_counter_init(void) {
+    // El DWT solo cuenta con el trace habilitado en DEMCR
+    m33_hw->demcr |= M33_DEMCR_TRCENA_BITS;
+    m33_hw->dwt_ctrl |= M33_DWT_CTRL_CYCCNTENA_BITS;
+}
+
+uint32_t hal_cycle_counter(void) {
+    return m33_hw->dwt_cyccnt;
+}
+
+uint32_t hal_cycle_counter_per_us(void) {
+    return clock_get_hz(clk_sys) / 1000000u;
+}
+
+// ============================================================================
+// SECCIÓN CRÍTICA
+// ============================================================================
+
+void hal_critical_enter(void) {
+    critical_section_enter_blocking(&hal_crit);
+}
+
+void hal_critical_exit(void) {
+    critical_section_exit(&hal_crit);
+}
+
+// ============================================================================
+// SEGUNDO NÚCLEO
+// ============================================================================
+
+/**
+ * @brief Envoltorio del core 1: corre el trabajo y queda dormido
+ *
+ * Retornar de la entrada de multicore_launch_core1() no es válido, por eso
+ * el fin se señaliza con core1_done y hal_core1_join() resetea el núcleo.
+ * Mientras corre el trabajo el núcleo es víctima del lockout de
+ * flash_safe_execute(): una escritura en flash desde el core 0 lo detiene
+ * en RAM. Deja de serlo antes de dormir, así nadie espera a un núcleo
+ * reseteado.
+ */
+static void hal_core1_trampoline(void) {
+    hal_cycle_counter_init();
+    flash_safe_execute_core_init();
+    core1_entry();
+    flash_safe_execute_core_deinit();
+    __dmb();
+    core1_done = true;
+    __sev();
+    while (true) {
+        __wfe();
+    }
+}
+
+bool hal_core1_launch(void (*entry)(void)) {
+    if (!core1_done) {
+        return false;
+    }
+    core1_entry = entry;
+    core1_done = false;
+    multicore_reset_core1();
+    multicore_launch_core1(hal_core1_trampoline);
+    return true;
+}
+
+void hal_core1_join(void) {
+    while (!core1_done) {
+        __wfe();
+    }
+    multicore_reset_core1();
+}
+
+void hal_cpu_relax(void) {
+    tight_loop_contents();
+}
+
+// ============================================================================
+// GPIO DE DEBUG
+// ============================================================================
+
+void hal_debug_pin_put(uint32_t pin, bool value) {
+    gpio_put(pin, value);
+}
+
+// ============================================================================
+// SPI (AD9833)
+// ============================================================================
+
+/**
+ * @brief IRQ de DMA del SPI: el bloque ya está en el FIFO TX
+ */
+static void hal_spi_dma_irq(void) {
+    if (!dma_channel_get_irq1_status(AD9833_DMA_CHANNEL)) {
+        return;
+    }
+    dma_channel_acknowledge_irq1(AD9833_DMA_CHANNEL);
+    
+    hal_spi_done_cb_t cb = spi_done_cb;
+    spi_done_cb = NULL;
+    if (cb) {
+        cb(spi_done_ctx);
+    }
+}
+
+bool hal_spi_init(void) {
+    spi_init(AD9833_SPI_INSTANCE, AD9833_SPI_BAUDRATE);
+
+    // AD9833: datos muestreados en flanco descendente con SCLK en alto (modo 2)
+    spi_set_format(AD9833_SPI_INSTANCE, 16, SPI_CPOL_1, SPI_CPHA_0, SPI_MSB_FIRST);
+
+    gpio_set_function(AD9833_PIN_SCK, GPIO_FUNC_SPI);
+    gpio_set_function(AD9833_PIN_MOSI, GPIO_FUNC_SPI);
+
+    // FSYNC lo maneja el periférico: con CPHA=0 el PL022 sube CSn entre
+    // tramas consecutivas, así cada palabra de 16 bits lleva su propio
+    // pulso aunque el FIFO lo llene el DMA sin intervención del CPU
+    gpio_set_function(AD9833_PIN_CS, GPIO_FUNC_SPI);
+
+    if (!spi_dma_ready) {
+        dma_channel_claim(AD9833_DMA_CHANNEL);
+        spi_dma_cfg = dma_channel_get_default_config(AD9833_DMA_CHANNEL);
+        channel_config_set_transfer_data_size(&spi_dma_cfg, DMA_SIZE_16);
+        channel_config_set_read_increment(&spi_dma_cfg, true);
+        channel_config_set_write_increment(&spi_dma_cfg, false);
+        channel_config_set_dreq(&spi_dma_cfg, spi_get_dreq(AD9833_SPI_INSTANCE, true));
+        
+        // DMA_IRQ_0 queda para la captura continua del ADC
+        dma_channel_set_irq1_enabled(AD9833_DMA_CHANNEL, true);
+        irq_set_exclusive_handler(DMA_IRQ_1, hal_spi_dma_irq);
+        irq_set_enabled(DMA_IRQ_1, true);
+        spi_dma_ready = true;
+    }
+
+    return true;
+}
+
+void hal_spi_write16(uint16_t word) {
+    hal_spi_wait();
+    spi_write16_blocking(AD9833_SPI_INSTANCE, &word, 1);
+}
+
+bool hal_spi_write16_async(const uint16_t *words, uint32_t count,
+                           hal_spi_done_cb_t done, void *ctx) {
+    if (dma_channel_is_busy(AD9833_DMA_CHANNEL)) {
+        return false;
+    }
+    
+    spi_done_cb = done;
+    spi_done_ctx = ctx;
+    dma_channel_configure(AD9833_DMA_CHANNEL, &spi_dma_cfg,
+                          &spi_get_hw(AD9833_SPI_INSTANCE)->dr, words, count, true);
+    return true;
+}
+
+bool hal_spi_is_busy(void) {
+    return dma_channel_is_busy(AD9833_DMA_CHANNEL) || spi_is_busy(AD9833_SPI_INSTANCE);
+}
+
+void hal_spi_wait(void) {
+    while (dma_channel_is_busy(AD9833_DMA_CHANNEL)) {
+        tight_loop_contents();
+    }
+    while (spi_is_busy(AD9833_SPI_INSTANCE)) {
+        tight_loop_contents();
+    }
+    
+    // El DMA solo escribe TX: descartar lo recibido y el overrun del FIFO RX
+    while (spi_is_readable(AD9833_SPI_INSTANCE)) {
+        (void)spi_get_hw(AD9833_SPI_INSTANCE)->dr;
+    }
+    spi_get_hw(AD9833_SPI_INSTANCE)->icr = SPI_SSPICR_RORIC_BITS;
+}
+
+// ============================================================================
+// ADC + DMA
+// ============================================================================
+
+bool hal_adc_init(void) {
+    // La sección crítica protege el estado compartido con la IRQ de DMA
+    critical_section_init(&hal_crit);
+
+    adc_init();
+    adc_gpio_init(ADC_PIN_RESPONSE);
+#if ADC_CHANNELS == 2
+    adc_gpio_init(ADC_PIN_REFERENCE);
+    adc_set_round_robin((1u << (ADC_PIN_REFERENCE - 26)) | (1u << (ADC_PIN_RESPONSE - 26)));
+#endif
+    adc_select_input(HAL_ADC_FIRST_INPUT);
+
+    // FIFO habilitado, DREQ con 1 muestra, sin bit de error, 12 bits completos
+    adc_fifo_setup(true, true, 1, false, false);
+
+    // En modo free-running el período de conversión es (1 + div) ciclos
+    adc_set_clkdiv(ADC_CLOCK_HZ / HAL_ADC_CONVERSION_RATE - 1.0f);
+
+    dma_channel_claim(ADC_DMA_CHANNEL);
+    dma_chan = ADC_DMA_CHANNEL;
+
+    dma_cfg = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&dma_cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&dma_cfg, false);
+    channel_config_set_write_increment(&dma_cfg, true);
+    channel_config_set_dreq(&dma_cfg, DREQ_ADC);
+
+    return true;
+}
+
+/**
+ * @brief Detiene el ADC y deja el round-robin apuntando al primer canal
+ *
+ * Espera la conversión en curso antes de vaciar el FIFO: si quedara un
+ * código de más, la captura siguiente arrancaría con los canales cruzados.
+ */
+static void hal_adc_rewind(void) {
+    adc_run(false);
+    while (!(adc_hw->cs & ADC_CS_READY_BITS)) {
+        tight_loop_contents();
+    }
+    adc_fifo_drain();
+    hw_set_bits(&adc_hw->fcs, ADC_FCS_OVER_BITS);   // W1C: desborde anterior
+    adc_select_input(HAL_ADC_FIRST_INPUT);
+}
+
+void hal_adc_start(uint16_t *dst, uint32_t num_samples) {
+    hal_adc_rewind();
+
+    capture_len = num_samples;
+    dma_channel_configure(dma_chan, &dma_cfg, dst, &adc_hw->fifo, num_samples, true);
+    adc_run(true);
+}
+
+bool hal_adc_continue(uint16_t *dst, uint32_t num_samples) {
+    // Con el DMA detenido el ADC sigue llenando la FIFO (4 conversiones);
+    // si desbordó se perdió al menos una y los canales pueden estar cruzados
+    if (!(adc_hw->cs & ADC_CS_START_MANY_BITS) || (adc_hw->fcs & ADC_FCS_OVER_BITS)) {
+        return false;
+    }
+
+    capture_len = num_samples;
+    dma_channel_configure(dma_chan, &dma_cfg, dst, &adc_hw->fifo, num_samples, true);
+    return true;
+}
+
+bool hal_adc_is_busy(void) {
+    return dma_channel_is_busy(dma_chan);
+}
+
+uint32_t hal_adc_samples_done(void) {
+    uint32_t remaining = dma_channel_hw_addr(dma_chan)->transfer_count & DMA_TRANS_COUNT_MASK;
+    return capture_len - remaining;
+}
+
+void hal_adc_wait(void) {
+    dma_channel_wait_for_finish_blocking(dma_chan);
+    adc_run(false);
+}
+
+void hal_adc_abort(void) {
+    adc_run(false);
+    dma_channel_abort(dma_chan);
+    adc_fifo_drain();
+}
+
+/**
+ * @brief IRQ de DMA: rearma el canal que terminó con el buffer que indique
+ *        el callback. El otro canal ya está capturando (encadenado).
+ */
+static void hal_adc_stream_irq(void) {
+    for (int i = 0; i < 2; i++) {
+        int ch = stream_chan[i];
+        if (!dma_channel_get_irq0_status(ch)) {
+            continue;
+        }
+        dma_channel_acknowledge_irq0(ch);
+
+        uint16_t *next = stream_cb(stream_target[i]);
+        stream_target[i] = next;
+        dma_channel_set_write_addr(ch, next, false);
+        dma_channel_set_trans_count(ch, stream_len, false);
+    }
+}
+
+bool hal_adc_stream_start(uint16_t *first, uint16_t *second, uint32_t num_samples,
+                          hal_adc_block_cb_t on_block) {
+    stream_chan[0] = dma_chan;
+    stream_chan[1] = ADC_DMA_CHANNEL_PONG;
+    dma_channel_claim(stream_chan[1]);
+
+    stream_target[0] = first;
+    stream_target[1] = second;
+    stream_len = num_samples;
+    stream_cb = on_block;
+
+    hal_adc_rewind();
+
+    // A -> B -> A: el canal que termina dispara al otro sin intervención del CPU
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config cfg = dma_cfg;
+        channel_config_set_chain_to(&cfg, stream_chan[i ^ 1]);
+        dma_channel_configure(stream_chan[i], &cfg, stream_target[i], &adc_hw->fifo,
+                              num_samples, false);
+        dma_channel_set_irq0_enabled(stream_chan[i], true);
+    }
+
+    irq_set_exclusive_handler(DMA_IRQ_0, hal_adc_stream_irq);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    dma_channel_start(stream_chan[0]);
+    adc_run(true);
+    return true;
+}
+
+void hal_adc_stream_stop(void) {
+    adc_run(false);
+
+    irq_set_enabled(DMA_IRQ_0, false);
+    for (int i = 0; i < 2; i++) {
+        dma_channel_set_irq0_enabled(stream_chan[i], false);
+    }
+
+    // Cortar la cadena antes de abortar para que un canal no re-dispare al otro
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config cfg = dma_cfg;
+        channel_config_set_chain_to(&cfg, stream_chan[i]);
+        dma_channel_set_config(stream_chan[i], &cfg, false);
+    }
+    dma_channel_abort(stream_chan[0]);
+    dma_channel_abort(stream_chan[1]);
+    dma_channel_acknowledge_irq0(stream_chan[0]);
+    dma_channel_acknowledge_irq0(stream_chan[1]);
+
+    irq_remove_handler(DMA_IRQ_0, hal_adc_stream_irq);
+    dma_channel_unclaim(stream_chan[1]);
+
+    adc_fifo_drain();
+    stream_cb = NULL;
+}
+
+// ============================================================================
+// FLASH (ALMACÉN DE BARRIDOS)
+// ============================================================================
+
+// Operación a ejecutar con la flash fuera del XIP
+typedef struct {
+    uint32_t offset;
+    const uint8_t *src;
+    uint32_t len;
+} hal_flash_op_t;
+
+static void hal_flash_do_erase(void *param) {
+    const hal_flash_op_t *op = param;
+    flash_range_erase(SWEEP_STORE_FLASH_OFFSET + op->offset, FLASH_SECTOR_SIZE);
+}
+
+static void hal_flash_do_program(void *param) {
+    const hal_flash_op_t *op = param;
+    flash_range_program(SWEEP_STORE_FLASH_OFFSET + op->offset, op->src, op->len);
+}
+
+bool hal_flash_read(uint32_t offset, void *dst, uint32_t len) {
+    if (offset > HAL_FLASH_REGION_SIZE || len > HAL_FLASH_REGION_SIZE - offset) {
+        return false;
+    }
+    // Lectura directa por XIP; flash_range_* invalidan la caché al terminar
+    memcpy(dst, (const void *)(XIP_BASE + SWEEP_STORE_FLASH_OFFSET + offset), len);
+    return true;
+}
+
+bool hal_flash_erase(uint32_t offset) {
+    if (offset % FLASH_SECTOR_SIZE != 0 || offset >= HAL_FLASH_REGION_SIZE) {
+        return false;
+    }
+    // flash_safe_execute() deshabilita las IRQ y, si el core 1 está
+    // corriendo un trabajo (víctima del lockout desde
+    // hal_core1_trampoline()), lo detiene mientras el XIP no está disponible
+    hal_flash_op_t op = { offset, NULL, 0 };
+    return flash_safe_execute(hal_flash_do_erase, &op, UINT32_MAX) == PICO_OK;
+}
+
+bool hal_flash_program(uint32_t offset, const void *src, uint32_t len) {
+    if (offset % FLASH_PAGE_SIZE != 0 || len % FLASH_PAGE_SIZE != 0
+        || offset > HAL_FLASH_REGION_SIZE || len > HAL_FLASH_REGION_SIZE - offset) {
+        return false;
+    }
+    hal_flash_op_t op = { offset, src, len };
+    return flash_safe_execute(hal_flash_do_program, &op, UINT32_MAX) == PICO_OK;
+}
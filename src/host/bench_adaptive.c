@@ -0,0 +1,191 @@
+/**
+ * @file bench_adaptive.c
+ * @brief Barrido adaptativo contra grilla logarítmica fija (fra_bench_adaptive)
+ *
+ * Para cada DUT sintético (RC, RLC y notch) corre el barrido adaptativo y
+ * mide su error de interpolación: la magnitud medida, interpolada
+ * linealmente en log f, contra |H| teórico sobre una grilla densa de
+ * referencia. Después busca la grilla logarítmica más chica que, medida
+ * por el mismo camino (frequency_sweep_measure()), alcanza ese error.
+ * Falla si para algún DUT el adaptativo necesita más puntos.
+ *
+ * El error se evalúa con la magnitud recortada a ERROR_FLOOR_DB por
+ * debajo de la ganancia de paso: en el fondo de un notch el dB diverge y
+ * ninguna grilla finita lo interpola.
+ *
+ * Uso: fra_bench_adaptive [-t tolerancia_db]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "ad9833.h"
+#include "adc_dma.h"
+#include "hal.h"
+#include "hal_host.h"
+#include "mqtt_client.h"
+#include "sim_dut.h"
+#include "sweep.h"
+#include "sweep_adaptive.h"
+#include "sweep_store.h"
+
+// Grilla densa donde se compara la interpolación contra la teoría
+#define REFERENCE_POINTS 2000
+
+// Recorte de la magnitud relativa al evaluar el error (dB)
+#define ERROR_FLOOR_DB -40.0f
+
+typedef struct {
+    const char *name;
+    sim_dut_type_t type;
+    float corner_hz;
+    float q;
+} bench_dut_t;
+
+static const bench_dut_t bench_duts[] = {
+    { "RC 1 kHz",          SIM_DUT_RC_LOWPASS,   1000.0f, 0.0f },
+    { "RLC 2 kHz, Q=10",   SIM_DUT_RLC_BANDPASS, 2000.0f, 10.0f },
+    { "notch 3 kHz, Q=2",  SIM_DUT_NOTCH,        3000.0f, 2.0f },
+};
+
+static float uniform_freq[SWEEP_NUM_POINTS];
+static float uniform_mag[SWEEP_NUM_POINTS];
+
+/**
+ * @brief Magnitud de Goertzel esperada en dB para |H| = 1
+ *
+ * Con dos canales el barrido ya entrega |H|; con uno, la amplitud absoluta
+ * de la respuesta.
+ */
+static float passband_db(const sim_dut_config_t *dut) {
+#if ADC_CHANNELS == 2
+    (void)dut;
+    return 0.0f;
+#else
+    return 20.0f * log10f(dut->amplitude * 4095.0f / 2048.0f);
+#endif
+}
+
+/**
+ * @brief Error máximo (dB) de interpolar en log f los puntos medidos
+ */
+static float interpolation_error(const sim_dut_config_t *dut, const float *freq,
+                                 const float *mag_db, uint16_t count) {
+    float ref_db = passband_db(dut);
+    float worst = 0.0f;
+    uint16_t seg = 0;
+
+    for (uint32_t r = 0; r < REFERENCE_POINTS; r++) {
+        float f = freq[0] * powf(freq[count - 1] / freq[0], (float)r / (REFERENCE_POINTS - 1));
+        while (seg + 2 < count && freq[seg + 1] < f) {
+            seg++;
+        }
+
+        float t = (logf(f) - logf(freq[seg])) / (logf(freq[seg + 1]) - logf(freq[seg]));
+        float interp = mag_db[seg] + t * (mag_db[seg + 1] - mag_db[seg]) - ref_db;
+
+        float h_mag, h_phase;
+        sim_dut_response(f, &h_mag, &h_phase);
+        float expected = 20.0f * log10f(h_mag);
+
+        float err = fabsf(fmaxf(interp, ERROR_FLOOR_DB) - fmaxf(expected, ERROR_FLOOR_DB));
+        if (err > worst) {
+            worst = err;
+        }
+    }
+    return worst;
+}
+
+/**
+ * @brief Mide una grilla logarítmica de n puntos y devuelve su error
+ */
+static float uniform_error(const sim_dut_config_t *dut, uint16_t n, uint32_t *elapsed_ms) {
+    uint32_t t0 = hal_time_ms();
+    for (uint16_t k = 0; k < n; k++) {
+        float f = SWEEP_FREQ_MIN * powf(SWEEP_FREQ_MAX / SWEEP_FREQ_MIN, (float)k / (n - 1));
+        sweep_measurement_t m;
+        frequency_sweep_measure(f, &m);
+        uniform_freq[k] = m.frequency_hz;
+        uniform_mag[k] = m.magnitude_db;
+    }
+    *elapsed_ms = hal_time_ms() - t0;
+    return interpolation_error(dut, uniform_freq, uniform_mag, n);
+}
+
+int main(int argc, char **argv) {
+    sweep_adaptive_params_t params;
+    sweep_adaptive_default_params(&params);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:h")) != -1) {
+        switch (opt) {
+            case 't': params.mag_tol_db = strtof(optarg, NULL); break;
+            default:
+                printf("Uso: %s [-t tolerancia_db]\n", argv[0]);
+                return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    mqtt_config_t mqtt_cfg = {
+        .broker_addr = MQTT_BROKER_ADDR,
+        .broker_port = MQTT_BROKER_PORT,
+        .client_id = MQTT_CLIENT_ID,
+        .topic = MQTT_TOPIC_MEASUREMENTS
+    };
+    if (!hal_host_flash_open(NULL) || !adc_dma_init() || !ad9833_init() || !mqtt_init(&mqtt_cfg)
+        || !sweep_store_init() || !frequency_sweep_init()) {
+        fprintf(stderr, "[FATAL] Fallo en inicialización de módulos\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Adaptativo: %d puntos gruesos, tolerancia %.2f dB, %.0f-%.0f Hz\n\n",
+           params.coarse_points, params.mag_tol_db, params.start_hz, params.stop_hz);
+    printf("%-18s %8s %10s %10s   %8s %10s %10s\n", "DUT", "puntos", "error_dB", "tiempo_ms",
+           "log fijo", "error_dB", "tiempo_ms");
+
+    static sweep_adaptive_result_t result;
+    bool pass = true;
+
+    for (size_t d = 0; d < sizeof(bench_duts) / sizeof(bench_duts[0]); d++) {
+        const bench_dut_t *b = &bench_duts[d];
+        sim_dut_config_t dut;
+        sim_dut_default_config(&dut);
+        dut.type = b->type;
+        dut.corner_hz = b->corner_hz;
+        dut.q = b->q;
+        sim_dut_configure(&dut);
+
+        if (!sweep_adaptive_execute(&params, &result)) {
+            fprintf(stderr, "[FATAL] Falló el barrido adaptativo (%s)\n", b->name);
+            return EXIT_FAILURE;
+        }
+        mqtt_client_poll(UINT32_MAX);
+        float adaptive_err = interpolation_error(&dut, result.frequency_hz, result.magnitude_db,
+                                                 result.count);
+
+        // Grilla fija más chica que iguala el error del adaptativo
+        uint16_t n = 3;
+        uint32_t uniform_ms = 0;
+        float err = uniform_error(&dut, n, &uniform_ms);
+        while (err > adaptive_err && n < SWEEP_NUM_POINTS) {
+            n++;
+            err = uniform_error(&dut, n, &uniform_ms);
+        }
+        bool reached = err <= adaptive_err;
+
+        printf("%-18s %8u %10.3f %10lu   %7u%s %10.3f %10lu\n", b->name, result.count, adaptive_err,
+               (unsigned long)result.total_time_ms, n, reached ? " " : "+", err,
+               (unsigned long)uniform_ms);
+
+        if (reached && result.count > n) {
+            pass = false;
+        }
+    }
+
+    printf("\n(+ = la grilla fija no alcanza el error ni con %d puntos)\n", SWEEP_NUM_POINTS);
+    printf("%s\n", pass ? "OK" : "FALLA");
+    return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,227 @@
+/**
+ * @file bench_average.c
+ * @brief Promedio coherente con corte anticipado (fra_bench_average)
+ *
+ * Sobre un RC ruidoso mide una grilla logarítmica tres veces con
+ * frequency_sweep_measure():
+ * - una captura por punto (sin promedio);
+ * - promedio fijo: -n capturas sin corte (cotas en 0);
+ * - promedio con corte anticipado.
+ * En cada caso compara |H| y arg H contra la transferencia teórica. Falla
+ * si el promedio no baja el error como lo predice el número de ventanas,
+ * si el corte anticipado no ahorra capturas o si el error real de los
+ * puntos que convergieron no es compatible con la cota pedida.
+ *
+ * Con un canal el barrido mide la amplitud absoluta de la respuesta: la
+ * magnitud se compara descontando la ganancia de paso y la fase, que es
+ * la del DDS al empezar la captura, no se evalúa.
+ *
+ * Una cuarta corrida sin ruido verifica que las capturas encadenadas
+ * sigan la fase de la señal: el error con promedio no puede ser mayor que
+ * el de una sola captura, y todos los puntos cortan en min_windows.
+ *
+ * Uso: fra_bench_average [-r ruido_rms] [-n ventanas_max]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "ad9833.h"
+#include "adc_dma.h"
+#include "hal.h"
+#include "hal_host.h"
+#include "mqtt_client.h"
+#include "sim_dut.h"
+#include "sweep.h"
+#include "sweep_store.h"
+
+#define BENCH_POINTS 40
+#define BENCH_MAX_WINDOWS 64
+
+// Ruido de la corrida ruidosa (fracción de fondo de escala)
+#define BENCH_NOISE_RMS 0.01f
+
+// Cotas del corte anticipado
+#define BENCH_STDERR_DB 0.02f
+#define BENCH_STDERR_DEG 0.15f
+
+typedef struct {
+    const char *name;
+    float rms_db;           // Error cuadrático medio de |H| (dB)
+    float rms_deg;          // Error cuadrático medio de fase (grados)
+    float over_bound;       // De los que cortaron antes de max, fracción con error > 3 cotas
+    float avg_windows;
+    uint32_t elapsed_ms;
+} bench_run_t;
+
+/**
+ * @brief Magnitud medida en dB para |H| = 1
+ */
+static float bench_passband_db(const sim_dut_config_t *dut) {
+#if ADC_CHANNELS == 2
+    (void)dut;
+    return 0.0f;
+#else
+    return 20.0f * log10f(dut->amplitude * 4095.0f / 2048.0f);
+#endif
+}
+
+static bool bench_configure(uint16_t max_windows, float stderr_db, float stderr_deg) {
+    sweep_plan_spec_t spec;
+    sweep_plan_default_spec(&spec);
+    spec.average.max_windows = max_windows;
+    spec.average.stderr_db = stderr_db;
+    spec.average.stderr_deg = stderr_deg;
+    return frequency_sweep_set_plan(&spec);
+}
+
+/**
+ * @brief Mide la grilla y acumula los errores contra la teoría
+ */
+static bool bench_measure(bench_run_t *run, const sim_dut_config_t *dut, uint16_t max_windows) {
+    double sum_db = 0.0;
+    double sum_deg = 0.0;
+    uint32_t windows = 0;
+    uint32_t over = 0;
+    uint32_t stopped = 0;
+    uint32_t t0 = hal_time_ms();
+
+    for (uint16_t k = 0; k < BENCH_POINTS; k++) {
+        float f = SWEEP_FREQ_MIN * powf(SWEEP_FREQ_MAX / SWEEP_FREQ_MIN, (float)k / (BENCH_POINTS - 1));
+        sweep_measurement_t m;
+        if (!frequency_sweep_measure(f, &m)) {
+            return false;
+        }
+
+        float h_mag, h_phase;
+        sim_dut_response(m.frequency_hz, &h_mag, &h_phase);
+        float err_db = m.magnitude_db - bench_passband_db(dut) - 20.0f * log10f(h_mag);
+#if ADC_CHANNELS == 2
+        float err_deg = remainderf(m.phase_deg - h_phase * (180.0f / (float)M_PI), 360.0f);
+#else
+        float err_deg = 0.0f;
+#endif
+
+        sum_db += (double)err_db * err_db;
+        sum_deg += (double)err_deg * err_deg;
+        windows += m.windows;
+        if (m.windows >= max_windows) {
+            continue;
+        }
+        stopped++;
+        if (fabsf(err_db) > 3.0f * BENCH_STDERR_DB || fabsf(err_deg) > 3.0f * BENCH_STDERR_DEG) {
+            over++;
+        }
+    }
+
+    run->elapsed_ms = hal_time_ms() - t0;
+    run->rms_db = (float)sqrt(sum_db / BENCH_POINTS);
+    run->rms_deg = (float)sqrt(sum_deg / BENCH_POINTS);
+    run->over_bound = stopped > 0 ? (float)over / stopped : 0.0f;
+    run->avg_windows = (float)windows / BENCH_POINTS;
+    return true;
+}
+
+static void bench_print(const bench_run_t *run) {
+    printf("%-22s %10.4f %10.3f %10.2f %10lu %10.0f%%\n", run->name, run->rms_db, run->rms_deg,
+           run->avg_windows, (unsigned long)run->elapsed_ms, 100.0f * run->over_bound);
+}
+
+int main(int argc, char **argv) {
+    float noise_rms = BENCH_NOISE_RMS;
+    uint16_t max_windows = BENCH_MAX_WINDOWS;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:n:h")) != -1) {
+        switch (opt) {
+            case 'r': noise_rms = strtof(optarg, NULL); break;
+            case 'n': max_windows = (uint16_t)strtoul(optarg, NULL, 0); break;
+            default:
+                printf("Uso: %s [-r ruido_rms] [-n ventanas_max]\n", argv[0]);
+                return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    mqtt_config_t mqtt_cfg = {
+        .broker_addr = MQTT_BROKER_ADDR,
+        .broker_port = MQTT_BROKER_PORT,
+        .client_id = MQTT_CLIENT_ID,
+        .topic = MQTT_TOPIC_MEASUREMENTS
+    };
+    if (!hal_host_flash_open(NULL) || !adc_dma_init() || !ad9833_init() || !mqtt_init(&mqtt_cfg)
+        || !sweep_store_init() || !frequency_sweep_init()) {
+        fprintf(stderr, "[FATAL] Fallo en inicialización de módulos\n");
+        return EXIT_FAILURE;
+    }
+
+    sim_dut_config_t dut;
+    sim_dut_default_config(&dut);
+    dut.noise_rms = noise_rms;
+    sim_dut_configure(&dut);
+
+    printf("RC %.0f Hz, ruido %.4f rms, %d puntos log, hasta %d capturas, cotas %.3f dB / %.2f°\n\n",
+           dut.corner_hz, noise_rms, BENCH_POINTS, max_windows, BENCH_STDERR_DB, BENCH_STDERR_DEG);
+    printf("%-22s %10s %10s %10s %10s %11s\n", "modo", "rms_dB", "rms_deg", "capturas",
+           "tiempo_ms", "> 3 cotas*");
+
+    bench_run_t single = { .name = "una captura" };
+    bench_run_t fixed = { .name = "promedio fijo" };
+    bench_run_t early = { .name = "corte anticipado" };
+    bool ok = bench_configure(1, BENCH_STDERR_DB, BENCH_STDERR_DEG)
+        && bench_measure(&single, &dut, 1)
+        && bench_configure(max_windows, 0.0f, 0.0f)
+        && bench_measure(&fixed, &dut, max_windows)
+        && bench_configure(max_windows, BENCH_STDERR_DB, BENCH_STDERR_DEG)
+        && bench_measure(&early, &dut, max_windows);
+    if (!ok) {
+        fprintf(stderr, "[FATAL] Falló la medición\n");
+        return EXIT_FAILURE;
+    }
+    bench_print(&single);
+    bench_print(&fixed);
+    bench_print(&early);
+
+    // Las estadísticas del barrido reportan las capturas por punto
+    sweep_stats_t stats;
+    frequency_sweep_execute_with_stats(&stats);
+    mqtt_client_poll(UINT32_MAX);
+    printf("\nBarrido del plan: %.2f capturas/punto (máx %lu, %lu sin converger), %lu ms\n",
+           stats.avg_windows_per_point, (unsigned long)stats.max_windows_per_point,
+           (unsigned long)stats.unconverged_points, (unsigned long)stats.total_time_ms);
+
+    // Sin ruido: la fase tiene que seguir de una captura a la siguiente
+    dut.noise_rms = 0.0f;
+    sim_dut_configure(&dut);
+    bench_run_t clean_single = { .name = "sin ruido, una" };
+    bench_run_t clean_avg = { .name = "sin ruido, promedio" };
+    ok = bench_configure(1, BENCH_STDERR_DB, BENCH_STDERR_DEG)
+        && bench_measure(&clean_single, &dut, 1)
+        && bench_configure(max_windows, BENCH_STDERR_DB, BENCH_STDERR_DEG)
+        && bench_measure(&clean_avg, &dut, max_windows);
+    if (!ok) {
+        fprintf(stderr, "[FATAL] Falló la medición\n");
+        return EXIT_FAILURE;
+    }
+    printf("\n");
+    bench_print(&clean_single);
+    bench_print(&clean_avg);
+
+    // El promedio fijo baja el ruido como √K (con margen por la
+    // estimación de 40 puntos); el corte no puede gastar más que el fijo
+    float expected = 1.0f / sqrtf((float)max_windows);
+    bool pass = fixed.rms_db <= 2.0f * expected * single.rms_db
+        && fixed.rms_deg <= 2.0f * expected * single.rms_deg
+        && early.avg_windows < fixed.avg_windows
+        && early.over_bound <= 0.1f
+        && stats.avg_windows_per_point > 1.0f
+        && clean_avg.rms_db <= clean_single.rms_db + 0.001f
+        && clean_avg.rms_deg <= clean_single.rms_deg + 0.01f
+        && clean_avg.avg_windows == (float)SWEEP_AVG_MIN_WINDOWS;
+
+    printf("\n(* entre los puntos que cortaron antes del máximo)\n");
+    printf("%s\n", pass ? "OK" : "FALLA");
+    return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,317 @@
+/**
+ * @file bench_fft.c
+ * @brief FFT contra DFT en doble precisión y cruce con Goertzel (fra_bench_fft)
+ *
+ * Para cada largo admitido (2 a FFT_MAX_SIZE):
+ * - fft_real() y fft_complex() sobre ruido uniforme contra una DFT directa
+ *   en doble precisión: error máximo por bin relativo a la norma de la
+ *   entrada, que tiene que quedar bajo FFT_TOL;
+ * - fft_pair_bins() sobre códigos ADC intercalados contra la DFT de cada
+ *   canal en todos los bines de 0 a N/2; se informa también el error de
+ *   goertzel_pair_bins() en los mismos bines, que crece con N.
+ * Verifica además que los largos no admitidos se rechacen sin tocar el
+ * buffer y la elección de fft_choose_detector().
+ *
+ * Después mide, de 16 a FFT_MAX_SIZE pares por bloque, el costo de
+ * goertzel_pair_bins() por bin y el de fft_pair_bins(), el cruce real
+ * (bines desde los que la FFT es más barata) contra el de
+ * fft_crossover_bins(), y ajusta FFT_CROSSOVER_BINS_PER_STAGE y
+ * FFT_CROSSOVER_BINS_OFFSET por mínimos cuadrados. Los tiempos son del
+ * host: solo se informan, no hacen fallar el benchmark.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "config.h"
+#include "fft.h"
+#include "goertzel.h"
+#define CHECK_QUIET
+#include "check.h"
+
+#define BENCH_TARGET_SECONDS 0.2
+#define BENCH_TIMED_BINS 16
+#define BENCH_MIN_TIMED_SIZE 16
+
+// Error máximo por bin / sqrt(Σ|x|²). Redondeo float (6e-8) por etapa
+// con holgura: 12 etapas en 4096 puntos dan ~2e-7 en el peor bin
+#define FFT_TOL 1e-6
+
+static volatile float bench_sink;
+static float data[2 * FFT_MAX_SIZE];
+static float original[2 * FFT_MAX_SIZE];
+static double ref_re[FFT_MAX_SIZE];
+static double ref_im[FFT_MAX_SIZE];
+static double cos_table[FFT_MAX_SIZE];
+static double sin_table[FFT_MAX_SIZE];
+static uint16_t frames[2 * FFT_MAX_SIZE];
+static uint16_t bins[FFT_MAX_SIZE / 2 + 1];
+static goertzel_coeffs_t coeffs[FFT_MAX_SIZE / 2 + 1];
+static float fft_ref[2 * (FFT_MAX_SIZE / 2 + 1)];
+static float fft_resp[2 * (FFT_MAX_SIZE / 2 + 1)];
+static float goertzel_ref[2 * (FFT_MAX_SIZE / 2 + 1)];
+static float goertzel_resp[2 * (FFT_MAX_SIZE / 2 + 1)];
+
+static uint32_t rng_state = 0x2545F491u;
+
+static double host_now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/**
+ * @brief Uniforme en [-1, 1)
+ */
+static float rng_unit(void) {
+    return (float)(rng_next() >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+/**
+ * @brief DFT directa de n puntos (stride 1 real o 2 complejo) en doble
+ *
+ * @param x Entrada: x[stride·i] real e x[stride·i + 1] imaginaria si
+ *          stride == 2
+ */
+static void reference_dft(const float *x, uint32_t n, uint32_t stride) {
+    for (uint32_t i = 0; i < n; i++) {
+        cos_table[i] = cos(2.0 * M_PI * i / n);
+        sin_table[i] = sin(2.0 * M_PI * i / n);
+    }
+    for (uint32_t k = 0; k < n; k++) {
+        double re = 0.0;
+        double im = 0.0;
+        uint32_t index = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            double xr = x[stride * i];
+            double xi = (stride == 2) ? x[stride * i + 1] : 0.0;
+            // (xr + j·xi)·(cos - j·sin)
+            re += xr * cos_table[index] + xi * sin_table[index];
+            im += xi * cos_table[index] - xr * sin_table[index];
+            index = (index + k) & (n - 1);
+        }
+        ref_re[k] = re;
+        ref_im[k] = im;
+    }
+}
+
+/**
+ * @brief sqrt(Σ|x|²) de n valores
+ */
+static double input_norm(const float *x, uint32_t count) {
+    double sum = 0.0;
+    for (uint32_t i = 0; i < count; i++) {
+        sum += (double)x[i] * x[i];
+    }
+    return fmax(sqrt(sum), 1e-30);
+}
+
+/**
+ * @brief Error de fft_real() y fft_complex() contra la DFT en doble
+ */
+static void check_transforms(uint32_t n, double *real_err, double *complex_err) {
+    // Real: salida empaquetada
+    for (uint32_t i = 0; i < n; i++) {
+        original[i] = rng_unit();
+    }
+    memcpy(data, original, n * sizeof(float));
+    reference_dft(original, n, 1);
+    expect(fft_real(data, n), "fft_real() acepta los largos admitidos");
+
+    double norm = input_norm(original, n);
+    double worst = fmax(fabs(data[0] - ref_re[0]), fabs(data[1] - ref_re[n / 2]));
+    worst = fmax(worst, fmax(fabs(ref_im[0]), fabs(ref_im[n / 2])));
+    for (uint32_t k = 1; k < n / 2; k++) {
+        worst = fmax(worst, hypot(data[2 * k] - ref_re[k], data[2 * k + 1] - ref_im[k]));
+    }
+    *real_err = worst / norm;
+
+    // Compleja
+    for (uint32_t i = 0; i < 2 * n; i++) {
+        original[i] = rng_unit();
+    }
+    memcpy(data, original, 2 * n * sizeof(float));
+    reference_dft(original, n, 2);
+    expect(fft_complex(data, n), "fft_complex() acepta los largos admitidos");
+
+    norm = input_norm(original, 2 * n);
+    worst = 0.0;
+    for (uint32_t k = 0; k < n; k++) {
+        worst = fmax(worst, hypot(data[2 * k] - ref_re[k], data[2 * k + 1] - ref_im[k]));
+    }
+    *complex_err = worst / norm;
+}
+
+/**
+ * @brief fft_pair_bins() y goertzel_pair_bins() contra la DFT de cada canal
+ */
+static void check_pair(uint32_t n, double *dft_err, double *goertzel_err) {
+    for (uint32_t i = 0; i < 2 * n; i++) {
+        frames[i] = (uint16_t)(rng_next() & 0x0FFFu);
+    }
+    uint32_t count = n / 2 + 1;
+    for (uint32_t k = 0; k < count; k++) {
+        bins[k] = (uint16_t)k;
+        goertzel_coeffs_init(&coeffs[k], (float)k * SAMPLE_RATE / (float)n, SAMPLE_RATE);
+    }
+    expect(fft_pair_bins(frames, n, bins, count, data, fft_ref, fft_resp),
+           "fft_pair_bins() acepta los largos admitidos");
+    goertzel_pair_bins(frames, n, coeffs, count, goertzel_ref, goertzel_resp);
+
+    double worst_dft = 0.0;
+    double worst_goertzel = 0.0;
+    for (int c = 0; c < 2; c++) {
+        const float *fft_out = (c == 0) ? fft_ref : fft_resp;
+        const float *goertzel_out = (c == 0) ? goertzel_ref : goertzel_resp;
+
+        for (uint32_t i = 0; i < n; i++) {
+            original[i] = ((float)frames[2 * i + c] - 2048.0f) * (1.0f / 2048.0f);
+        }
+        reference_dft(original, n, 1);
+        double norm = input_norm(original, n);
+
+        for (uint32_t k = 0; k < count; k++) {
+            double re = fft_out[2 * k];
+            double im = fft_out[2 * k + 1];
+            worst_dft = fmax(worst_dft, hypot(re - ref_re[k], im - ref_im[k]) / norm);
+            worst_goertzel = fmax(worst_goertzel,
+                                  hypot(goertzel_out[2 * k] - ref_re[k],
+                                        goertzel_out[2 * k + 1] - ref_im[k]) / norm);
+        }
+    }
+    *dft_err = worst_dft;
+    *goertzel_err = worst_goertzel;
+}
+
+/**
+ * @brief Rechazo de largos no admitidos, bines exactos y elección del detector
+ */
+static void check_api(void) {
+    static const uint32_t invalid[] = {0, 1, 3, WINDOW_SIZE, 2 * FFT_MAX_SIZE};
+
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        if (FFT_SIZE_SUPPORTED(invalid[i])) {
+            continue;
+        }
+        for (uint32_t j = 0; j < 16; j++) {
+            data[j] = (float)j;
+        }
+        bool rejected = !fft_real(data, invalid[i]) && !fft_complex(data, invalid[i])
+                        && !fft_pair_bins(frames, invalid[i], bins, 1, data, fft_ref, fft_resp)
+                        && fft_crossover_bins(invalid[i]) == 0;
+        bool untouched = true;
+        for (uint32_t j = 0; j < 16; j++) {
+            untouched = untouched && data[j] == (float)j;
+        }
+        expect(rejected && untouched, "los largos no admitidos se rechazan sin tocar el buffer");
+    }
+
+    uint16_t bin = 0;
+    expect(fft_bin_index(1500.0f, SAMPLE_RATE, 512, &bin) && bin == 16, "1500 Hz es el bin 16 de 512");
+    expect(!fft_bin_index(1000.0f, SAMPLE_RATE, 512, &bin), "1000 Hz cae entre bines de 512");
+    expect(!fft_bin_index(30000.0f, SAMPLE_RATE, 512, &bin), "más allá de Nyquist no es un bin");
+
+    uint32_t cross = fft_crossover_bins(512);
+    expect(cross >= 1, "el cruce es de al menos un bin");
+    expect(fft_choose_detector(512, cross, true) == FFT_DETECTOR_FFT, "desde el cruce elige la FFT");
+    expect(cross < 2 || fft_choose_detector(512, cross - 1, true) == FFT_DETECTOR_GOERTZEL,
+           "antes del cruce elige Goertzel");
+    expect(fft_choose_detector(512, 256, false) == FFT_DETECTOR_GOERTZEL,
+           "con bines inexactos elige Goertzel");
+    expect(fft_choose_detector(WINDOW_SIZE, 256, true)
+           == (FFT_SIZE_SUPPORTED(WINDOW_SIZE) ? FFT_DETECTOR_FFT : FFT_DETECTOR_GOERTZEL),
+           "WINDOW_SIZE no potencia de dos elige Goertzel");
+}
+
+/**
+ * @brief Segundos por llamada de cada detector con BENCH_TIMED_BINS bines
+ */
+static void time_detectors(uint32_t n, double *goertzel_s, double *fft_s) {
+    for (uint32_t i = 0; i < 2 * n; i++) {
+        frames[i] = (uint16_t)(rng_next() & 0x0FFFu);
+    }
+    for (uint32_t k = 0; k < BENCH_TIMED_BINS; k++) {
+        bins[k] = (uint16_t)(1 + k * (n / 2 - 1) / BENCH_TIMED_BINS);
+        goertzel_coeffs_init(&coeffs[k], (float)bins[k] * SAMPLE_RATE / (float)n, SAMPLE_RATE);
+    }
+
+    long reps = 0;
+    double t0 = host_now_s();
+    double elapsed;
+    do {
+        goertzel_pair_bins(frames, n, coeffs, BENCH_TIMED_BINS, goertzel_ref, goertzel_resp);
+        bench_sink += goertzel_ref[0];
+        reps++;
+    } while ((elapsed = host_now_s() - t0) < BENCH_TARGET_SECONDS);
+    *goertzel_s = elapsed / (double)reps;
+
+    reps = 0;
+    t0 = host_now_s();
+    do {
+        fft_pair_bins(frames, n, bins, BENCH_TIMED_BINS, data, fft_ref, fft_resp);
+        bench_sink += fft_ref[0];
+        reps++;
+    } while ((elapsed = host_now_s() - t0) < BENCH_TARGET_SECONDS);
+    *fft_s = elapsed / (double)reps;
+}
+
+int main(void) {
+    printf("FFT contra DFT directa en doble precisión (error máximo por bin / norma de la entrada)\n\n");
+    printf("%6s %12s %12s %12s %12s\n", "N", "real", "compleja", "par", "Goertzel");
+
+    double worst = 0.0;
+    for (uint32_t n = FFT_MIN_SIZE; n <= FFT_MAX_SIZE; n <<= 1) {
+        double real_err, complex_err, pair_err, goertzel_err;
+        check_transforms(n, &real_err, &complex_err);
+        check_pair(n, &pair_err, &goertzel_err);
+        printf("%6lu %12.2e %12.2e %12.2e %12.2e\n", (unsigned long)n, real_err, complex_err, pair_err,
+               goertzel_err);
+        worst = fmax(worst, fmax(fmax(real_err, complex_err), pair_err));
+    }
+    expect(worst < FFT_TOL, "la FFT coincide con la DFT en doble precisión");
+
+    check_api();
+
+    printf("\nCruce Goertzel/FFT sobre pares intercalados (%d bines medidos)\n\n", BENCH_TIMED_BINS);
+    printf("%6s %16s %14s %14s %14s\n", "N", "Goertzel us/bin", "FFT us", "cruce medido",
+           "cruce modelo");
+
+    // Ajuste cruce = a·log2(N) + b
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    int points = 0;
+    for (uint32_t n = BENCH_MIN_TIMED_SIZE; n <= FFT_MAX_SIZE; n <<= 1) {
+        double goertzel_s, fft_s;
+        time_detectors(n, &goertzel_s, &fft_s);
+
+        double per_bin = goertzel_s / BENCH_TIMED_BINS;
+        double crossover = fft_s / per_bin;
+        double stages = log2((double)n);
+        printf("%6lu %16.3f %14.3f %14.1f %14lu\n", (unsigned long)n, per_bin * 1e6, fft_s * 1e6,
+               crossover, (unsigned long)fft_crossover_bins(n));
+
+        sx += stages;
+        sy += crossover;
+        sxx += stages * stages;
+        sxy += stages * crossover;
+        points++;
+    }
+    double slope = (points * sxy - sx * sy) / (points * sxx - sx * sx);
+    double offset = (sy - slope * sx) / points;
+    printf("\nAjuste en este host: FFT_CROSSOVER_BINS_PER_STAGE %.2f, FFT_CROSSOVER_BINS_OFFSET %.2f\n",
+           slope, offset);
+    printf("config.h: %.2f, %.2f\n", (double)FFT_CROSSOVER_BINS_PER_STAGE,
+           (double)FFT_CROSSOVER_BINS_OFFSET);
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FALLA");
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
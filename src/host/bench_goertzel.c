@@ -0,0 +1,398 @@
+/**
+ * @file bench_goertzel.c
+ * @brief Benchmark del detector Goertzel en el host (fra_bench_goertzel)
+ *
+ * Compara el costo por bin de goertzel_compute() llamado una vez por
+ * frecuencia, del Goertzel incremental con coeficientes precalculados
+ * (como los puntos de sweep_plan) y de goertzel_compute_bins() para
+ * distintas cantidades de bins sobre una ventana de WINDOW_SIZE muestras,
+ * y reporta la máxima diferencia entre el camino de un bin y el
+ * multi-bin. Luego compara el kernel float contra el de punto fijo sobre
+ * toda la grilla del barrido: ns/muestra y máxima desviación de magnitud
+ * y fase, que falla por encima de BENCH_FIXED_TOL_DB/BENCH_FIXED_TOL_DEG.
+ * Por último verifica que el Goertzel incremental alimentado en bloques
+ * de tamaño aleatorio da el mismo resultado bit a bit que el cálculo de
+ * una sola vez, y que el Goertzel de dos canales sobre una
+ * captura intercalada coincide con dos pasadas sobre los canales
+ * desintercalados (y cuánto cuesta cada camino).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "config.h"
+#include "goertzel.h"
+
+#define BENCH_MAX_BINS 64
+#define BENCH_TARGET_SECONDS 0.2
+#define BENCH_STREAM_TRIALS 2000
+
+// Desviación admitida del kernel fijo frente al float en la grilla del
+// barrido (medido: ~1.5e-4 dB y ~3e-3°)
+#define BENCH_FIXED_TOL_DB 1e-3
+#define BENCH_FIXED_TOL_DEG 0.01
+
+static volatile float bench_sink;
+
+static double host_now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Ventana de prueba: fundamental de 1 kHz con armónicos
+ */
+static void bench_fill_window(uint16_t *samples) {
+    for (int n = 0; n < WINDOW_SIZE; n++) {
+        double t = (double)n / SAMPLE_RATE;
+        double v = 0.5;
+        for (int h = 1; h <= 5; h++) {
+            v += (0.3 / h) * sin(2.0 * M_PI * 1000.0 * h * t + 0.3 * h);
+        }
+        samples[n] = (uint16_t)lrint(v * 4095.0);
+    }
+}
+
+static double bench_single(const uint16_t *samples, const float *freqs, size_t nbins,
+                           goertzel_result_t *out, long *iters) {
+    long reps = 0;
+    double t0 = host_now_s();
+    double elapsed;
+    do {
+        for (size_t b = 0; b < nbins; b++) {
+            goertzel_compute(samples, WINDOW_SIZE, freqs[b], SAMPLE_RATE, &out[b]);
+        }
+        bench_sink += out[0].magnitude;
+        reps++;
+        elapsed = host_now_s() - t0;
+    } while (elapsed < BENCH_TARGET_SECONDS);
+    *iters = reps;
+    return elapsed;
+}
+
+/**
+ * @brief Una ventana completa con coeficientes ya calculados
+ */
+static void bench_coeffs_compute(const goertzel_coeffs_t *coeffs, const uint16_t *samples,
+                                 goertzel_result_t *out) {
+    goertzel_stream_t stream;
+    goertzel_stream_init(&stream, coeffs, WINDOW_SIZE);
+    goertzel_stream_push(&stream, samples, WINDOW_SIZE);
+    goertzel_stream_result(&stream, out);
+}
+
+static double bench_coeffs(const uint16_t *samples, const goertzel_coeffs_t *coeffs, size_t nbins,
+                           goertzel_result_t *out, long *iters) {
+    long reps = 0;
+    double t0 = host_now_s();
+    double elapsed;
+    do {
+        for (size_t b = 0; b < nbins; b++) {
+            bench_coeffs_compute(&coeffs[b], samples, &out[b]);
+        }
+        bench_sink += out[0].magnitude;
+        reps++;
+        elapsed = host_now_s() - t0;
+    } while (elapsed < BENCH_TARGET_SECONDS);
+    *iters = reps;
+    return elapsed;
+}
+
+static double bench_multi(const uint16_t *samples, const float *freqs, size_t nbins,
+                          goertzel_result_t *out, long *iters) {
+    long reps = 0;
+    double t0 = host_now_s();
+    double elapsed;
+    do {
+        goertzel_compute_bins(samples, WINDOW_SIZE, freqs, nbins, SAMPLE_RATE, out);
+        bench_sink += out[0].magnitude;
+        reps++;
+        elapsed = host_now_s() - t0;
+    } while (elapsed < BENCH_TARGET_SECONDS);
+    *iters = reps;
+    return elapsed;
+}
+
+/**
+ * @brief Float vs punto fijo sobre la grilla completa del barrido
+ * 
+ * @return Puntos en que el fijo se aparta del float más que
+ *         BENCH_FIXED_TOL_DB o BENCH_FIXED_TOL_DEG
+ */
+static unsigned bench_kernels(void) {
+    static uint16_t windows[SWEEP_NUM_POINTS][WINDOW_SIZE];
+    static float grid[SWEEP_NUM_POINTS];
+    static goertzel_coeffs_t bins[SWEEP_NUM_POINTS];
+    static goertzel_result_t ref[SWEEP_NUM_POINTS];
+    static goertzel_result_t fix[SWEEP_NUM_POINTS];
+    static const goertzel_kernel_t kernels[] = {GOERTZEL_KERNEL_FLOAT, GOERTZEL_KERNEL_FIXED};
+    static const char *names[] = {"float", "fijo"};
+    double ns_per_sample[2];
+    
+    // Un tono coherente por punto, con amplitud y fase variables
+    for (int k = 0; k < SWEEP_NUM_POINTS; k++) {
+        grid[k] = SWEEP_FREQ_MIN + k * FREQ_RESOLUTION;
+        double amp = 0.45 * (1.0 - 0.9 * k / SWEEP_NUM_POINTS);
+        for (int n = 0; n < WINDOW_SIZE; n++) {
+            double v = 0.5 + amp * sin(2.0 * M_PI * grid[k] * n / SAMPLE_RATE + 0.1 * k);
+            windows[k][n] = (uint16_t)lrint(v * 4095.0);
+        }
+    }
+    for (int k = 0; k < SWEEP_NUM_POINTS; k++) {
+        goertzel_coeffs_init(&bins[k], grid[k], SAMPLE_RATE);
+    }
+    
+    goertzel_kernel_t saved = goertzel_get_kernel();
+    for (int i = 0; i < 2; i++) {
+        goertzel_result_t *out = (i == 0) ? ref : fix;
+        long reps = 0;
+        double t0 = host_now_s();
+        double elapsed;
+        
+        goertzel_set_kernel(kernels[i]);
+        do {
+            for (uint16_t k = 0; k < SWEEP_NUM_POINTS; k++) {
+                bench_coeffs_compute(&bins[k], windows[k], &out[k]);
+            }
+            bench_sink += out[0].magnitude;
+            reps++;
+            elapsed = host_now_s() - t0;
+        } while (elapsed < BENCH_TARGET_SECONDS);
+        
+        ns_per_sample[i] = elapsed * 1e9 / ((double)reps * SWEEP_NUM_POINTS * WINDOW_SIZE);
+    }
+    goertzel_set_kernel(saved);
+    
+    double max_db = 0.0;
+    double max_deg = 0.0;
+    unsigned outside = 0;
+    for (int k = 0; k < SWEEP_NUM_POINTS; k++) {
+        double err_db = fabs(ref[k].magnitude_db - fix[k].magnitude_db);
+        double err_deg = fabs(remainder(ref[k].phase_deg - fix[k].phase_deg, 360.0));
+        max_db = fmax(max_db, err_db);
+        max_deg = fmax(max_deg, err_deg);
+        if (!(err_db <= BENCH_FIXED_TOL_DB && err_deg <= BENCH_FIXED_TOL_DEG)) {
+            outside++;
+        }
+    }
+    
+    printf("\nKernel float vs punto fijo (%d puntos de la grilla)\n\n", SWEEP_NUM_POINTS);
+    for (int i = 0; i < 2; i++) {
+        printf("  %-6s %8.3f ns/muestra\n", names[i], ns_per_sample[i]);
+    }
+    printf("  Desviación máxima fijo vs float: %.3g dB, %.3g° (tolerancia %.3g dB, %.3g°)\n",
+           max_db, max_deg, BENCH_FIXED_TOL_DB, BENCH_FIXED_TOL_DEG);
+    printf("  %u/%d puntos fuera de tolerancia\n", outside, SWEEP_NUM_POINTS);
+    return outside;
+}
+
+/**
+ * @brief Streaming en bloques aleatorios vs una sola vez
+ * 
+ * @return Número de resultados que difieren del cálculo de una sola vez
+ */
+static unsigned bench_streaming(void) {
+    static uint16_t samples[WINDOW_SIZE];
+    static const goertzel_kernel_t kernels[] = {GOERTZEL_KERNEL_FLOAT, GOERTZEL_KERNEL_FIXED};
+    static const char *names[] = {"float", "fijo"};
+    uint32_t rng = 0x9E3779B9u;
+    unsigned total_mismatches = 0;
+    
+    bench_fill_window(samples);
+    goertzel_kernel_t saved = goertzel_get_kernel();
+    
+    printf("\nGoertzel incremental vs una sola vez (%d particiones aleatorias)\n\n",
+           BENCH_STREAM_TRIALS);
+    
+    for (int i = 0; i < 2; i++) {
+        unsigned mismatches = 0;
+        goertzel_set_kernel(kernels[i]);
+        
+        for (int trial = 0; trial < BENCH_STREAM_TRIALS; trial++) {
+            float freq = SWEEP_FREQ_MIN + (float)(trial % SWEEP_NUM_POINTS) * FREQ_RESOLUTION;
+            goertzel_coeffs_t coeffs;
+            goertzel_result_t oneshot;
+            goertzel_result_t streamed;
+            goertzel_stream_t stream;
+            
+            goertzel_coeffs_init(&coeffs, freq, SAMPLE_RATE);
+            goertzel_compute(samples, WINDOW_SIZE, freq, SAMPLE_RATE, &oneshot);
+            
+            goertzel_stream_init(&stream, &coeffs, WINDOW_SIZE);
+            uint32_t pos = 0;
+            while (pos < WINDOW_SIZE) {
+                rng ^= rng << 13;
+                rng ^= rng >> 17;
+                rng ^= rng << 5;
+                uint32_t block = rng % 97;     // incluye bloques vacíos
+                if (block > WINDOW_SIZE - pos) {
+                    block = WINDOW_SIZE - pos;
+                }
+                goertzel_stream_push(&stream, &samples[pos], block);
+                pos += block;
+            }
+            goertzel_stream_result(&stream, &streamed);
+            
+            if (memcmp(&oneshot, &streamed, sizeof(oneshot)) != 0) {
+                mismatches++;
+            }
+        }
+        
+        printf("  %-6s %u/%d resultados distintos\n", names[i], mismatches, BENCH_STREAM_TRIALS);
+        total_mismatches += mismatches;
+    }
+    
+    goertzel_set_kernel(saved);
+    return total_mismatches;
+}
+
+/**
+ * @brief Dos canales intercalados: una pasada vs desintercalar y dos pasadas
+ * 
+ * @return Número de resultados que difieren de las pasadas separadas
+ */
+static unsigned bench_pair(void) {
+    static uint16_t frames[2 * WINDOW_SIZE];
+    static uint16_t channel[2][WINDOW_SIZE];
+    static const goertzel_kernel_t kernels[] = {GOERTZEL_KERNEL_FLOAT, GOERTZEL_KERNEL_FIXED};
+    static const char *names[] = {"float", "fijo"};
+    unsigned total_mismatches = 0;
+    
+    // Referencia: la ventana de prueba; respuesta: la misma atenuada y
+    // corrida unas muestras
+    bench_fill_window(channel[0]);
+    for (int n = 0; n < WINDOW_SIZE; n++) {
+        channel[1][n] = (uint16_t)(2048 + (channel[0][(n + 7) % WINDOW_SIZE] - 2048) / 3);
+        frames[2 * n] = channel[0][n];
+        frames[2 * n + 1] = channel[1][n];
+    }
+    goertzel_kernel_t saved = goertzel_get_kernel();
+    
+    printf("\nDos canales intercalados: una pasada vs desintercalar + dos pasadas\n\n");
+    
+    for (int i = 0; i < 2; i++) {
+        unsigned mismatches = 0;
+        goertzel_set_kernel(kernels[i]);
+        
+        for (int k = 0; k < SWEEP_NUM_POINTS; k++) {
+            goertzel_coeffs_t coeffs;
+            goertzel_pair_t pair;
+            goertzel_stream_t separate[2];
+            goertzel_result_t paired[2];
+            goertzel_result_t alone[2];
+            
+            goertzel_coeffs_init(&coeffs, SWEEP_FREQ_MIN + (float)k * FREQ_RESOLUTION, SAMPLE_RATE);
+            goertzel_pair_init(&pair, &coeffs, WINDOW_SIZE);
+            goertzel_pair_push(&pair, frames, WINDOW_SIZE / 3);
+            goertzel_pair_push(&pair, &frames[2 * (WINDOW_SIZE / 3)], WINDOW_SIZE - WINDOW_SIZE / 3);
+            goertzel_pair_result(&pair, &paired[0], &paired[1]);
+            
+            for (int c = 0; c < 2; c++) {
+                goertzel_stream_init(&separate[c], &coeffs, WINDOW_SIZE);
+                goertzel_stream_push(&separate[c], channel[c], WINDOW_SIZE);
+                goertzel_stream_result(&separate[c], &alone[c]);
+            }
+            if (memcmp(paired, alone, sizeof(paired)) != 0) {
+                mismatches++;
+            }
+        }
+        
+        // Costo por punto: el par recorre la captura una vez; la
+        // alternativa copia cada canal a su buffer y pasa dos veces
+        goertzel_coeffs_t coeffs;
+        goertzel_coeffs_init(&coeffs, 1000.0f, SAMPLE_RATE);
+        goertzel_result_t out[2];
+        long reps = 0;
+        double t0 = host_now_s();
+        double t_pair;
+        do {
+            goertzel_pair_t pair;
+            goertzel_pair_init(&pair, &coeffs, WINDOW_SIZE);
+            goertzel_pair_push(&pair, frames, WINDOW_SIZE);
+            goertzel_pair_result(&pair, &out[0], &out[1]);
+            bench_sink += out[1].magnitude;
+            reps++;
+        } while ((t_pair = host_now_s() - t0) < BENCH_TARGET_SECONDS);
+        double ns_pair = t_pair * 1e9 / ((double)reps * WINDOW_SIZE);
+        
+        reps = 0;
+        t0 = host_now_s();
+        double t_split;
+        do {
+            for (int n = 0; n < WINDOW_SIZE; n++) {
+                channel[0][n] = frames[2 * n];
+                channel[1][n] = frames[2 * n + 1];
+            }
+            for (int c = 0; c < 2; c++) {
+                goertzel_stream_t stream;
+                goertzel_stream_init(&stream, &coeffs, WINDOW_SIZE);
+                goertzel_stream_push(&stream, channel[c], WINDOW_SIZE);
+                goertzel_stream_result(&stream, &out[c]);
+            }
+            bench_sink += out[1].magnitude;
+            reps++;
+        } while ((t_split = host_now_s() - t0) < BENCH_TARGET_SECONDS);
+        double ns_split = t_split * 1e9 / ((double)reps * WINDOW_SIZE);
+        
+        printf("  %-6s %8.3f vs %8.3f ns/instante (%.2fx), %u/%d resultados distintos\n",
+               names[i], ns_pair, ns_split, ns_split / ns_pair, mismatches, SWEEP_NUM_POINTS);
+        total_mismatches += mismatches;
+    }
+    
+    goertzel_set_kernel(saved);
+    return total_mismatches;
+}
+
+int main(void) {
+    static uint16_t samples[WINDOW_SIZE];
+    static float freqs[BENCH_MAX_BINS];
+    static goertzel_result_t single[BENCH_MAX_BINS];
+    static goertzel_result_t precomputed[BENCH_MAX_BINS];
+    static goertzel_result_t multi[BENCH_MAX_BINS];
+    static goertzel_coeffs_t coeffs[BENCH_MAX_BINS];
+    static const size_t bin_counts[] = {1, 2, 4, 8, 16, 32, 64};
+    
+    bench_fill_window(samples);
+    
+    // Bins coherentes sobre la grilla del barrido
+    for (size_t b = 0; b < BENCH_MAX_BINS; b++) {
+        freqs[b] = SWEEP_FREQ_MIN + (float)(b * 3) * FREQ_RESOLUTION;
+        goertzel_coeffs_init(&coeffs[b], freqs[b], SAMPLE_RATE);
+    }
+    
+    printf("Goertzel sobre %d muestras: costo por bin\n\n", WINDOW_SIZE);
+    printf("%6s %14s %14s %14s %9s %12s %12s\n", "bins", "single ns/bin", "coef ns/bin",
+           "multi ns/bin", "speedup", "max dmag", "max dphase");
+    
+    for (size_t i = 0; i < sizeof(bin_counts) / sizeof(bin_counts[0]); i++) {
+        size_t nbins = bin_counts[i];
+        long reps_single, reps_coeffs, reps_multi;
+        
+        double t_single = bench_single(samples, freqs, nbins, single, &reps_single);
+        double t_coeffs = bench_coeffs(samples, coeffs, nbins, precomputed, &reps_coeffs);
+        double t_multi = bench_multi(samples, freqs, nbins, multi, &reps_multi);
+        
+        double ns_single = t_single * 1e9 / ((double)reps_single * nbins);
+        double ns_coeffs = t_coeffs * 1e9 / ((double)reps_coeffs * nbins);
+        double ns_multi = t_multi * 1e9 / ((double)reps_multi * nbins);
+        
+        float max_dmag = 0.0f;
+        float max_dphase = 0.0f;
+        for (size_t b = 0; b < nbins; b++) {
+            max_dmag = fmaxf(max_dmag, fabsf(single[b].magnitude - multi[b].magnitude));
+            max_dphase = fmaxf(max_dphase, fabsf(single[b].phase_deg - multi[b].phase_deg));
+        }
+        
+        printf("%6zu %14.1f %14.1f %14.1f %8.2fx %12.3g %12.3g\n", nbins, ns_single, ns_coeffs,
+               ns_multi, ns_single / ns_multi, max_dmag, max_dphase);
+    }
+    
+    unsigned mismatches = bench_kernels();
+    mismatches += bench_streaming();
+    mismatches += bench_pair();
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file bench_json.c
+ * @brief Benchmark del serializador JSON en el host (fra_bench_json)
+ *
+ * Mide ns/punto de json_format_measurement() contra el snprintf("%.1f…")
+ * que usaba mqtt_publish_measurement(), y de json_format_points() contra
+ * el mismo arreglo armado con snprintf, sobre los puntos de un barrido
+ * con magnitudes y fases realistas. Reporta además cuántos payloads salen
+ * idénticos byte a byte (solo difieren en empates de redondeo y en -0.0).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "config.h"
+#include "json_writer.h"
+
+#define BENCH_TARGET_SECONDS 0.2
+#define BENCH_PAYLOAD_SIZE 128
+#define BENCH_ARRAY_SIZE (SWEEP_NUM_POINTS * 48 + 8)
+
+static volatile size_t bench_sink;
+
+static json_point_t bench_points[SWEEP_NUM_POINTS];
+
+static double host_now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Puntos de un barrido sobre un pasabajos RC de 1 kHz
+ */
+static void bench_fill_points(void) {
+    for (int k = 0; k < SWEEP_NUM_POINTS; k++) {
+        float f = SWEEP_FREQ_MIN + k * FREQ_RESOLUTION;
+        float x = f / 1000.0f;
+        bench_points[k].frequency_hz = f;
+        bench_points[k].magnitude_db = -10.0f * log10f(1.0f + x * x);
+        bench_points[k].phase_deg = -atanf(x) * 180.0f / (float)M_PI;
+    }
+}
+
+static size_t snprintf_measurement(char *buf, size_t capacity, const json_point_t *p) {
+    int n = snprintf(buf, capacity, "{\"freq\":%.1f,\"mag\":%.2f,\"phase\":%.1f}",
+                     p->frequency_hz, p->magnitude_db, p->phase_deg);
+    return (n > 0 && (size_t)n < capacity) ? (size_t)n : 0;
+}
+
+static size_t snprintf_points(char *buf, size_t capacity, const json_point_t *points, uint16_t count) {
+    size_t len = 0;
+    buf[len++] = '[';
+    for (uint16_t i = 0; i < count; i++) {
+        if (i > 0) {
+            buf[len++] = ',';
+        }
+        size_t n = snprintf_measurement(buf + len, capacity - len, &points[i]);
+        if (n == 0) {
+            return 0;
+        }
+        len += n;
+    }
+    buf[len++] = ']';
+    buf[len] = '\0';
+    return len;
+}
+
+typedef size_t (*bench_single_fn)(char *, size_t, const json_point_t *);
+typedef size_t (*bench_array_fn)(char *, size_t, const json_point_t *, uint16_t);
+
+static double bench_per_point(bench_single_fn fn) {
+    char buf[BENCH_PAYLOAD_SIZE];
+    long reps = 0;
+    double t0 = host_now_s();
+    double elapsed;
+    do {
+        for (int k = 0; k < SWEEP_NUM_POINTS; k++) {
+            bench_sink += fn(buf, sizeof(buf), &bench_points[k]);
+        }
+        reps++;
+        elapsed = host_now_s() - t0;
+    } while (elapsed < BENCH_TARGET_SECONDS);
+    return elapsed * 1e9 / ((double)reps * SWEEP_NUM_POINTS);
+}
+
+static double bench_array(bench_array_fn fn, size_t *len) {
+    static char buf[BENCH_ARRAY_SIZE];
+    long reps = 0;
+    double t0 = host_now_s();
+    double elapsed;
+    do {
+        *len = fn(buf, sizeof(buf), bench_points, SWEEP_NUM_POINTS);
+        bench_sink += *len;
+        reps++;
+        elapsed = host_now_s() - t0;
+    } while (elapsed < BENCH_TARGET_SECONDS);
+    return elapsed * 1e9 / ((double)reps * SWEEP_NUM_POINTS);
+}
+
+int main(void) {
+    bench_fill_points();
+
+    // Coincidencia byte a byte con el formato anterior
+    int identical = 0;
+    for (int k = 0; k < SWEEP_NUM_POINTS; k++) {
+        char a[BENCH_PAYLOAD_SIZE];
+        char b[BENCH_PAYLOAD_SIZE];
+        snprintf_measurement(a, sizeof(a), &bench_points[k]);
+        json_format_measurement(b, sizeof(b), &bench_points[k]);
+        if (strcmp(a, b) == 0) {
+            identical++;
+        }
+    }
+
+    double ns_snprintf = bench_per_point(snprintf_measurement);
+    double ns_writer = bench_per_point(json_format_measurement);
+    size_t len_snprintf = 0;
+    size_t len_writer = 0;
+    double ns_array_snprintf = bench_array(snprintf_points, &len_snprintf);
+    double ns_array_writer = bench_array(json_format_points, &len_writer);
+
+    printf("Payload de medición (%d puntos de un barrido RC)\n", SWEEP_NUM_POINTS);
+    printf("  snprintf:          %8.1f ns/punto\n", ns_snprintf);
+    printf("  json_writer:       %8.1f ns/punto  (%.1fx)\n", ns_writer, ns_snprintf / ns_writer);
+    printf("Arreglo de %d puntos en un payload\n", SWEEP_NUM_POINTS);
+    printf("  snprintf:          %8.1f ns/punto  (%lu bytes)\n",
+           ns_array_snprintf, (unsigned long)len_snprintf);
+    printf("  json_writer:       %8.1f ns/punto  (%lu bytes, %.1fx)\n",
+           ns_array_writer, (unsigned long)len_writer, ns_array_snprintf / ns_array_writer);
+    printf("Payloads idénticos a snprintf: %d/%d\n", identical, SWEEP_NUM_POINTS);
+
+    return 0;
+}
@@ -0,0 +1,276 @@
+/**
+ * @file bench_multitone.c
+ * @brief Excitación multitono contra el barrido tono a tono (fra_bench_multitone)
+ *
+ * Con un RC pasabajos de 1 kHz y ruido en el ADC, para cada multiseno:
+ * - planifica y verifica el pico de multitone_excitation() contra el
+ *   admitido;
+ * - la aplica con la fuente externa del simulador y la mide sobre la
+ *   captura continua (multitone_measure());
+ * - compara cada tono contra la H teórica: el error relativo tiene que
+ *   quedar dentro de lo que anuncia su propia SNR (4σ más un piso), así la
+ *   SNR reportada queda validada y no solo calculada;
+ * - mide los mismos tonos uno por uno con frequency_sweep_measure() y
+ *   compara puntos por segundo (reloj virtual en los dos casos) y estima
+ *   desde cuántos tonos conviene la multiseno.
+ * Además verifica goertzel_pair_bins() contra goertzel_pair_t, que el JSON
+ * más largo entre en MULTITONE_JSON_MAX y que un punto suelto medido
+ * después de la multiseno (con el AD9833 de vuelta encendido) dé la H
+ * teórica. Falla si algún tono queda fuera de tolerancia o si, a partir
+ * de 40 tonos, la multiseno no es más rápida que el barrido.
+ *
+ * Promedia MULTITONE_PERIODS períodos: con menos, la SNR estimada con la
+ * dispersión entre períodos es demasiado ruidosa para validarla así.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "config.h"
+#include "ad9833.h"
+#include "adc_dma.h"
+#include "goertzel.h"
+#include "hal.h"
+#include "hal_host.h"
+#include "mqtt_client.h"
+#include "multitone.h"
+#include "sim_dut.h"
+#include "sweep.h"
+#include "sweep_store.h"
+#define CHECK_QUIET
+#include "check.h"
+
+// Aceleración del hilo DMA (ver check_monitor.c): un bloque cada 5 ms
+#define STREAM_SPEEDUP 2.0
+
+// Ruido del ADC del DUT simulado (fracción del fondo de escala)
+#define NOISE_RMS 0.001f
+
+// Piso del error relativo admitido (redondeo del float, ~0.01 dB)
+#define ERROR_FLOOR 1e-3f
+
+#if ADC_CHANNELS == 2
+
+typedef struct {
+    const char *name;
+    sweep_grid_t grid;
+    uint16_t tones;
+    uint8_t period_blocks;
+    bool must_win;              // Tiene que medir más puntos por segundo
+} bench_case_t;
+
+// Con pocos tonos gana el barrido: la multiseno paga el asentamiento y
+// todos los períodos igual, así que el caso de 10 tonos muestra el cruce
+static const bench_case_t bench_cases[] = {
+    { "log 10, B=4",     SWEEP_GRID_LOG,    10,  4,  false },
+    { "log 40, B=4",     SWEEP_GRID_LOG,    40,  4,  true },
+    { "lineal 200, B=4", SWEEP_GRID_LINEAR, 200, 4,  true },
+    { "log 100, B=16",   SWEEP_GRID_LOG,    100, 16, true },
+};
+
+static multitone_plan_t plan;
+static multitone_result_t result;
+static float period[MULTITONE_PERIOD_BLOCKS_MAX * WINDOW_SIZE];
+
+/**
+ * @brief goertzel_pair_bins() contra un goertzel_pair_t por bin
+ */
+static void check_pair_bins(void) {
+    static uint16_t frames[2 * WINDOW_SIZE];
+    static goertzel_coeffs_t coeffs[11];
+    float ref[2 * 11];
+    float resp[2 * 11];
+
+    uint32_t x = 12345u;
+    for (uint32_t n = 0; n < 2 * WINDOW_SIZE; n++) {
+        x = x * 1103515245u + 12345u;
+        frames[n] = (uint16_t)((x >> 16) & 0x0FFFu);
+    }
+    for (size_t i = 0; i < 11; i++) {
+        goertzel_coeffs_init(&coeffs[i], 100.0f + 1900.0f * (float)i, SAMPLE_RATE);
+    }
+    goertzel_pair_bins(frames, WINDOW_SIZE, coeffs, 11, ref, resp);
+
+    float worst = 0.0f;
+    for (size_t i = 0; i < 11; i++) {
+        goertzel_pair_t pair;
+        float re, im;
+        goertzel_set_kernel(GOERTZEL_KERNEL_FLOAT);
+        goertzel_pair_init(&pair, &coeffs[i], WINDOW_SIZE);
+        goertzel_pair_push(&pair, frames, WINDOW_SIZE);
+        goertzel_stream_bin(&pair.reference, &re, &im);
+        worst = fmaxf(worst, hypotf(re - ref[2 * i], im - ref[2 * i + 1]) / fmaxf(hypotf(re, im), 1.0f));
+        goertzel_stream_bin(&pair.response, &re, &im);
+        worst = fmaxf(worst, hypotf(re - resp[2 * i], im - resp[2 * i + 1]) / fmaxf(hypotf(re, im), 1.0f));
+    }
+    goertzel_set_kernel(GOERTZEL_DEFAULT_KERNEL);
+
+    printf("goertzel_pair_bins() contra goertzel_pair_t: error relativo %.2e\n", worst);
+    expect(worst < 1e-5f, "goertzel_pair_bins() coincide con goertzel_pair_t");
+}
+
+/**
+ * @brief El JSON con todos los tonos y la SNR más larga entra en el slot
+ */
+static void check_format(void) {
+    static char buf[MULTITONE_JSON_MAX];
+
+    plan.period_blocks = MULTITONE_PERIOD_BLOCKS_MAX;
+    plan.crest_factor = 99.99f;
+    plan.tone_db = -99.9f;
+    result.count = MULTITONE_TONES_MAX;
+    result.periods = UINT16_MAX;
+    for (uint16_t i = 0; i < MULTITONE_TONES_MAX; i++) {
+        result.snr_db[i] = (i % 2) ? -1000.0f : 1000.0f;
+    }
+    size_t len = multitone_format_json(&plan, &result, UINT32_MAX, buf, sizeof(buf));
+
+    printf("JSON con %d tonos: %zu de %d bytes\n", MULTITONE_TONES_MAX, len,
+           (int)MULTITONE_JSON_MAX);
+    expect(len > 0, "el JSON más largo entra en MULTITONE_JSON_MAX");
+}
+
+/**
+ * @brief Mide un caso con la multiseno y tono a tono
+ */
+static void run_case(const bench_case_t *c) {
+    multitone_params_t params;
+    multitone_default_params(&params);
+    params.grid = c->grid;
+    params.tones = c->tones;
+    params.period_blocks = c->period_blocks;
+
+    if (!multitone_plan_build(&plan, &params)) {
+        expect(false, "multitone_plan_build()");
+        return;
+    }
+
+    // El pico admitido cubre también el de entre muestras: sobre la grilla
+    // la excitación queda a lo sumo en él
+    float peak = 0.0f;
+    multitone_excitation(&plan, 0, period, plan.period_samples);
+    for (uint32_t n = 0; n < plan.period_samples; n++) {
+        peak = fmaxf(peak, fabsf(period[n]));
+    }
+    expect(peak <= params.peak + 1e-4f && peak > 0.8f * params.peak,
+           "el pico de la excitación sobre la grilla no pasa el pedido");
+
+    sim_dut_set_multisine(plan.freq_hz, plan.phase_rad, plan.count, plan.amplitude);
+    bool measured = multitone_measure(&plan, params.periods, &result);
+    sim_dut_set_multisine(NULL, NULL, 0, 0.0f);
+    if (!measured) {
+        expect(false, "multitone_measure()");
+        return;
+    }
+
+    float worst_ratio = 0.0f;
+    float min_snr = INFINITY;
+    bool snr_reported = true;
+    for (uint16_t i = 0; i < result.count; i++) {
+        float mag, phase;
+        sim_dut_response(result.frequency_hz[i], &mag, &phase);
+
+        float m = powf(10.0f, result.magnitude_db[i] / 20.0f);
+        float p = result.phase_deg[i] * ((float)M_PI / 180.0f);
+        float err = hypotf(m * cosf(p) - mag * cosf(phase), m * sinf(p) - mag * sinf(phase)) / mag;
+
+        // σ relativo de la H promediada = 10^(-SNR/20)
+        float allowed = 4.0f * powf(10.0f, -result.snr_db[i] / 20.0f) + ERROR_FLOOR;
+        worst_ratio = fmaxf(worst_ratio, err / allowed);
+        min_snr = fminf(min_snr, result.snr_db[i]);
+        snr_reported = snr_reported && isfinite(result.snr_db[i]);
+    }
+    expect(result.count == plan.count, "un resultado por tono");
+    expect(snr_reported, "SNR por bin reportada");
+    expect(worst_ratio <= 1.0f, "cada tono dentro de lo que anuncia su SNR");
+
+    // Los mismos tonos, uno por uno
+    uint32_t t0 = hal_time_ms();
+    for (uint16_t i = 0; i < plan.count; i++) {
+        sweep_measurement_t m;
+        frequency_sweep_measure(plan.freq_hz[i], &m);
+    }
+    uint32_t single_ms = hal_time_ms() - t0;
+
+    float multi_rate = 1000.0f * (float)result.count / (float)result.total_time_ms;
+    float single_rate = 1000.0f * (float)plan.count / (float)single_ms;
+    // Tonos desde los que la multiseno empata con el barrido
+    float crossover = (float)result.total_time_ms * single_rate / 1000.0f;
+
+    printf("%-16s %5u %6.2f %7.1f %7.1f %7.2f %5lu %8lu %9.1f %8lu %9.1f %6.1fx %5.0f\n", c->name,
+           plan.count, plan.crest_factor, plan.tone_db, min_snr, worst_ratio, (unsigned long)result.gaps,
+           (unsigned long)result.total_time_ms, multi_rate, (unsigned long)single_ms, single_rate,
+           multi_rate / single_rate, crossover);
+    if (c->must_win) {
+        expect(multi_rate > single_rate, "la multiseno mide más puntos por segundo");
+    }
+}
+
+/**
+ * @brief Un punto suelto después de la multiseno mide con el DDS encendido
+ *
+ * multitone_measure() apaga el AD9833: si no lo vuelve a encender, el
+ * punto mide una referencia nula y la H sale basura.
+ */
+static void check_point_after(void) {
+    sweep_measurement_t m;
+    float mag, phase;
+
+    expect(ad9833_is_output_enabled(), "la salida del AD9833 vuelve a quedar habilitada");
+    if (!frequency_sweep_measure(1000.0f, &m)) {
+        expect(false, "frequency_sweep_measure() después de la multiseno");
+        return;
+    }
+    sim_dut_response(m.frequency_hz, &mag, &phase);
+    float err_db = fabsf(m.magnitude_db - 20.0f * log10f(mag));
+    float err_deg = fabsf(remainderf(m.phase_deg - phase * (180.0f / (float)M_PI), 360.0f));
+
+    printf("\nPunto suelto después de la multiseno: %.1f Hz, error %.3f dB, %.2f°\n",
+           m.frequency_hz, err_db, err_deg);
+    expect(err_db < 0.1f && err_deg < 1.0f, "el punto suelto coincide con la H teórica");
+}
+
+#endif // ADC_CHANNELS == 2
+
+int main(void) {
+#if ADC_CHANNELS != 2
+    printf("La multiseno se mide contra el canal de referencia: requiere ADC_CHANNELS = 2\n");
+    return EXIT_SUCCESS;
+#else
+    mqtt_config_t mqtt_cfg = {
+        .broker_addr = MQTT_BROKER_ADDR,
+        .broker_port = MQTT_BROKER_PORT,
+        .client_id = MQTT_CLIENT_ID,
+        .topic = MQTT_TOPIC_MEASUREMENTS
+    };
+    if (!hal_host_flash_open(NULL) || !adc_dma_init() || !ad9833_init() || !mqtt_init(&mqtt_cfg)
+        || !sweep_store_init() || !frequency_sweep_init()) {
+        fprintf(stderr, "[FATAL] Fallo en inicialización de módulos\n");
+        return EXIT_FAILURE;
+    }
+
+    sim_dut_config_t dut;
+    sim_dut_default_config(&dut);
+    dut.noise_rms = NOISE_RMS;
+    sim_dut_configure(&dut);
+    hal_host_set_stream_speedup(STREAM_SPEEDUP);
+
+    check_pair_bins();
+    check_format();
+
+    printf("\nRC 1 kHz, ruido %.4f FS, %u períodos, pico %.2f FS\n\n", NOISE_RMS, MULTITONE_PERIODS,
+           MULTITONE_PEAK);
+    printf("%-16s %5s %6s %7s %7s %7s %5s %8s %9s %8s %9s %7s %5s\n", "multiseno", "tonos", "cresta",
+           "tono_dB", "SNRmin", "err/tol", "huecos", "multi_ms", "puntos/s", "tono_ms", "puntos/s",
+           "ganancia", "cruce");
+    for (size_t i = 0; i < sizeof(bench_cases) / sizeof(bench_cases[0]); i++) {
+        run_case(&bench_cases[i]);
+    }
+    check_point_after();
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FALLA");
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+#endif
+}
@@ -0,0 +1,59 @@
+/**
+ * @file check.h
+ * @brief Verificaciones de los ejecutables de prueba del host
+ *
+ * Cada fra_check_* y fra_bench_* es un ejecutable aparte con su propia
+ * cuenta de fallas: expect() registra cada verificación y el main()
+ * decide el código de salida con failures. Los benchmarks, que imprimen
+ * tablas, definen CHECK_QUIET antes de incluirlo para que expect() solo
+ * informe las fallas. drain_publish_queue() hace de red para los que
+ * leen lo publicado.
+ */
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "publish_queue.h"
+
+static int failures = 0;
+
+static inline void expect(bool cond, const char *what) {
+#ifdef CHECK_QUIET
+    if (!cond) {
+        printf("  [FALLA] %s\n", what);
+    }
+#else
+    printf("  [%s] %s\n", cond ? " OK " : "FALLA", what);
+#endif
+    if (!cond) {
+        failures++;
+    }
+}
+
+/**
+ * @brief Recibe un mensaje drenado: tópico y payload terminado en '\0'
+ */
+typedef void (*drain_fn_t)(const char *topic, const char *text, size_t len, void *ctx);
+
+/**
+ * @brief Vacía la cola de publicación como si la red lo entregara todo
+ *
+ * Pasa cada mensaje a on_msg antes de liberar su slot.
+ */
+static inline void drain_publish_queue(drain_fn_t on_msg, void *ctx) {
+    publish_msg_t *msg;
+    while ((msg = publish_queue_acquire()) != NULL) {
+        char text[PUBLISH_QUEUE_MSG_MAX + 1];
+        memcpy(text, msg->payload, msg->len);
+        text[msg->len] = '\0';
+        on_msg(msg->topic, text, msg->len, ctx);
+        publish_queue_release(msg, true);
+    }
+}
+
+#endif // CHECK_H
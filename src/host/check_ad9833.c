@@ -0,0 +1,298 @@
+/**
+ * @file check_ad9833.c
+ * @brief Verificación de la secuencia SPI del AD9833 (fra_check_ad9833)
+ *
+ * Instala un transporte que registra cada palabra y la reenvía al DDS
+ * simulado, y comprueba:
+ * - que set_frequency escribe LSB/MSB en el registro inactivo y conmuta
+ *   FSELECT con una sola palabra de control;
+ * - que la precarga no altera la salida y el cambio posterior cuesta una
+ *   sola palabra;
+ * - que forma de onda y habilitación conservan el registro seleccionado;
+ * - que el salto de frecuencia es de fase continua en el modelo del chip;
+ * - que un guion de comandos produce la secuencia dorada de palabras, igual
+ *   de a una que en lote, y que los lotes se encadenan en orden;
+ * - que con el SPI de la HAL el lote no detiene el reloj y avisa al final.
+ * Retorna distinto de cero ante cualquier discrepancia.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "config.h"
+#include "ad9833.h"
+#include "hal.h"
+#include "sim_dds.h"
+#include "check.h"
+
+#define LOG_CAPACITY 64
+
+// Campos de la palabra SPI según el datasheet
+#define REG_MASK     0xC000
+#define REG_CONTROL  0x0000
+#define REG_FREQ0    0x4000
+#define REG_FREQ1    0x8000
+#define CTRL_B28     0x2000
+#define CTRL_FSELECT 0x0800
+#define CTRL_RESET   0x0100
+#define CTRL_MODE    0x0002
+#define HALF_MASK    0x3FFF
+
+typedef struct {
+    uint16_t words[LOG_CAPACITY];
+    uint32_t count;
+    uint32_t batches;                ///< Lotes recibidos por write_async
+    ad9833_done_cb_t pending;        ///< Aviso del lote "en vuelo"
+    void *pending_ctx;
+} spi_log_t;
+
+// Secuencia dorada de golden_script(): init, 1000 Hz, fase 90°, precarga
+// de 2000 Hz, conmutación y onda cuadrada
+static const uint16_t golden_words[] = {
+    0x2100, 0x4000, 0x4000, 0x8000, 0x8000, 0xC000, 0x2000,
+    0xA9F1, 0x8000, 0x2800,
+    0xC400,
+    0x53E3, 0x4001,
+    0x2000,
+    0x2028
+};
+#define GOLDEN_COUNT (sizeof(golden_words) / sizeof(golden_words[0]))
+
+static void log_write16(void *ctx, uint16_t word) {
+    spi_log_t *log = ctx;
+    if (log->count < LOG_CAPACITY) {
+        log->words[log->count] = word;
+    }
+    log->count++;
+    hal_spi_write16(word);
+}
+
+/**
+ * @brief Lote "por DMA": registra las palabras y deja el aviso pendiente
+ *        hasta que el driver espere
+ */
+static bool log_write_async(void *ctx, const uint16_t *words, uint32_t count,
+                            ad9833_done_cb_t done, void *done_ctx) {
+    spi_log_t *log = ctx;
+    if (log->pending) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        log_write16(log, words[i]);
+    }
+    log->batches++;
+    log->pending = done;
+    log->pending_ctx = done_ctx;
+    return true;
+}
+
+static bool log_is_busy(void *ctx) {
+    return ((spi_log_t *)ctx)->pending != NULL;
+}
+
+static void log_wait(void *ctx) {
+    spi_log_t *log = ctx;
+    ad9833_done_cb_t done = log->pending;
+    log->pending = NULL;
+    if (done) {
+        done(log->pending_ctx);
+    }
+}
+
+static void count_done(void *ctx) {
+    (*(uint32_t *)ctx)++;
+}
+
+static void golden_script(void) {
+    ad9833_reset();
+    ad9833_set_frequency(1000.0f);
+    ad9833_set_phase(90.0f);
+    ad9833_preload_frequency(2000.0f);
+    ad9833_switch_preloaded();
+    ad9833_set_waveform(AD9833_WAVEFORM_SQUARE);
+}
+
+static bool log_matches_golden(const spi_log_t *log, uint32_t offset) {
+    for (uint32_t i = 0; i < GOLDEN_COUNT; i++) {
+        if (log->words[offset + i] != golden_words[i]) {
+            printf("  palabra %lu: 0x%04X, se esperaba 0x%04X\n", (unsigned long)(offset + i),
+                   log->words[offset + i], golden_words[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t expected_word(float freq_hz) {
+    return (uint32_t)((freq_hz * 268435456.0f) / AD9833_MCLK + 0.5f);
+}
+
+/**
+ * @brief Verifica que words[first..first+1] sean LSB/MSB de freq en reg
+ */
+static bool is_freq_write(const spi_log_t *log, uint32_t first, uint16_t reg, float freq_hz) {
+    uint32_t word = expected_word(freq_hz);
+    return log->words[first] == (reg | (word & HALF_MASK))
+        && log->words[first + 1] == (reg | ((word >> 14) & HALF_MASK));
+}
+
+int main(void) {
+    spi_log_t log = {0};
+    ad9833_transport_t transport = { .write16 = log_write16, .ctx = &log };
+    
+    // El DDS simulado necesita el SPI de la HAL inicializado
+    hal_spi_init();
+    ad9833_set_transport(&transport);
+    
+    printf("Inicialización\n");
+    expect(ad9833_init(), "ad9833_init() con transporte propio");
+    expect(log.count >= 2 && log.words[0] == (CTRL_B28 | CTRL_RESET), "primera palabra: B28 | RESET");
+    expect(log.words[log.count - 1] == CTRL_B28, "última palabra: control sin RESET, FREQ0 activo");
+    
+    printf("set_frequency(1000 Hz) desde FREQ0 activo\n");
+    log.count = 0;
+    ad9833_set_frequency(1000.0f);
+    expect(log.count == 3, "tres palabras");
+    expect(is_freq_write(&log, 0, REG_FREQ1, 1000.0f), "LSB y MSB en FREQ1 (inactivo)");
+    expect(log.words[2] == (CTRL_B28 | CTRL_FSELECT), "control con FSELECT=1");
+    expect(fabs(sim_dds_frequency() - 1000.0) < 0.1, "el DDS genera 1000 Hz");
+    
+    printf("Precarga de 1100 Hz\n");
+    log.count = 0;
+    uint64_t t_before = hal_time_us();
+    double phase_before = sim_dds_phase_at(t_before);
+    ad9833_preload_frequency(1100.0f);
+    expect(log.count == 2, "dos palabras");
+    expect(is_freq_write(&log, 0, REG_FREQ0, 1100.0f), "LSB y MSB en FREQ0 (inactivo)");
+    expect(fabs(sim_dds_frequency() - 1000.0) < 0.1, "la salida sigue en 1000 Hz");
+    float preloaded = 0.0f;
+    expect(ad9833_get_preloaded(&preloaded) && preloaded == 1100.0f, "precarga pendiente de 1100 Hz");
+    
+    printf("Conmutación a la precarga\n");
+    log.count = 0;
+    uint64_t t_switch = hal_time_us();
+    expect(ad9833_switch_preloaded(), "switch_preloaded() retorna true");
+    expect(log.count == 1, "una sola palabra");
+    expect(log.words[0] == CTRL_B28, "control con FSELECT=0");
+    expect(fabs(sim_dds_frequency() - 1100.0) < 0.1, "el DDS genera 1100 Hz");
+    expect(ad9833_get_frequency() == 1100.0f, "ad9833_get_frequency() = 1100 Hz");
+    
+    // Fase continua: la fase en el instante del cambio es la que traía la
+    // senoide de 1000 Hz desde t_before
+    double f_old = expected_word(1000.0f) * (double)AD9833_MCLK / 268435456.0;
+    double phase_expected = phase_before + 2.0 * M_PI * f_old * (double)(t_switch - t_before) * 1e-6;
+    expect(fabs(sim_dds_phase_at(t_switch) - phase_expected) < 1e-6, "fase continua en el salto");
+    expect(!ad9833_switch_preloaded(), "sin precarga pendiente, switch no escribe");
+    expect(log.count == 1, "ninguna palabra extra");
+    
+    printf("Forma de onda y habilitación con FREQ1 activo\n");
+    ad9833_set_frequency(1200.0f);
+    log.count = 0;
+    ad9833_set_waveform(AD9833_WAVEFORM_TRIANGLE);
+    ad9833_enable_output(false);
+    ad9833_enable_output(true);
+    ad9833_set_waveform(AD9833_WAVEFORM_SINE);
+    expect(log.count == 4, "una palabra por llamada");
+    expect(log.words[0] == (CTRL_B28 | CTRL_FSELECT | CTRL_MODE), "triangular conserva FSELECT");
+    expect(log.words[1] == (CTRL_B28 | CTRL_FSELECT | CTRL_MODE | CTRL_RESET),
+           "deshabilitar conserva FSELECT y la forma de onda");
+    expect(log.words[3] == (CTRL_B28 | CTRL_FSELECT), "senoidal conserva FSELECT");
+    expect(fabs(sim_dds_frequency() - 1200.0) < 0.1, "el DDS sigue en 1200 Hz");
+    
+    printf("set_frequency descarta la precarga\n");
+    ad9833_preload_frequency(5000.0f);
+    ad9833_set_frequency(3000.0f);
+    expect(!ad9833_get_preloaded(NULL), "sin precarga pendiente");
+    expect(fabs(sim_dds_frequency() - 3000.0) < 0.1, "el DDS genera 3000 Hz");
+    
+    printf("Barrido con precarga: palabras en el camino crítico\n");
+    uint32_t critical = 0;
+    uint32_t total = 0;
+    ad9833_set_frequency(SWEEP_FREQ_MIN);
+    for (uint16_t k = 0; k + 1 < SWEEP_NUM_POINTS; k++) {
+        log.count = 0;
+        ad9833_preload_frequency(SWEEP_FREQ_MIN + (k + 1) * FREQ_RESOLUTION);
+        total += log.count;
+        log.count = 0;
+        ad9833_switch_preloaded();
+        critical += log.count;
+        total += log.count;
+    }
+    printf("  %lu palabras por punto, %lu en el cambio de frecuencia\n",
+           (unsigned long)(total / (SWEEP_NUM_POINTS - 1)),
+           (unsigned long)(critical / (SWEEP_NUM_POINTS - 1)));
+    expect(critical == SWEEP_NUM_POINTS - 1, "una palabra SPI por cambio de punto");
+    
+    printf("Secuencia dorada de a una palabra\n");
+    log.count = 0;
+    golden_script();
+    expect(log.count == GOLDEN_COUNT && log_matches_golden(&log, 0), "coincide palabra a palabra");
+    
+    printf("Secuencia dorada en lotes\n");
+    spi_log_t batch_log = {0};
+    ad9833_transport_t batch_transport = {
+        .write16 = log_write16,
+        .write_async = log_write_async,
+        .is_busy = log_is_busy,
+        .wait = log_wait,
+        .ctx = &batch_log
+    };
+    uint32_t done_count = 0;
+    ad9833_set_transport(&batch_transport);
+    ad9833_set_batch_callback(count_done, &done_count);
+    ad9833_batch_begin();
+    golden_script();
+    expect(batch_log.count == 0, "nada sale antes del commit");
+    ad9833_batch_commit();
+    expect(batch_log.batches == 1, "un solo lote");
+    expect(batch_log.count == GOLDEN_COUNT && log_matches_golden(&batch_log, 0),
+           "mismas palabras y mismo orden que de a una");
+    expect(ad9833_is_busy() && done_count == 0, "lote en vuelo hasta el aviso");
+    ad9833_wait_idle();
+    expect(!ad9833_is_busy() && done_count == 1, "aviso de fin entregado una vez");
+    
+    printf("Lotes encadenados y lote desbordado\n");
+    batch_log.count = 0;
+    batch_log.batches = 0;
+    ad9833_batch_begin();
+    golden_script();
+    golden_script();
+    ad9833_batch_commit();
+    expect(batch_log.batches == 2, "el lote lleno se envía y se sigue encolando");
+    expect(batch_log.count == 2 * GOLDEN_COUNT && log_matches_golden(&batch_log, 0)
+           && log_matches_golden(&batch_log, GOLDEN_COUNT), "dos secuencias doradas en orden");
+    ad9833_set_frequency(1500.0f);
+    expect(!ad9833_is_busy() && batch_log.count == 2 * GOLDEN_COUNT + 3,
+           "la escritura bloqueante espera al lote en vuelo");
+    ad9833_set_batch_callback(NULL, NULL);
+    
+    printf("Lote por el SPI de la HAL (DMA simulado)\n");
+    done_count = 0;
+    ad9833_set_transport(NULL);
+    ad9833_set_batch_callback(count_done, &done_count);
+    expect(ad9833_init(), "ad9833_init() con el SPI de la HAL");
+    ad9833_set_frequency(1000.0f);
+    uint64_t t_commit = hal_time_us();
+    ad9833_batch_begin();
+    ad9833_preload_frequency(1100.0f);
+    ad9833_batch_commit();
+    expect(hal_time_us() == t_commit, "el commit no detiene al CPU");
+    expect(ad9833_is_busy() && hal_spi_is_busy(), "bus ocupado mientras salen las palabras");
+    hal_sleep_us(16);
+    expect(!ad9833_is_busy() && done_count == 1, "aviso al terminar las dos palabras");
+    expect(fabs(sim_dds_frequency() - 1000.0) < 0.1, "la precarga no altera la salida");
+    ad9833_batch_begin();
+    ad9833_preload_frequency(1200.0f);
+    ad9833_batch_commit();
+    t_commit = hal_time_us();
+    ad9833_switch_preloaded();
+    expect(hal_time_us() >= t_commit + 24, "la conmutación espera al lote y luego a su palabra");
+    expect(fabs(sim_dds_frequency() - 1200.0) < 0.1, "el DDS genera 1200 Hz");
+    ad9833_set_batch_callback(NULL, NULL);
+    
+    ad9833_set_transport(NULL);
+    
+    printf("\n%s (%d fallas)\n", failures ? "FALLA" : "OK", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
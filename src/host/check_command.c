@@ -0,0 +1,487 @@
+/**
+ * @file check_command.c
+ * @brief Verificación del control remoto por MQTT (fra_check_command)
+ *
+ * Corre sobre el simulador con un RC y la cola de publicación drenada a
+ * mano. Comprueba:
+ * - command_parse() sobre comandos válidos (perfil completo, perfil
+ *   parcial que parte del vigente, lista, punto, start, stop, rate,
+ *   monitor) y
+ *   sobre JSON roto, comandos desconocidos, claves ajenas al comando y
+ *   valores fuera de rango;
+ * - de punta a punta, mqtt_client_incoming() → command_poll() → la
+ *   confirmación exacta en MQTT_TOPIC_STATUS;
+ * - que un perfil cambie el plan, y que uno que no se puede construir deje
+ *   el anterior y confirme "failed";
+ * - que "point" publique una medición y "rate" cambie las tramas por
+ *   barrido;
+ * - que "stop" corte un barrido del motor en curso y que, mientras corre,
+ *   perfil, punto, start y tramas se confirmen "busy";
+ * - la bandeja llena (descarta y cuenta) y el payload demasiado largo;
+ * - comandos mutados al azar: command_parse() nunca lee fuera del payload
+ *   (copia exacta en el heap) y lo que acepta está dentro de rango.
+ * Retorna distinto de cero ante cualquier discrepancia.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "config.h"
+#include "ad9833.h"
+#include "adc_dma.h"
+#include "command.h"
+#include "hal_host.h"
+#include "mqtt_client.h"
+#include "publish_queue.h"
+#include "sim_dut.h"
+#include "sweep.h"
+#include "sweep_frame.h"
+#include "sweep_store.h"
+#include "check.h"
+
+// Consultas del motor antes de mandar "stop" (a mitad del barrido)
+#define POLLS_BEFORE_STOP 300
+
+// Puntos por trama de la prueba de "rate"
+#define RATE_FRAME_POINTS 50
+
+#define FUZZ_COMMANDS 50000
+#define FUZZ_MUTATIONS 3
+
+// Confirmaciones y publicaciones leídas de la cola
+#define MAX_ACKS 8
+
+typedef struct {
+    uint32_t acks;
+    char ack[MAX_ACKS][COMMAND_ACK_JSON_MAX];
+    uint32_t measurements;
+    uint32_t frames;
+    bool aborted;
+} drained_t;
+
+/**
+ * @brief Guarda las confirmaciones y cuenta lo demás que se publicó
+ */
+static void collect(const char *topic, const char *text, size_t len, void *ctx) {
+    drained_t *d = ctx;
+    if (strcmp(topic, MQTT_TOPIC_STATUS) == 0) {
+        if (strstr(text, "\"ack\"") && d->acks < MAX_ACKS && len < COMMAND_ACK_JSON_MAX) {
+            strcpy(d->ack[d->acks++], text);
+        }
+        d->aborted |= strstr(text, "sweep_aborted") != NULL;
+    } else if (strcmp(topic, MQTT_TOPIC_MEASUREMENTS) == 0) {
+        d->measurements++;
+    } else if (strcmp(topic, MQTT_TOPIC_SWEEP) == 0) {
+        d->frames++;
+    }
+}
+
+static void drain(drained_t *d) {
+    memset(d, 0, sizeof(*d));
+    drain_publish_queue(collect, d);
+}
+
+static command_error_t parse(const char *text, command_t *cmd) {
+    return command_parse(text, strlen(text), cmd);
+}
+
+static bool send(const char *text) {
+    return mqtt_client_incoming(MQTT_TOPIC_COMMAND, (const uint8_t *)text, strlen(text));
+}
+
+/**
+ * @brief Manda un comando, lo ejecuta y compara la única confirmación
+ */
+static void roundtrip(const char *text, const char *expected_ack, const char *what) {
+    static drained_t d;
+    send(text);
+    command_poll();
+    drain(&d);
+    bool ok = d.acks == 1 && strcmp(d.ack[0], expected_ack) == 0;
+    expect(ok, what);
+    if (!ok && d.acks > 0) {
+        printf("  %s\n", d.ack[0]);
+    }
+}
+
+static void run_engine(void) {
+    while (frequency_sweep_poll() == SWEEP_RUNNING) {
+        frequency_sweep_wait();
+    }
+}
+
+static void check_parse(void) {
+    static command_t cmd;
+    printf("Parseo\n");
+
+    expect(parse("{\"cmd\":\"profile\",\"id\":7,\"grid\":\"log\",\"start\":20,\"stop\":20000,"
+                 "\"points\":61,\"averages\":2,\"window\":960,\"snr\":40,\"max_windows\":8,"
+                 "\"stderr_db\":0.02,\"stderr_deg\":0.2}", &cmd) == COMMAND_OK
+           && cmd.type == COMMAND_PROFILE && cmd.has_id && cmd.id == 7
+           && cmd.spec.grid == SWEEP_GRID_LOG && cmd.spec.start_hz == 20.0f
+           && cmd.spec.stop_hz == 20000.0f && cmd.spec.points == 61 && cmd.spec.averages == 2
+           && cmd.spec.max_window == 960 && cmd.spec.target_snr_db == 40.0f
+           && cmd.spec.average.max_windows == 8 && cmd.spec.average.stderr_db == 0.02f
+           && cmd.spec.average.stderr_deg == 0.2f && cmd.spec.list_hz == NULL,
+           "perfil completo");
+
+    sweep_plan_spec_t defaults;
+    sweep_plan_default_spec(&defaults);
+    expect(parse(" { \"points\" : 10 , \"cmd\" : \"profile\" } ", &cmd) == COMMAND_OK
+           && !cmd.has_id && cmd.spec.points == 10 && cmd.spec.grid == defaults.grid
+           && cmd.spec.start_hz == defaults.start_hz && cmd.spec.averages == defaults.averages,
+           "perfil parcial: el resto queda como el vigente, \"cmd\" en cualquier lugar");
+    expect(parse("{\"cmd\":\"profile\",\"list\":[50,1e3,2500.5]}", &cmd) == COMMAND_OK
+           && cmd.spec.grid == SWEEP_GRID_LIST && cmd.spec.points == 3 && cmd.spec.list_hz != NULL
+           && cmd.spec.list_hz[1] == 1000.0f && cmd.spec.list_hz[2] == 2500.5f,
+           "lista: pasa a la grilla LIST");
+    expect(parse("{\"cmd\":\"point\",\"freq\":1234.5,\"id\":4294967295}", &cmd) == COMMAND_OK
+           && cmd.type == COMMAND_POINT && cmd.freq_hz == 1234.5f && cmd.id == UINT32_MAX,
+           "punto");
+    expect(parse("{\"cmd\":\"start\"}", &cmd) == COMMAND_OK && cmd.type == COMMAND_START
+           && parse("{\"cmd\":\"stop\",\"id\":1}", &cmd) == COMMAND_OK && cmd.type == COMMAND_STOP,
+           "start y stop");
+    expect(parse("{\"cmd\":\"rate\",\"frame_points\":0}", &cmd) == COMMAND_OK
+           && cmd.has_frame_points && !cmd.has_interval && cmd.frame_points == 0
+           && cmd.interval_ms == command_interval_ms(),
+           "rate parcial");
+    expect(parse("{\"cmd\":\"monitor\",\"freq\":1234,\"window\":8,\"hop\":2,\"batch\":20}", &cmd)
+           == COMMAND_OK && cmd.type == COMMAND_MONITOR && cmd.monitor.freq_hz == 1234.0f
+           && cmd.monitor.window_blocks == 8 && cmd.monitor.hop_blocks == 2 && cmd.monitor.batch == 20,
+           "monitor");
+    expect(parse("{\"cmd\":\"monitor\",\"freq\":500}", &cmd) == COMMAND_OK
+           && cmd.monitor.freq_hz == 500.0f && cmd.monitor.window_blocks == MONITOR_WINDOW_BLOCKS
+           && cmd.monitor.hop_blocks == MONITOR_HOP_BLOCKS && cmd.monitor.batch == MONITOR_BATCH,
+           "monitor parcial");
+
+    static const struct {
+        const char *text;
+        command_error_t error;
+    } bad[] = {
+        { "", COMMAND_ERR_PARSE },
+        { "{\"cmd\":\"start\"", COMMAND_ERR_PARSE },
+        { "{\"cmd\":\"start\",}", COMMAND_ERR_PARSE },
+        { "[\"start\"]", COMMAND_ERR_PARSE },
+        { "{\"cmd\":\"start\"} x", COMMAND_ERR_PARSE },
+        { "{}", COMMAND_ERR_UNKNOWN },
+        { "{\"cmd\":\"reboot\"}", COMMAND_ERR_UNKNOWN },
+        { "{\"cmd\":7}", COMMAND_ERR_UNKNOWN },
+        { "{\"cmd\":\"start\",\"freq\":100}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"point\"}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"point\",\"freq\":0}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"point\",\"freq\":30000}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"point\",\"freq\":\"1000\"}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"poinst\":10}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"points\":0}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"points\":100000}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"points\":1.5}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"start\":5000,\"stop\":1000}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"grid\":\"cubic\"}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"grid\":\"list\"}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"grid\":\"lin\",\"list\":[100]}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"list\":[]}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"list\":[100,-5]}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"list\":[100],\"points\":1}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"averages\":0}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"window\":5000}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"profile\",\"stderr_db\":0}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"rate\"}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"rate\",\"frame_points\":100000}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"rate\",\"interval_ms\":-1}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"monitor\",\"window\":0}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"monitor\",\"window\":256}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"monitor\",\"window\":2,\"hop\":3}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"monitor\",\"batch\":0}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"monitor\",\"freq\":10,\"window\":1}", COMMAND_ERR_INVALID },
+        { "{\"cmd\":\"monitor\",\"interval_ms\":10}", COMMAND_ERR_INVALID },
+    };
+    uint32_t wrong = 0;
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        command_error_t error = parse(bad[i].text, &cmd);
+        if (error != bad[i].error) {
+            printf("  %s: %s en lugar de %s\n", bad[i].text,
+                   command_error_name(error) ? command_error_name(error) : "ok",
+                   command_error_name(bad[i].error));
+            wrong++;
+        }
+    }
+    expect(wrong == 0, "JSON roto, comandos desconocidos, claves ajenas y fuera de rango");
+
+    // Más de SWEEP_NUM_POINTS frecuencias
+    static char list[16 * (SWEEP_NUM_POINTS + 2)];
+    size_t len = (size_t)sprintf(list, "{\"cmd\":\"profile\",\"list\":[");
+    for (int i = 0; i <= SWEEP_NUM_POINTS; i++) {
+        len += (size_t)sprintf(&list[len], "%s%d", i ? "," : "", 100 + i * 50);
+    }
+    strcpy(&list[len], "]}");
+    expect(parse(list, &cmd) == COMMAND_ERR_INVALID, "lista más larga que SWEEP_NUM_POINTS");
+}
+
+static void check_profile(void) {
+    static drained_t d;
+    char expected[COMMAND_ACK_JSON_MAX];
+    printf("Perfil de punta a punta\n");
+
+    roundtrip("{\"cmd\":\"profile\",\"id\":1,\"grid\":\"log\",\"start\":100,\"stop\":10000,\"points\":41}",
+              "{\"status\":\"ack\",\"cmd\":\"profile\",\"id\":1,\"ok\":true,\"points\":41}",
+              "confirmación con los puntos del plan nuevo");
+    const sweep_plan_t *plan = frequency_sweep_get_plan();
+    expect(plan->grid == SWEEP_GRID_LOG && plan->count == 41
+           && fabsf(plan->points[0].freq_hz - 100.0f) < 1.0f
+           && fabsf(plan->points[plan->count - 1].freq_hz - 10000.0f) < 10.0f,
+           "el plan sigue el perfil");
+
+    frequency_sweep_start();
+    run_engine();
+    drain(&d);
+    expect(frequency_sweep_status() == SWEEP_DONE && d.frames == 1, "el barrido usa el plan nuevo");
+
+    // Parcial: mismo rango log, menos puntos
+    roundtrip("{\"cmd\":\"profile\",\"points\":21}",
+              "{\"status\":\"ack\",\"cmd\":\"profile\",\"ok\":true,\"points\":21}",
+              "perfil parcial");
+    expect(plan->grid == SWEEP_GRID_LOG && plan->count == 21, "conserva la grilla y el rango");
+
+    // 30 Hz no entra ni un ciclo en 256 muestras: falla al construir el plan
+    roundtrip("{\"cmd\":\"profile\",\"id\":2,\"list\":[30,1000],\"window\":256}",
+              "{\"status\":\"ack\",\"cmd\":\"profile\",\"id\":2,\"ok\":false,\"error\":\"failed\"}",
+              "plan imposible: failed");
+    expect(plan->grid == SWEEP_GRID_LOG && plan->count == 21, "queda el plan anterior");
+
+    // Lista que sí se construye; después un parcial que la reutiliza
+    roundtrip("{\"cmd\":\"profile\",\"list\":[1000,500,2000]}",
+              "{\"status\":\"ack\",\"cmd\":\"profile\",\"ok\":true,\"points\":3}", "perfil con lista");
+    roundtrip("{\"cmd\":\"profile\",\"averages\":2}",
+              "{\"status\":\"ack\",\"cmd\":\"profile\",\"ok\":true,\"points\":3}",
+              "parcial sobre la lista vigente");
+    expect(plan->grid == SWEEP_GRID_LIST && fabsf(plan->points[1].freq_hz - 500.0f) < 1.0f
+           && plan->points[0].averages == 2, "la lista sigue siendo la misma");
+
+    send("{\"cmd\":\"profile\",\"grid\":\"lin\",\"start\":100,\"stop\":20000,\"points\":200,"
+         "\"averages\":1}");
+    command_poll();
+    drain(&d);
+    snprintf(expected, sizeof(expected), "{\"status\":\"ack\",\"cmd\":\"profile\",\"ok\":true,\"points\":%d}",
+             plan->count);
+    expect(d.acks == 1 && strcmp(d.ack[0], expected) == 0 && plan->grid == SWEEP_GRID_LINEAR,
+           "vuelta a una grilla lineal");
+}
+
+static void check_point_and_rate(void) {
+    static drained_t d;
+    printf("Punto y ritmo\n");
+
+    send("{\"cmd\":\"point\",\"id\":3,\"freq\":1000}");
+    command_poll();
+    drain(&d);
+    expect(d.measurements == 1 && d.acks == 1
+           && strcmp(d.ack[0], "{\"status\":\"ack\",\"cmd\":\"point\",\"id\":3,\"ok\":true}") == 0,
+           "point publica la medición y confirma");
+
+    roundtrip("{\"cmd\":\"rate\",\"interval_ms\":1500,\"frame_points\":50}",
+              "{\"status\":\"ack\",\"cmd\":\"rate\",\"ok\":true}", "rate");
+    expect(command_interval_ms() == 1500 && frequency_sweep_get_frame_points() == RATE_FRAME_POINTS,
+           "pausa y tramas nuevas");
+
+    uint16_t count = frequency_sweep_get_plan()->count;
+    frequency_sweep_start();
+    run_engine();
+    drain(&d);
+    expect(d.frames == (uint32_t)((count + RATE_FRAME_POINTS - 1) / RATE_FRAME_POINTS),
+           "una trama cada frame_points puntos");
+
+    roundtrip("{\"cmd\":\"rate\",\"frame_points\":0,\"interval_ms\":10000}",
+              "{\"status\":\"ack\",\"cmd\":\"rate\",\"ok\":true}", "rate de vuelta");
+    frequency_sweep_start();
+    run_engine();
+    drain(&d);
+    expect(d.frames == 1, "una trama por barrido");
+}
+
+static void check_busy_and_stop(void) {
+    static drained_t d;
+    printf("Start, stop y barrido en curso\n");
+
+    roundtrip("{\"cmd\":\"start\",\"id\":9}", "{\"status\":\"ack\",\"cmd\":\"start\",\"id\":9,\"ok\":true}",
+              "start");
+    expect(command_sweeps_enabled() && command_take_start() && !command_take_start(),
+           "pide un barrido, una sola vez");
+
+    frequency_sweep_start();
+    for (int i = 0; i < POLLS_BEFORE_STOP && frequency_sweep_poll() == SWEEP_RUNNING; i++) {
+        frequency_sweep_wait();
+    }
+    expect(frequency_sweep_status() == SWEEP_RUNNING, "barrido en curso");
+
+    const sweep_plan_t *plan = frequency_sweep_get_plan();
+    uint16_t count = plan->count;
+    send("{\"cmd\":\"profile\",\"points\":10}");
+    send("{\"cmd\":\"point\",\"freq\":1000}");
+    send("{\"cmd\":\"start\"}");
+    send("{\"cmd\":\"rate\",\"frame_points\":10}");
+    expect(command_poll() == 4, "cuatro comandos procesados");
+    drain(&d);
+    bool all_busy = d.acks == 4;
+    for (uint32_t i = 0; i < d.acks; i++) {
+        all_busy &= strstr(d.ack[i], "\"ok\":false,\"error\":\"busy\"") != NULL;
+    }
+    expect(all_busy, "perfil, punto, start y tramas: busy");
+    expect(plan->count == count && frequency_sweep_get_frame_points() == 0
+           && frequency_sweep_status() == SWEEP_RUNNING, "sin cambios y el barrido sigue");
+
+    send("{\"cmd\":\"stop\"}");
+    command_poll();
+    drain(&d);
+    expect(frequency_sweep_status() == SWEEP_ABORTED && !adc_dma_is_busy() && d.aborted,
+           "stop corta el barrido (sweep_aborted)");
+    expect(d.acks == 1 && strcmp(d.ack[0], "{\"status\":\"ack\",\"cmd\":\"stop\",\"ok\":true}") == 0
+           && !command_sweeps_enabled(), "confirma y detiene los barridos periódicos");
+    expect(sweep_store_pending() == 0, "el barrido cortado no va a la flash");
+
+    roundtrip("{\"cmd\":\"start\"}", "{\"status\":\"ack\",\"cmd\":\"start\",\"ok\":true}",
+              "start después de stop");
+    expect(command_sweeps_enabled() && command_take_start(), "vuelven los barridos");
+}
+
+static void check_inbox(void) {
+    static drained_t d;
+    printf("Bandeja\n");
+
+    command_stats_t before;
+    command_get_stats(&before);
+
+    bool accepted = true;
+    for (int i = 0; i < COMMAND_QUEUE_SLOTS; i++) {
+        accepted &= send("{\"cmd\":\"rate\",\"interval_ms\":10000}");
+    }
+    expect(accepted && !send("{\"cmd\":\"start\"}"), "con la bandeja llena descarta");
+    expect(command_poll() == COMMAND_QUEUE_SLOTS, "procesa los que entraron");
+    drain(&d);
+
+    static char big[COMMAND_PAYLOAD_MAX + 16];
+    memset(big, ' ', sizeof(big));
+    memcpy(big, "{\"cmd\":\"start\"}", 15);
+    mqtt_client_incoming(MQTT_TOPIC_COMMAND, (const uint8_t *)big, sizeof(big));
+    command_poll();
+    drain(&d);
+    expect(d.acks == 1 && strcmp(d.ack[0], "{\"status\":\"ack\",\"ok\":false,\"error\":\"parse\"}") == 0,
+           "payload demasiado largo: error de parseo");
+
+    expect(!mqtt_client_incoming(MQTT_TOPIC_STATUS, (const uint8_t *)"{}", 2) && command_poll() == 0,
+           "otros topics no llegan a la bandeja");
+
+    command_stats_t after;
+    command_get_stats(&after);
+    expect(after.received - before.received == COMMAND_QUEUE_SLOTS + 1
+           && after.dropped - before.dropped == 1 && after.executed - before.executed == COMMAND_QUEUE_SLOTS
+           && after.rejected - before.rejected == 1, "estadísticas");
+}
+
+static uint32_t rng_state = 2463534242u;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void check_fuzz(void) {
+    static const char *const seeds[] = {
+        "{\"cmd\":\"profile\",\"id\":12,\"grid\":\"log\",\"start\":20,\"stop\":2000,\"points\":50,"
+        "\"averages\":2,\"window\":960,\"snr\":40,\"max_windows\":4,\"stderr_db\":0.05}",
+        "{\"cmd\":\"profile\",\"list\":[100,200.5,3e3,4E+2]}",
+        "{\"cmd\":\"point\",\"freq\":1000.25}",
+        "{\"cmd\":\"rate\",\"interval_ms\":500,\"frame_points\":20}",
+        "{\"cmd\":\"stop\",\"id\":3}",
+        "{\"cmd\":\"monitor\",\"freq\":1e3,\"window\":4,\"hop\":2,\"batch\":10}",
+    };
+    static const char alphabet[] = "{}[]\",:0123456789.eE+-\\ cmdstartpoinlg";
+    static command_t cmd;
+    char buf[256];
+    uint32_t accepted = 0;
+    uint32_t out_of_range = 0;
+
+    printf("%d comandos mutados\n", FUZZ_COMMANDS);
+    for (uint32_t n = 0; n < FUZZ_COMMANDS; n++) {
+        const char *seed = seeds[rng_next() % (sizeof(seeds) / sizeof(seeds[0]))];
+        size_t len = strlen(seed);
+        memcpy(buf, seed, len);
+
+        uint32_t mutations = 1 + rng_next() % FUZZ_MUTATIONS;
+        for (uint32_t m = 0; m < mutations && len > 0; m++) {
+            size_t at = rng_next() % len;
+            switch (rng_next() % 3) {
+                case 0:
+                    buf[at] = alphabet[rng_next() % (sizeof(alphabet) - 1)];
+                    break;
+                case 1:
+                    memmove(&buf[at], &buf[at + 1], len - at - 1);
+                    len--;
+                    break;
+                default:
+                    len = at;
+                    break;
+            }
+        }
+
+        // Copia exacta: con FRA_HOST_SANITIZE=address, leer de más aborta
+        char *copy = malloc(len > 0 ? len : 1);
+        memcpy(copy, buf, len);
+        if (command_parse(copy, len, &cmd) == COMMAND_OK) {
+            accepted++;
+            const sweep_plan_spec_t *spec = &cmd.spec;
+            bool in_range = true;
+            if (cmd.type == COMMAND_PROFILE) {
+                in_range = spec->points >= 1 && spec->points <= SWEEP_NUM_POINTS
+                    && spec->averages >= 1 && spec->max_window <= ADC_CAPTURE_MAX_SAMPLES
+                    && spec->average.max_windows >= 1
+                    && (spec->grid == SWEEP_GRID_LIST ? spec->list_hz != NULL
+                                                      : spec->stop_hz > spec->start_hz);
+            } else if (cmd.type == COMMAND_POINT) {
+                in_range = cmd.freq_hz > 0.0f && cmd.freq_hz < SAMPLE_RATE / 2.0f;
+            } else if (cmd.type == COMMAND_RATE) {
+                in_range = cmd.frame_points <= SWEEP_NUM_POINTS
+                    && cmd.interval_ms <= COMMAND_INTERVAL_MAX_MS;
+            } else if (cmd.type == COMMAND_MONITOR) {
+                in_range = monitor_check_spec(&cmd.monitor, NULL);
+            }
+            out_of_range += !in_range;
+        }
+        free(copy);
+    }
+
+    printf("  %lu aceptados\n", (unsigned long)accepted);
+    expect(out_of_range == 0, "todo lo aceptado está dentro de rango");
+}
+
+int main(void) {
+    mqtt_config_t mqtt_cfg = {
+        .broker_addr = MQTT_BROKER_ADDR,
+        .broker_port = MQTT_BROKER_PORT,
+        .client_id = MQTT_CLIENT_ID,
+        .topic = MQTT_TOPIC_MEASUREMENTS
+    };
+    command_init();
+    if (!hal_host_flash_open(NULL) || !adc_dma_init() || !ad9833_init() || !mqtt_init(&mqtt_cfg)
+        || !sweep_store_init() || !frequency_sweep_init()) {
+        fprintf(stderr, "[FATAL] Fallo en inicialización de módulos\n");
+        return EXIT_FAILURE;
+    }
+
+    sim_dut_config_t dut;
+    sim_dut_default_config(&dut);
+    sim_dut_configure(&dut);
+
+    check_parse();
+    check_profile();
+    check_point_and_rate();
+    check_busy_and_stop();
+    check_inbox();
+    check_fuzz();
+
+    printf("\n%s (%d fallas)\n", failures ? "FALLA" : "OK", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
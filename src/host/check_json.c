@@ -0,0 +1,828 @@
+/**
+ * @file check_json.c
+ * @brief Verificación del serializador y del lector JSON (fra_check_json)
+ *
+ * Pasa la salida de json_writer por un parser JSON estricto (gramática
+ * RFC 8259 completa, sin extensiones) y comprueba:
+ * - payloads exactos para casos conocidos (formato, -0, acarreo, null);
+ * - ida y vuelta de mediciones pseudoaleatorias, incluyendo extremos,
+ *   empates de redondeo y no finitos, con error ≤ media unidad del último
+ *   decimal;
+ * - arreglos de puntos con buffers de tamaño aleatorio: o el payload es
+ *   JSON válido y completo, o finish retorna 0, y nunca se escribe fuera
+ *   del buffer;
+ * - strings de estado con bytes arbitrarios que vuelven idénticos;
+ * - json_reader: casos conocidos (gramática, rangos, escapes, \\u con
+ *   pares sustitutos, anidamiento, buffers justos), los números de
+ *   json_writer leídos de vuelta, y documentos generados y mutados al
+ *   azar que el lector acepta si y solo si los acepta el parser de
+ *   referencia, leyendo siempre desde una copia exacta en el heap (con
+ *   FRA_HOST_SANITIZE=address, cualquier lectura fuera del payload
+ *   aborta).
+ * Retorna distinto de cero ante cualquier discrepancia.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "json_reader.h"
+#include "json_writer.h"
+#include "check.h"
+
+#define FUZZ_MEASUREMENTS 200000
+#define FUZZ_ARRAYS 20000
+#define FUZZ_STATUS 50000
+#define FUZZ_MAX_POINTS 40
+#define FUZZ_MAX_STATUS 48
+#define FUZZ_READER_DOCS 100000
+#define FUZZ_READER_MUTATIONS 4
+#define FUZZ_READER_DEPTH 3
+#define FUZZ_READER_DOC_MAX 768
+
+#define PARSE_MAX_EVENTS 512
+#define PARSE_POOL_SIZE 4096
+#define PARSE_MAX_DEPTH 8
+
+// Bytes centinela detrás del buffer del escritor
+#define CANARY_SIZE 16
+#define CANARY_BYTE 0x5A
+
+typedef enum {
+    EV_OBJ_BEGIN, EV_OBJ_END, EV_ARR_BEGIN, EV_ARR_END,
+    EV_KEY, EV_STRING, EV_NUMBER, EV_NULL, EV_BOOL
+} event_kind_t;
+
+typedef struct {
+    event_kind_t kind;
+    double number;
+    const char *text;   // KEY/STRING: decodificado, dentro del pool
+} event_t;
+
+typedef struct {
+    const char *p;
+    const char *end;
+    event_t events[PARSE_MAX_EVENTS];
+    int count;
+    char pool[PARSE_POOL_SIZE];
+    size_t pool_len;
+    int depth;
+} parser_t;
+
+// ============================================================================
+// PARSER JSON ESTRICTO
+// ============================================================================
+
+static bool parse_value(parser_t *ps);
+
+static void skip_ws(parser_t *ps) {
+    while (ps->p < ps->end && (*ps->p == ' ' || *ps->p == '\t' || *ps->p == '\n' || *ps->p == '\r')) {
+        ps->p++;
+    }
+}
+
+static bool emit(parser_t *ps, event_kind_t kind, double number, const char *text) {
+    if (ps->count >= PARSE_MAX_EVENTS) {
+        return false;
+    }
+    ps->events[ps->count++] = (event_t){ kind, number, text };
+    return true;
+}
+
+static bool pool_put(parser_t *ps, char c) {
+    if (ps->pool_len >= PARSE_POOL_SIZE) {
+        return false;
+    }
+    ps->pool[ps->pool_len++] = c;
+    return true;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief String JSON; los \u fuera de ASCII se codifican en UTF-8
+ */
+static bool parse_string(parser_t *ps, event_kind_t kind) {
+    if (ps->p >= ps->end || *ps->p != '"') {
+        return false;
+    }
+    ps->p++;
+    const char *text = &ps->pool[ps->pool_len];
+
+    while (true) {
+        if (ps->p >= ps->end) {
+            return false;
+        }
+        unsigned char c = (unsigned char)*ps->p++;
+        if (c == '"') {
+            break;
+        }
+        if (c < 0x20) {
+            return false;
+        }
+        if (c != '\\') {
+            if (!pool_put(ps, (char)c)) return false;
+            continue;
+        }
+        if (ps->p >= ps->end) {
+            return false;
+        }
+        char e = *ps->p++;
+        char out;
+        switch (e) {
+            case '"': out = '"'; break;
+            case '\\': out = '\\'; break;
+            case '/': out = '/'; break;
+            case 'b': out = '\b'; break;
+            case 'f': out = '\f'; break;
+            case 'n': out = '\n'; break;
+            case 'r': out = '\r'; break;
+            case 't': out = '\t'; break;
+            case 'u': {
+                if (ps->end - ps->p < 4) return false;
+                int code = 0;
+                for (int i = 0; i < 4; i++) {
+                    int h = hex_value(ps->p[i]);
+                    if (h < 0) return false;
+                    code = code * 16 + h;
+                }
+                ps->p += 4;
+                if (code < 0x80) {
+                    out = (char)code;
+                } else if (code < 0x800) {
+                    if (!pool_put(ps, (char)(0xC0 | (code >> 6)))) return false;
+                    out = (char)(0x80 | (code & 0x3F));
+                } else {
+                    if (!pool_put(ps, (char)(0xE0 | (code >> 12)))) return false;
+                    if (!pool_put(ps, (char)(0x80 | ((code >> 6) & 0x3F)))) return false;
+                    out = (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default:
+                return false;
+        }
+        if (!pool_put(ps, out)) return false;
+    }
+
+    return pool_put(ps, '\0') && emit(ps, kind, 0.0, text);
+}
+
+/**
+ * @brief Número JSON: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+ */
+static bool parse_number(parser_t *ps) {
+    const char *start = ps->p;
+    const char *q = ps->p;
+
+    if (q < ps->end && *q == '-') q++;
+    if (q >= ps->end) return false;
+    if (*q == '0') {
+        q++;
+    } else if (*q >= '1' && *q <= '9') {
+        while (q < ps->end && *q >= '0' && *q <= '9') q++;
+    } else {
+        return false;
+    }
+    if (q < ps->end && *q == '.') {
+        q++;
+        if (q >= ps->end || *q < '0' || *q > '9') return false;
+        while (q < ps->end && *q >= '0' && *q <= '9') q++;
+    }
+    if (q < ps->end && (*q == 'e' || *q == 'E')) {
+        q++;
+        if (q < ps->end && (*q == '+' || *q == '-')) q++;
+        if (q >= ps->end || *q < '0' || *q > '9') return false;
+        while (q < ps->end && *q >= '0' && *q <= '9') q++;
+    }
+
+    char tmp[64];
+    size_t n = (size_t)(q - start);
+    if (n >= sizeof(tmp)) return false;
+    memcpy(tmp, start, n);
+    tmp[n] = '\0';
+    ps->p = q;
+    return emit(ps, EV_NUMBER, strtod(tmp, NULL), NULL);
+}
+
+static bool parse_literal(parser_t *ps, const char *lit, event_kind_t kind) {
+    size_t n = strlen(lit);
+    if ((size_t)(ps->end - ps->p) < n || memcmp(ps->p, lit, n) != 0) {
+        return false;
+    }
+    ps->p += n;
+    return emit(ps, kind, 0.0, NULL);
+}
+
+static bool parse_container(parser_t *ps, bool object) {
+    if (++ps->depth > PARSE_MAX_DEPTH) {
+        return false;
+    }
+    ps->p++;
+    if (!emit(ps, object ? EV_OBJ_BEGIN : EV_ARR_BEGIN, 0.0, NULL)) return false;
+
+    char close = object ? '}' : ']';
+    skip_ws(ps);
+    if (ps->p < ps->end && *ps->p == close) {
+        ps->p++;
+    } else {
+        while (true) {
+            skip_ws(ps);
+            if (object) {
+                if (!parse_string(ps, EV_KEY)) return false;
+                skip_ws(ps);
+                if (ps->p >= ps->end || *ps->p++ != ':') return false;
+            }
+            if (!parse_value(ps)) return false;
+            skip_ws(ps);
+            if (ps->p >= ps->end) return false;
+            char c = *ps->p++;
+            if (c == close) break;
+            if (c != ',') return false;
+        }
+    }
+
+    ps->depth--;
+    return emit(ps, object ? EV_OBJ_END : EV_ARR_END, 0.0, NULL);
+}
+
+static bool parse_value(parser_t *ps) {
+    skip_ws(ps);
+    if (ps->p >= ps->end) {
+        return false;
+    }
+    switch (*ps->p) {
+        case '{': return parse_container(ps, true);
+        case '[': return parse_container(ps, false);
+        case '"': return parse_string(ps, EV_STRING);
+        case 'n': return parse_literal(ps, "null", EV_NULL);
+        case 't': return parse_literal(ps, "true", EV_BOOL);
+        case 'f': return parse_literal(ps, "false", EV_BOOL);
+        default: return parse_number(ps);
+    }
+}
+
+/**
+ * @brief Parsea un documento completo (sin basura al final)
+ */
+static bool parse_document(parser_t *ps, const char *text, size_t len) {
+    ps->p = text;
+    ps->end = text + len;
+    ps->count = 0;
+    ps->pool_len = 0;
+    ps->depth = 0;
+    if (!parse_value(ps)) {
+        return false;
+    }
+    skip_ws(ps);
+    return ps->p == ps->end;
+}
+
+// ============================================================================
+// GENERADORES Y VERIFICACIONES
+// ============================================================================
+
+static uint32_t rng_state = 2463534242u;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static float rng_uniform(float lo, float hi) {
+    return lo + (hi - lo) * (float)(rng_next() >> 8) / 16777216.0f;
+}
+
+/**
+ * @brief Valor de prueba: rangos del esquema, extremos, empates y no finitos
+ */
+static float fuzz_value(uint8_t decimals) {
+    switch (rng_next() % 10) {
+        case 0: {
+            // Empate de redondeo en el último decimal
+            float step = 1.0f;
+            for (uint8_t i = 0; i < decimals; i++) step /= 10.0f;
+            return ((float)(int32_t)(rng_next() % 20001) - 10000.0f) * step + step / 2.0f;
+        }
+        case 1: {
+            uint32_t bits = rng_next();
+            float v;
+            memcpy(&v, &bits, sizeof(v));
+            return v;   // Cualquier patrón: NaN, infinitos, subnormales, enormes
+        }
+        case 2:
+            return (rng_next() & 1) ? -0.0f : 0.0f;
+        case 3:
+            return rng_uniform(-1e-3f, 1e-3f);
+        case 4:
+            return rng_uniform(-5e9f, 5e9f);
+        default:
+            return rng_uniform(-20000.0f, 20000.0f);
+    }
+}
+
+/**
+ * @brief El número parseado representa value con decimals cifras
+ */
+static bool number_matches(const event_t *ev, float value, uint8_t decimals) {
+    bool representable = isfinite(value) && fabsf(value) < 4294967296.0f;
+    if (!representable) {
+        return ev->kind == EV_NULL;
+    }
+    if (ev->kind != EV_NUMBER) {
+        return false;
+    }
+    double half_ulp = 0.5 * pow(10.0, -decimals);
+    double tol = half_ulp * (1.0 + 1e-6) + fabs((double)value) * 1.2e-7 + 1e-12;
+    return fabs(ev->number - (double)value) <= tol;
+}
+
+static bool check_point_events(const event_t *ev, const json_point_t *pt) {
+    return ev[0].kind == EV_OBJ_BEGIN
+        && ev[1].kind == EV_KEY && strcmp(ev[1].text, "freq") == 0
+        && number_matches(&ev[2], pt->frequency_hz, JSON_FREQ_DECIMALS)
+        && ev[3].kind == EV_KEY && strcmp(ev[3].text, "mag") == 0
+        && number_matches(&ev[4], pt->magnitude_db, JSON_MAG_DECIMALS)
+        && ev[5].kind == EV_KEY && strcmp(ev[5].text, "phase") == 0
+        && number_matches(&ev[6], pt->phase_deg, JSON_PHASE_DECIMALS)
+        && ev[7].kind == EV_OBJ_END;
+}
+
+static void check_known(void) {
+    char buf[128];
+    json_writer_t w;
+
+    printf("Payloads conocidos\n");
+    json_point_t pt = { 1000.0f, -3.45f, -87.3f };
+    json_format_measurement(buf, sizeof(buf), &pt);
+    expect(strcmp(buf, "{\"freq\":1000.0,\"mag\":-3.45,\"phase\":-87.3}") == 0,
+           "mismo formato que el snprintf anterior");
+
+    json_writer_init(&w, buf, sizeof(buf));
+    json_writer_begin_array(&w);
+    json_writer_fixed(&w, -0.04f, 1);
+    json_writer_fixed(&w, 0.999f, 2);
+    json_writer_fixed(&w, 9.96f, 1);
+    json_writer_fixed(&w, NAN, 2);
+    json_writer_fixed(&w, -INFINITY, 2);
+    json_writer_fixed(&w, 12.5f, 0);
+    json_writer_uint(&w, 4294967295u);
+    json_writer_end_array(&w);
+    json_writer_finish(&w);
+    expect(strcmp(buf, "[0.0,1.00,10.0,null,null,13,4294967295]") == 0,
+           "-0 sin signo, acarreo a la parte entera, no finitos como null");
+
+    json_format_status(buf, sizeof(buf), "a\"b\\c\nd\x01");
+    expect(strcmp(buf, "{\"status\":\"a\\\"b\\\\c\\nd\\u0001\"}") == 0, "escapes de string");
+
+    expect(json_format_measurement(buf, 10, &pt) == 0 && buf[0] == '\0',
+           "buffer chico: finish retorna 0 y deja string vacío");
+}
+
+static void check_measurements(void) {
+    static parser_t ps;
+    char buf[128];
+    uint32_t invalid = 0;
+    uint32_t mismatch = 0;
+
+    printf("Ida y vuelta de %d mediciones pseudoaleatorias\n", FUZZ_MEASUREMENTS);
+    for (uint32_t n = 0; n < FUZZ_MEASUREMENTS; n++) {
+        json_point_t pt = {
+            fuzz_value(JSON_FREQ_DECIMALS),
+            fuzz_value(JSON_MAG_DECIMALS),
+            fuzz_value(JSON_PHASE_DECIMALS)
+        };
+        size_t len = json_format_measurement(buf, sizeof(buf), &pt);
+        if (len == 0 || !parse_document(&ps, buf, len) || ps.count != 8) {
+            invalid++;
+            continue;
+        }
+        if (!check_point_events(ps.events, &pt)) {
+            if (mismatch == 0) {
+                printf("  primer desvío: %s (%.9g, %.9g, %.9g)\n", buf,
+                       pt.frequency_hz, pt.magnitude_db, pt.phase_deg);
+            }
+            mismatch++;
+        }
+    }
+
+    expect(invalid == 0, "todo payload es JSON válido");
+    expect(mismatch == 0, "valores dentro de media unidad del último decimal");
+}
+
+static void check_arrays(void) {
+    static parser_t ps;
+    static json_point_t points[FUZZ_MAX_POINTS];
+    static char full[FUZZ_MAX_POINTS * 64 + 8];
+    static char buf[FUZZ_MAX_POINTS * 64 + 8 + CANARY_SIZE];
+    uint32_t invalid = 0;
+    uint32_t truncated_ok = 0;
+    uint32_t wrong_truncation = 0;
+    uint32_t overruns = 0;
+
+    printf("Arreglos de puntos con %d buffers de tamaño aleatorio\n", FUZZ_ARRAYS);
+    for (uint32_t n = 0; n < FUZZ_ARRAYS; n++) {
+        uint16_t count = (uint16_t)(rng_next() % (FUZZ_MAX_POINTS + 1));
+        for (uint16_t i = 0; i < count; i++) {
+            points[i] = (json_point_t){ fuzz_value(1), fuzz_value(2), fuzz_value(1) };
+        }
+        size_t needed = json_format_points(full, sizeof(full), points, count);
+
+        // Mitad con lugar de sobra, mitad con buffers que pueden quedar cortos
+        size_t capacity = (rng_next() & 1) ? needed + 1 + rng_next() % 8
+                                           : rng_next() % (needed + 2);
+        memset(buf, CANARY_BYTE, sizeof(buf));
+        size_t len = json_format_points(buf, capacity, points, count);
+
+        for (size_t i = capacity; i < capacity + CANARY_SIZE; i++) {
+            if ((unsigned char)buf[i] != CANARY_BYTE) {
+                overruns++;
+                break;
+            }
+        }
+
+        if (len == 0) {
+            // Solo vale truncar si de verdad no entraba (payload + '\0')
+            if (capacity > needed) {
+                wrong_truncation++;
+            } else {
+                truncated_ok++;
+            }
+            continue;
+        }
+
+        bool ok = len == needed && parse_document(&ps, buf, len)
+               && ps.count == 2 + 8 * count
+               && ps.events[0].kind == EV_ARR_BEGIN && ps.events[ps.count - 1].kind == EV_ARR_END;
+        for (uint16_t i = 0; ok && i < count; i++) {
+            ok = check_point_events(&ps.events[1 + 8 * i], &points[i]);
+        }
+        if (!ok) {
+            invalid++;
+        }
+    }
+
+    printf("  %lu truncados por buffer chico\n", (unsigned long)truncated_ok);
+    expect(overruns == 0, "nunca escribe fuera del buffer");
+    expect(wrong_truncation == 0, "solo trunca cuando el payload no entra");
+    expect(invalid == 0, "los payloads completos son JSON válido con todos los puntos");
+}
+
+static void check_status(void) {
+    static parser_t ps;
+    char status[FUZZ_MAX_STATUS + 1];
+    char buf[FUZZ_MAX_STATUS * 6 + 32];
+    uint32_t invalid = 0;
+
+    printf("Strings de estado con %d contenidos arbitrarios\n", FUZZ_STATUS);
+    for (uint32_t n = 0; n < FUZZ_STATUS; n++) {
+        size_t len = rng_next() % (FUZZ_MAX_STATUS + 1);
+        for (size_t i = 0; i < len; i++) {
+            status[i] = (char)(1 + rng_next() % 255);
+        }
+        status[len] = '\0';
+
+        size_t out = json_format_status(buf, sizeof(buf), status);
+        bool ok = out > 0 && parse_document(&ps, buf, out) && ps.count == 4
+               && ps.events[1].kind == EV_KEY && strcmp(ps.events[1].text, "status") == 0
+               && ps.events[2].kind == EV_STRING && strcmp(ps.events[2].text, status) == 0;
+        if (!ok) {
+            invalid++;
+        }
+    }
+
+    expect(invalid == 0, "el string vuelve idéntico byte a byte");
+}
+
+// ============================================================================
+// LECTOR (json_reader.h)
+// ============================================================================
+
+/**
+ * @brief Documento completo aceptado por json_reader, leído desde una
+ *        copia del tamaño justo
+ */
+static bool reader_accepts(const char *text, size_t len) {
+    char *copy = malloc(len > 0 ? len : 1);
+    memcpy(copy, text, len);
+
+    json_reader_t r;
+    json_reader_init(&r, copy, len);
+    bool ok = json_reader_skip(&r) && json_reader_end(&r);
+    free(copy);
+    return ok;
+}
+
+static bool reader_float(const char *text, float *value) {
+    json_reader_t r;
+    json_reader_init(&r, text, strlen(text));
+    return json_reader_float(&r, value) && json_reader_end(&r);
+}
+
+static bool reader_uint(const char *text, uint32_t *value) {
+    json_reader_t r;
+    json_reader_init(&r, text, strlen(text));
+    return json_reader_uint(&r, value) && json_reader_end(&r);
+}
+
+static bool reader_string(const char *text, char *out, size_t capacity) {
+    json_reader_t r;
+    json_reader_init(&r, text, strlen(text));
+    return json_reader_string(&r, out, capacity) && json_reader_end(&r);
+}
+
+/**
+ * @brief value a lo sumo a un ulp de float de expected
+ */
+static bool float_near(float value, double expected) {
+    return fabs((double)value - expected) <= fabs(expected) * 1.2e-7 + 1e-38;
+}
+
+static void check_reader_known(void) {
+    static const struct {
+        const char *text;
+        bool valid;
+    } docs[] = {
+        { "{}", true },
+        { "[]", true },
+        { " {\"a\" : [1, -0.5e+3, 0, 1E-2, true, false, null, \"x\"]}\r\n", true },
+        { "{\"a\":{\"b\":[{},[]]},\"c\":\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"}", true },
+        { "[[[[[[[[1]]]]]]]]", true },
+        { "[[[[[[[[[1]]]]]]]]]", false },
+        { "\"\\uD83D\\uDE00\"", true },
+        { "\"\\uDE00\"", false },
+        { "\"\\uD83Dx\"", false },
+        { "{\"a\":1,}", false },
+        { "[1,]", false },
+        { "[,1]", false },
+        { "{\"a\" 1}", false },
+        { "{\"a\":1 \"b\":2}", false },
+        { "{1:2}", false },
+        { "[1 2]", false },
+        { "01", false },
+        { "-01", false },
+        { "1.", false },
+        { ".5", false },
+        { "-", false },
+        { "+1", false },
+        { "1e", false },
+        { "1e+", false },
+        { "NaN", false },
+        { "Infinity", false },
+        { "tru", false },
+        { "nul", false },
+        { "\"\\x\"", false },
+        { "\"a\nb\"", false },
+        { "\"abc", false },
+        { "{\"a\":1}x", false },
+        { "{\"a\":1}{}", false },
+        { "", false },
+        { "  ", false },
+        { "{", false },
+        { "]", false },
+    };
+    uint32_t wrong = 0;
+
+    printf("Lector: casos conocidos\n");
+    for (size_t i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+        if (reader_accepts(docs[i].text, strlen(docs[i].text)) != docs[i].valid) {
+            printf("  mal clasificado: %s\n", docs[i].text);
+            wrong++;
+        }
+    }
+    expect(wrong == 0, "gramática estricta y anidamiento hasta JSON_READER_MAX_DEPTH");
+
+    float f;
+    uint32_t u;
+    expect(reader_float("1.5e3", &f) && f == 1500.0f && reader_float("0.1", &f) && f == 0.1f
+           && reader_float("-0.000125", &f) && float_near(f, -0.000125)
+           && reader_float("123456789012345678901234", &f) && float_near(f, 1.23456789012345678e23)
+           && reader_float("0.0000000000000000000000000000000000001", &f) && float_near(f, 1e-37)
+           && reader_float("3.4e38", &f) && float_near(f, 3.4e38),
+           "floats, incluidas mantisas largas y exponentes extremos");
+    expect(!reader_float("3.5e38", &f) && !reader_float("1e999", &f) && !reader_float("\"1\"", &f),
+           "floats fuera de rango o de otro tipo");
+    expect(reader_uint("4294967295", &u) && u == UINT32_MAX && reader_uint("0", &u) && u == 0
+           && !reader_uint("4294967296", &u) && !reader_uint("99999999999999999999", &u)
+           && !reader_uint("-1", &u) && !reader_uint("1.0", &u) && !reader_uint("1e2", &u),
+           "enteros sin signo dentro de 32 bits");
+
+    char out[16];
+    expect(reader_string("\"caf\\u00e9 \\uD83D\\uDE00\"", out, sizeof(out))
+           && strcmp(out, "caf\xc3\xa9 \xf0\x9f\x98\x80") == 0, "\\u a UTF-8, con par sustituto");
+    expect(reader_string("\"abc\"", out, 4) && strcmp(out, "abc") == 0
+           && !reader_string("\"abcd\"", out, 4), "string justo en el buffer, y uno más largo");
+
+    // Recorrido con claves y elementos
+    const char *text = "{\"cmd\":\"x\",\"n\":[1,2,3],\"deep\":{\"a\":[{}]},\"ok\":true}";
+    json_reader_t r;
+    char key[8];
+    uint32_t sum = 0;
+    bool ok = false;
+    bool ordered = true;
+    json_reader_init(&r, text, strlen(text));
+    json_reader_begin_object(&r);
+    while (json_reader_next_key(&r, key, sizeof(key))) {
+        if (strcmp(key, "n") == 0) {
+            json_reader_begin_array(&r);
+            while (json_reader_next_element(&r)) {
+                json_reader_uint(&r, &u);
+                sum += u;
+            }
+        } else if (strcmp(key, "ok") == 0) {
+            json_reader_bool(&r, &ok);
+        } else {
+            ordered &= json_reader_skip(&r);
+        }
+    }
+    expect(json_reader_end(&r) && sum == 6 && ok && ordered, "claves, arreglo y valores salteados");
+
+    json_reader_init(&r, text, strlen(text));
+    json_reader_begin_object(&r);
+    expect(!json_reader_next_key(&r, key, 3) && !json_reader_end(&r), "clave más larga que el buffer");
+}
+
+static void check_reader_numbers(void) {
+    static parser_t ps;
+    char buf[128];
+    uint32_t wrong = 0;
+
+    printf("Lector: %d mediciones de json_writer leídas de vuelta\n", FUZZ_MEASUREMENTS);
+    for (uint32_t n = 0; n < FUZZ_MEASUREMENTS; n++) {
+        json_point_t pt = {
+            fuzz_value(JSON_FREQ_DECIMALS),
+            fuzz_value(JSON_MAG_DECIMALS),
+            fuzz_value(JSON_PHASE_DECIMALS)
+        };
+        size_t len = json_format_measurement(buf, sizeof(buf), &pt);
+        if (len == 0 || !parse_document(&ps, buf, len)) {
+            wrong++;
+            continue;
+        }
+
+        // Los null (no finitos) no son números: el lector los rechaza
+        json_reader_t r;
+        char key[8];
+        int value = 0;
+        bool ok = true;
+        json_reader_init(&r, buf, len);
+        json_reader_begin_object(&r);
+        while (ok && json_reader_next_key(&r, key, sizeof(key))) {
+            const event_t *ev = &ps.events[2 + 2 * value++];
+            if (ev->kind == EV_NULL) {
+                ok = json_reader_skip(&r);
+            } else {
+                float f;
+                ok = json_reader_float(&r, &f) && float_near(f, ev->number);
+            }
+        }
+        if (!ok || value != 3 || !json_reader_end(&r)) {
+            if (wrong == 0) {
+                printf("  primer desvío: %s\n", buf);
+            }
+            wrong++;
+        }
+    }
+    expect(wrong == 0, "mismo valor que el parser de referencia, a un ulp de float");
+}
+
+/**
+ * @brief Valor JSON al azar escrito con json_writer
+ */
+static void fuzz_doc_value(json_writer_t *w, int depth) {
+    char text[12];
+    uint32_t kinds = depth < FUZZ_READER_DEPTH ? 6 : 4;
+
+    switch (rng_next() % kinds) {
+        case 0:
+            json_writer_fixed(w, rng_uniform(-1e5f, 1e5f), (uint8_t)(rng_next() % 4));
+            break;
+        case 1:
+            json_writer_uint(w, rng_next() >> (rng_next() % 32));
+            break;
+        case 2:
+            json_writer_bool(w, rng_next() & 1);
+            break;
+        case 3: {
+            size_t len = rng_next() % sizeof(text);
+            for (size_t i = 0; i < len; i++) {
+                text[i] = (char)(1 + rng_next() % 127);
+            }
+            text[len] = '\0';
+            json_writer_string(w, text);
+            break;
+        }
+        case 4: {
+            uint32_t count = rng_next() % 5;
+            json_writer_begin_array(w);
+            for (uint32_t i = 0; i < count; i++) {
+                fuzz_doc_value(w, depth + 1);
+            }
+            json_writer_end_array(w);
+            break;
+        }
+        default: {
+            uint32_t count = rng_next() % 5;
+            json_writer_begin_object(w);
+            for (uint32_t i = 0; i < count; i++) {
+                snprintf(text, sizeof(text), "k%lu", (unsigned long)(rng_next() % 100));
+                json_writer_key(w, text);
+                fuzz_doc_value(w, depth + 1);
+            }
+            json_writer_end_object(w);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Cambia, borra, inserta o corta bytes del documento
+ *
+ * Sin 'd'/'D': un \u mutado nunca cae en un sustituto, que el parser de
+ * referencia no valida.
+ */
+static size_t fuzz_doc_mutate(char *doc, size_t len, size_t capacity) {
+    static const char alphabet[] = "{}[]\",:0123456789.eE+-truefalsn\\ \n\t";
+    uint32_t mutations = 1 + rng_next() % FUZZ_READER_MUTATIONS;
+
+    for (uint32_t m = 0; m < mutations && len > 0; m++) {
+        size_t at = rng_next() % len;
+        char c = alphabet[rng_next() % (sizeof(alphabet) - 1)];
+        switch (rng_next() % 4) {
+            case 0:
+                doc[at] = c;
+                break;
+            case 1:
+                memmove(&doc[at], &doc[at + 1], len - at - 1);
+                len--;
+                break;
+            case 2:
+                if (len < capacity) {
+                    memmove(&doc[at + 1], &doc[at], len - at);
+                    doc[at] = c;
+                    len++;
+                }
+                break;
+            default:
+                len = at;
+                break;
+        }
+    }
+    return len;
+}
+
+static void check_reader_fuzz(void) {
+    static parser_t ps;
+    static char doc[FUZZ_READER_DOC_MAX];
+    uint32_t valid = 0;
+    uint32_t mismatch = 0;
+
+    printf("Lector: %d documentos al azar, mutados o no\n", FUZZ_READER_DOCS);
+    for (uint32_t n = 0; n < FUZZ_READER_DOCS; n++) {
+        json_writer_t w;
+        json_writer_init(&w, doc, sizeof(doc));
+        fuzz_doc_value(&w, 0);
+        size_t len = json_writer_finish(&w);
+        if (len == 0) {
+            continue;
+        }
+        if (rng_next() % 4 != 0) {
+            len = fuzz_doc_mutate(doc, len, sizeof(doc));
+        }
+
+        bool expected = parse_document(&ps, doc, len);
+        if (reader_accepts(doc, len) != expected) {
+            if (mismatch == 0) {
+                printf("  primer desacuerdo (referencia: %s): %.*s\n",
+                       expected ? "válido" : "inválido", (int)len, doc);
+            }
+            mismatch++;
+        }
+        valid += expected;
+    }
+
+    printf("  %lu válidos, %lu inválidos\n", (unsigned long)valid,
+           (unsigned long)(FUZZ_READER_DOCS - valid));
+    expect(mismatch == 0, "acepta exactamente lo que acepta el parser de referencia");
+}
+
+int main(void) {
+    check_known();
+    check_measurements();
+    check_arrays();
+    check_status();
+    check_reader_known();
+    check_reader_numbers();
+    check_reader_fuzz();
+
+    printf("\n%s (%d fallas)\n", failures ? "FALLA" : "OK", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,457 @@
+/**
+ * @file check_monitor.c
+ * @brief Verificación del modo monitor (fra_check_monitor)
+ *
+ * Corre sobre la captura continua del simulador (el hilo DMA, acelerado)
+ * con un RC pasabajos y la cola de publicación drenada a mano. Comprueba:
+ * - monitor_check_spec(): rangos y corrección al tono coherente;
+ * - que el mensaje más largo entre en MONITOR_JSON_MAX y se lea de vuelta;
+ * - de punta a punta, "monitor" por MQTT_TOPIC_COMMAND: la confirmación con
+ *   la frecuencia coherente, magnitud y fase contra la H teórica, "block"
+ *   sin saltos entre actualizaciones ni entre mensajes y exactamente una
+ *   actualización cada hop bloques después del asentamiento, sin overrun;
+ * - ventanas contiguas (hop = window) en un tono que no es coherente con
+ *   un bloque solo;
+ * - una deriva del corte a mitad de la captura: las ventanas anteriores
+ *   miden el DUT viejo, las posteriores el nuevo y la transición dura lo
+ *   que la ventana;
+ * - que con el monitor activo "point" y "start" se confirmen "busy" y que
+ *   "stop" lo detenga.
+ * Retorna distinto de cero ante cualquier discrepancia.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "ad9833.h"
+#include "adc_dma.h"
+#include "command.h"
+#include "hal_host.h"
+#include "json_reader.h"
+#include "monitor.h"
+#include "mqtt_client.h"
+#include "publish_queue.h"
+#include "sim_dut.h"
+#include "sweep.h"
+#include "sweep_store.h"
+#include "check.h"
+
+// Aceleración del hilo DMA: un bloque de 10 ms cada 5 ms. Con el anillo
+// de 4 buffers el consumidor tiene un bloque de holgura; en un host de un
+// solo núcleo el planificador llega a demorarlo un par de ms
+#define STREAM_SPEEDUP 2.0
+
+// Tolerancias contra la H teórica (incluyen el redondeo del JSON)
+#define MAG_TOL_DB 0.03f
+#define PHASE_TOL_DEG 0.3f
+
+// Actualizaciones y confirmaciones leídas de la cola
+#define MAX_UPDATES 4096
+#define MAX_ACKS 8
+
+typedef struct {
+    uint32_t block;             // Último bloque de la ventana
+    float mag_db;
+    float phase_deg;
+} update_t;
+
+typedef struct {
+    update_t updates[MAX_UPDATES];
+    uint32_t count;
+    uint32_t messages;
+    uint32_t bad_messages;      // No se pudieron leer
+    uint32_t discontinuities;   // "block" que no sigue al anterior
+    float freq_hz;
+    float rate_hz;
+    uint32_t hop;
+    uint32_t acks;
+    char ack[MAX_ACKS][COMMAND_ACK_JSON_MAX];
+} collected_t;
+
+/**
+ * @brief Lee un mensaje de MQTT_TOPIC_MONITOR y agrega sus actualizaciones
+ */
+static bool parse_monitor(const char *text, size_t len, collected_t *c) {
+    json_reader_t r;
+    char key[16];
+    uint32_t window = 0;
+    uint32_t block = 0;
+    float mag[MONITOR_BATCH_MAX];
+    float phase[MONITOR_BATCH_MAX];
+    uint32_t mags = 0;
+    uint32_t phases = 0;
+
+    json_reader_init(&r, text, len);
+    json_reader_begin_object(&r);
+    while (json_reader_next_key(&r, key, sizeof(key))) {
+        bool ok = true;
+        if (strcmp(key, "freq") == 0) {
+            ok = json_reader_float(&r, &c->freq_hz);
+        } else if (strcmp(key, "rate") == 0) {
+            ok = json_reader_float(&r, &c->rate_hz);
+        } else if (strcmp(key, "window") == 0) {
+            ok = json_reader_uint(&r, &window);
+        } else if (strcmp(key, "hop") == 0) {
+            ok = json_reader_uint(&r, &c->hop);
+        } else if (strcmp(key, "block") == 0) {
+            ok = json_reader_uint(&r, &block);
+        } else if (strcmp(key, "mag_db") == 0 || strcmp(key, "phase_deg") == 0) {
+            bool is_mag = key[0] == 'm';
+            float *dst = is_mag ? mag : phase;
+            uint32_t *n = is_mag ? &mags : &phases;
+            ok = json_reader_begin_array(&r);
+            while (ok && json_reader_next_element(&r)) {
+                ok = *n < MONITOR_BATCH_MAX && json_reader_float(&r, &dst[*n]);
+                (*n)++;
+            }
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    if (!json_reader_end(&r) || mags != phases || mags == 0 || c->hop == 0) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < mags && c->count < MAX_UPDATES; i++) {
+        update_t *u = &c->updates[c->count];
+        u->block = block + i * c->hop;
+        u->mag_db = mag[i];
+        u->phase_deg = phase[i];
+        if (c->count > 0 && u->block != c->updates[c->count - 1].block + c->hop) {
+            c->discontinuities++;
+        }
+        c->count++;
+    }
+    return true;
+}
+
+/**
+ * @brief Agrega las actualizaciones del monitor y guarda las confirmaciones
+ */
+static void collect(const char *topic, const char *text, size_t len, void *ctx) {
+    collected_t *c = ctx;
+    if (strcmp(topic, MQTT_TOPIC_MONITOR) == 0) {
+        c->messages++;
+        c->bad_messages += !parse_monitor(text, len, c);
+    } else if (strcmp(topic, MQTT_TOPIC_STATUS) == 0 && len < COMMAND_ACK_JSON_MAX) {
+        if (c->acks < MAX_ACKS) {
+            memcpy(c->ack[c->acks], text, len + 1);
+        }
+        c->acks++;
+    }
+}
+
+static void drain(collected_t *c) {
+    drain_publish_queue(collect, c);
+}
+
+static bool send(const char *text) {
+    return mqtt_client_incoming(MQTT_TOPIC_COMMAND, (const uint8_t *)text, strlen(text));
+}
+
+/**
+ * @brief Manda un comando, lo ejecuta y compara la última confirmación
+ */
+static void roundtrip(collected_t *c, const char *text, const char *expected_ack, const char *what) {
+    uint32_t before = c->acks;
+    send(text);
+    command_poll();
+    drain(c);
+    bool ok = c->acks == before + 1 && c->acks <= MAX_ACKS
+        && strcmp(c->ack[c->acks - 1], expected_ack) == 0;
+    expect(ok, what);
+    if (!ok && c->acks > 0 && c->acks <= MAX_ACKS) {
+        printf("  %s\n", c->ack[c->acks - 1]);
+    }
+}
+
+/**
+ * @brief Procesa bloques del monitor hasta haber consumido blocks
+ */
+static void run_blocks(collected_t *c, uint32_t blocks) {
+    monitor_stats_t stats;
+    monitor_get_stats(&stats);
+    uint32_t target = stats.blocks + blocks;
+
+    while (stats.blocks < target) {
+        if (monitor_poll() == 0) {
+            usleep(50);
+        }
+        drain(c);
+        monitor_get_stats(&stats);
+    }
+}
+
+/**
+ * @brief H teórica del DUT vigente en dB y grados
+ */
+static void expected_h(float freq_hz, float *mag_db, float *phase_deg) {
+    float mag, phase;
+    sim_dut_response(freq_hz, &mag, &phase);
+    *mag_db = 20.0f * log10f(mag);
+    *phase_deg = phase * (180.0f / (float)M_PI);
+}
+
+static bool update_matches(const update_t *u, float mag_db, float phase_deg) {
+    return fabsf(u->mag_db - mag_db) <= MAG_TOL_DB
+        && fabsf(remainderf(u->phase_deg - phase_deg, 360.0f)) <= PHASE_TOL_DEG;
+}
+
+static void check_spec(void) {
+    monitor_spec_t spec;
+    float freq;
+    printf("Parámetros\n");
+
+    monitor_default_spec(&spec);
+    expect(monitor_check_spec(&spec, &freq) && freq == MONITOR_FREQ_HZ, "los de config.h son válidos");
+
+    spec.freq_hz = 1234.0f;
+    spec.window_blocks = 4;
+    expect(monitor_check_spec(&spec, &freq) && freq == 1225.0f,
+           "1234 Hz con 4 bloques (25 Hz de resolución) → 1225 Hz");
+    spec.window_blocks = 1;
+    expect(monitor_check_spec(&spec, &freq) && freq == 1200.0f, "con 1 bloque → 1200 Hz");
+
+    monitor_spec_t bad = spec;
+    bad.window_blocks = 0;
+    bool rejected = !monitor_check_spec(&bad, NULL);
+    bad = spec;
+    bad.window_blocks = MONITOR_WINDOW_BLOCKS_MAX + 1;
+    rejected &= !monitor_check_spec(&bad, NULL);
+    bad = spec;
+    bad.window_blocks = 2;
+    bad.hop_blocks = 3;
+    rejected &= !monitor_check_spec(&bad, NULL);
+    bad = spec;
+    bad.batch = 0;
+    rejected &= !monitor_check_spec(&bad, NULL);
+    bad = spec;
+    bad.batch = MONITOR_BATCH_MAX + 1;
+    rejected &= !monitor_check_spec(&bad, NULL);
+    bad = spec;
+    bad.freq_hz = 40.0f;
+    rejected &= !monitor_check_spec(&bad, NULL);
+    bad = spec;
+    bad.freq_hz = SAMPLE_RATE / 2.0f;
+    rejected &= !monitor_check_spec(&bad, NULL);
+    bad = spec;
+    bad.freq_hz = NAN;
+    rejected &= !monitor_check_spec(&bad, NULL);
+    expect(rejected, "fuera de rango, hop > window y tonos sin bin coherente");
+}
+
+static void check_format(void) {
+    static monitor_batch_t batch;
+    static collected_t c;
+    char buf[MONITOR_JSON_MAX];
+    printf("Formato\n");
+
+    // El mensaje más largo posible
+    batch.freq_hz = 23999.9f;
+    batch.update_hz = 100.0f;
+    batch.window_blocks = MONITOR_WINDOW_BLOCKS_MAX;
+    batch.hop_blocks = MONITOR_WINDOW_BLOCKS_MAX;
+    batch.block = UINT32_MAX - MONITOR_BATCH_MAX * MONITOR_WINDOW_BLOCKS_MAX;
+    batch.count = MONITOR_BATCH_MAX;
+    for (int i = 0; i < MONITOR_BATCH_MAX; i++) {
+        batch.magnitude_db[i] = -179.99f;
+        batch.phase_deg[i] = -179.9f;
+    }
+    size_t len = monitor_format_json(&batch, buf, sizeof(buf));
+    printf("  %lu bytes con %d actualizaciones\n", (unsigned long)len, MONITOR_BATCH_MAX);
+    expect(len > 0, "el mensaje más largo entra en MONITOR_JSON_MAX");
+
+    batch.count = 3;
+    batch.block = 100;
+    batch.magnitude_db[1] = -3.01f;
+    batch.phase_deg[1] = -45.0f;
+    len = monitor_format_json(&batch, buf, sizeof(buf));
+    expect(parse_monitor(buf, len, &c) && c.count == 3 && c.updates[1].block == 100u + batch.hop_blocks
+           && c.updates[1].mag_db == -3.01f && c.updates[1].phase_deg == -45.0f
+           && c.freq_hz == 23999.9f && c.rate_hz == 100.0f && c.discontinuities == 0,
+           "se lee de vuelta");
+}
+
+/**
+ * @brief Monitor de punta a punta con un juego de parámetros
+ */
+static void check_stream(const char *command, const char *expected_ack, uint32_t hop,
+                         uint32_t window, float freq_hz, uint32_t blocks) {
+    static collected_t c;
+    memset(&c, 0, sizeof(c));
+    printf("Monitor: %s\n", command);
+
+    roundtrip(&c, command, expected_ack, "confirmación con la frecuencia coherente");
+    run_blocks(&c, blocks);
+    monitor_stats_t stats;
+    monitor_get_stats(&stats);
+    adc_dma_ring_stats_t ring;
+    adc_dma_get_ring_stats(&ring);
+    monitor_stop();
+    drain(&c);
+
+    float mag_db, phase_deg;
+    expected_h(freq_hz, &mag_db, &phase_deg);
+    uint32_t wrong = 0;
+    for (uint32_t i = 0; i < c.count; i++) {
+        wrong += !update_matches(&c.updates[i], mag_db, phase_deg);
+    }
+    uint32_t expected_updates = (stats.blocks - stats.settle_blocks - window) / hop + 1;
+
+    printf("  %lu bloques (%lu de asentamiento), %lu actualizaciones en %lu mensajes, "
+           "%.1f/s\n", (unsigned long)stats.blocks, (unsigned long)stats.settle_blocks,
+           (unsigned long)c.count, (unsigned long)c.messages, c.rate_hz);
+    if (c.count > 0) {
+        printf("  última: %.2f dB %.1f° (teórica %.3f dB %.2f°)\n", c.updates[c.count - 1].mag_db,
+               c.updates[c.count - 1].phase_deg, mag_db, phase_deg);
+    }
+    expect(c.bad_messages == 0 && c.freq_hz == freq_hz && c.hop == hop
+           && fabsf(c.rate_hz - SAMPLE_RATE / (float)(WINDOW_SIZE * hop)) < 0.05f,
+           "mensajes legibles con frecuencia, paso y ritmo pedidos");
+    printf("  anillo: %lu bloques descartados, hasta %u en espera\n",
+           (unsigned long)ring.blocks_dropped, ring.max_ready_depth);
+    expect(ring.blocks_dropped == 0 && stats.gaps == 0 && c.discontinuities == 0,
+           "sin overrun ni saltos de \"block\"");
+    expect(c.count == expected_updates && stats.updates == c.count && stats.publish_failures == 0,
+           "una actualización cada hop bloques, todas publicadas");
+    expect(c.count > 0 && c.updates[0].block == stats.settle_blocks + window - 1,
+           "la primera ventana empieza después del asentamiento");
+    expect(c.count > 0 && wrong == 0, "magnitud y fase contra la H teórica");
+}
+
+static void check_drift(void) {
+    static collected_t c;
+    memset(&c, 0, sizeof(c));
+    const uint32_t window = 4;
+    printf("Deriva del corte durante el monitor\n");
+
+    roundtrip(&c, "{\"cmd\":\"monitor\",\"freq\":1000,\"window\":4,\"hop\":1,\"batch\":10}",
+              "{\"status\":\"ack\",\"cmd\":\"monitor\",\"ok\":true,\"freq\":1000.0}",
+              "monitor a 1 kHz");
+
+    // Primero que asiente y salgan unas cuantas ventanas
+    monitor_stats_t stats;
+    do {
+        run_blocks(&c, 1);
+        monitor_get_stats(&stats);
+    } while (stats.updates < 20);
+
+    float old_mag, old_phase;
+    expected_h(1000.0f, &old_mag, &old_phase);
+
+    sim_dut_config_t dut;
+    sim_dut_default_config(&dut);
+    dut.corner_hz = 1200.0f;
+    hal_host_configure_dut(&dut);
+    adc_dma_ring_stats_t ring;
+    adc_dma_get_ring_stats(&ring);
+    // El bloque blocks_captured pudo sintetizarse antes del cambio; desde el
+    // siguiente son todos del DUT nuevo
+    uint32_t switch_block = ring.blocks_captured;
+
+    float new_mag, new_phase;
+    expected_h(1000.0f, &new_mag, &new_phase);
+    run_blocks(&c, 60);
+    monitor_stop();
+    drain(&c);
+
+    uint32_t old_wrong = 0;
+    uint32_t new_wrong = 0;
+    uint32_t old_count = 0;
+    uint32_t new_count = 0;
+    uint32_t transition = 0;
+    for (uint32_t i = 0; i < c.count; i++) {
+        const update_t *u = &c.updates[i];
+        if (u->block < switch_block) {
+            old_count++;
+            old_wrong += !update_matches(u, old_mag, old_phase);
+        } else if (u->block - (window - 1) > switch_block) {
+            new_count++;
+            new_wrong += !update_matches(u, new_mag, new_phase);
+        } else {
+            transition++;
+        }
+    }
+    printf("  corte 1000 → 1200 Hz en el bloque %lu: %.2f dB %.1f° → %.2f dB %.1f°\n",
+           (unsigned long)switch_block, old_mag, old_phase, new_mag, new_phase);
+    printf("  %lu ventanas antes, %lu en la transición, %lu después\n",
+           (unsigned long)old_count, (unsigned long)transition, (unsigned long)new_count);
+    expect(old_count > 0 && old_wrong == 0, "las ventanas anteriores miden el DUT viejo");
+    expect(new_count > 0 && new_wrong == 0, "las posteriores miden el DUT nuevo");
+    expect(transition <= window + 1 && c.discontinuities == 0,
+           "la transición dura lo que la ventana, sin saltos");
+
+    sim_dut_default_config(&dut);
+    hal_host_configure_dut(&dut);
+}
+
+static void check_busy_and_stop(void) {
+    static collected_t c;
+    memset(&c, 0, sizeof(c));
+    printf("Monitor contra barrido\n");
+
+    roundtrip(&c, "{\"cmd\":\"monitor\",\"id\":1}",
+              "{\"status\":\"ack\",\"cmd\":\"monitor\",\"id\":1,\"ok\":true,\"freq\":1000.0}",
+              "monitor con los parámetros vigentes");
+    expect(monitor_active(), "monitor activo");
+    roundtrip(&c, "{\"cmd\":\"point\",\"freq\":1000}",
+              "{\"status\":\"ack\",\"cmd\":\"point\",\"ok\":false,\"error\":\"busy\"}",
+              "point ocupado");
+    roundtrip(&c, "{\"cmd\":\"start\"}",
+              "{\"status\":\"ack\",\"cmd\":\"start\",\"ok\":false,\"error\":\"busy\"}",
+              "start ocupado");
+    roundtrip(&c, "{\"cmd\":\"monitor\",\"freq\":2000,\"batch\":5}",
+              "{\"status\":\"ack\",\"cmd\":\"monitor\",\"ok\":true,\"freq\":2000.0}",
+              "reconfigurar el monitor en marcha");
+    run_blocks(&c, 50);
+    roundtrip(&c, "{\"cmd\":\"stop\"}", "{\"status\":\"ack\",\"cmd\":\"stop\",\"ok\":true}", "stop");
+    expect(!monitor_active() && c.count > 0 && c.bad_messages == 0 && c.freq_hz == 2000.0f,
+           "stop detiene el monitor y publica lo pendiente");
+    roundtrip(&c, "{\"cmd\":\"point\",\"freq\":1000}",
+              "{\"status\":\"ack\",\"cmd\":\"point\",\"ok\":true}",
+              "point vuelve a medir sin el monitor");
+}
+
+int main(void) {
+    mqtt_config_t mqtt_cfg = {
+        .broker_addr = MQTT_BROKER_ADDR,
+        .broker_port = MQTT_BROKER_PORT,
+        .client_id = MQTT_CLIENT_ID,
+        .topic = MQTT_TOPIC_MEASUREMENTS
+    };
+    command_init();
+    if (!hal_host_flash_open(NULL) || !adc_dma_init() || !ad9833_init() || !mqtt_init(&mqtt_cfg)
+        || !sweep_store_init() || !frequency_sweep_init()) {
+        fprintf(stderr, "[FATAL] Fallo en inicialización de módulos\n");
+        return EXIT_FAILURE;
+    }
+
+    sim_dut_config_t dut;
+    sim_dut_default_config(&dut);
+    sim_dut_configure(&dut);
+    hal_host_set_stream_speedup(STREAM_SPEEDUP);
+
+    check_spec();
+    check_format();
+    check_stream("{\"cmd\":\"monitor\",\"freq\":1000,\"window\":4,\"hop\":1,\"batch\":10}",
+                 "{\"status\":\"ack\",\"cmd\":\"monitor\",\"ok\":true,\"freq\":1000.0}",
+                 1, 4, 1000.0f, 200);
+    check_stream("{\"cmd\":\"monitor\",\"freq\":1234,\"window\":4,\"hop\":4,\"batch\":7}",
+                 "{\"status\":\"ack\",\"cmd\":\"monitor\",\"ok\":true,\"freq\":1225.0}",
+                 4, 4, 1225.0f, 200);
+    check_stream("{\"cmd\":\"monitor\",\"freq\":150,\"window\":16,\"hop\":3,\"batch\":25}",
+                 "{\"status\":\"ack\",\"cmd\":\"monitor\",\"ok\":true,\"freq\":150.0}",
+                 3, 16, 150.0f, 200);
+    check_drift();
+    check_busy_and_stop();
+
+    printf("\n%s (%d fallas)\n", failures ? "FALLA" : "OK", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,361 @@
+/**
+ * @file check_publish_queue.c
+ * @brief Verificación de la cola de publicación contra un broker TCP que
+ *        se atasca (fra_check_publish_queue)
+ *
+ * Levanta en 127.0.0.1 un broker sustituto que lee mensajes con prefijo de
+ * largo y, tras los primeros BROKER_STALL_AFTER, deja de leer durante
+ * BROKER_STALL_MS. Con buffers de socket chicos, el atasco llena TCP y
+ * después la cola. Un hilo hace de contexto de red: toma mensajes con
+ * publish_queue_acquire() y los escribe en un socket no bloqueante,
+ * conservando el slot mientras el envío queda a medias. El hilo principal
+ * hace de barrido y publica un mensaje de trama por milisegundo.
+ *
+ * Para cada política comprueba:
+ * - DROP_OLDEST / DROP_NEWEST: el productor nunca espera al atasco, los
+ *   mensajes llegan en orden y sin corromper, recibidos + descartados =
+ *   producidos, y se conserva el último (OLDEST) o el primero (NEWEST);
+ * - BLOCK: no se pierde ninguno y el productor sí espera.
+ * Retorna distinto de cero ante cualquier discrepancia.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "config.h"
+#include "publish_queue.h"
+#include "check.h"
+
+#define PQ_MESSAGES 300
+#define PQ_PERIOD_US 1000
+#define PQ_MSG_BYTES SWEEP_FRAME_SIZE(SWEEP_NUM_POINTS)
+
+#define BROKER_STALL_AFTER 10
+#define BROKER_STALL_MS 150
+#define SOCKET_BUFFER_BYTES 4096
+
+// Umbrales de latencia de publicación: muy por debajo y por encima del atasco
+#define MAX_NONBLOCKING_US 20000.0
+#define MIN_BLOCKED_US 50000.0
+
+typedef struct {
+    int listen_fd;
+    uint16_t port;
+    uint32_t received[PQ_MESSAGES];
+    uint32_t count;
+    uint32_t corrupt;
+    pthread_t thread;
+} broker_t;
+
+typedef struct {
+    int fd;
+    atomic_bool producer_done;
+    pthread_t thread;
+} network_t;
+
+static double host_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec * 1e-3;
+}
+
+static void sleep_until_us(double t_us) {
+    double now = host_now_us();
+    if (t_us > now) {
+        struct timespec ts = { 0, (long)((t_us - now) * 1e3) };
+        nanosleep(&ts, NULL);
+    }
+}
+
+// ============================================================================
+// BROKER SUSTITUTO
+// ============================================================================
+
+static bool recv_all(int fd, uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = recv(fd, buf, len, 0);
+        if (n <= 0) {
+            return false;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static void *broker_main(void *arg) {
+    broker_t *b = arg;
+    int fd = accept(b->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    static uint8_t payload[PUBLISH_QUEUE_MSG_MAX];
+    while (true) {
+        uint8_t hdr[2];
+        if (!recv_all(fd, hdr, sizeof(hdr))) {
+            break;
+        }
+        uint16_t len = (uint16_t)(hdr[0] | (hdr[1] << 8));
+        if (len > sizeof(payload) || !recv_all(fd, payload, len)) {
+            b->corrupt++;
+            break;
+        }
+
+        uint32_t seq = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8)
+                     | ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+        bool intact = (len == PQ_MSG_BYTES);
+        for (uint16_t i = 4; intact && i < len; i++) {
+            intact = payload[i] == (uint8_t)(seq + i);
+        }
+        if (!intact) {
+            b->corrupt++;
+        }
+        if (b->count < PQ_MESSAGES) {
+            b->received[b->count] = seq;
+        }
+        b->count++;
+
+        // El atasco: el broker deja de leer y TCP se llena
+        if (b->count == BROKER_STALL_AFTER) {
+            usleep(BROKER_STALL_MS * 1000);
+        }
+    }
+
+    close(fd);
+    return NULL;
+}
+
+static bool broker_start(broker_t *b) {
+    memset(b, 0, sizeof(*b));
+    b->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (b->listen_fd < 0) {
+        return false;
+    }
+
+    // El buffer de recepción chico se hereda en el socket aceptado
+    int rcvbuf = SOCKET_BUFFER_BYTES;
+    setsockopt(b->listen_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t addr_len = sizeof(addr);
+    if (bind(b->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen(b->listen_fd, 1) != 0
+        || getsockname(b->listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        close(b->listen_fd);
+        return false;
+    }
+    b->port = ntohs(addr.sin_port);
+
+    return pthread_create(&b->thread, NULL, broker_main, b) == 0;
+}
+
+static void broker_stop(broker_t *b) {
+    pthread_join(b->thread, NULL);
+    close(b->listen_fd);
+}
+
+// ============================================================================
+// CONTEXTO DE RED
+// ============================================================================
+
+/**
+ * @brief Drena la cola hacia el socket; un envío a medias conserva su slot
+ */
+static void *network_main(void *arg) {
+    network_t *net = arg;
+    publish_msg_t *msg = NULL;
+    size_t offset = 0;
+
+    while (true) {
+        if (!msg) {
+            msg = publish_queue_acquire();
+            offset = 0;
+            if (!msg) {
+                if (atomic_load(&net->producer_done)) {
+                    break;
+                }
+                usleep(100);
+                continue;
+            }
+        }
+
+        uint8_t hdr[2] = { (uint8_t)msg->len, (uint8_t)(msg->len >> 8) };
+        size_t total = sizeof(hdr) + msg->len;
+        const uint8_t *src = offset < sizeof(hdr) ? &hdr[offset] : &msg->payload[offset - sizeof(hdr)];
+        size_t chunk = offset < sizeof(hdr) ? sizeof(hdr) - offset : total - offset;
+
+        ssize_t n = send(net->fd, src, chunk, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // Broker atascado: reintentar más tarde con el mismo slot
+                usleep(200);
+                continue;
+            }
+            publish_queue_release(msg, false);
+            msg = NULL;
+            continue;
+        }
+
+        offset += (size_t)n;
+        if (offset == total) {
+            publish_queue_release(msg, true);
+            msg = NULL;
+        }
+    }
+
+    return NULL;
+}
+
+static bool network_start(network_t *net, uint16_t port) {
+    net->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (net->fd < 0) {
+        return false;
+    }
+    int sndbuf = SOCKET_BUFFER_BYTES;
+    setsockopt(net->fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(net->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(net->fd);
+        return false;
+    }
+    fcntl(net->fd, F_SETFL, fcntl(net->fd, F_GETFL) | O_NONBLOCK);
+
+    atomic_store(&net->producer_done, false);
+    return pthread_create(&net->thread, NULL, network_main, net) == 0;
+}
+
+static void network_stop(network_t *net) {
+    atomic_store(&net->producer_done, true);
+    pthread_join(net->thread, NULL);
+    close(net->fd);
+}
+
+// ============================================================================
+// ESCENARIOS
+// ============================================================================
+
+static const char *policy_name(publish_overflow_t policy) {
+    switch (policy) {
+        case PUBLISH_DROP_OLDEST: return "PUBLISH_DROP_OLDEST";
+        case PUBLISH_DROP_NEWEST: return "PUBLISH_DROP_NEWEST";
+        default: return "PUBLISH_BLOCK";
+    }
+}
+
+static void run_scenario(publish_overflow_t policy) {
+    static broker_t broker;
+    network_t net;
+
+    printf("%s: %d mensajes de %d bytes cada %d us, broker atascado %d ms\n",
+           policy_name(policy), PQ_MESSAGES, PQ_MSG_BYTES, PQ_PERIOD_US, BROKER_STALL_MS);
+
+    publish_queue_init(policy);
+    if (!broker_start(&broker) || !network_start(&net, broker.port)) {
+        expect(false, "levantar broker y conexión TCP");
+        return;
+    }
+
+    // "Barrido": publica a ritmo fijo y mide cuánto tarda cada publicación
+    double max_publish_us = 0.0;
+    uint32_t rejected = 0;
+    double t_next = host_now_us();
+    for (uint32_t seq = 0; seq < PQ_MESSAGES; seq++) {
+        double t0 = host_now_us();
+        publish_msg_t *msg = publish_queue_reserve(MQTT_TOPIC_SWEEP);
+        if (msg) {
+            for (uint16_t i = 0; i < 4; i++) {
+                msg->payload[i] = (uint8_t)(seq >> (8 * i));
+            }
+            for (uint16_t i = 4; i < PQ_MSG_BYTES; i++) {
+                msg->payload[i] = (uint8_t)(seq + i);
+            }
+            publish_queue_commit(msg, PQ_MSG_BYTES);
+        } else {
+            rejected++;
+        }
+        double dt = host_now_us() - t0;
+        if (dt > max_publish_us) {
+            max_publish_us = dt;
+        }
+
+        t_next += PQ_PERIOD_US;
+        sleep_until_us(t_next);
+    }
+
+    network_stop(&net);
+    broker_stop(&broker);
+
+    publish_queue_stats_t stats;
+    publish_queue_get_stats(&stats);
+
+    bool ordered = true;
+    uint32_t n = broker.count < PQ_MESSAGES ? broker.count : PQ_MESSAGES;
+    for (uint32_t i = 1; i < n; i++) {
+        if (broker.received[i] <= broker.received[i - 1]) {
+            ordered = false;
+        }
+    }
+
+    printf("  recibidos %lu, descartados %lu viejos + %lu nuevos, máx cola %lu/%d, "
+           "esperas %lu, publicación máx %.0f us\n",
+           (unsigned long)broker.count, (unsigned long)stats.dropped_oldest,
+           (unsigned long)stats.dropped_newest, (unsigned long)stats.high_water,
+           PUBLISH_QUEUE_SLOTS, (unsigned long)stats.block_waits, max_publish_us);
+
+    expect(broker.corrupt == 0, "ningún mensaje corrupto (slot no pisado mientras se envía)");
+    expect(ordered, "orden de llegada = orden de publicación");
+    expect(stats.sent == broker.count && stats.failed == 0 && stats.depth == 0,
+           "contadores: enviados = recibidos, cola vacía al final");
+    expect(stats.high_water == PUBLISH_QUEUE_SLOTS, "el atasco llenó la cola (marca de agua alta)");
+    expect(rejected == stats.dropped_newest, "rechazos del productor = dropped_newest");
+
+    switch (policy) {
+        case PUBLISH_DROP_OLDEST:
+            expect(max_publish_us < MAX_NONBLOCKING_US, "el productor nunca espera al atasco");
+            expect(stats.dropped_oldest > 0 && broker.count + stats.dropped_oldest
+                   + stats.dropped_newest == PQ_MESSAGES, "recibidos + descartados = producidos");
+            expect(n > 0 && broker.received[n - 1] == PQ_MESSAGES - 1, "llega el último mensaje");
+            break;
+        case PUBLISH_DROP_NEWEST:
+            expect(max_publish_us < MAX_NONBLOCKING_US, "el productor nunca espera al atasco");
+            expect(stats.dropped_newest > 0 && stats.dropped_oldest == 0
+                   && broker.count + stats.dropped_newest == PQ_MESSAGES,
+                   "recibidos + rechazados = producidos");
+            expect(n > 0 && broker.received[0] == 0, "llega el primer mensaje");
+            break;
+        default:
+            expect(broker.count == PQ_MESSAGES && stats.dropped_oldest == 0
+                   && stats.dropped_newest == 0, "no se pierde ningún mensaje");
+            expect(stats.block_waits > 0 && max_publish_us >= MIN_BLOCKED_US,
+                   "el productor espera mientras el broker está atascado");
+            break;
+    }
+}
+
+int main(void) {
+    run_scenario(PUBLISH_DROP_OLDEST);
+    run_scenario(PUBLISH_DROP_NEWEST);
+    run_scenario(PUBLISH_BLOCK);
+
+    printf("\n%s (%d fallas)\n", failures ? "FALLA" : "OK", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
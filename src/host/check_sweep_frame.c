@@ -0,0 +1,234 @@
+/**
+ * @file check_sweep_frame.c
+ * @brief Verificación de la trama binaria de barrido (fra_check_sweep_frame)
+ *
+ * Comprueba:
+ * - la disposición exacta de bytes de una trama chica contra una
+ *   secuencia dorada (orden de campos, little-endian, arreglos separados);
+ * - ida y vuelta encode/decode de tramas pseudoaleatorias, con puntos
+ *   inválidos y valores fuera de rango, dentro del error de cuantización;
+ * - que el decoder rechaza tramas truncadas, con bytes de más, con magia o
+ *   versión desconocidas o con count fuera de rango.
+ * Retorna distinto de cero ante cualquier discrepancia.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "config.h"
+#include "sweep_frame.h"
+#include "check.h"
+
+#define ROUNDTRIP_FRAMES 20000
+
+// Error máximo de la cuantización a centésimas
+#define QUANT_TOL 0.0051f
+
+static uint32_t rng_state = 12345u;
+
+static uint32_t rng_next(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state;
+}
+
+static float rng_uniform(float lo, float hi) {
+    return lo + (hi - lo) * (float)(rng_next() >> 8) / 16777216.0f;
+}
+
+static bool value_matches(float sent, int16_t got) {
+    if (!isfinite(sent)) {
+        return false;
+    }
+    float clamped = fminf(fmaxf(sent, -327.67f), 327.67f);
+    return fabsf(got / 100.0f - clamped) <= QUANT_TOL;
+}
+
+/**
+ * @brief Trama pseudoaleatoria: encabezado, puntos válidos, inválidos y
+ *        saturados. Devuelve en mag/phase los valores originales.
+ */
+static void random_frame(sweep_frame_t *frame, float *mag, float *phase) {
+    uint16_t count = (uint16_t)(rng_next() % (SWEEP_FRAME_MAX_POINTS + 1));
+    sweep_frame_begin(frame, rng_next(), rng_next(), rng_uniform(1.0f, 1000.0f),
+                      rng_uniform(0.1f, 500.0f), (uint16_t)(rng_next() % SWEEP_NUM_POINTS));
+    frame->header.flags = (uint8_t)(rng_next() & SWEEP_FRAME_FLAG_LAST);
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t kind = rng_next() % 16;
+        if (kind == 0) {
+            mag[i] = NAN;
+            phase[i] = rng_uniform(-180.0f, 180.0f);
+        } else if (kind == 1) {
+            mag[i] = rng_uniform(-1000.0f, 1000.0f);
+            phase[i] = INFINITY;
+        } else if (kind == 2) {
+            mag[i] = rng_uniform(-1000.0f, 1000.0f);
+            phase[i] = rng_uniform(-400.0f, 400.0f);
+        } else {
+            mag[i] = rng_uniform(-120.0f, 40.0f);
+            phase[i] = rng_uniform(-180.0f, 180.0f);
+        }
+        sweep_frame_add(frame, mag[i], phase[i]);
+    }
+}
+
+static void check_golden(void) {
+    static const uint8_t golden[] = {
+        'F', 'R', 0x01, 0x01,           // magia, versión, flags = LAST
+        0x04, 0x03, 0x02, 0x01,         // sweep_id
+        0x0D, 0x0C, 0x0B, 0x0A,         // timestamp_ms
+        0x00, 0x00, 0xC8, 0x42,         // start_hz = 100.0f
+        0x00, 0x00, 0x48, 0x42,         // step_hz = 50.0f
+        0x02, 0x00,                     // first_index
+        0x02, 0x00,                     // count
+        0xA6, 0xFE, 0x00, 0x80,         // magnitudes: -3.46 dB, inválido
+        0xE6, 0xDD, 0x00, 0x80          // fases: -87.30°, inválido
+    };
+    sweep_frame_t frame;
+    uint8_t buf[64];
+
+    printf("Disposición de bytes (secuencia dorada)\n");
+    sweep_frame_begin(&frame, 0x01020304u, 0x0A0B0C0Du, 100.0f, 50.0f, 2);
+    sweep_frame_add(&frame, -3.456f, -87.3f);
+    sweep_frame_add(&frame, NAN, 10.0f);
+    frame.header.flags = SWEEP_FRAME_FLAG_LAST;
+
+    size_t len = sweep_frame_encode(&frame, buf, sizeof(buf));
+    expect(len == sizeof(golden), "largo = encabezado + 4 bytes por punto");
+    expect(len == sizeof(golden) && memcmp(buf, golden, len) == 0, "bytes idénticos a la secuencia dorada");
+    expect(sweep_frame_encode(&frame, buf, len - 1) == 0, "buffer chico: encode retorna 0");
+
+    sweep_frame_t decoded;
+    expect(sweep_frame_decode(golden, sizeof(golden), &decoded), "decode de la secuencia dorada");
+    expect(decoded.header.count == 2 && decoded.header.first_index == 2, "count y first_index");
+    expect(fabsf(sweep_frame_frequency_hz(&decoded, 1) - 250.0f) < 1e-3f,
+           "frecuencia del punto 1 = start + (first + 1) * step");
+    expect(sweep_frame_point_valid(&decoded, 0) && !sweep_frame_point_valid(&decoded, 1),
+           "punto 0 válido, punto 1 inválido");
+}
+
+static void check_roundtrip(void) {
+    static sweep_frame_t frame;
+    static sweep_frame_t decoded;
+    static float mag[SWEEP_FRAME_MAX_POINTS];
+    static float phase[SWEEP_FRAME_MAX_POINTS];
+    static uint8_t buf[SWEEP_FRAME_SIZE(SWEEP_FRAME_MAX_POINTS)];
+    uint32_t header_errors = 0;
+    uint32_t value_errors = 0;
+    uint32_t decode_errors = 0;
+
+    printf("Ida y vuelta de %d tramas pseudoaleatorias\n", ROUNDTRIP_FRAMES);
+    for (uint32_t n = 0; n < ROUNDTRIP_FRAMES; n++) {
+        random_frame(&frame, mag, phase);
+        size_t len = sweep_frame_encode(&frame, buf, sizeof(buf));
+        memset(&decoded, 0xA5, sizeof(decoded));
+        if (len == 0 || !sweep_frame_decode(buf, len, &decoded)) {
+            decode_errors++;
+            continue;
+        }
+
+        const sweep_frame_header_t *a = &frame.header;
+        const sweep_frame_header_t *b = &decoded.header;
+        if (a->sweep_id != b->sweep_id || a->timestamp_ms != b->timestamp_ms
+            || a->start_hz != b->start_hz || a->step_hz != b->step_hz
+            || a->first_index != b->first_index || a->count != b->count || a->flags != b->flags) {
+            header_errors++;
+            continue;
+        }
+
+        for (uint16_t i = 0; i < a->count; i++) {
+            bool valid = isfinite(mag[i]) && isfinite(phase[i]);
+            bool ok = valid
+                ? (sweep_frame_point_valid(&decoded, i)
+                   && value_matches(mag[i], decoded.magnitude_cdb[i])
+                   && value_matches(phase[i], decoded.phase_cdeg[i]))
+                : !sweep_frame_point_valid(&decoded, i);
+            if (!ok) {
+                value_errors++;
+            }
+        }
+    }
+
+    expect(decode_errors == 0, "toda trama codificada se decodifica");
+    expect(header_errors == 0, "encabezados idénticos");
+    expect(value_errors == 0, "valores dentro de ±0.005 (saturados a ±327.67) e inválidos preservados");
+}
+
+static void check_rejects(void) {
+    static sweep_frame_t frame;
+    static sweep_frame_t decoded;
+    static float mag[SWEEP_FRAME_MAX_POINTS];
+    static float phase[SWEEP_FRAME_MAX_POINTS];
+    static uint8_t buf[SWEEP_FRAME_SIZE(SWEEP_FRAME_MAX_POINTS) + 1];
+
+    printf("Tramas inválidas\n");
+    do {
+        random_frame(&frame, mag, phase);
+    } while (frame.header.count == 0);
+    size_t len = sweep_frame_encode(&frame, buf, sizeof(buf));
+
+    expect(!sweep_frame_decode(buf, len - 1, &decoded), "truncada");
+    expect(!sweep_frame_decode(buf, len + 1, &decoded), "con bytes de más");
+    expect(!sweep_frame_decode(buf, SWEEP_FRAME_HEADER_SIZE - 1, &decoded), "encabezado incompleto");
+
+    buf[0] ^= 0xFF;
+    expect(!sweep_frame_decode(buf, len, &decoded), "magia desconocida");
+    buf[0] ^= 0xFF;
+
+    buf[2] = SWEEP_FRAME_VERSION + 1;
+    expect(!sweep_frame_decode(buf, len, &decoded), "versión desconocida");
+    buf[2] = SWEEP_FRAME_VERSION;
+
+    // count mayor que el máximo, con el largo que le correspondería
+    static uint8_t big[SWEEP_FRAME_SIZE(SWEEP_FRAME_MAX_POINTS + 1)];
+    memcpy(big, buf, SWEEP_FRAME_HEADER_SIZE);
+    big[22] = (uint8_t)(SWEEP_FRAME_MAX_POINTS + 1);
+    big[23] = (uint8_t)((SWEEP_FRAME_MAX_POINTS + 1) >> 8);
+    expect(!sweep_frame_decode(big, sizeof(big), &decoded), "count mayor que SWEEP_FRAME_MAX_POINTS");
+
+    expect(sweep_frame_decode(buf, len, &decoded), "la trama original sigue siendo válida");
+}
+
+static void check_freq_list(void) {
+    static const float freqs[] = { 100.0f, 125.98f, 158.42f, 1000.0f, 17837.16f };
+    static sweep_frame_t frame;
+    static sweep_frame_t decoded;
+    static uint8_t buf[SWEEP_FRAME_MAX_SIZE];
+    const uint16_t count = sizeof(freqs) / sizeof(freqs[0]);
+
+    printf("Trama con lista de frecuencias (grilla no uniforme)\n");
+    sweep_frame_begin(&frame, 7, 1000, freqs[0], 0.0f, 0);
+    for (uint16_t i = 0; i < count; i++) {
+        sweep_frame_add_at(&frame, freqs[i], -3.0f * i, -10.0f * i);
+    }
+
+    size_t len = sweep_frame_encode(&frame, buf, sizeof(buf));
+    expect(len == SWEEP_FRAME_SIZE_FREQS(count), "largo = encabezado + 8 bytes por punto");
+    expect((buf[3] & SWEEP_FRAME_FLAG_FREQS) != 0, "flag de lista de frecuencias");
+    expect(sweep_frame_decode(buf, len, &decoded), "decode");
+
+    bool same = decoded.header.count == count;
+    for (uint16_t i = 0; same && i < count; i++) {
+        same = sweep_frame_frequency_hz(&decoded, i) == freqs[i]
+            && value_matches(-3.0f * i, decoded.magnitude_cdb[i]);
+    }
+    expect(same, "frecuencias exactas y valores preservados");
+    expect(!sweep_frame_decode(buf, SWEEP_FRAME_SIZE(count), &decoded),
+           "sin la lista (largo de trama uniforme) se rechaza");
+}
+
+int main(void) {
+    check_golden();
+    check_roundtrip();
+    check_rejects();
+    check_freq_list();
+
+    // Referencia: un JSON {"freq":…,"mag":…,"phase":…} por punto
+    printf("\nBarrido de %d puntos: 1 trama de %d bytes (antes %d mensajes JSON)\n",
+           SWEEP_NUM_POINTS, SWEEP_FRAME_SIZE(SWEEP_NUM_POINTS), SWEEP_NUM_POINTS);
+
+    printf("\n%s (%d fallas)\n", failures ? "FALLA" : "OK", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,398 @@
+/**
+ * @file check_sweep_store.c
+ * @brief Verificación del almacén de barridos en flash (fra_check_sweep_store)
+ *
+ * Corre contra la flash simulada respaldada por un archivo temporal, así
+ * cada "reinicio" vuelve a abrir el archivo y reconstruye el log desde cero:
+ * - ida y vuelta: los barridos guardados se leen en orden y sin cambios;
+ * - persistencia: pendientes y confirmados sobreviven a un reinicio;
+ * - capacidad: con el almacén lleno se pierden los más antiguos, nunca los
+ *   más nuevos, y el orden se mantiene;
+ * - un registro que no entra en el buffer de lectura se descarta y no traba
+ *   a los siguientes;
+ * - desgaste: con reenvío inmediato todos los sectores se borran por igual;
+ * - cortes de energía: miles de cortes en puntos al azar de escrituras,
+ *   borrados y confirmaciones. Tras reiniciar, los pendientes son
+ *   exactamente los esperados (salvo la operación cortada, que puede estar
+ *   o no), en orden, íntegros, y el log sigue aceptando barridos;
+ * - reenvío por MQTT: con el broker caído los barridos van a la flash y al
+ *   reconectar mqtt_client_replay() los entrega en orden.
+ * Retorna distinto de cero ante cualquier discrepancia.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "hal.h"
+#include "hal_host.h"
+#include "mqtt_client.h"
+#include "publish_queue.h"
+#include "sweep_frame.h"
+#include "sweep_store.h"
+#include "check.h"
+
+#define CUT_ITERATIONS 3000
+#define CUT_MAX_OPS 30
+#define MODEL_MAX 512
+
+static char flash_path[] = "/tmp/fra_check_sweep_store_XXXXXX";
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/**
+ * @brief Barrido sintético cuyos puntos dependen de sweep_id
+ */
+static void make_sweep(sweep_frame_t *sweep, uint32_t sweep_id) {
+    sweep_frame_begin(sweep, sweep_id, sweep_id * 3500u, SWEEP_FREQ_MIN, FREQ_RESOLUTION, 0);
+    for (uint16_t i = 0; i < SWEEP_NUM_POINTS; i++) {
+        sweep_frame_add(sweep, -0.01f * (float)((sweep_id * 7u + i) % 6000u),
+                        0.01f * (float)((sweep_id * 13u + 3u * i) % 18000u) - 90.0f);
+    }
+}
+
+/**
+ * @brief Decodifica un payload guardado y verifica que sea el barrido
+ *        sweep_id completo, marcado como reenvío
+ */
+static bool payload_matches(const uint8_t *payload, uint16_t len, uint32_t *sweep_id) {
+    static sweep_frame_t got;
+    static sweep_frame_t want;
+
+    if (!sweep_frame_decode(payload, len, &got)) {
+        return false;
+    }
+    *sweep_id = got.header.sweep_id;
+    make_sweep(&want, got.header.sweep_id);
+    return got.header.count == SWEEP_NUM_POINTS
+        && got.header.flags == (SWEEP_FRAME_FLAG_REPLAY | SWEEP_FRAME_FLAG_LAST)
+        && got.header.timestamp_ms == want.header.timestamp_ms
+        && memcmp(got.magnitude_cdb, want.magnitude_cdb, sizeof(want.magnitude_cdb)) == 0
+        && memcmp(got.phase_cdeg, want.phase_cdeg, sizeof(want.phase_cdeg)) == 0;
+}
+
+/**
+ * @brief Reinicio: vuelve a abrir el archivo y reconstruye el log
+ */
+static bool reboot(void) {
+    return hal_host_flash_open(flash_path) && sweep_store_init();
+}
+
+/**
+ * @brief Arranca con la flash borrada
+ */
+static bool fresh(void) {
+    if (truncate(flash_path, 0) != 0) {
+        return false;
+    }
+    return reboot();
+}
+
+static bool append_id(uint32_t sweep_id) {
+    static sweep_frame_t sweep;
+    make_sweep(&sweep, sweep_id);
+    return sweep_store_append(&sweep);
+}
+
+/**
+ * @brief Lee el pendiente más antiguo y lo confirma
+ *
+ * @return false si no hay pendientes o el payload no es válido
+ */
+static bool pop_oldest(uint32_t *sweep_id, bool *intact) {
+    static uint8_t payload[SWEEP_STORE_PAYLOAD_MAX];
+    uint32_t record;
+
+    uint16_t len = sweep_store_read_oldest(payload, sizeof(payload), &record);
+    if (len == 0) {
+        return false;
+    }
+    *intact = payload_matches(payload, len, sweep_id);
+    return sweep_store_ack(record);
+}
+
+static void check_round_trip(void) {
+    printf("Ida y vuelta y persistencia\n");
+
+    expect(fresh() && sweep_store_pending() == 0, "flash borrada: sin pendientes");
+
+    bool ok = true;
+    for (uint32_t id = 1; id <= 10; id++) {
+        ok &= append_id(id);
+    }
+    expect(ok && sweep_store_pending() == 10, "10 barridos guardados");
+
+    bool ordered = true;
+    bool intact_all = true;
+    for (uint32_t want = 1; want <= 4; want++) {
+        uint32_t id = 0;
+        bool intact = false;
+        ordered &= pop_oldest(&id, &intact) && id == want;
+        intact_all &= intact;
+    }
+    expect(ordered && intact_all, "se leen en orden, íntegros y marcados como reenvío");
+
+    expect(reboot() && sweep_store_pending() == 6, "tras reiniciar siguen 6 pendientes");
+    uint32_t id = 0;
+    bool intact = false;
+    expect(pop_oldest(&id, &intact) && id == 5 && intact,
+           "el más antiguo tras reiniciar es el 5 (los confirmados no vuelven)");
+    expect(append_id(11) && sweep_store_pending() == 6, "el log sigue aceptando barridos");
+
+    uint32_t last = 0;
+    while (pop_oldest(&id, &intact)) {
+        last = id;
+    }
+    expect(last == 11 && sweep_store_pending() == 0, "el agregado tras reiniciar sale último");
+}
+
+static void check_capacity(void) {
+    printf("Capacidad\n");
+
+    expect(fresh(), "flash borrada");
+    const uint32_t total = 100;
+    for (uint32_t id = 1; id <= total; id++) {
+        append_id(id);
+    }
+
+    sweep_store_stats_t stats;
+    sweep_store_get_stats(&stats);
+    printf("  %lu pendientes de %lu guardados, %lu perdidos\n", (unsigned long)stats.pending,
+           (unsigned long)stats.appended, (unsigned long)stats.overwritten);
+    expect(stats.pending + stats.overwritten == total && stats.overwritten > 0,
+           "guardados = pendientes + perdidos");
+
+    uint32_t expected = total - stats.pending + 1;
+    bool ordered = true;
+    uint32_t id;
+    bool intact;
+    while (pop_oldest(&id, &intact)) {
+        ordered &= intact && id == expected;
+        expected++;
+    }
+    expect(ordered && expected == total + 1, "se conservan los más nuevos, en orden");
+}
+
+static void check_oversize(void) {
+    printf("Registro más grande que el buffer\n");
+
+    expect(fresh() && append_id(1) && append_id(2), "2 barridos guardados");
+    uint8_t small[16];
+    uint32_t record = 0;
+    expect(sweep_store_read_oldest(small, sizeof(small), &record) == 0 && sweep_store_pending() == 1,
+           "el que no entra se descarta");
+    uint32_t id = 0;
+    bool intact = false;
+    expect(pop_oldest(&id, &intact) && id == 2 && intact, "el siguiente se lee igual");
+}
+
+static void check_wear(void) {
+    printf("Desgaste\n");
+
+    expect(fresh(), "flash borrada");
+    uint32_t before[SWEEP_STORE_SECTORS];
+    for (uint32_t s = 0; s < SWEEP_STORE_SECTORS; s++) {
+        before[s] = hal_host_flash_erase_count(s);
+    }
+
+    uint32_t id;
+    bool intact;
+    for (uint32_t n = 1; n <= 2000; n++) {
+        append_id(n);
+        // Un reenvío atrasado cada tanto deja sectores con pendientes
+        if (n % 7 != 0) {
+            while (sweep_store_pending() > 2 && pop_oldest(&id, &intact)) {
+            }
+        }
+    }
+
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    for (uint32_t s = 0; s < SWEEP_STORE_SECTORS; s++) {
+        uint32_t erases = hal_host_flash_erase_count(s) - before[s];
+        min = erases < min ? erases : min;
+        max = erases > max ? erases : max;
+    }
+    printf("  borrados por sector tras 2000 barridos: mín %lu, máx %lu\n",
+           (unsigned long)min, (unsigned long)max);
+    expect(min > 0 && max - min <= 1, "todos los sectores se borran por igual (±1)");
+}
+
+/**
+ * @brief Una iteración de corte: historia previa al azar, corte durante
+ *        una secuencia de operaciones, reinicio y comparación con el modelo
+ */
+static bool cut_iteration(uint32_t *next_id, uint32_t *torn_seen) {
+    static uint32_t model[MODEL_MAX];
+    uint32_t model_head = 0;
+    uint32_t model_count = 0;
+
+    if (!fresh()) {
+        return false;
+    }
+
+    // Historia: sectores ya rotados, algunos pendientes al final
+    uint32_t history = rng_next() % 150;
+    uint32_t keep = rng_next() % 20;
+    uint32_t id;
+    bool intact;
+    for (uint32_t n = 0; n < history; n++) {
+        uint32_t sweep_id = (*next_id)++;
+        if (!append_id(sweep_id)) {
+            return false;
+        }
+        model[model_count++ % MODEL_MAX] = sweep_id;
+        while (sweep_store_pending() > keep) {
+            if (!pop_oldest(&id, &intact) || id != model[model_head++ % MODEL_MAX]) {
+                return false;
+            }
+        }
+    }
+
+    // Corte en algún punto de las próximas operaciones
+    hal_host_flash_power_cut(rng_next() % 9000);
+    int32_t maybe_added = -1;       // Append cortado: puede estar al final
+    bool maybe_acked = false;       // Ack cortado: el más antiguo puede faltar
+    for (uint32_t op = 0; op < CUT_MAX_OPS; op++) {
+        if (model_count - model_head > 0 && rng_next() % 10 < 3) {
+            if (!pop_oldest(&id, &intact)) {
+                maybe_acked = true;
+                break;
+            }
+            model_head++;
+        } else {
+            uint32_t sweep_id = (*next_id)++;
+            if (!append_id(sweep_id)) {
+                maybe_added = (int32_t)sweep_id;
+                break;
+            }
+            model[model_count++ % MODEL_MAX] = sweep_id;
+        }
+    }
+
+    if (!reboot()) {
+        return false;
+    }
+    sweep_store_stats_t stats;
+    sweep_store_get_stats(&stats);
+    *torn_seen += stats.torn;
+
+    // Pendientes tras el reinicio contra el modelo
+    if (maybe_acked && sweep_store_pending() == model_count - model_head - 1) {
+        model_head++;
+    }
+    while (model_head < model_count) {
+        if (!pop_oldest(&id, &intact) || !intact || id != model[model_head++ % MODEL_MAX]) {
+            return false;
+        }
+    }
+    if (pop_oldest(&id, &intact) && !(intact && (int32_t)id == maybe_added)) {
+        return false;
+    }
+    if (sweep_store_pending() != 0) {
+        return false;
+    }
+
+    // El log sigue vivo
+    uint32_t sweep_id = (*next_id)++;
+    return append_id(sweep_id) && pop_oldest(&id, &intact) && intact && id == sweep_id;
+}
+
+static void check_power_cuts(void) {
+    printf("Cortes de energía (%d iteraciones)\n", CUT_ITERATIONS);
+
+    uint32_t next_id = 1;
+    uint32_t torn = 0;
+    uint32_t failed = 0;
+    uint32_t first_failure = 0;
+    for (uint32_t i = 0; i < CUT_ITERATIONS; i++) {
+        if (!cut_iteration(&next_id, &torn)) {
+            if (failed++ == 0) {
+                first_failure = i;
+            }
+        }
+    }
+
+    printf("  %lu registros cortados descartados al reiniciar\n", (unsigned long)torn);
+    if (failed > 0) {
+        printf("  primera falla en la iteración %lu\n", (unsigned long)first_failure);
+    }
+    expect(failed == 0, "tras cada corte: pendientes exactos, en orden e íntegros");
+    expect(torn > 0, "hubo cortes a mitad de registro");
+}
+
+static void check_mqtt_replay(void) {
+    printf("Reenvío por MQTT\n");
+
+    mqtt_config_t cfg = {
+        .broker_addr = MQTT_BROKER_ADDR,
+        .broker_port = MQTT_BROKER_PORT,
+        .client_id = MQTT_CLIENT_ID,
+        .topic = MQTT_TOPIC_MEASUREMENTS
+    };
+    expect(fresh() && mqtt_init(&cfg), "almacén y cliente MQTT listos");
+
+    fra_mqtt_disconnect();
+    for (uint32_t id = 1; id <= 12; id++) {
+        append_id(id);
+    }
+    mqtt_client_replay();
+    mqtt_client_poll(UINT32_MAX);
+    expect(sweep_store_pending() == 12, "sin broker no se reenvía nada");
+
+    // Se simula un reinicio a mitad del corte de red
+    expect(reboot() && sweep_store_pending() == 12, "los pendientes sobreviven al reinicio");
+
+    mqtt_reconnect();
+    sweep_store_stats_t before;
+    sweep_store_get_stats(&before);
+    uint32_t rounds = 0;
+    bool ordered = true;
+    uint32_t expected = 1;
+    while (mqtt_client_replay() > 0 && rounds++ < 100) {
+        // Lo que está en vuelo es el más antiguo pendiente
+        publish_msg_t *msg = publish_queue_acquire();
+        uint32_t id = 0;
+        if (!msg || !payload_matches(msg->payload, msg->len, &id) || id != expected) {
+            ordered = false;
+        }
+        expected++;
+        if (msg) {
+            publish_queue_release(msg, true);
+        }
+    }
+
+    sweep_store_stats_t after;
+    sweep_store_get_stats(&after);
+    expect(ordered && expected == 13, "al reconectar se entregan los 12 en orden");
+    expect(after.pending == 0 && after.acked - before.acked == 12,
+           "cada entrega queda confirmada en flash");
+}
+
+int main(void) {
+    int fd = mkstemp(flash_path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return EXIT_FAILURE;
+    }
+    close(fd);
+
+    check_round_trip();
+    check_capacity();
+    check_oversize();
+    check_wear();
+    check_power_cuts();
+    check_mqtt_replay();
+
+    unlink(flash_path);
+    printf("\n%s (%d fallas)\n", failures ? "FALLA" : "OK", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file check_trace.c
+ * @brief Verificación de la traza de etapas (fra_check_trace)
+ *
+ * Comprueba:
+ * - percentiles por rango más cercano sobre duraciones conocidas;
+ * - que el anillo lleno cuente los eventos sobrescritos y reporte solo
+ *   los últimos TRACE_RING_EVENTS;
+ * - que dos escritores concurrentes (el "core 1" de la HAL y el hilo
+ *   principal) no pierdan ni mezclen eventos;
+ * - que trace_begin()/trace_end() midan una espera conocida;
+ * - el JSON del reporte, y que un buffer chico dé 0.
+ * Retorna distinto de cero ante cualquier discrepancia.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "config.h"
+#include "hal.h"
+#include "trace.h"
+#include "check.h"
+
+#if !TRACE_ENABLED
+#error "fra_check_trace necesita TRACE_ENABLED"
+#endif
+
+// Eventos por escritor en la prueba concurrente (entran los dos sin
+// sobrescribir)
+#define CONCURRENT_EVENTS (TRACE_RING_EVENTS / 2)
+
+// Espera medida con trace_begin()/trace_end()
+#define SLEEP_US 2000
+
+static bool near(float value, float expected) {
+    return fabsf(value - expected) <= 1e-3f * fmaxf(1.0f, expected);
+}
+
+static void check_percentiles(void) {
+    printf("Percentiles\n");
+    uint32_t per_us = hal_cycle_counter_per_us();
+    trace_reset();
+
+    // 1..100 µs en orden mezclado, y una sola muestra en otra etapa
+    for (uint32_t i = 0; i < 100; i++) {
+        uint32_t us = (i * 37u) % 100u + 1u;
+        trace_record(TRACE_GOERTZEL, us * per_us);
+    }
+    trace_record(TRACE_SETTLE, 7u * per_us);
+
+    trace_report_t report;
+    trace_report(&report);
+    const trace_stage_stats_t *g = &report.stages[TRACE_GOERTZEL];
+    const trace_stage_stats_t *s = &report.stages[TRACE_SETTLE];
+    expect(report.events == 101 && report.overwritten == 0, "101 eventos, ninguno sobrescrito");
+    expect(g->count == 100 && near(g->p50_us, 50.0f) && near(g->p95_us, 95.0f)
+           && near(g->max_us, 100.0f), "p50 = 50, p95 = 95, máx = 100 sobre 1..100");
+    expect(s->count == 1 && near(s->p50_us, 7.0f) && near(s->p95_us, 7.0f) && near(s->max_us, 7.0f),
+           "una sola muestra: p50 = p95 = máx");
+    expect(report.stages[TRACE_PUBLISH].count == 0, "etapa sin eventos");
+}
+
+static void check_wrap(void) {
+    printf("Anillo lleno\n");
+    uint32_t per_us = hal_cycle_counter_per_us();
+    trace_reset();
+
+    // Los 10 primeros (1000 µs) se pisan; quedan TRACE_RING_EVENTS de 1 µs
+    for (uint32_t i = 0; i < 10; i++) {
+        trace_record(TRACE_PUBLISH, 1000u * per_us);
+    }
+    for (uint32_t i = 0; i < TRACE_RING_EVENTS; i++) {
+        trace_record(TRACE_PUBLISH, per_us);
+    }
+
+    trace_report_t report;
+    trace_report(&report);
+    expect(report.events == TRACE_RING_EVENTS && report.overwritten == 10,
+           "cuenta los 10 sobrescritos");
+    expect(near(report.stages[TRACE_PUBLISH].max_us, 1.0f), "solo quedan los más recientes");
+}
+
+static void concurrent_writer(void) {
+    for (uint32_t i = 0; i < CONCURRENT_EVENTS; i++) {
+        trace_record(TRACE_GOERTZEL, 3u);
+    }
+}
+
+static void check_concurrent(void) {
+    printf("Dos escritores\n");
+    trace_reset();
+
+    if (!hal_core1_launch(concurrent_writer)) {
+        expect(false, "lanzar el segundo escritor");
+        return;
+    }
+    for (uint32_t i = 0; i < CONCURRENT_EVENTS; i++) {
+        trace_record(TRACE_ADC_CAPTURE, 5u);
+    }
+    hal_core1_join();
+
+    trace_report_t report;
+    trace_report(&report);
+    uint32_t per_us = hal_cycle_counter_per_us();
+    expect(report.events == 2 * CONCURRENT_EVENTS && report.overwritten == 0,
+           "ningún evento perdido");
+    expect(report.stages[TRACE_GOERTZEL].count == CONCURRENT_EVENTS
+           && report.stages[TRACE_ADC_CAPTURE].count == CONCURRENT_EVENTS,
+           "cada escritor conserva sus eventos");
+    expect(near(report.stages[TRACE_GOERTZEL].max_us, 3.0f / per_us)
+           && near(report.stages[TRACE_ADC_CAPTURE].max_us, 5.0f / per_us),
+           "sin eventos mezclados");
+}
+
+static void check_timing(void) {
+    printf("Medición\n");
+    trace_reset();
+
+    struct timespec ts = { 0, SLEEP_US * 1000L };
+    uint32_t t0 = trace_begin(TRACE_SETTLE);
+    nanosleep(&ts, NULL);
+    trace_end(TRACE_SETTLE, t0);
+
+    trace_report_t report;
+    trace_report(&report);
+    float us = report.stages[TRACE_SETTLE].max_us;
+    printf("  espera de %d us medida en %.1f us\n", SLEEP_US, us);
+    expect(us >= SLEEP_US && us < 50.0f * SLEEP_US, "la duración cubre la espera");
+}
+
+static void check_json(void) {
+    printf("JSON\n");
+    uint32_t per_us = hal_cycle_counter_per_us();
+    trace_reset();
+    trace_record(TRACE_DDS_WRITE, 12u * per_us);
+    trace_record(TRACE_VALIDATE, 3u * per_us);
+
+    trace_report_t report;
+    trace_report(&report);
+
+    char buf[TRACE_JSON_MAX];
+    size_t len = trace_format_json(&report, buf, sizeof(buf));
+    const char *expected = "{\"events\":2,\"overwritten\":0,\"stages\":["
+        "{\"stage\":\"dds_write\",\"n\":1,\"p50\":12.0,\"p95\":12.0,\"max\":12.0},"
+        "{\"stage\":\"validate\",\"n\":1,\"p50\":3.0,\"p95\":3.0,\"max\":3.0}]}";
+    expect(len == strlen(expected) && strcmp(buf, expected) == 0, "payload exacto");
+    if (strcmp(buf, expected) != 0) {
+        printf("  %s\n", buf);
+    }
+    expect(trace_format_json(&report, buf, 32) == 0, "buffer chico: 0");
+
+    // El peor caso (todas las etapas, valores grandes) entra en TRACE_JSON_MAX
+    for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+        report.stages[s] = (trace_stage_stats_t){ UINT32_MAX, 4e9f, 4e9f, 4e9f };
+    }
+    report.events = UINT32_MAX;
+    report.overwritten = UINT32_MAX;
+    expect(trace_format_json(&report, buf, sizeof(buf)) > 0, "peor caso dentro de TRACE_JSON_MAX");
+}
+
+int main(void) {
+    trace_init();
+
+    check_percentiles();
+    check_wrap();
+    check_concurrent();
+    check_timing();
+    check_json();
+
+    printf("\n%s (%d fallas)\n", failures ? "FALLA" : "OK", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,557 @@
+/**
+ * @file hal_host.c
+ * @brief Implementación de la HAL para el simulador nativo
+ *
+ * El reloj es virtual: hal_sleep_*() y las esperas de captura ADC lo
+ * avanzan sin dormir, así un barrido de 200 puntos con sus esperas de
+ * estabilización corre en el tiempo de CPU que consume el DSP. hal_time_*() reporta ese
+ * reloj, de modo que las estadísticas del barrido equivalen a las del
+ * firmware. El SPI alimenta al modelo del AD9833 y el ADC sintetiza la
+ * respuesta del DUT simulado.
+ *
+ * La captura continua corre en un hilo propio que hace de motor DMA: llena
+ * los bloques a ritmo real (escalable) y llama al callback como lo haría
+ * la IRQ, de modo que el traspaso de buffers se ejercita con concurrencia
+ * real y puede revisarse con ThreadSanitizer. El core 1 también es un hilo.
+ *
+ * La flash es un arreglo en memoria, opcionalmente respaldado por un
+ * archivo, con semántica NOR (programar solo baja bits) y cortes de energía
+ * programables para probar la recuperación del almacén de barridos.
+ */
+
+#include "hal.h"
+#include "hal_host.h"
+#include "config.h"
+#include "sim_dds.h"
+#include "sim_dut.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+static _Atomic uint64_t virtual_time_us = 0;
+static bool spi_ready = false;
+
+// Captura puntual en curso (reloj virtual). Una captura encadenada con
+// hal_adc_continue() arranca entre dos µs: capture_start_frac/rate µs
+// después de capture_start_us
+static uint64_t capture_start_us = 0;
+static uint32_t capture_start_frac = 0;
+static uint32_t capture_len = 0;
+
+// El núcleo acaba de despertar de hal_wait_event_until_us(): la consulta
+// siguiente del DMA no cuesta tiempo (la IRQ lo despertó justo a tiempo)
+static bool woke_from_wait = false;
+
+// Envío SPI asíncrono: fin en el reloj virtual y aviso pendiente
+static uint64_t spi_busy_until_us = 0;
+static hal_spi_done_cb_t spi_done_cb = NULL;
+static void *spi_done_ctx = NULL;
+
+// Duración de una palabra SPI de 16 bits a 2 MHz (AD9833_SPI_BAUDRATE)
+#define HOST_SPI_WORD_US 8
+
+// Muestras que avanza el DMA simulado por cada consulta de progreso
+#define HOST_ADC_POLL_SAMPLES 16
+
+// Conversiones que retiene la FIFO del ADC mientras el DMA no está armado
+#define HOST_ADC_FIFO_DEPTH 4
+
+// Exclusión entre el "núcleo" y el hilo DMA (sección crítica de la HAL)
+static pthread_mutex_t crit_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Protege el modelo DDS/DUT, que leen ambos hilos
+static pthread_mutex_t sim_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Captura continua
+static pthread_t stream_thread;
+static atomic_bool stream_running = false;
+static uint16_t *stream_target[2];
+static uint32_t stream_len = 0;
+static hal_adc_block_cb_t stream_cb = NULL;
+static double stream_speedup = 1.0;
+
+// Tiempos típicos de una flash QSPI (W25Q): borrado de sector y página
+#define HOST_FLASH_ERASE_US 45000
+#define HOST_FLASH_PAGE_US 700
+
+// Flash simulada: imagen, archivo de respaldo y corte de energía pendiente
+static uint8_t flash_image[HAL_FLASH_REGION_SIZE];
+static bool flash_loaded = false;
+static int flash_fd = -1;
+static bool flash_cut_armed = false;
+static uint32_t flash_cut_budget = 0;
+static bool flash_dead = false;
+static uint32_t flash_erase_counts[SWEEP_STORE_SECTORS];
+
+// "Core 1": un hilo por trabajo lanzado
+static pthread_t core1_thread;
+static bool core1_running = false;
+static void (*core1_entry)(void) = NULL;
+
+/**
+ * @brief Avanza el reloj virtual hasta t_us si todavía no llegó
+ */
+static void hal_host_advance_to(uint64_t t_us) {
+    uint64_t now = atomic_load(&virtual_time_us);
+    while (now < t_us && !atomic_compare_exchange_weak(&virtual_time_us, &now, t_us)) {
+    }
+}
+
+static uint64_t hal_host_window_us(uint32_t num_samples) {
+    return (uint64_t)((double)num_samples * 1e6 / (double)HAL_ADC_CONVERSION_RATE + 0.5);
+}
+
+// ============================================================================
+// TIEMPO
+// ============================================================================
+
+uint32_t hal_time_ms(void) {
+    return (uint32_t)(atomic_load(&virtual_time_us) / 1000u);
+}
+
+uint64_t hal_time_us(void) {
+    return atomic_load(&virtual_time_us);
+}
+
+void hal_sleep_ms(uint32_t ms) {
+    atomic_fetch_add(&virtual_time_us, (uint64_t)ms * 1000u);
+}
+
+void hal_sleep_us(uint64_t us) {
+    atomic_fetch_add(&virtual_time_us, us);
+}
+
+void hal_wait_event_until_us(uint64_t deadline_us) {
+    // Nada despierta antes al núcleo simulado: saltar al instante pedido
+    if (deadline_us > atomic_load(&virtual_time_us)) {
+        hal_host_advance_to(deadline_us);
+        woke_from_wait = true;
+    }
+}
+
+// ============================================================================
+// CONTADOR DE CICLOS (TRAZA)
+// ============================================================================
+
+void hal_cycle_counter_init(void) {
+}
+
+uint32_t hal_cycle_counter(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+uint32_t hal_cycle_counter_per_us(void) {
+    return 1000u;
+}
+
+// ============================================================================
+// SECCIÓN CRÍTICA
+// ============================================================================
+
+void hal_critical_enter(void) {
+    pthread_mutex_lock(&crit_mutex);
+}
+
+void hal_critical_exit(void) {
+    pthread_mutex_unlock(&crit_mutex);
+}
+
+// ============================================================================
+// SEGUNDO NÚCLEO
+// ============================================================================
+
+static void *hal_host_core1_main(void *arg) {
+    (void)arg;
+    core1_entry();
+    return NULL;
+}
+
+bool hal_core1_launch(void (*entry)(void)) {
+    if (core1_running) {
+        return false;
+    }
+    core1_entry = entry;
+    if (pthread_create(&core1_thread, NULL, hal_host_core1_main, NULL) != 0) {
+        return false;
+    }
+    core1_running = true;
+    return true;
+}
+
+void hal_core1_join(void) {
+    if (core1_running) {
+        pthread_join(core1_thread, NULL);
+        core1_running = false;
+    }
+}
+
+void hal_cpu_relax(void) {
+    sched_yield();
+}
+
+// ============================================================================
+// GPIO DE DEBUG
+// ============================================================================
+
+void hal_debug_pin_put(uint32_t pin, bool value) {
+    (void)pin;
+    (void)value;
+}
+
+// ============================================================================
+// SPI (AD9833)
+// ============================================================================
+
+bool hal_spi_init(void) {
+    pthread_mutex_lock(&sim_mutex);
+    sim_dds_reset();
+    pthread_mutex_unlock(&sim_mutex);
+    spi_ready = true;
+    return true;
+}
+
+/**
+ * @brief Entrega el aviso de fin del envío asíncrono si ya pasó su instante
+ */
+static void hal_host_spi_poll(void) {
+    if (spi_done_cb && atomic_load(&virtual_time_us) >= spi_busy_until_us) {
+        hal_spi_done_cb_t cb = spi_done_cb;
+        spi_done_cb = NULL;
+        cb(spi_done_ctx);
+    }
+}
+
+void hal_spi_write16(uint16_t word) {
+    hal_spi_wait();
+    if (spi_ready) {
+        pthread_mutex_lock(&sim_mutex);
+        sim_dds_write(word, atomic_load(&virtual_time_us));
+        pthread_mutex_unlock(&sim_mutex);
+        atomic_fetch_add(&virtual_time_us, HOST_SPI_WORD_US);
+    }
+}
+
+bool hal_spi_write16_async(const uint16_t *words, uint32_t count,
+                           hal_spi_done_cb_t done, void *ctx) {
+    hal_host_spi_poll();
+    uint64_t now = atomic_load(&virtual_time_us);
+    if (now < spi_busy_until_us) {
+        return false;
+    }
+    
+    // Las palabras llegan al modelo en el instante de arranque; el bus queda
+    // ocupado lo que tardaría el DMA en sacarlas, sin detener el reloj
+    if (spi_ready) {
+        pthread_mutex_lock(&sim_mutex);
+        for (uint32_t i = 0; i < count; i++) {
+            sim_dds_write(words[i], now);
+        }
+        pthread_mutex_unlock(&sim_mutex);
+    }
+    
+    spi_busy_until_us = now + (uint64_t)count * HOST_SPI_WORD_US;
+    spi_done_cb = done;
+    spi_done_ctx = ctx;
+    hal_host_spi_poll();
+    return true;
+}
+
+bool hal_spi_is_busy(void) {
+    hal_host_spi_poll();
+    return atomic_load(&virtual_time_us) < spi_busy_until_us;
+}
+
+void hal_spi_wait(void) {
+    hal_host_advance_to(spi_busy_until_us);
+    hal_host_spi_poll();
+}
+
+// ============================================================================
+// ADC + DMA
+// ============================================================================
+
+bool hal_adc_init(void) {
+    return true;
+}
+
+void hal_adc_start(uint16_t *dst, uint32_t num_samples) {
+    // La captura se sintetiza completa de una vez, pero las muestras se
+    // "entregan" según el reloj virtual: el llamador las ve llegar a medida
+    // que consulta el progreso o espera, igual que con el DMA real
+    uint64_t now = atomic_load(&virtual_time_us);
+    
+    pthread_mutex_lock(&sim_mutex);
+    sim_dut_capture(dst, num_samples, now, 0.0);
+    pthread_mutex_unlock(&sim_mutex);
+    
+    capture_start_us = now;
+    capture_start_frac = 0;
+    capture_len = num_samples;
+}
+
+/**
+ * @brief Muestras de la captura en curso ya "escritas" según el reloj virtual
+ */
+static uint32_t hal_host_samples_at(uint64_t t_us) {
+    uint64_t elapsed = (t_us - capture_start_us) * (uint64_t)HAL_ADC_CONVERSION_RATE;
+    if (elapsed < capture_start_frac) {
+        return 0;
+    }
+    uint64_t n = (elapsed - capture_start_frac) / 1000000u;
+    return (n < capture_len) ? (uint32_t)n : capture_len;
+}
+
+/**
+ * @brief Instante en que el DMA completa la muestra num_samples
+ */
+static uint64_t hal_host_sample_time(uint32_t num_samples) {
+    uint64_t rate = (uint64_t)HAL_ADC_CONVERSION_RATE;
+    return capture_start_us + ((uint64_t)num_samples * 1000000u + capture_start_frac + rate - 1) / rate;
+}
+
+bool hal_adc_continue(uint16_t *dst, uint32_t num_samples) {
+    // Rearme tardío: la FIFO se llenó y se perdieron conversiones
+    if (atomic_load(&virtual_time_us) > hal_host_sample_time(capture_len + HOST_ADC_FIFO_DEPTH)) {
+        return false;
+    }
+    
+    // La primera conversión es la siguiente a la última de la captura
+    // anterior, en su instante exacto (la fracción de µs mantiene la fase)
+    uint64_t rate = (uint64_t)HAL_ADC_CONVERSION_RATE;
+    uint64_t offset = (uint64_t)capture_len * 1000000u + capture_start_frac;
+    capture_start_us += offset / rate;
+    capture_start_frac = (uint32_t)(offset % rate);
+    capture_len = num_samples;
+    
+    pthread_mutex_lock(&sim_mutex);
+    sim_dut_capture(dst, num_samples, capture_start_us, (double)capture_start_frac / (double)rate);
+    pthread_mutex_unlock(&sim_mutex);
+    return true;
+}
+
+bool hal_adc_is_busy(void) {
+    return hal_adc_samples_done() < capture_len;
+}
+
+uint32_t hal_adc_samples_done(void) {
+    // Consultar cuesta tiempo: cada llamada deja correr el DMA unas muestras
+    // más, así los lazos de espera activa avanzan el reloj virtual
+    uint32_t done = hal_host_samples_at(atomic_load(&virtual_time_us));
+    bool woke = woke_from_wait;
+    woke_from_wait = false;
+    if (done < capture_len && !woke) {
+        uint32_t next = done + HOST_ADC_POLL_SAMPLES;
+        hal_host_advance_to(hal_host_sample_time(next < capture_len ? next : capture_len));
+        done = hal_host_samples_at(atomic_load(&virtual_time_us));
+    }
+    return done;
+}
+
+void hal_adc_wait(void) {
+    hal_host_advance_to(hal_host_sample_time(capture_len));
+}
+
+void hal_adc_abort(void) {
+    capture_len = hal_host_samples_at(atomic_load(&virtual_time_us));
+}
+
+/**
+ * @brief Hilo que emula los dos canales DMA encadenados
+ */
+static void *hal_host_stream_main(void *arg) {
+    (void)arg;
+    uint64_t block_us = hal_host_window_us(stream_len);
+    uint64_t t_block = atomic_load(&virtual_time_us);
+    int chan = 0;
+    
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    
+    while (atomic_load(&stream_running)) {
+        // Ritmo real escalado: un bloque cada block_us / speedup
+        if (stream_speedup > 0.0) {
+            uint64_t period_ns = (uint64_t)((double)block_us * 1000.0 / stream_speedup);
+            next.tv_nsec += (long)(period_ns % 1000000000u);
+            next.tv_sec += (time_t)(period_ns / 1000000000u);
+            if (next.tv_nsec >= 1000000000L) {
+                next.tv_nsec -= 1000000000L;
+                next.tv_sec++;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        }
+        
+        pthread_mutex_lock(&sim_mutex);
+        sim_dut_capture(stream_target[chan], stream_len, t_block, 0.0);
+        pthread_mutex_unlock(&sim_mutex);
+        
+        t_block += block_us;
+        hal_host_advance_to(t_block);
+        
+        // Fin de bloque: el otro canal ya arrancó (encadenado); la "IRQ"
+        // rearma el que terminó
+        stream_target[chan] = stream_cb(stream_target[chan]);
+        chan ^= 1;
+    }
+    
+    return NULL;
+}
+
+bool hal_adc_stream_start(uint16_t *first, uint16_t *second, uint32_t num_samples,
+                          hal_adc_block_cb_t on_block) {
+    if (atomic_load(&stream_running)) {
+        return false;
+    }
+    
+    stream_target[0] = first;
+    stream_target[1] = second;
+    stream_len = num_samples;
+    stream_cb = on_block;
+    
+    atomic_store(&stream_running, true);
+    if (pthread_create(&stream_thread, NULL, hal_host_stream_main, NULL) != 0) {
+        atomic_store(&stream_running, false);
+        return false;
+    }
+    return true;
+}
+
+void hal_adc_stream_stop(void) {
+    if (!atomic_load(&stream_running)) {
+        return;
+    }
+    atomic_store(&stream_running, false);
+    pthread_join(stream_thread, NULL);
+    stream_cb = NULL;
+}
+
+// ============================================================================
+// FLASH (ALMACÉN DE BARRIDOS)
+// ============================================================================
+
+static void hal_host_flash_load(void) {
+    if (!flash_loaded) {
+        memset(flash_image, 0xFF, sizeof(flash_image));
+        flash_loaded = true;
+    }
+}
+
+/**
+ * @brief Aplica un borrado o una programación byte a byte, respetando el
+ *        corte de energía, y la persiste en el archivo
+ *
+ * @param src Datos a programar, NULL para borrar
+ * @return true si se aplicaron los len bytes
+ */
+static bool hal_host_flash_apply(uint32_t offset, const uint8_t *src, uint32_t len) {
+    if (flash_dead) {
+        return false;
+    }
+    hal_host_flash_load();
+
+    uint32_t done = len;
+    if (flash_cut_armed && flash_cut_budget < len) {
+        done = flash_cut_budget;
+        flash_dead = true;
+    }
+    flash_cut_budget -= flash_cut_armed ? done : 0;
+
+    for (uint32_t i = 0; i < done; i++) {
+        flash_image[offset + i] = src ? (flash_image[offset + i] & src[i]) : 0xFF;
+    }
+    if (flash_fd >= 0 && done > 0) {
+        if (pwrite(flash_fd, &flash_image[offset], done, offset) != (ssize_t)done) {
+            return false;
+        }
+    }
+    return !flash_dead;
+}
+
+bool hal_flash_read(uint32_t offset, void *dst, uint32_t len) {
+    if (offset > HAL_FLASH_REGION_SIZE || len > HAL_FLASH_REGION_SIZE - offset) {
+        return false;
+    }
+    hal_host_flash_load();
+    memcpy(dst, &flash_image[offset], len);
+    return true;
+}
+
+bool hal_flash_erase(uint32_t offset) {
+    if (offset % HAL_FLASH_SECTOR_SIZE != 0 || offset >= HAL_FLASH_REGION_SIZE) {
+        return false;
+    }
+    atomic_fetch_add(&virtual_time_us, HOST_FLASH_ERASE_US);
+    if (!flash_dead) {
+        flash_erase_counts[offset / HAL_FLASH_SECTOR_SIZE]++;
+    }
+    return hal_host_flash_apply(offset, NULL, HAL_FLASH_SECTOR_SIZE);
+}
+
+bool hal_flash_program(uint32_t offset, const void *src, uint32_t len) {
+    if (offset % HAL_FLASH_PAGE_SIZE != 0 || len % HAL_FLASH_PAGE_SIZE != 0
+        || offset > HAL_FLASH_REGION_SIZE || len > HAL_FLASH_REGION_SIZE - offset) {
+        return false;
+    }
+    atomic_fetch_add(&virtual_time_us, (uint64_t)(len / HAL_FLASH_PAGE_SIZE) * HOST_FLASH_PAGE_US);
+    return hal_host_flash_apply(offset, src, len);
+}
+
+// ============================================================================
+// EXTENSIONES DEL SIMULADOR
+// ============================================================================
+
+void hal_host_set_stream_speedup(double speedup) {
+    stream_speedup = speedup;
+}
+
+void hal_host_configure_dut(const sim_dut_config_t *cfg) {
+    pthread_mutex_lock(&sim_mutex);
+    sim_dut_configure(cfg);
+    pthread_mutex_unlock(&sim_mutex);
+}
+
+bool hal_host_flash_open(const char *path) {
+    if (flash_fd >= 0) {
+        close(flash_fd);
+        flash_fd = -1;
+    }
+    flash_dead = false;
+    flash_cut_armed = false;
+    memset(flash_image, 0xFF, sizeof(flash_image));
+    flash_loaded = true;
+
+    if (!path) {
+        return true;
+    }
+
+    flash_fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (flash_fd < 0) {
+        return false;
+    }
+    // Lo que falte del archivo se considera borrado
+    ssize_t n = pread(flash_fd, flash_image, sizeof(flash_image), 0);
+    if (n < (ssize_t)sizeof(flash_image)) {
+        uint32_t start = n > 0 ? (uint32_t)n : 0;
+        memset(&flash_image[start], 0xFF, sizeof(flash_image) - start);
+        if (pwrite(flash_fd, &flash_image[start], sizeof(flash_image) - start, start) < 0) {
+            close(flash_fd);
+            flash_fd = -1;
+            return false;
+        }
+    }
+    return true;
+}
+
+void hal_host_flash_power_cut(uint32_t budget_bytes) {
+    flash_cut_armed = true;
+    flash_cut_budget = budget_bytes;
+}
+
+uint32_t hal_host_flash_erase_count(uint32_t sector) {
+    return sector < SWEEP_STORE_SECTORS ? flash_erase_counts[sector] : 0;
+}
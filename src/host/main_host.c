@@ -0,0 +1,392 @@
+/**
+ * @file main_host.c
+ * @brief Punto de entrada del simulador nativo (fra_host_sim)
+ *
+ * Ejecuta el mismo código de barrido/Goertzel/MQTT del firmware contra la
+ * HAL simulada. Dos modos:
+ * - benchmark (por defecto): N barridos completos, reporta barridos/s y
+ *   tiempo de CPU por punto junto al tiempo equivalente en el firmware.
+ *   Con -P usa el barrido pipeline (captura y DSP en hilos separados) y
+ *   reporta además la profundidad de la cola entre núcleos. Con -o el
+ *   broker está caído durante los primeros barridos: se guardan en la
+ *   flash simulada (-S la respalda con un archivo) y se reenvían al volver.
+ * - verificación (-c): mide cada punto del plan y lo compara contra la
+ *   respuesta teórica del DUT; retorna error si excede la tolerancia. Con
+ *   dos canales compara H directamente contra la transferencia, lo que
+ *   incluye la corrección del desfase de muestreo entre canales.
+ * En ambos modos -g elige la grilla del plan (lineal o logarítmica). En el
+ * benchmark, -T imprime al final la traza de etapas del último barrido con
+ * el mismo reporte que el firmware envía por USB y MQTT (en el host, con
+ * tiempos reales medidos con clock_gettime).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "adc_dma.h"
+#include "ad9833.h"
+#include "goertzel.h"
+#include "hal_host.h"
+#include "mqtt_client.h"
+#include "sweep.h"
+#include "sweep_plan.h"
+#include "settle.h"
+#include "sim_dut.h"
+#include "sweep_store.h"
+#include "trace.h"
+
+// Tolerancias del modo verificación (checklist de docs/implementation_notes.md)
+#define CHECK_DEFAULT_MAG_TOL_PCT   1.0f
+#define CHECK_DEFAULT_PHASE_TOL_DEG 5.0f
+
+// Por debajo de esta |H| (-60 dB) el error relativo y la fase no tienen
+// referencia útil (fondo de un notch): el punto se lista pero no se evalúa
+#define CHECK_MIN_H 0.001f
+
+static double host_now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void print_usage(const char *prog) {
+    printf("Uso: %s [opciones]\n", prog);
+    printf("\n");
+    printf("Opciones:\n");
+    printf("  -n <barridos>  Número de barridos del benchmark (default 1000)\n");
+    printf("  -d <modelo>    DUT: flat | rc | hp | rlc | notch (default rc)\n");
+    printf("  -f <hz>        Frecuencia de corte/resonancia (default 1000)\n");
+    printf("  -q <Q>         Factor de calidad del RLC/notch (default 5)\n");
+    printf("  -a <amp>       Amplitud de pico, fracción de fondo de escala (default 0.4)\n");
+    printf("  -r <rms>       Ruido gaussiano, fracción de fondo de escala (default 0)\n");
+    printf("  -e <bits>      ENOB del ADC (default 12)\n");
+    printf("  -s <semilla>   Semilla del generador de ruido\n");
+    printf("  -k <kernel>    Kernel de Goertzel: float | fixed (default float)\n");
+    printf("  -P             Benchmark con el barrido pipeline de dos núcleos\n");
+    printf("  -o <barridos>  Broker caído durante los primeros barridos del benchmark\n");
+    printf("  -S <archivo>   Respaldar la flash del almacén de barridos con un archivo\n");
+    printf("  -g <grilla>    Grilla del barrido: lin | log (default config.h)\n");
+    printf("  -m <puntos>    Puntos por década de la grilla log (default %d)\n",
+           SWEEP_LOG_POINTS_PER_DECADE);
+    printf("  -w <dB>        SNR objetivo del plan, 0 = ventana más larga (default %.0f)\n",
+           SWEEP_PLAN_TARGET_SNR_DB);
+    printf("  -A <capturas>  Capturas por punto como máximo, con corte por error estándar\n");
+    printf("                 (default %d)\n", SWEEP_AVG_MAX_WINDOWS);
+    printf("  -T             Imprimir la traza de etapas del último barrido (p50/p95/máx)\n");
+    printf("  -c             Modo verificación contra la respuesta teórica\n");
+    printf("  -t <pct>       Tolerancia de magnitud en %% (default %.1f)\n", CHECK_DEFAULT_MAG_TOL_PCT);
+    printf("  -p <grados>    Tolerancia de fase (default %.1f)\n", CHECK_DEFAULT_PHASE_TOL_DEG);
+}
+
+static bool parse_dut_type(const char *name, sim_dut_type_t *type) {
+    if (strcmp(name, "flat") == 0) {
+        *type = SIM_DUT_FLAT;
+    } else if (strcmp(name, "rc") == 0) {
+        *type = SIM_DUT_RC_LOWPASS;
+    } else if (strcmp(name, "hp") == 0) {
+        *type = SIM_DUT_RC_HIGHPASS;
+    } else if (strcmp(name, "rlc") == 0) {
+        *type = SIM_DUT_RLC_BANDPASS;
+    } else if (strcmp(name, "notch") == 0) {
+        *type = SIM_DUT_NOTCH;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Modo verificación: un punto por frecuencia del plan
+ */
+static int run_check(const sim_dut_config_t *dut, float mag_tol_pct, float phase_tol_deg) {
+    float worst_mag_pct = 0.0f;
+    float worst_phase_deg = 0.0f;
+    float worst_mag_freq = 0.0f;
+    float worst_phase_freq = 0.0f;
+    uint32_t unsettled = 0;
+    uint32_t skipped = 0;
+    
+    printf("%10s %6s %12s %12s %10s %10s %10s\n", "freq_hz", "N", "mag_db", "esperado", "err_%",
+           "err_deg", "settle_ms");
+    
+    const sweep_plan_t *plan = frequency_sweep_get_plan();
+    
+    for (uint16_t k = 0; k < plan->count; k++) {
+        const sweep_point_t *point = &plan->points[k];
+        float freq = point->freq_hz;
+        uint16_t num_samples = (uint16_t)(point->window * point->averages);
+        
+        // Mismo detector de asentamiento que el barrido: si declara el punto
+        // asentado antes de tiempo, el transitorio del DUT aparece como error
+        settle_report_t report;
+        
+        ad9833_set_frequency(freq);
+        if (!settle_wait(&point->settle, &point->coeffs, &report)) {
+            unsettled++;
+        }
+        adc_dma_start_capture(num_samples);
+        adc_dma_wait_complete();
+        
+        float h_mag, h_phase;
+        sim_dut_response(freq, &h_mag, &h_phase);
+        
+        goertzel_result_t result;
+#if ADC_CHANNELS == 2
+        // H = respuesta/referencia, corregida por el desfase de muestreo
+        // entre canales: se compara directo contra la transferencia
+        goertzel_pair_t pair;
+        goertzel_result_t reference, response;
+        goertzel_pair_init(&pair, &point->coeffs, num_samples);
+        goertzel_pair_push(&pair, adc_sample_buffer, num_samples);
+        goertzel_pair_result(&pair, &reference, &response);
+        goertzel_transfer(&reference, &response, point->skew_rad, &result);
+        
+        float expected_mag = h_mag;
+        double expected_phase = h_phase;
+        (void)dut;
+#else
+        goertzel_compute(adc_sample_buffer, num_samples, freq, SAMPLE_RATE, &result);
+        
+        // Amplitud esperada en la escala normalizada de Goertzel
+        // (códigos/2048) y fase DFT de un seno: fase del DDS + arg H - 90°
+        float expected_mag = dut->amplitude * h_mag * 4095.0f / 2048.0f;
+        double expected_phase = sim_dut_last_capture_phase() + h_phase - M_PI / 2.0;
+#endif
+        
+        float mag_err_pct = 100.0f * fabsf(result.magnitude - expected_mag) / expected_mag;
+        float phase_err_deg = (float)(remainder(result.phase_rad - expected_phase, 2.0 * M_PI)
+                                      * 180.0 / M_PI);
+        
+        printf("%10.2f %6u %12.3f %12.3f %10.4f %10.3f %10.2f\n", freq, num_samples, result.magnitude_db,
+               20.0f * log10f(expected_mag), mag_err_pct, phase_err_deg,
+               report.elapsed_us / 1000.0f);
+        
+        if (h_mag < CHECK_MIN_H) {
+            skipped++;
+            continue;
+        }
+        if (mag_err_pct > worst_mag_pct) {
+            worst_mag_pct = mag_err_pct;
+            worst_mag_freq = freq;
+        }
+        if (fabsf(phase_err_deg) > worst_phase_deg) {
+            worst_phase_deg = fabsf(phase_err_deg);
+            worst_phase_freq = freq;
+        }
+    }
+    
+    bool pass = (worst_mag_pct <= mag_tol_pct) && (worst_phase_deg <= phase_tol_deg);
+    
+    printf("\n");
+    printf("Puntos:                   %u\n", plan->count);
+    printf("Error máximo de magnitud: %.4f %% en %.1f Hz (tolerancia %.2f %%)\n",
+           worst_mag_pct, worst_mag_freq, mag_tol_pct);
+    printf("Error máximo de fase:     %.3f° en %.1f Hz (tolerancia %.2f°)\n",
+           worst_phase_deg, worst_phase_freq, phase_tol_deg);
+    printf("Puntos sin converger:     %lu\n", (unsigned long)unsettled);
+    printf("Puntos bajo -60 dB:       %lu (no evaluados)\n", (unsigned long)skipped);
+    printf("Resultado: %s\n", pass ? "OK" : "FALLA");
+    
+    return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Modo benchmark: barridos completos a través de sweep.c
+ */
+static int run_benchmark(uint32_t num_sweeps, bool pipelined, uint32_t outage_sweeps,
+                         bool print_trace) {
+    sweep_stats_t stats = {0};
+    uint64_t sim_total_ms = 0;
+    uint32_t failed = 0;
+    uint32_t max_depth = 0;
+    uint64_t stalls = 0;
+    
+    if (outage_sweeps > 0) {
+        fra_mqtt_disconnect();
+    }
+    
+    double t0 = host_now_s();
+    for (uint32_t i = 0; i < num_sweeps; i++) {
+        trace_reset();
+        if (pipelined) {
+            frequency_sweep_execute_pipelined(&stats);
+        } else {
+            frequency_sweep_execute_with_stats(&stats);
+        }
+        if (i + 1 == outage_sweeps) {
+            mqtt_reconnect();
+        }
+        // Entre barridos la "red" drena lo que encoló el barrido y se
+        // reenvía lo guardado en flash, de a un registro en vuelo
+        mqtt_client_poll(UINT32_MAX);
+        for (uint32_t pending = mqtt_client_replay(), n = 0;
+             pending > 0 && mqtt_is_connected() && n <= SWEEP_STORE_SECTORS * 8; n++) {
+            mqtt_client_poll(UINT32_MAX);
+            pending = mqtt_client_replay();
+        }
+        sim_total_ms += stats.total_time_ms;
+        failed += stats.failed_points;
+        stalls += stats.producer_stalls;
+        if (stats.max_queue_depth > max_depth) {
+            max_depth = stats.max_queue_depth;
+        }
+    }
+    double elapsed = host_now_s() - t0;
+    
+    uint16_t plan_points = frequency_sweep_get_plan()->count;
+    double points = (double)num_sweeps * plan_points;
+    
+    printf("Barridos:               %lu x %u puntos\n", (unsigned long)num_sweeps, plan_points);
+    printf("Tiempo host:            %.3f s\n", elapsed);
+    printf("Modo:                   %s\n", pipelined ? "pipeline (2 núcleos)" : "secuencial");
+    printf("Barridos/s:             %.1f\n", num_sweeps / elapsed);
+    printf("Puntos/s:               %.0f\n", points / elapsed);
+    printf("CPU por punto:          %.3f us\n", elapsed * 1e6 / points);
+    printf("Tiempo firmware/barrido: %.2f s (reloj virtual)\n",
+           (double)sim_total_ms / 1000.0 / num_sweeps);
+    if (pipelined) {
+        printf("Cola core0->core1 máx:  %lu de %d buffers\n",
+               (unsigned long)max_depth, SWEEP_PIPELINE_BUFFERS);
+        printf("Esperas del productor:  %.2f por barrido\n", (double)stalls / num_sweeps);
+    }
+    printf("Asentamiento:           %.2f ms/punto (último barrido, máx %.2f ms, %lu sin converger)\n",
+           stats.avg_settle_ms, stats.max_settle_ms, (unsigned long)stats.settle_timeouts);
+    printf("Capturas por punto:     %.2f (último barrido, máx %lu, %lu sin converger)\n",
+           stats.avg_windows_per_point, (unsigned long)stats.max_windows_per_point,
+           (unsigned long)stats.unconverged_points);
+    printf("Puntos fallidos:        %lu\n", (unsigned long)failed);
+    printf("Puntos saturados:       %lu (último barrido)\n", (unsigned long)stats.saturated_points);
+    
+    publish_queue_stats_t pq;
+    publish_queue_get_stats(&pq);
+    printf("Cola de publicación:    %lu enviados, máx %lu de %d slots, %lu descartados\n",
+           (unsigned long)pq.sent, (unsigned long)pq.high_water, PUBLISH_QUEUE_SLOTS,
+           (unsigned long)(pq.dropped_oldest + pq.dropped_newest));
+    
+    sweep_store_stats_t ss;
+    sweep_store_get_stats(&ss);
+    printf("Almacén en flash:       %lu guardados, %lu reenviados, %lu pendientes, %lu perdidos\n",
+           (unsigned long)ss.appended, (unsigned long)ss.acked, (unsigned long)ss.pending,
+           (unsigned long)ss.overwritten);
+    
+    if (print_trace) {
+        trace_report_t trace;
+        trace_report(&trace);
+        printf("\n");
+        trace_print(&trace);
+    }
+    
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+    sim_dut_config_t dut;
+    sim_dut_default_config(&dut);
+    
+    uint32_t num_sweeps = 1000;
+    bool check_mode = false;
+    bool pipelined = false;
+    bool print_trace = false;
+    uint32_t outage_sweeps = 0;
+    const char *flash_path = NULL;
+    float mag_tol_pct = CHECK_DEFAULT_MAG_TOL_PCT;
+    float phase_tol_deg = CHECK_DEFAULT_PHASE_TOL_DEG;
+    sweep_plan_spec_t plan_spec;
+    sweep_plan_default_spec(&plan_spec);
+    int log_points_per_decade = SWEEP_LOG_POINTS_PER_DECADE;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:f:q:a:r:e:s:k:g:m:w:A:TcPo:S:t:p:h")) != -1) {
+        switch (opt) {
+            case 'n': num_sweeps = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'd':
+                if (!parse_dut_type(optarg, &dut.type)) {
+                    fprintf(stderr, "Modelo de DUT desconocido: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'f': dut.corner_hz = strtof(optarg, NULL); break;
+            case 'q': dut.q = strtof(optarg, NULL); break;
+            case 'a': dut.amplitude = strtof(optarg, NULL); break;
+            case 'r': dut.noise_rms = strtof(optarg, NULL); break;
+            case 'e': dut.enob = strtof(optarg, NULL); break;
+            case 's': dut.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'k':
+                if (strcmp(optarg, "float") == 0) {
+                    goertzel_set_kernel(GOERTZEL_KERNEL_FLOAT);
+                } else if (strcmp(optarg, "fixed") == 0) {
+                    goertzel_set_kernel(GOERTZEL_KERNEL_FIXED);
+                } else {
+                    fprintf(stderr, "Kernel desconocido: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'g':
+                if (strcmp(optarg, "lin") == 0) {
+                    plan_spec.grid = SWEEP_GRID_LINEAR;
+                } else if (strcmp(optarg, "log") == 0) {
+                    plan_spec.grid = SWEEP_GRID_LOG;
+                } else {
+                    fprintf(stderr, "Grilla desconocida: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'm': log_points_per_decade = atoi(optarg); break;
+            case 'w': plan_spec.target_snr_db = strtof(optarg, NULL); break;
+            case 'A': plan_spec.average.max_windows = (uint16_t)strtoul(optarg, NULL, 0); break;
+            case 'T': print_trace = true; break;
+            case 'c': check_mode = true; break;
+            case 'P': pipelined = true; break;
+            case 'o': outage_sweeps = (uint32_t)strtoul(optarg, NULL, 0); break;
+            case 'S': flash_path = optarg; break;
+            case 't': mag_tol_pct = strtof(optarg, NULL); break;
+            case 'p': phase_tol_deg = strtof(optarg, NULL); break;
+            case 'h':
+                print_usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    
+    sim_dut_configure(&dut);
+    
+    if (!hal_host_flash_open(flash_path)) {
+        fprintf(stderr, "[FATAL] No se pudo abrir %s\n", flash_path);
+        return EXIT_FAILURE;
+    }
+    
+    mqtt_config_t mqtt_cfg = {
+        .broker_addr = MQTT_BROKER_ADDR,
+        .broker_port = MQTT_BROKER_PORT,
+        .client_id = MQTT_CLIENT_ID,
+        .topic = MQTT_TOPIC_MEASUREMENTS
+    };
+    
+    trace_init();
+    if (!adc_dma_init() || !ad9833_init() || !mqtt_init(&mqtt_cfg) ||
+        !sweep_store_init() || !frequency_sweep_init()) {
+        fprintf(stderr, "[FATAL] Fallo en inicialización de módulos\n");
+        return EXIT_FAILURE;
+    }
+    
+    long points = plan_spec.grid == SWEEP_GRID_LOG
+        ? lroundf(log10f(plan_spec.stop_hz / plan_spec.start_hz) * log_points_per_decade) + 1
+        : lroundf((plan_spec.stop_hz - plan_spec.start_hz) / FREQ_RESOLUTION) + 1;
+    plan_spec.points = (uint16_t)(points < SWEEP_NUM_POINTS ? points : SWEEP_NUM_POINTS);
+    if (!frequency_sweep_set_plan(&plan_spec)) {
+        fprintf(stderr, "[FATAL] Plan de barrido inválido\n");
+        return EXIT_FAILURE;
+    }
+    
+    if (check_mode) {
+        return run_check(&dut, mag_tol_pct, phase_tol_deg);
+    }
+    return run_benchmark(num_sweeps, pipelined, outage_sweeps, print_trace);
+}
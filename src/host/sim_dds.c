@@ -0,0 +1,176 @@
+/**
+ * @file sim_dds.c
+ * @brief Modelo del AD9833 para el simulador nativo
+ */
+
+#include "sim_dds.h"
+#include "config.h"
+#include <math.h>
+
+// Campos de la palabra SPI (mismos valores que src/ad9833.c)
+#define SIM_REG_MASK    0xC000
+#define SIM_REG_CONTROL 0x0000
+#define SIM_REG_FREQ0   0x4000
+#define SIM_REG_FREQ1   0x8000
+#define SIM_REG_PHASE   0xC000
+#define SIM_PHASE_SEL   0x2000
+
+#define SIM_B28     0x2000
+#define SIM_HLB     0x1000
+#define SIM_FSELECT 0x0800
+#define SIM_PSELECT 0x0400
+#define SIM_RESET   0x0100
+#define SIM_SLEEP1  0x0080
+#define SIM_SLEEP12 0x0040
+
+#define SIM_FREQ_HALF_MASK 0x3FFF
+#define SIM_PHASE_MASK     0x0FFF
+
+// Estado del chip
+static uint16_t control;
+static uint32_t freq_reg[2];
+static uint16_t phase_reg[2];
+static bool pending_msb[2];         // B28=1: la próxima escritura es el MSB
+
+// Acumulador de fase: fase en t_ref y frecuencia vigente desde entonces
+static uint64_t t_ref_us;
+static double phase_ref_rad;
+static double freq_hz;
+
+// Último cambio de salida, para el transitorio del DUT
+static uint64_t change_us;
+static double change_prev_freq_hz;
+static bool change_prev_enabled;
+static bool change_open;            // Ya se registró algún cambio
+
+// Cambios más cercanos que esto forman una sola reprogramación (p. ej. LSB
+// y MSB de una misma palabra): el DUT no llega a responder al intermedio
+#define SIM_DDS_BURST_US 100
+
+/**
+ * @brief Valor del acumulador de fase (sin offset PHASEx) en t_us
+ */
+static double sim_dds_accumulator_at(uint64_t t_us) {
+    double dt = (double)(t_us - t_ref_us) * 1e-6;
+    return phase_ref_rad + 2.0 * M_PI * freq_hz * dt;
+}
+
+/**
+ * @brief Registra un cambio de salida en t_us con el estado previo dado
+ *
+ * Dentro de una ráfaga solo cuenta el estado previo al primer cambio.
+ */
+static void sim_dds_mark_change(uint64_t t_us, double prev_freq, bool prev_enabled) {
+    if (change_open && t_us - change_us < SIM_DDS_BURST_US) {
+        change_us = t_us;
+        return;
+    }
+    change_us = t_us;
+    change_prev_freq_hz = prev_freq;
+    change_prev_enabled = prev_enabled;
+    change_open = true;
+}
+
+/**
+ * @brief Recalcula el acumulador cuando cambia algo que afecta la salida
+ */
+static void sim_dds_retime(uint64_t t_us) {
+    phase_ref_rad = sim_dds_accumulator_at(t_us);
+    t_ref_us = t_us;
+    
+    uint32_t word = freq_reg[(control & SIM_FSELECT) ? 1 : 0];
+    freq_hz = (double)word * (double)AD9833_MCLK / 268435456.0;
+}
+
+static void sim_dds_write_freq(int reg, uint16_t data) {
+    uint32_t half = data & SIM_FREQ_HALF_MASK;
+    
+    if (control & SIM_B28) {
+        if (pending_msb[reg]) {
+            freq_reg[reg] = (freq_reg[reg] & SIM_FREQ_HALF_MASK) | (half << 14);
+        } else {
+            freq_reg[reg] = (freq_reg[reg] & ~(uint32_t)SIM_FREQ_HALF_MASK) | half;
+        }
+        pending_msb[reg] = !pending_msb[reg];
+    } else if (control & SIM_HLB) {
+        freq_reg[reg] = (freq_reg[reg] & SIM_FREQ_HALF_MASK) | (half << 14);
+    } else {
+        freq_reg[reg] = (freq_reg[reg] & ~(uint32_t)SIM_FREQ_HALF_MASK) | half;
+    }
+}
+
+void sim_dds_reset(void) {
+    control = SIM_RESET;
+    freq_reg[0] = freq_reg[1] = 0;
+    phase_reg[0] = phase_reg[1] = 0;
+    pending_msb[0] = pending_msb[1] = false;
+    t_ref_us = 0;
+    phase_ref_rad = 0.0;
+    freq_hz = 0.0;
+    change_us = 0;
+    change_prev_freq_hz = 0.0;
+    change_prev_enabled = false;
+    change_open = false;
+}
+
+void sim_dds_write(uint16_t word, uint64_t t_us) {
+    double prev_freq = freq_hz;
+    bool prev_enabled = sim_dds_output_enabled();
+    
+    switch (word & SIM_REG_MASK) {
+        case SIM_REG_CONTROL:
+            control = word;
+            // Escribir el control reinicia la secuencia LSB/MSB
+            pending_msb[0] = pending_msb[1] = false;
+            if (control & SIM_RESET) {
+                // RESET mantiene el acumulador de fase en cero
+                phase_ref_rad = 0.0;
+                t_ref_us = t_us;
+                freq_hz = 0.0;
+            } else {
+                sim_dds_retime(t_us);
+            }
+            break;
+        case SIM_REG_FREQ0:
+            sim_dds_write_freq(0, word);
+            if (!(control & SIM_RESET)) {
+                sim_dds_retime(t_us);
+            }
+            break;
+        case SIM_REG_FREQ1:
+            sim_dds_write_freq(1, word);
+            if (!(control & SIM_RESET)) {
+                sim_dds_retime(t_us);
+            }
+            break;
+        case SIM_REG_PHASE:
+            phase_reg[(word & SIM_PHASE_SEL) ? 1 : 0] = word & SIM_PHASE_MASK;
+            break;
+        default:
+            break;
+    }
+    
+    // Escribir el registro no seleccionado no altera la salida
+    if (freq_hz != prev_freq || sim_dds_output_enabled() != prev_enabled) {
+        sim_dds_mark_change(t_us, prev_freq, prev_enabled);
+    }
+}
+
+double sim_dds_frequency(void) {
+    return freq_hz;
+}
+
+double sim_dds_phase_at(uint64_t t_us) {
+    double offset = 2.0 * M_PI * (double)phase_reg[(control & SIM_PSELECT) ? 1 : 0] / 4096.0;
+    return sim_dds_accumulator_at(t_us) + offset;
+}
+
+bool sim_dds_output_enabled(void) {
+    return (control & (SIM_RESET | SIM_SLEEP1 | SIM_SLEEP12)) == 0;
+}
+
+bool sim_dds_last_change(uint64_t *t_us, double *prev_freq_hz) {
+    *t_us = change_us;
+    *prev_freq_hz = change_prev_freq_hz;
+    return change_prev_enabled;
+}
@@ -0,0 +1,294 @@
+/**
+ * @file sim_dut.c
+ * @brief Modelo del DUT y del ADC simulado
+ */
+
+#include "sim_dut.h"
+#include "sim_dds.h"
+#include "config.h"
+#include <stdbool.h>
+#include <math.h>
+#include <complex.h>
+
+// Resolución nominal del ADC del RP2350
+#define SIM_ADC_BITS 12
+#define SIM_ADC_MAX_CODE 4095
+
+static sim_dut_config_t dut_cfg;
+static float enob_noise_rms;        // Ruido extra equivalente a la pérdida de ENOB
+static uint32_t rng_state;
+static bool gauss_cached;
+static float gauss_cache;
+static double last_capture_phase;
+
+// Fuente multiseno externa (sim_dut_set_multisine()); count = 0 usa el DDS
+static uint16_t multisine_count;
+static float multisine_amplitude;
+static float multisine_freq[SIM_DUT_MULTISINE_MAX];
+static float multisine_phase[SIM_DUT_MULTISINE_MAX];
+
+/**
+ * @brief Generador xorshift32 (determinista, sin estado global de libc)
+ */
+static uint32_t sim_rng_next(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    return x;
+}
+
+/**
+ * @brief Muestra gaussiana N(0,1) por Box-Muller
+ */
+static float sim_rng_gauss(void) {
+    if (gauss_cached) {
+        gauss_cached = false;
+        return gauss_cache;
+    }
+    
+    float u1 = ((float)(sim_rng_next() >> 8) + 1.0f) * (1.0f / 16777217.0f);
+    float u2 = (float)(sim_rng_next() >> 8) * (1.0f / 16777216.0f);
+    float r = sqrtf(-2.0f * logf(u1));
+    
+    gauss_cache = r * sinf(2.0f * (float)M_PI * u2);
+    gauss_cached = true;
+    return r * cosf(2.0f * (float)M_PI * u2);
+}
+
+static double complex sim_dut_h(double f) {
+    double fc = dut_cfg.corner_hz;
+    
+    switch (dut_cfg.type) {
+        case SIM_DUT_RC_LOWPASS:
+            return 1.0 / (1.0 + I * (f / fc));
+        case SIM_DUT_RC_HIGHPASS:
+            return (I * (f / fc)) / (1.0 + I * (f / fc));
+        case SIM_DUT_RLC_BANDPASS:
+            if (f <= 0.0) {
+                return 0.0;
+            }
+            return 1.0 / (1.0 + I * dut_cfg.q * (f / fc - fc / f));
+        case SIM_DUT_NOTCH:
+            if (f <= 0.0) {
+                return 1.0;
+            }
+            return 1.0 - 1.0 / (1.0 + I * dut_cfg.q * (f / fc - fc / f));
+        case SIM_DUT_FLAT:
+        default:
+            return 1.0;
+    }
+}
+
+/**
+ * @brief Constante de tiempo de los polos del DUT y frecuencia de oscilación
+ *        libre del transitorio
+ *
+ * @return τ en segundos (0 si el DUT no tiene dinámica)
+ */
+static double sim_dut_tau(double *ring_hz) {
+    double fc = dut_cfg.corner_hz;
+    
+    *ring_hz = 0.0;
+    switch (dut_cfg.type) {
+        case SIM_DUT_RC_LOWPASS:
+        case SIM_DUT_RC_HIGHPASS:
+            return 1.0 / (2.0 * M_PI * fc);
+        case SIM_DUT_RLC_BANDPASS:
+        case SIM_DUT_NOTCH:
+            // Polos a f0·sqrt(1 - 1/4Q²) con envolvente e^(-t·π·f0/Q)
+            *ring_hz = fc * sqrt(fmax(0.0, 1.0 - 1.0 / (4.0 * dut_cfg.q * dut_cfg.q)));
+            return dut_cfg.q / (M_PI * fc);
+        case SIM_DUT_FLAT:
+        default:
+            return 0.0;
+    }
+}
+
+void sim_dut_default_config(sim_dut_config_t *cfg) {
+    cfg->type = SIM_DUT_RC_LOWPASS;
+    cfg->corner_hz = 1000.0f;
+    cfg->q = 5.0f;
+    cfg->amplitude = 0.4f;
+    cfg->offset = 0.5f;
+    cfg->noise_rms = 0.0f;
+    cfg->enob = (float)SIM_ADC_BITS;
+    cfg->seed = 0x12345678u;
+}
+
+void sim_dut_configure(const sim_dut_config_t *cfg) {
+    dut_cfg = *cfg;
+    
+    // Ruido de cuantización de un ADC ideal de ENOB bits menos el que ya
+    // aporta el redondeo a 12 bits
+    float lsb_enob = powf(2.0f, -cfg->enob);
+    float lsb_adc = 1.0f / (float)(1 << SIM_ADC_BITS);
+    float excess = lsb_enob * lsb_enob - lsb_adc * lsb_adc;
+    enob_noise_rms = (excess > 0.0f) ? sqrtf(excess / 12.0f) : 0.0f;
+    
+    rng_state = cfg->seed ? cfg->seed : 1u;
+    gauss_cached = false;
+}
+
+void sim_dut_response(float freq_hz, float *mag, float *phase_rad) {
+    double complex h = sim_dut_h(freq_hz);
+    *mag = (float)cabs(h);
+    *phase_rad = (float)carg(h);
+}
+
+/**
+ * @brief Convierte un nivel en fracción de fondo de escala a código de
+ *        12 bits, con el ruido del ADC
+ */
+static uint16_t sim_adc_code(float v, float noise_rms) {
+    if (noise_rms > 0.0f) {
+        v += noise_rms * sim_rng_gauss();
+    }
+    
+    long code = lrintf(v * (float)SIM_ADC_MAX_CODE);
+    if (code < 0) {
+        code = 0;
+    } else if (code > SIM_ADC_MAX_CODE) {
+        code = SIM_ADC_MAX_CODE;
+    }
+    return (uint16_t)code;
+}
+
+void sim_dut_set_multisine(const float *freq_hz, const float *phase_rad, uint16_t count,
+                           float amplitude) {
+    if (count > SIM_DUT_MULTISINE_MAX) {
+        count = SIM_DUT_MULTISINE_MAX;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        multisine_freq[i] = freq_hz[i];
+        multisine_phase[i] = phase_rad[i];
+    }
+    multisine_amplitude = amplitude;
+    multisine_count = count;
+}
+
+/**
+ * @brief Captura con la fuente multiseno: suma de tonos en régimen
+ */
+static void sim_dut_capture_multisine(uint16_t *dst, uint32_t num_samples, uint64_t t_start_us,
+                                      double t_frac_us) {
+#if ADC_CHANNELS == 2
+    static double complex ref_rot[SIM_DUT_MULTISINE_MAX];
+#endif
+    static double complex rot[SIM_DUT_MULTISINE_MAX];
+    static double complex step[SIM_DUT_MULTISINE_MAX];
+    double t0 = ((double)t_start_us + t_frac_us) * 1e-6;
+    double resp_delay = (double)(ADC_CHANNELS - 1) / ((double)SAMPLE_RATE * ADC_CHANNELS);
+    float noise_rms = sqrtf(dut_cfg.noise_rms * dut_cfg.noise_rms +
+                            enob_noise_rms * enob_noise_rms);
+    
+    // Un rotor por tono, como el del DDS: la fase inicial sale del reloj
+    // absoluto y después avanza por multiplicación
+    for (uint16_t i = 0; i < multisine_count; i++) {
+        double w = 2.0 * M_PI * multisine_freq[i];
+        double phase0 = remainder(w * t0, 2.0 * M_PI) + multisine_phase[i];
+        double complex h = sim_dut_h(multisine_freq[i]);
+        
+#if ADC_CHANNELS == 2
+        ref_rot[i] = multisine_amplitude * cexp(I * phase0);
+#endif
+        rot[i] = multisine_amplitude * cabs(h) * cexp(I * (phase0 + carg(h) + w * resp_delay));
+        step[i] = cexp(I * w / (double)SAMPLE_RATE);
+    }
+    last_capture_phase = 0.0;
+    
+    for (uint32_t n = 0; n < num_samples; ) {
+#if ADC_CHANNELS == 2
+        double ref = dut_cfg.offset;
+        for (uint16_t i = 0; i < multisine_count; i++) {
+            ref += cimag(ref_rot[i]);
+            ref_rot[i] *= step[i];
+        }
+        dst[n++] = sim_adc_code((float)ref, noise_rms);
+        if (n >= num_samples) {
+            break;
+        }
+#endif
+        double resp = dut_cfg.offset;
+        for (uint16_t i = 0; i < multisine_count; i++) {
+            resp += cimag(rot[i]);
+            rot[i] *= step[i];
+        }
+        dst[n++] = sim_adc_code((float)resp, noise_rms);
+    }
+}
+
+void sim_dut_capture(uint16_t *dst, uint32_t num_samples, uint64_t t_start_us,
+                     double t_frac_us) {
+    if (multisine_count > 0) {
+        sim_dut_capture_multisine(dst, num_samples, t_start_us, t_frac_us);
+        return;
+    }
+    
+    double freq = sim_dds_frequency();
+    double phase0 = sim_dds_phase_at(t_start_us) + 2.0 * M_PI * freq * t_frac_us * 1e-6;
+    double amplitude = sim_dds_output_enabled() ? dut_cfg.amplitude : 0.0;
+    double complex h = sim_dut_h(freq);
+    
+    last_capture_phase = remainder(phase0, 2.0 * M_PI);
+    
+    // La respuesta es el último canal de cada ronda: con dos canales se
+    // convierte una conversión después que la referencia
+    double resp_delay = (double)(ADC_CHANNELS - 1) / ((double)SAMPLE_RATE * ADC_CHANNELS);
+    
+    // Senoides por rotación compleja: evita un sin() por muestra
+#if ADC_CHANNELS == 2
+    double complex ref_rot = cexp(I * phase0);
+#endif
+    double complex rot = cexp(I * (phase0 + carg(h) + 2.0 * M_PI * freq * resp_delay));
+    double complex step = cexp(I * 2.0 * M_PI * freq / (double)SAMPLE_RATE);
+    double a = amplitude * cabs(h);
+    float noise_rms = sqrtf(dut_cfg.noise_rms * dut_cfg.noise_rms +
+                            enob_noise_rms * enob_noise_rms);
+    
+    // Transitorio desde el último cambio del DDS: el estado de régimen
+    // anterior no coincide con el nuevo y la diferencia decae con los polos
+    // del DUT (exponencial en RC, oscilación amortiguada en RLC y notch)
+    double complex tr_rot = 0.0;
+    double complex tr_step = 1.0;
+    double ring_hz;
+    double tau = sim_dut_tau(&ring_hz);
+    uint64_t change_us;
+    double prev_freq;
+    bool prev_on = sim_dds_last_change(&change_us, &prev_freq);
+    
+    if (tau > 0.0 && t_start_us >= change_us) {
+        double dt = ((double)(t_start_us - change_us) + t_frac_us) * 1e-6 + resp_delay;
+        if (dt < 30.0 * tau) {
+            double complex before = prev_on ? dut_cfg.amplitude * sim_dut_h(prev_freq) : 0.0;
+            double complex after = amplitude * h;
+            double complex d = (before - after) * cexp(I * sim_dds_phase_at(change_us));
+            
+            tr_rot = d * exp(-dt / tau) * cexp(I * 2.0 * M_PI * ring_hz * dt);
+            tr_step = exp(-1.0 / ((double)SAMPLE_RATE * tau))
+                    * cexp(I * 2.0 * M_PI * ring_hz / (double)SAMPLE_RATE);
+        }
+    }
+    
+    // Una ronda del round-robin por instante de muestreo: [referencia,]
+    // respuesta. Una captura que corta a mitad de ronda termina en la
+    // referencia
+    for (uint32_t n = 0; n < num_samples; ) {
+#if ADC_CHANNELS == 2
+        dst[n++] = sim_adc_code((float)(dut_cfg.offset + amplitude * cimag(ref_rot)), noise_rms);
+        ref_rot *= step;
+        if (n >= num_samples) {
+            break;
+        }
+#endif
+        dst[n++] = sim_adc_code((float)(dut_cfg.offset + a * cimag(rot) + cimag(tr_rot)),
+                                noise_rms);
+        tr_rot *= tr_step;
+        rot *= step;
+    }
+}
+
+double sim_dut_last_capture_phase(void) {
+    return last_capture_phase;
+}
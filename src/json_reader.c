@@ -0,0 +1,494 @@
+/**
+ * @file json_reader.c
+ * @brief Implementación del lector JSON sin heap
+ */
+
+#include "json_reader.h"
+#include <float.h>
+
+// Cifras significativas que se acumulan en la mantisa; las siguientes solo
+// corren el exponente (float tiene ~7)
+#define JSON_MANTISSA_DIGITS 18
+
+// Exponente decimal a partir del cual el número ya no es un float finito
+// ni distinto de cero
+#define JSON_EXPONENT_LIMIT 60
+
+static bool json_fail(json_reader_t *r) {
+    r->error = true;
+    return false;
+}
+
+static void json_skip_ws(json_reader_t *r) {
+    while (r->pos < r->len) {
+        char c = r->buf[r->pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        r->pos++;
+    }
+}
+
+/**
+ * @brief Próximo byte significativo sin consumirlo (0 al final del payload)
+ */
+static char json_peek(json_reader_t *r) {
+    json_skip_ws(r);
+    return r->pos < r->len ? r->buf[r->pos] : '\0';
+}
+
+static bool json_expect(json_reader_t *r, char c) {
+    if (r->error || json_peek(r) != c) {
+        return json_fail(r);
+    }
+    r->pos++;
+    return true;
+}
+
+static bool json_is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/**
+ * @brief Consume una palabra literal (true, false, null)
+ */
+static bool json_literal(json_reader_t *r, const char *word) {
+    json_skip_ws(r);
+    for (; *word; word++) {
+        if (r->pos >= r->len || r->buf[r->pos] != *word) {
+            return json_fail(r);
+        }
+        r->pos++;
+    }
+    return true;
+}
+
+/**
+ * @brief Guarda un byte en out si hay lugar (out NULL: descartar)
+ */
+static bool json_put(json_reader_t *r, char *out, size_t capacity, size_t *n, char c) {
+    if (out) {
+        // Siempre queda un byte para el terminador
+        if (*n + 1 >= capacity) {
+            return json_fail(r);
+        }
+        out[*n] = c;
+    }
+    (*n)++;
+    return true;
+}
+
+/**
+ * @brief Lee las 4 cifras hexadecimales de un escape \\u
+ */
+static bool json_hex4(json_reader_t *r, uint32_t *code) {
+    if (r->len - r->pos < 4) {
+        return json_fail(r);
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = r->buf[r->pos++];
+        uint32_t digit;
+        if (json_is_digit(c)) {
+            digit = (uint32_t)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            digit = (uint32_t)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            digit = (uint32_t)(c - 'A' + 10);
+        } else {
+            return json_fail(r);
+        }
+        value = (value << 4) | digit;
+    }
+    *code = value;
+    return true;
+}
+
+/**
+ * @brief Decodifica un escape \\u (con par sustituto si hace falta) y lo
+ *        guarda en UTF-8
+ */
+static bool json_unicode(json_reader_t *r, char *out, size_t capacity, size_t *n) {
+    uint32_t code;
+    if (!json_hex4(r, &code)) {
+        return false;
+    }
+    if (code >= 0xDC00 && code <= 0xDFFF) {
+        // Segunda mitad de un par sin la primera
+        return json_fail(r);
+    }
+    if (code >= 0xD800 && code <= 0xDBFF) {
+        uint32_t low;
+        if (r->len - r->pos < 2 || r->buf[r->pos] != '\\' || r->buf[r->pos + 1] != 'u') {
+            return json_fail(r);
+        }
+        r->pos += 2;
+        if (!json_hex4(r, &low) || low < 0xDC00 || low > 0xDFFF) {
+            return json_fail(r);
+        }
+        code = 0x10000u + ((code - 0xD800u) << 10) + (low - 0xDC00u);
+    }
+
+    char utf8[4];
+    size_t bytes;
+    if (code < 0x80) {
+        utf8[0] = (char)code;
+        bytes = 1;
+    } else if (code < 0x800) {
+        utf8[0] = (char)(0xC0 | (code >> 6));
+        utf8[1] = (char)(0x80 | (code & 0x3F));
+        bytes = 2;
+    } else if (code < 0x10000) {
+        utf8[0] = (char)(0xE0 | (code >> 12));
+        utf8[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        utf8[2] = (char)(0x80 | (code & 0x3F));
+        bytes = 3;
+    } else {
+        utf8[0] = (char)(0xF0 | (code >> 18));
+        utf8[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+        utf8[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+        utf8[3] = (char)(0x80 | (code & 0x3F));
+        bytes = 4;
+    }
+    for (size_t i = 0; i < bytes; i++) {
+        if (!json_put(r, out, capacity, n, utf8[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Lee un string a out (out NULL: solo lo recorre)
+ */
+static bool json_read_string(json_reader_t *r, char *out, size_t capacity) {
+    if (out && capacity == 0) {
+        return json_fail(r);
+    }
+    if (!json_expect(r, '"')) {
+        return false;
+    }
+
+    size_t n = 0;
+    while (true) {
+        if (r->pos >= r->len) {
+            return json_fail(r);
+        }
+        char c = r->buf[r->pos++];
+        if (c == '"') {
+            break;
+        }
+        if ((unsigned char)c < 0x20) {
+            // Los caracteres de control van escapados
+            return json_fail(r);
+        }
+        if (c != '\\') {
+            if (!json_put(r, out, capacity, &n, c)) {
+                return false;
+            }
+            continue;
+        }
+
+        if (r->pos >= r->len) {
+            return json_fail(r);
+        }
+        char e = r->buf[r->pos++];
+        bool ok;
+        switch (e) {
+            case '"':  ok = json_put(r, out, capacity, &n, '"'); break;
+            case '\\': ok = json_put(r, out, capacity, &n, '\\'); break;
+            case '/':  ok = json_put(r, out, capacity, &n, '/'); break;
+            case 'b':  ok = json_put(r, out, capacity, &n, '\b'); break;
+            case 'f':  ok = json_put(r, out, capacity, &n, '\f'); break;
+            case 'n':  ok = json_put(r, out, capacity, &n, '\n'); break;
+            case 'r':  ok = json_put(r, out, capacity, &n, '\r'); break;
+            case 't':  ok = json_put(r, out, capacity, &n, '\t'); break;
+            case 'u':  ok = json_unicode(r, out, capacity, &n); break;
+            default:   ok = json_fail(r); break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+
+    if (out) {
+        out[n] = '\0';
+    }
+    return true;
+}
+
+/**
+ * @brief Número descompuesto: valor = mantissa · 10^exponent
+ */
+typedef struct {
+    bool negative;
+    bool integer;               // Sin fracción ni exponente
+    uint64_t mantissa;
+    int32_t exponent;
+} json_number_t;
+
+/**
+ * @brief Lee un número con la gramática estricta de RFC 8259
+ *
+ * Sin ceros a la izquierda, sin '+', sin '.' suelto ni Infinity/NaN.
+ */
+static bool json_read_number(json_reader_t *r, json_number_t *num) {
+    if (r->error) {
+        return false;
+    }
+    json_skip_ws(r);
+
+    num->negative = false;
+    num->integer = true;
+    num->mantissa = 0;
+    num->exponent = 0;
+    uint8_t digits = 0;
+
+    if (r->pos < r->len && r->buf[r->pos] == '-') {
+        num->negative = true;
+        r->pos++;
+    }
+
+    // Parte entera
+    if (r->pos >= r->len || !json_is_digit(r->buf[r->pos])) {
+        return json_fail(r);
+    }
+    if (r->buf[r->pos] == '0') {
+        r->pos++;
+    } else {
+        while (r->pos < r->len && json_is_digit(r->buf[r->pos])) {
+            if (digits < JSON_MANTISSA_DIGITS) {
+                num->mantissa = num->mantissa * 10u + (uint64_t)(r->buf[r->pos] - '0');
+                digits++;
+            } else if (num->exponent < JSON_EXPONENT_LIMIT) {
+                num->exponent++;
+            }
+            r->pos++;
+        }
+    }
+
+    // Fracción
+    if (r->pos < r->len && r->buf[r->pos] == '.') {
+        num->integer = false;
+        r->pos++;
+        if (r->pos >= r->len || !json_is_digit(r->buf[r->pos])) {
+            return json_fail(r);
+        }
+        while (r->pos < r->len && json_is_digit(r->buf[r->pos])) {
+            if (digits < JSON_MANTISSA_DIGITS && (num->mantissa != 0 || r->buf[r->pos] != '0')) {
+                num->mantissa = num->mantissa * 10u + (uint64_t)(r->buf[r->pos] - '0');
+                digits++;
+                num->exponent--;
+            } else if (num->mantissa == 0 && num->exponent > -JSON_EXPONENT_LIMIT) {
+                // Ceros iniciales de 0.000x
+                num->exponent--;
+            }
+            r->pos++;
+        }
+    }
+
+    // Exponente
+    if (r->pos < r->len && (r->buf[r->pos] == 'e' || r->buf[r->pos] == 'E')) {
+        num->integer = false;
+        r->pos++;
+        bool negative_exp = false;
+        if (r->pos < r->len && (r->buf[r->pos] == '+' || r->buf[r->pos] == '-')) {
+            negative_exp = (r->buf[r->pos] == '-');
+            r->pos++;
+        }
+        if (r->pos >= r->len || !json_is_digit(r->buf[r->pos])) {
+            return json_fail(r);
+        }
+        int32_t exp = 0;
+        while (r->pos < r->len && json_is_digit(r->buf[r->pos])) {
+            if (exp < 10 * JSON_EXPONENT_LIMIT) {
+                exp = exp * 10 + (r->buf[r->pos] - '0');
+            }
+            r->pos++;
+        }
+        num->exponent += negative_exp ? -exp : exp;
+    }
+
+    return true;
+}
+
+void json_reader_init(json_reader_t *r, const char *buf, size_t len) {
+    r->buf = buf;
+    r->len = buf ? len : 0;
+    r->pos = 0;
+    r->error = (buf == NULL);
+    r->opened = false;
+}
+
+bool json_reader_begin_object(json_reader_t *r) {
+    if (!json_expect(r, '{')) {
+        return false;
+    }
+    r->opened = true;
+    return true;
+}
+
+bool json_reader_next_key(json_reader_t *r, char *key, size_t capacity) {
+    if (r->error) {
+        return false;
+    }
+    if (json_peek(r) == '}') {
+        r->pos++;
+        r->opened = false;
+        return false;
+    }
+    if (!r->opened && !json_expect(r, ',')) {
+        return false;
+    }
+    r->opened = false;
+    return json_read_string(r, key, capacity) && json_expect(r, ':');
+}
+
+bool json_reader_begin_array(json_reader_t *r) {
+    if (!json_expect(r, '[')) {
+        return false;
+    }
+    r->opened = true;
+    return true;
+}
+
+bool json_reader_next_element(json_reader_t *r) {
+    if (r->error) {
+        return false;
+    }
+    if (json_peek(r) == ']') {
+        r->pos++;
+        r->opened = false;
+        return false;
+    }
+    if (!r->opened && !json_expect(r, ',')) {
+        return false;
+    }
+    r->opened = false;
+    return true;
+}
+
+bool json_reader_string(json_reader_t *r, char *out, size_t capacity) {
+    if (!out) {
+        return json_fail(r);
+    }
+    return json_read_string(r, out, capacity);
+}
+
+bool json_reader_float(json_reader_t *r, float *value) {
+    json_number_t num;
+    if (!json_read_number(r, &num)) {
+        return false;
+    }
+
+    double v = (double)num.mantissa;
+    if (num.mantissa != 0) {
+        if (num.exponent > JSON_EXPONENT_LIMIT || num.exponent < -JSON_EXPONENT_LIMIT) {
+            return json_fail(r);
+        }
+        for (int32_t e = num.exponent; e > 0; e--) {
+            v *= 10.0;
+        }
+        for (int32_t e = num.exponent; e < 0; e++) {
+            v /= 10.0;
+        }
+        if (v > FLT_MAX) {
+            return json_fail(r);
+        }
+    }
+    *value = (float)(num.negative ? -v : v);
+    return true;
+}
+
+bool json_reader_uint(json_reader_t *r, uint32_t *value) {
+    json_number_t num;
+    if (!json_read_number(r, &num)) {
+        return false;
+    }
+    // Sin exponente la mantisa solo corre si hay más de
+    // JSON_MANTISSA_DIGITS cifras: fuera de rango de todos modos
+    if (!num.integer || num.exponent != 0 || num.mantissa > UINT32_MAX
+        || (num.negative && num.mantissa != 0)) {
+        return json_fail(r);
+    }
+    *value = (uint32_t)num.mantissa;
+    return true;
+}
+
+bool json_reader_bool(json_reader_t *r, bool *value) {
+    if (r->error) {
+        return false;
+    }
+    char c = json_peek(r);
+    if (c == 't' && json_literal(r, "true")) {
+        *value = true;
+        return true;
+    }
+    if (c == 'f' && json_literal(r, "false")) {
+        *value = false;
+        return true;
+    }
+    return json_fail(r);
+}
+
+bool json_reader_skip(json_reader_t *r) {
+    // Cierre pendiente de cada objeto o arreglo abierto
+    char closers[JSON_READER_MAX_DEPTH];
+    uint8_t depth = 0;
+
+    while (!r->error) {
+        // Un valor
+        char c = json_peek(r);
+        if (c == '{' || c == '[') {
+            if (depth == JSON_READER_MAX_DEPTH) {
+                return json_fail(r);
+            }
+            if (c == '{') {
+                json_reader_begin_object(r);
+            } else {
+                json_reader_begin_array(r);
+            }
+            closers[depth++] = (c == '{') ? '}' : ']';
+        } else if (c == '"') {
+            json_read_string(r, NULL, 0);
+        } else if (c == 't') {
+            json_literal(r, "true");
+        } else if (c == 'f') {
+            json_literal(r, "false");
+        } else if (c == 'n') {
+            json_literal(r, "null");
+        } else {
+            json_number_t num;
+            json_read_number(r, &num);
+        }
+
+        // Cerrar los contenedores que terminan acá; si queda un elemento
+        // o una clave, volver a leer un valor
+        while (depth > 0 && !r->error) {
+            bool more = (closers[depth - 1] == '}')
+                ? json_reader_next_key(r, NULL, 0)
+                : json_reader_next_element(r);
+            if (more) {
+                break;
+            }
+            if (!r->error) {
+                depth--;
+            }
+        }
+        if (depth == 0) {
+            break;
+        }
+    }
+    return !r->error;
+}
+
+bool json_reader_end(json_reader_t *r) {
+    if (r->error) {
+        return false;
+    }
+    json_skip_ws(r);
+    if (r->pos != r->len) {
+        return json_fail(r);
+    }
+    return true;
+}
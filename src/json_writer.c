@@ -0,0 +1,228 @@
+/**
+ * @file json_writer.c
+ * @brief Implementación del serializador JSON sin heap
+ */
+
+#include "json_writer.h"
+#include <math.h>
+
+static const uint32_t json_pow10[JSON_MAX_DECIMALS + 1] = {
+    1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u
+};
+
+static void json_put(json_writer_t *w, char c) {
+    // Siempre queda un byte para el terminador
+    if (w->len + 1 >= w->capacity) {
+        w->overflow = true;
+        return;
+    }
+    w->buf[w->len++] = c;
+}
+
+static void json_put_str(json_writer_t *w, const char *s) {
+    while (*s) {
+        json_put(w, *s++);
+    }
+}
+
+/**
+ * @brief Escribe value en decimal con exactamente min_digits cifras como
+ *        mínimo (ceros a la izquierda)
+ */
+static void json_put_digits(json_writer_t *w, uint32_t value, uint8_t min_digits) {
+    char tmp[10];
+    uint8_t n = 0;
+
+    do {
+        tmp[n++] = (char)('0' + value % 10u);
+        value /= 10u;
+    } while (value != 0);
+
+    while (n < min_digits) {
+        tmp[n++] = '0';
+    }
+    while (n > 0) {
+        json_put(w, tmp[--n]);
+    }
+}
+
+/**
+ * @brief Separador antes de un elemento nuevo
+ */
+static void json_separate(json_writer_t *w) {
+    if (w->need_comma) {
+        json_put(w, ',');
+    }
+}
+
+void json_writer_init(json_writer_t *w, char *buf, size_t capacity) {
+    w->buf = buf;
+    w->capacity = capacity;
+    w->len = 0;
+    w->overflow = (capacity == 0);
+    w->need_comma = false;
+}
+
+void json_writer_begin_object(json_writer_t *w) {
+    json_separate(w);
+    json_put(w, '{');
+    w->need_comma = false;
+}
+
+void json_writer_end_object(json_writer_t *w) {
+    json_put(w, '}');
+    w->need_comma = true;
+}
+
+void json_writer_begin_array(json_writer_t *w) {
+    json_separate(w);
+    json_put(w, '[');
+    w->need_comma = false;
+}
+
+void json_writer_end_array(json_writer_t *w) {
+    json_put(w, ']');
+    w->need_comma = true;
+}
+
+void json_writer_key(json_writer_t *w, const char *key) {
+    json_separate(w);
+    json_put(w, '"');
+    json_put_str(w, key);
+    json_put(w, '"');
+    json_put(w, ':');
+    w->need_comma = false;
+}
+
+void json_writer_fixed(json_writer_t *w, float value, uint8_t decimals) {
+    json_separate(w);
+    w->need_comma = true;
+
+    if (decimals > JSON_MAX_DECIMALS) {
+        decimals = JSON_MAX_DECIMALS;
+    }
+
+    float magnitude = fabsf(value);
+    if (!isfinite(value) || magnitude >= 4294967296.0f) {
+        json_put_str(w, "null");
+        return;
+    }
+
+    // Parte entera y fracción por separado: la fracción escalada nunca
+    // supera 10^6, así no se pierde precisión con partes enteras grandes
+    uint32_t scale = json_pow10[decimals];
+    uint32_t ipart = (uint32_t)magnitude;
+    uint32_t fpart = (uint32_t)((magnitude - (float)ipart) * (float)scale + 0.5f);
+    if (fpart >= scale) {
+        if (ipart == UINT32_MAX) {
+            json_put_str(w, "null");
+            return;
+        }
+        ipart++;
+        fpart -= scale;
+    }
+
+    if (value < 0.0f && (ipart != 0 || fpart != 0)) {
+        json_put(w, '-');
+    }
+    json_put_digits(w, ipart, 1);
+    if (decimals > 0) {
+        json_put(w, '.');
+        json_put_digits(w, fpart, decimals);
+    }
+}
+
+void json_writer_uint(json_writer_t *w, uint32_t value) {
+    json_separate(w);
+    w->need_comma = true;
+    json_put_digits(w, value, 1);
+}
+
+void json_writer_bool(json_writer_t *w, bool value) {
+    json_separate(w);
+    w->need_comma = true;
+    json_put_str(w, value ? "true" : "false");
+}
+
+void json_writer_string(json_writer_t *w, const char *str) {
+    static const char hex[] = "0123456789abcdef";
+
+    json_separate(w);
+    w->need_comma = true;
+    json_put(w, '"');
+
+    for (const unsigned char *p = (const unsigned char *)str; *p; p++) {
+        unsigned char c = *p;
+        if (c == '"' || c == '\\') {
+            json_put(w, '\\');
+            json_put(w, (char)c);
+        } else if (c == '\n') {
+            json_put_str(w, "\\n");
+        } else if (c == '\r') {
+            json_put_str(w, "\\r");
+        } else if (c == '\t') {
+            json_put_str(w, "\\t");
+        } else if (c < 0x20) {
+            json_put_str(w, "\\u00");
+            json_put(w, hex[c >> 4]);
+            json_put(w, hex[c & 0x0F]);
+        } else {
+            json_put(w, (char)c);
+        }
+    }
+
+    json_put(w, '"');
+}
+
+size_t json_writer_finish(json_writer_t *w) {
+    if (w->overflow) {
+        if (w->capacity > 0) {
+            w->buf[0] = '\0';
+        }
+        return 0;
+    }
+    w->buf[w->len] = '\0';
+    return w->len;
+}
+
+/**
+ * @brief Objeto de un punto dentro del escritor
+ */
+static void json_write_point(json_writer_t *w, const json_point_t *point) {
+    json_writer_begin_object(w);
+    json_writer_key(w, "freq");
+    json_writer_fixed(w, point->frequency_hz, JSON_FREQ_DECIMALS);
+    json_writer_key(w, "mag");
+    json_writer_fixed(w, point->magnitude_db, JSON_MAG_DECIMALS);
+    json_writer_key(w, "phase");
+    json_writer_fixed(w, point->phase_deg, JSON_PHASE_DECIMALS);
+    json_writer_end_object(w);
+}
+
+size_t json_format_measurement(char *buf, size_t capacity, const json_point_t *point) {
+    json_writer_t w;
+    json_writer_init(&w, buf, capacity);
+    json_write_point(&w, point);
+    return json_writer_finish(&w);
+}
+
+size_t json_format_points(char *buf, size_t capacity, const json_point_t *points, uint16_t count) {
+    json_writer_t w;
+    json_writer_init(&w, buf, capacity);
+    json_writer_begin_array(&w);
+    for (uint16_t i = 0; i < count; i++) {
+        json_write_point(&w, &points[i]);
+    }
+    json_writer_end_array(&w);
+    return json_writer_finish(&w);
+}
+
+size_t json_format_status(char *buf, size_t capacity, const char *status) {
+    json_writer_t w;
+    json_writer_init(&w, buf, capacity);
+    json_writer_begin_object(&w);
+    json_writer_key(&w, "status");
+    json_writer_string(&w, status);
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
+}
@@ -12,22 +12,18 @@
 #include "hardware/adc.h"
 
 #include "config.h"
+#include "debug.h"
 #include "adc_dma.h"
 #include "ad9833.h"
+#include "command.h"
 #include "goertzel.h"
+#include "monitor.h"
+#include "multitone.h"
 #include "mqtt_client.h"
 #include "sweep.h"
-
-// Macros de debug
-#ifdef DEBUG_ENABLED
-    #define DEBUG_PRINT(level, ...) do { \
-        if (level <= DEBUG_LEVEL) { \
-            printf(__VA_ARGS__); \
-        } \
-    } while(0)
-#else
-    #define DEBUG_PRINT(level, ...)
-#endif
+#include "sweep_adaptive.h"
+#include "sweep_store.h"
+#include "trace.h"
 
 /**
  * @brief Inicializa el hardware del sistema
@@ -138,6 +134,49 @@ static bool connect_wifi(void) {
     return false;
 }
 
+/**
+ * @brief Worker del async_context de cyw43: drena la cola de publicación
+ *        desde el contexto de red y se reprograma
+ */
+static void mqtt_poll_worker_fn(async_context_t *context, async_at_time_worker_t *worker) {
+    mqtt_client_poll(MQTT_POLL_BATCH);
+    async_context_add_at_time_worker_in_ms(context, worker, MQTT_POLL_INTERVAL_MS);
+}
+
+static async_at_time_worker_t mqtt_poll_worker = {
+    .do_work = mqtt_poll_worker_fn
+};
+
+// Próximo intento de reconexión al broker y espera hasta el siguiente
+static absolute_time_t mqtt_retry_at = nil_time;
+static uint32_t mqtt_retry_delay_ms = MQTT_RECONNECT_MIN_MS;
+
+/**
+ * @brief Reintenta la conexión al broker solo cuando vence el plazo
+ *
+ * El loop principal pasa por acá cada MQTT_POLL_INTERVAL_MS; sin plazo
+ * cada pasada desconectada volvería a llamar a mqtt_reconnect(). Cada
+ * intento fallido duplica la espera hasta MQTT_RECONNECT_MAX_MS.
+ */
+static void mqtt_keep_connected(void) {
+    if (mqtt_is_connected()) {
+        mqtt_retry_delay_ms = MQTT_RECONNECT_MIN_MS;
+        return;
+    }
+    if (!time_reached(mqtt_retry_at)) {
+        return;
+    }
+    if (mqtt_reconnect()) {
+        mqtt_retry_delay_ms = MQTT_RECONNECT_MIN_MS;
+        return;
+    }
+    mqtt_retry_at = make_timeout_time_ms(mqtt_retry_delay_ms);
+    DEBUG_PRINT(1, "[MQTT] Reconexión fallida, próximo intento en %lu ms\n",
+                (unsigned long)mqtt_retry_delay_ms);
+    mqtt_retry_delay_ms = mqtt_retry_delay_ms * 2 > MQTT_RECONNECT_MAX_MS
+        ? MQTT_RECONNECT_MAX_MS : mqtt_retry_delay_ms * 2;
+}
+
 /**
  * @brief Inicializa los módulos del sistema
  * @return true si la inicialización fue exitosa, false en caso contrario
@@ -159,6 +198,10 @@ static bool init_modules(void) {
         return false;
     }
     
+    // La bandeja de comandos tiene que estar lista antes de que la red
+    // pueda entregar el primero
+    command_init();
+    
     // Inicializar cliente MQTT
     DEBUG_PRINT(2, "[INIT] Configurando MQTT...\n");
     mqtt_config_t mqtt_cfg = {
@@ -173,6 +216,29 @@ static bool init_modules(void) {
         return false;
     }
     
+    // Barridos que quedaron en flash sin llegar al broker (antes de un
+    // corte de energía o de red); se reenvían entre barridos
+    DEBUG_PRINT(2, "[INIT] Recorriendo almacén de barridos en flash...\n");
+    if (!sweep_store_init()) {
+        DEBUG_PRINT(0, "[ERROR] Fallo al leer el almacén de barridos\n");
+        return false;
+    }
+    
+    // La cola de publicación se drena en el contexto de red, no en el barrido
+    async_context_add_at_time_worker_in_ms(cyw43_arch_async_context(), &mqtt_poll_worker,
+                                           MQTT_POLL_INTERVAL_MS);
+    
+    // Contador de ciclos de la traza de etapas (el core 1 habilita el suyo
+    // al lanzar cada trabajo)
+    trace_init();
+    
+    // Precalcular grilla y coeficientes del barrido
+    DEBUG_PRINT(2, "[INIT] Preparando plan de barrido...\n");
+    if (!frequency_sweep_init()) {
+        DEBUG_PRINT(0, "[ERROR] Fallo al preparar el barrido\n");
+        return false;
+    }
+    
     DEBUG_PRINT(2, "[INIT] Todos los módulos inicializados correctamente\n");
     return true;
 }
@@ -217,34 +283,105 @@ int main(void) {
     DEBUG_PRINT(1, "========================================\n");
     DEBUG_PRINT(1, "  Sistema listo para iniciar barrido\n");
     DEBUG_PRINT(1, "========================================\n");
-    DEBUG_PRINT(1, "  Frecuencia: %.0f Hz - %.0f Hz\n", SWEEP_FREQ_MIN, SWEEP_FREQ_MAX);
-    DEBUG_PRINT(1, "  Resolución: %.0f Hz\n", FREQ_RESOLUTION);
-    DEBUG_PRINT(1, "  Puntos: %d\n", SWEEP_NUM_POINTS);
+    const sweep_plan_t *plan = frequency_sweep_get_plan();
+    DEBUG_PRINT(1, "  Frecuencia: %.0f Hz - %.0f Hz\n",
+                plan->points[0].freq_hz, plan->points[plan->count - 1].freq_hz);
+    DEBUG_PRINT(1, "  Grilla: %s\n", plan->grid == SWEEP_GRID_LOG ? "logarítmica" : "lineal");
+    DEBUG_PRINT(1, "  Puntos: %d\n", plan->count);
+    DEBUG_PRINT(1, "  Canales: %d (%s)\n", ADC_CHANNELS,
+                ADC_CHANNELS == 2 ? "H = respuesta/referencia" : "solo respuesta");
     DEBUG_PRINT(1, "========================================\n\n");
     
     // Esperar un momento antes de iniciar
     sleep_ms(2000);
     
-    // Loop principal: ejecutar barrido
+    // Loop principal: un barrido cada command_interval_ms() (SWEEP_INTERVAL_MS
+    // hasta que un comando lo cambie) o cuando lo pide "start". El barrido
+    // avanza en el motor no bloqueante y entre consultas el núcleo duerme
+    // (WFE) hasta la próxima muestra que necesita o hasta una interrupción
+    // (DMA, red, alarmas); los comandos se atienden también durante el
+    // barrido, así "stop" lo corta. Con el modo monitor activo (comando
+    // "monitor") no hay barridos: el loop procesa los bloques de la captura
+    // continua a medida que los completa el DMA
+    absolute_time_t last_sweep = nil_time;
+    bool first_sweep = true;
     while (true) {
-        DEBUG_PRINT(1, "[MAIN] Iniciando barrido de frecuencia...\n");
-        
-        // Ejecutar barrido completo
-        frequency_sweep_execute();
+        command_poll();
         
-        DEBUG_PRINT(1, "[MAIN] Barrido completado\n");
-        DEBUG_PRINT(1, "[MAIN] Esperando 10 segundos antes del próximo barrido...\n\n");
+        if (monitor_active()) {
+            monitor_poll();
+            mqtt_keep_connected();
+            // La IRQ de cada bloque del DMA despierta al núcleo antes
+            best_effort_wfe_or_timeout(make_timeout_time_ms(MQTT_POLL_INTERVAL_MS));
+            continue;
+        }
         
-        // Parpadear LED para indicar barrido completo
-        for (int i = 0; i < 3; i++) {
+        // Con la pausa vigente: un "rate" nuevo reprograma el barrido que
+        // está esperando
+        absolute_time_t next_sweep = first_sweep
+            ? get_absolute_time() : delayed_by_ms(last_sweep, command_interval_ms());
+        bool start_now = command_take_start();
+        if (start_now || (command_sweeps_enabled() && time_reached(next_sweep))) {
+            DEBUG_PRINT(1, "[MAIN] Iniciando barrido de frecuencia...\n");
             cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 1);
-            sleep_ms(100);
+            
+#if SWEEP_ADAPTIVE
+            // El adaptativo decide cada punto con los anteriores: sigue
+            // siendo bloqueante
+            static sweep_adaptive_result_t adaptive_result;
+            sweep_adaptive_params_t adaptive_params;
+            sweep_adaptive_default_params(&adaptive_params);
+            sweep_adaptive_execute(&adaptive_params, &adaptive_result);
+#elif SWEEP_MULTITONE
+            // Todos los tonos en una medición, con la multiseno de un
+            // generador externo en la entrada del DUT
+            static multitone_result_t multitone_result;
+            multitone_params_t multitone_params;
+            multitone_default_params(&multitone_params);
+            multitone_execute(&multitone_params, &multitone_result);
+#elif SWEEP_PIPELINED
+            // Captura en el core 0, Goertzel y publicación en el core 1;
+            // bloquea hasta el último punto
+            sweep_stats_t pipeline_stats;
+            frequency_sweep_execute_pipelined(&pipeline_stats);
+#else
+            if (frequency_sweep_start()) {
+                while (frequency_sweep_poll() == SWEEP_RUNNING) {
+                    command_poll();
+                    frequency_sweep_wait();
+                }
+            }
+#endif
+            
             cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, 0);
-            sleep_ms(100);
+            DEBUG_PRINT(1, "[MAIN] Barrido %s\n",
+                        frequency_sweep_status() == SWEEP_ABORTED ? "cortado" : "completado");
+            
+#if TRACE_ENABLED
+            // Distribución de cada etapa del barrido: por USB y por MQTT
+            trace_report_t trace;
+            trace_report(&trace);
+            trace_print(&trace);
+            mqtt_publish_trace(&trace);
+            trace_reset();
+#endif
+            last_sweep = get_absolute_time();
+            next_sweep = delayed_by_ms(last_sweep, command_interval_ms());
+            first_sweep = false;
+            DEBUG_PRINT(1, "[MAIN] Esperando %lu ms antes del próximo barrido...\n\n",
+                        (unsigned long)command_interval_ms());
         }
         
-        // Esperar antes del próximo barrido
-        sleep_ms(10000);
+        // Entre barridos: reconectar si hace falta, reenviar los barridos
+        // guardados en flash y dormir hasta el próximo barrido o la próxima
+        // pasada de la red (que puede traer un comando)
+        mqtt_keep_connected();
+        mqtt_client_replay();
+        absolute_time_t wake = make_timeout_time_ms(MQTT_POLL_INTERVAL_MS);
+        if (command_sweeps_enabled()) {
+            wake = absolute_time_min(next_sweep, wake);
+        }
+        best_effort_wfe_or_timeout(wake);
     }
     
     // Cleanup (nunca alcanzado en este diseño)
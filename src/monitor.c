@@ -0,0 +1,378 @@
+/**
+ * @file monitor.c
+ * @brief Implementación del modo monitor
+ */
+
+#include "monitor.h"
+#include "ad9833.h"
+#include "adc_dma.h"
+#include "debug.h"
+#include "goertzel.h"
+#include "json_writer.h"
+#include "mqtt_client.h"
+#include "settle.h"
+#include "sweep.h"
+#include <math.h>
+#include <string.h>
+
+#if MONITOR_WINDOW_BLOCKS_MAX < 1 || MONITOR_WINDOW_BLOCKS_MAX > UINT8_MAX
+#error "MONITOR_WINDOW_BLOCKS_MAX debe estar entre 1 y 255"
+#endif
+
+#if MONITOR_BATCH_MAX < 1 || MONITOR_BATCH_MAX > UINT8_MAX
+#error "MONITOR_BATCH_MAX debe estar entre 1 y 255"
+#endif
+
+// Encabezado de un mensaje más, por actualización, "-180.00,-180.0,"
+#if MONITOR_JSON_MAX < 100 + 16 * MONITOR_BATCH_MAX
+#error "MONITOR_JSON_MAX no alcanza para MONITOR_BATCH_MAX actualizaciones"
+#endif
+
+// Bin de un bloque, ya rotado a la referencia de la ventana
+typedef struct {
+#if ADC_CHANNELS == 2
+    float ref_re, ref_im;
+#endif
+    float resp_re, resp_im;
+} monitor_bin_t;
+
+// Estado del monitor, avanzado por monitor_poll()
+typedef struct {
+    bool active;
+    monitor_spec_t spec;
+    float freq_hz;                  // Frecuencia coherente con la ventana
+    float skew_rad;                 // Corrección de fase por el desfase entre canales
+    goertzel_coeffs_t coeffs;
+    // Rotación del bloque k a la referencia común: e^{-j·2π·m·(k mod K)/K}
+    float rot_re[MONITOR_WINDOW_BLOCKS_MAX];
+    float rot_im[MONITOR_WINDOW_BLOCKS_MAX];
+    // Bines de los últimos K bloques, en la posición sequence mod K
+    monitor_bin_t bins[MONITOR_WINDOW_BLOCKS_MAX];
+    uint8_t filled;                 // Bloques contiguos en la ventana (hasta K)
+    uint8_t since_update;           // Bloques desde la última actualización
+    uint32_t settle_left;           // Bloques que faltan descartar
+    uint32_t next_sequence;         // Bloque que se espera del DMA
+    monitor_batch_t batch;
+    monitor_stats_t stats;
+} monitor_state_t;
+
+static monitor_state_t monitor = { .active = false };
+
+void monitor_default_spec(monitor_spec_t *spec) {
+    spec->freq_hz = MONITOR_FREQ_HZ;
+    spec->window_blocks = MONITOR_WINDOW_BLOCKS;
+    spec->hop_blocks = MONITOR_HOP_BLOCKS;
+    spec->batch = MONITOR_BATCH;
+}
+
+/**
+ * @brief Ciclos enteros del tono en una ventana de K bloques (0 si no hay
+ *        un bin coherente entre DC y Nyquist)
+ */
+static uint32_t monitor_cycles(float freq_hz, uint8_t window_blocks) {
+    uint32_t length = (uint32_t)window_blocks * WINDOW_SIZE;
+    float m = rintf(freq_hz * (float)length / SAMPLE_RATE);
+
+    if (!(m >= 1.0f) || m >= (float)(length / 2)) {
+        return 0;
+    }
+    return (uint32_t)m;
+}
+
+bool monitor_check_spec(const monitor_spec_t *spec, float *freq_hz) {
+    if (!isfinite(spec->freq_hz) ||
+        spec->window_blocks < 1 || spec->window_blocks > MONITOR_WINDOW_BLOCKS_MAX ||
+        spec->hop_blocks < 1 || spec->hop_blocks > spec->window_blocks ||
+        spec->batch < 1 || spec->batch > MONITOR_BATCH_MAX) {
+        return false;
+    }
+
+    uint32_t cycles = monitor_cycles(spec->freq_hz, spec->window_blocks);
+    if (cycles == 0) {
+        return false;
+    }
+    if (freq_hz) {
+        *freq_hz = (float)cycles * SAMPLE_RATE / (float)((uint32_t)spec->window_blocks * WINDOW_SIZE);
+    }
+    return true;
+}
+
+/**
+ * @brief Vacía el mensaje en curso; el próximo empieza con la próxima
+ *        actualización
+ */
+static void monitor_flush(void) {
+    monitor_batch_t *batch = &monitor.batch;
+
+    if (batch->count == 0) {
+        return;
+    }
+    if (mqtt_publish_monitor(batch)) {
+        monitor.stats.messages++;
+    } else {
+        monitor.stats.publish_failures++;
+    }
+    batch->count = 0;
+}
+
+bool monitor_start(const monitor_spec_t *spec) {
+    float freq_hz;
+
+    if (!monitor_check_spec(spec, &freq_hz)) {
+        DEBUG_PRINT(1, "[MONITOR] Pedido inválido (%.1f Hz, ventana %u, paso %u, lote %u)\n",
+                    spec->freq_hz, spec->window_blocks, spec->hop_blocks, spec->batch);
+        return false;
+    }
+    sweep_status_t status = frequency_sweep_status();
+    if (status == SWEEP_RUNNING || status == SWEEP_PAUSED) {
+        return false;
+    }
+    if (monitor.active) {
+        monitor_stop();
+    }
+
+    uint8_t k = spec->window_blocks;
+    uint32_t cycles = monitor_cycles(spec->freq_hz, k);
+
+    monitor.spec = *spec;
+    monitor.freq_hz = freq_hz;
+    monitor.skew_rad = -2.0f * (float)M_PI * freq_hz * ADC_DMA_CHANNEL_SKEW_S;
+    goertzel_coeffs_init(&monitor.coeffs, freq_hz, SAMPLE_RATE);
+    for (uint8_t i = 0; i < k; i++) {
+        // (m·i) mod K exacto en enteros: la rotación no pierde precisión
+        // con tonos altos
+        float angle = -2.0f * (float)M_PI * (float)((cycles * i) % k) / (float)k;
+        monitor.rot_re[i] = cosf(angle);
+        monitor.rot_im[i] = sinf(angle);
+    }
+
+    // El DUT se asienta con la misma cota que usa el barrido sin detector
+    settle_params_t settle;
+    settle_params_init(&settle, freq_hz, SAMPLE_RATE);
+    uint64_t block_us = (uint64_t)WINDOW_SIZE * 1000000u / (uint64_t)SAMPLE_RATE;
+    monitor.settle_left = (uint32_t)((settle.max_us + block_us - 1) / block_us);
+
+    monitor.filled = 0;
+    monitor.since_update = 0;
+    monitor.next_sequence = 0;
+    memset(&monitor.batch, 0, sizeof(monitor.batch));
+    monitor.batch.freq_hz = freq_hz;
+    monitor.batch.update_hz = SAMPLE_RATE / (float)((uint32_t)WINDOW_SIZE * spec->hop_blocks);
+    monitor.batch.window_blocks = k;
+    monitor.batch.hop_blocks = spec->hop_blocks;
+    memset(&monitor.stats, 0, sizeof(monitor.stats));
+
+    ad9833_set_frequency(freq_hz);
+    ad9833_enable_output(true);
+
+    if (!adc_dma_start_continuous()) {
+        return false;
+    }
+    monitor.active = true;
+
+    DEBUG_PRINT(2, "[MONITOR] %.1f Hz, ventana de %u bloques, %.1f actualizaciones/s, %u por mensaje\n",
+                freq_hz, k, monitor.batch.update_hz, spec->batch);
+    return true;
+}
+
+void monitor_stop(void) {
+    if (!monitor.active) {
+        return;
+    }
+
+    adc_dma_stop_continuous();
+    monitor_flush();
+    monitor.active = false;
+
+    DEBUG_PRINT(2, "[MONITOR] Detenido: %lu actualizaciones, %lu huecos (%lu bloques)\n",
+                (unsigned long)monitor.stats.updates, (unsigned long)monitor.stats.gaps,
+                (unsigned long)monitor.stats.blocks_lost);
+}
+
+bool monitor_active(void) {
+    return monitor.active;
+}
+
+/**
+ * @brief Goertzel sobre un bloque y rotación a la referencia de la ventana
+ */
+static void monitor_block_bin(const adc_dma_block_t *block, monitor_bin_t *bin) {
+    uint8_t slot = (uint8_t)(block->sequence % monitor.spec.window_blocks);
+    float c = monitor.rot_re[slot];
+    float s = monitor.rot_im[slot];
+    float re, im;
+
+#if ADC_CHANNELS == 2
+    goertzel_pair_t pair;
+    goertzel_pair_init(&pair, &monitor.coeffs, block->num_samples);
+    goertzel_pair_push(&pair, block->samples, block->num_samples);
+
+    goertzel_stream_bin(&pair.reference, &re, &im);
+    bin->ref_re = re * c - im * s;
+    bin->ref_im = re * s + im * c;
+    goertzel_stream_bin(&pair.response, &re, &im);
+#else
+    goertzel_stream_t stream;
+    goertzel_stream_init(&stream, &monitor.coeffs, block->num_samples);
+    goertzel_stream_push(&stream, block->samples, block->num_samples);
+    goertzel_stream_bin(&stream, &re, &im);
+#endif
+    bin->resp_re = re * c - im * s;
+    bin->resp_im = re * s + im * c;
+}
+
+/**
+ * @brief Polar de un bin de la ventana completa
+ */
+static void monitor_polar(float re, float im, goertzel_result_t *result) {
+    float length = (float)((uint32_t)monitor.spec.window_blocks * WINDOW_SIZE);
+
+    result->magnitude = 2.0f * sqrtf(re * re + im * im) / length;
+    result->magnitude_db = 20.0f * log10f(fmaxf(result->magnitude, 1e-9f));
+    result->phase_rad = atan2f(im, re);
+    result->phase_deg = result->phase_rad * (180.0f / (float)M_PI);
+}
+
+/**
+ * @brief Suma la ventana y agrega la actualización al mensaje en curso
+ *
+ * Se suma desde los K bines cada vez en lugar de llevar una suma corrida,
+ * así el redondeo no se acumula a lo largo de horas de monitor.
+ */
+static void monitor_update(uint32_t sequence) {
+    monitor_bin_t sum = { 0 };
+
+    for (uint8_t i = 0; i < monitor.spec.window_blocks; i++) {
+#if ADC_CHANNELS == 2
+        sum.ref_re += monitor.bins[i].ref_re;
+        sum.ref_im += monitor.bins[i].ref_im;
+#endif
+        sum.resp_re += monitor.bins[i].resp_re;
+        sum.resp_im += monitor.bins[i].resp_im;
+    }
+
+    goertzel_result_t result;
+#if ADC_CHANNELS == 2
+    goertzel_result_t reference;
+    goertzel_result_t response;
+    monitor_polar(sum.ref_re, sum.ref_im, &reference);
+    monitor_polar(sum.resp_re, sum.resp_im, &response);
+    goertzel_transfer(&reference, &response, monitor.skew_rad, &result);
+#else
+    // Un canal: amplitud de la respuesta y fase contra el primer bloque de
+    // la captura (sin referencia, el origen no está atado al DDS)
+    monitor_polar(sum.resp_re, sum.resp_im, &result);
+#endif
+
+    monitor_batch_t *batch = &monitor.batch;
+    if (batch->count == 0) {
+        batch->block = sequence;
+    }
+    batch->magnitude_db[batch->count] = result.magnitude_db;
+    batch->phase_deg[batch->count] = result.phase_deg;
+    batch->count++;
+    monitor.stats.updates++;
+
+    if (batch->count == monitor.spec.batch) {
+        monitor_flush();
+    }
+}
+
+/**
+ * @brief Incorpora un bloque a la ventana
+ */
+static void monitor_consume(const adc_dma_block_t *block) {
+    if (block->sequence != monitor.next_sequence) {
+        // Overrun: la ventana no puede cruzar el hueco. Lo ya medido sale
+        // ahora y la ventana se vuelve a llenar desde este bloque
+        monitor.stats.gaps++;
+        monitor.stats.blocks_lost += block->sequence - monitor.next_sequence;
+        monitor.filled = 0;
+        monitor.since_update = 0;
+        monitor_flush();
+    }
+    monitor.next_sequence = block->sequence + 1;
+    monitor.stats.blocks++;
+
+    if (monitor.settle_left > 0) {
+        monitor.settle_left--;
+        monitor.stats.settle_blocks++;
+        return;
+    }
+
+    monitor_block_bin(block, &monitor.bins[block->sequence % monitor.spec.window_blocks]);
+
+    if (monitor.filled < monitor.spec.window_blocks) {
+        monitor.filled++;
+        if (monitor.filled < monitor.spec.window_blocks) {
+            return;
+        }
+        // Primera ventana completa: actualización inmediata
+        monitor.since_update = monitor.spec.hop_blocks;
+    } else {
+        monitor.since_update++;
+    }
+
+    if (monitor.since_update >= monitor.spec.hop_blocks) {
+        monitor.since_update = 0;
+        monitor_update(block->sequence);
+    }
+}
+
+uint32_t monitor_poll(void) {
+    uint32_t processed = 0;
+    adc_dma_block_t block;
+
+    if (!monitor.active) {
+        return 0;
+    }
+
+    while (adc_dma_acquire_ready_buffer(&block)) {
+        monitor_consume(&block);
+        adc_dma_release_buffer(&block);
+        processed++;
+    }
+    return processed;
+}
+
+void monitor_get_spec(monitor_spec_t *spec) {
+    if (monitor.spec.window_blocks == 0) {
+        monitor_default_spec(spec);
+    } else {
+        *spec = monitor.spec;
+    }
+}
+
+void monitor_get_stats(monitor_stats_t *stats) {
+    *stats = monitor.stats;
+}
+
+size_t monitor_format_json(const monitor_batch_t *batch, char *buf, size_t capacity) {
+    json_writer_t w;
+    json_writer_init(&w, buf, capacity);
+    json_writer_begin_object(&w);
+    json_writer_key(&w, "freq");
+    json_writer_fixed(&w, batch->freq_hz, JSON_FREQ_DECIMALS);
+    json_writer_key(&w, "rate");
+    json_writer_fixed(&w, batch->update_hz, JSON_FREQ_DECIMALS);
+    json_writer_key(&w, "window");
+    json_writer_uint(&w, batch->window_blocks);
+    json_writer_key(&w, "hop");
+    json_writer_uint(&w, batch->hop_blocks);
+    json_writer_key(&w, "block");
+    json_writer_uint(&w, batch->block);
+    json_writer_key(&w, "mag_db");
+    json_writer_begin_array(&w);
+    for (uint8_t i = 0; i < batch->count; i++) {
+        json_writer_fixed(&w, batch->magnitude_db[i], JSON_MAG_DECIMALS);
+    }
+    json_writer_end_array(&w);
+    json_writer_key(&w, "phase_deg");
+    json_writer_begin_array(&w);
+    for (uint8_t i = 0; i < batch->count; i++) {
+        json_writer_fixed(&w, batch->phase_deg[i], JSON_PHASE_DECIMALS);
+    }
+    json_writer_end_array(&w);
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
+}
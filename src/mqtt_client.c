@@ -2,86 +2,280 @@
  * @file mqtt_client.c
  * @brief Implementación del cliente MQTT
  * 
+ * Las funciones mqtt_publish_*() no tocan la red: serializan en un slot de
+ * la cola de publicación y retornan. mqtt_client_poll(), llamado desde el
+ * contexto de red, drena la cola. mqtt_client_replay() suma a la cola los
+ * barridos guardados en flash mientras no había broker. Los comandos que
+ * llegan por MQTT_TOPIC_COMMAND pasan por mqtt_client_incoming() a la
+ * bandeja de command.h.
+ * 
  * ESTADO: STUB - Implementación mínima para compilación
  * TODO: Implementar cliente MQTT completo con lwIP
  */
 
 #include "mqtt_client.h"
+#include "command.h"
 #include "config.h"
+#include "debug.h"
+#include "json_writer.h"
+#include "monitor.h"
+#include "multitone.h"
+#include "publish_queue.h"
+#include "sweep_store.h"
+#include "trace.h"
 #include <stdio.h>
 #include <string.h>
 
+// Payload JSON de medición o de estado (dentro de un slot de la cola)
+#define MQTT_JSON_PAYLOAD_SIZE 128
+
+#if MQTT_JSON_PAYLOAD_SIZE > PUBLISH_QUEUE_MSG_MAX
+#error "MQTT_JSON_PAYLOAD_SIZE no entra en un slot de la cola de publicación"
+#endif
+
+#if TRACE_JSON_MAX > PUBLISH_QUEUE_MSG_MAX
+#error "TRACE_JSON_MAX no entra en un slot de la cola de publicación"
+#endif
+
+#if COMMAND_ACK_JSON_MAX > PUBLISH_QUEUE_MSG_MAX
+#error "COMMAND_ACK_JSON_MAX no entra en un slot de la cola de publicación"
+#endif
+
+#if MONITOR_JSON_MAX > PUBLISH_QUEUE_MSG_MAX
+#error "MONITOR_JSON_MAX no entra en un slot de la cola de publicación"
+#endif
+
+#if MULTITONE_JSON_MAX > PUBLISH_QUEUE_MSG_MAX
+#error "MULTITONE_JSON_MAX no entra en un slot de la cola de publicación"
+#endif
+
 // Estado del cliente
 static bool is_connected = false;
 static mqtt_config_t current_config;
 
+// Registro del almacén en flash que está en la cola (0 = ninguno)
+static uint32_t replay_in_flight = 0;
+
+
 bool mqtt_init(const mqtt_config_t *config) {
-    printf("[MQTT] Inicializando... (STUB)\n");
-    printf("[MQTT] Broker: %s:%d\n", config->broker_addr, config->broker_port);
-    printf("[MQTT] Client ID: %s\n", config->client_id);
-    printf("[MQTT] Topic: %s\n", config->topic);
+    DEBUG_PRINT(2, "[MQTT] Inicializando... (STUB)\n");
+    DEBUG_PRINT(2, "[MQTT] Broker: %s:%d\n", config->broker_addr, config->broker_port);
+    DEBUG_PRINT(2, "[MQTT] Client ID: %s\n", config->client_id);
+    DEBUG_PRINT(2, "[MQTT] Topic: %s\n", config->topic);
     
     // Guardar configuración
     current_config = *config;
+    publish_queue_init(PUBLISH_QUEUE_POLICY);
+    replay_in_flight = 0;
     
     // TODO: Implementar conexión real MQTT:
     // - Crear cliente MQTT con lwip_mqtt
     // - Configurar callbacks
     // - Conectar al broker
     // - Manejar autenticación si es necesaria
+    // - Suscribirse a MQTT_TOPIC_COMMAND (mqtt_subscribe) y registrar con
+    //   mqtt_set_inpub_callback() un par de callbacks que junten los tramos
+    //   del payload y, con MQTT_DATA_FLAG_LAST, llamen a
+    //   mqtt_client_incoming()
     
     // Simular conexión exitosa
     is_connected = true;
-    printf("[MQTT] Conectado (modo stub)\n");
+    DEBUG_PRINT(2, "[MQTT] Conectado (modo stub)\n");
     
     return true;
 }
 
+/**
+ * @brief Encola el payload JSON serializado en el slot (len = 0: no entró)
+ */
+static bool mqtt_commit_json(publish_msg_t *msg, size_t len) {
+    if (len == 0) {
+        DEBUG_PRINT(0, "[MQTT] ERROR: Payload JSON demasiado grande\n");
+        publish_queue_commit(msg, 0);
+        return false;
+    }
+    publish_queue_commit(msg, (uint16_t)len);
+    return true;
+}
+
 bool mqtt_publish_measurement(
     float frequency_hz,
     float magnitude_db,
     float phase_deg
 ) {
-    if (!is_connected) {
-        printf("[MQTT] ERROR: No conectado al broker\n");
+    publish_msg_t *msg = publish_queue_reserve(current_config.topic);
+    if (!msg) {
         return false;
     }
     
-    // Construir payload JSON
-    char payload[128];
-    snprintf(payload, sizeof(payload),
-             "{\"freq\":%.1f,\"mag\":%.2f,\"phase\":%.1f}",
-             frequency_hz, magnitude_db, phase_deg);
-    
-    printf("[MQTT] Publicando: %s (STUB)\n", payload);
+    // Serializar directo en el slot (punto fijo entero, sin printf de floats)
+    json_point_t point = { frequency_hz, magnitude_db, phase_deg };
+    size_t len = json_format_measurement((char *)msg->payload, MQTT_JSON_PAYLOAD_SIZE, &point);
+    return mqtt_commit_json(msg, len);
+}
+
+bool mqtt_publish_sweep_frame(const sweep_frame_t *frame) {
+    publish_msg_t *msg = publish_queue_reserve(MQTT_TOPIC_SWEEP);
+    if (!msg) {
+        return false;
+    }
     
-    // TODO: Implementar publicación real MQTT
-    // - mqtt_publish() con el payload JSON
-    // - Manejar QoS según configuración
-    // - Verificar ACK si QoS > 0
+    size_t len = sweep_frame_encode(frame, msg->payload, sizeof(msg->payload));
+    if (len == 0) {
+        DEBUG_PRINT(0, "[MQTT] ERROR: Trama de barrido demasiado grande\n");
+        publish_queue_commit(msg, 0);
+        return false;
+    }
     
+    publish_queue_commit(msg, (uint16_t)len);
     return true;
 }
 
 bool mqtt_publish_status(const char *status_msg) {
-    if (!is_connected) {
-        printf("[MQTT] ERROR: No conectado al broker\n");
+    publish_msg_t *msg = publish_queue_reserve(MQTT_TOPIC_STATUS);
+    if (!msg) {
         return false;
     }
     
-    printf("[MQTT] Publicando estado: %s (STUB)\n", status_msg);
+    size_t len = json_format_status((char *)msg->payload, MQTT_JSON_PAYLOAD_SIZE, status_msg);
+    return mqtt_commit_json(msg, len);
+}
+
+bool mqtt_publish_trace(const trace_report_t *report) {
+    publish_msg_t *msg = publish_queue_reserve(MQTT_TOPIC_TRACE);
+    if (!msg) {
+        return false;
+    }
     
-    // TODO: Implementar publicación de estado
+    size_t len = trace_format_json(report, (char *)msg->payload, TRACE_JSON_MAX);
+    return mqtt_commit_json(msg, len);
+}
+
+bool mqtt_publish_command_ack(const command_ack_t *ack) {
+    publish_msg_t *msg = publish_queue_reserve(MQTT_TOPIC_STATUS);
+    if (!msg) {
+        return false;
+    }
     
+    size_t len = command_format_ack(ack, (char *)msg->payload, COMMAND_ACK_JSON_MAX);
+    return mqtt_commit_json(msg, len);
+}
+
+bool mqtt_publish_monitor(const monitor_batch_t *batch) {
+    publish_msg_t *msg = publish_queue_reserve(MQTT_TOPIC_MONITOR);
+    if (!msg) {
+        return false;
+    }
+    
+    size_t len = monitor_format_json(batch, (char *)msg->payload, MONITOR_JSON_MAX);
+    return mqtt_commit_json(msg, len);
+}
+
+bool mqtt_publish_multitone(const multitone_plan_t *plan, const multitone_result_t *result,
+                            uint32_t sweep_id) {
+    publish_msg_t *msg = publish_queue_reserve(MQTT_TOPIC_MULTITONE);
+    if (!msg) {
+        return false;
+    }
+    
+    size_t len = multitone_format_json(plan, result, sweep_id, (char *)msg->payload,
+                                       MULTITONE_JSON_MAX);
+    return mqtt_commit_json(msg, len);
+}
+
+bool mqtt_client_incoming(const char *topic, const uint8_t *payload, size_t len) {
+    if (strcmp(topic, MQTT_TOPIC_COMMAND) != 0) {
+        DEBUG_PRINT(3, "[MQTT] Mensaje ignorado en %s\n", topic);
+        return false;
+    }
+    
+    if (!command_deliver(payload, len)) {
+        DEBUG_PRINT(0, "[MQTT] ERROR: Bandeja de comandos llena, comando descartado\n");
+        return false;
+    }
     return true;
 }
 
+uint32_t mqtt_client_poll(uint32_t max_messages) {
+    uint32_t sent = 0;
+    
+    if (!is_connected) {
+        // Sin broker los mensajes esperan en la cola (o los descarta la
+        // política de desborde) hasta la reconexión
+        return 0;
+    }
+    
+    while (sent < max_messages) {
+        publish_msg_t *msg = publish_queue_acquire();
+        if (!msg) {
+            break;
+        }
+        
+        DEBUG_PRINT(3, "[MQTT] Publicando en %s: %u bytes (STUB)\n", msg->topic, msg->len);
+        
+        // TODO: Implementar publicación real MQTT
+        // - mqtt_publish(client, msg->topic, msg->payload, msg->len, MQTT_QOS, 0, cb, msg)
+        // - Si retorna ERR_MEM (buffer TCP lleno) conservar el slot y
+        //   reintentar en la próxima pasada
+        // - Liberar el slot con publish_queue_release() desde el callback
+        
+        publish_queue_release(msg, true);
+        sent++;
+    }
+    
+    return sent;
+}
+
+uint32_t mqtt_client_replay(void) {
+    uint32_t receipt;
+    bool sent;
+    
+    // Confirmar en flash lo que la red ya entregó
+    while (publish_queue_take_receipt(&receipt, &sent)) {
+        if (receipt != replay_in_flight) {
+            continue;
+        }
+        replay_in_flight = 0;
+        if (sent) {
+            sweep_store_ack(receipt);
+        }
+    }
+    
+    if (!is_connected || replay_in_flight != 0 || sweep_store_pending() == 0) {
+        return sweep_store_pending();
+    }
+    
+    // Dejar siempre un slot libre para el barrido en curso
+    publish_queue_stats_t stats;
+    publish_queue_get_stats(&stats);
+    if (stats.depth + 1 >= PUBLISH_QUEUE_SLOTS) {
+        return sweep_store_pending();
+    }
+    
+    publish_msg_t *msg = publish_queue_reserve(MQTT_TOPIC_SWEEP);
+    if (!msg) {
+        return sweep_store_pending();
+    }
+    
+    // El registro ya es una trama v1: se copia tal cual al slot
+    uint16_t len = sweep_store_read_oldest(msg->payload, sizeof(msg->payload), &receipt);
+    if (len > 0) {
+        msg->receipt = receipt;
+        replay_in_flight = receipt;
+        DEBUG_PRINT(2, "[MQTT] Reenviando barrido guardado (registro %lu)\n",
+                    (unsigned long)receipt);
+    }
+    publish_queue_commit(msg, len);
+    
+    return sweep_store_pending();
+}
+
 bool mqtt_is_connected(void) {
     return is_connected;
 }
 
 bool mqtt_reconnect(void) {
-    printf("[MQTT] Intentando reconectar... (STUB)\n");
+    DEBUG_PRINT(1, "[MQTT] Intentando reconectar... (STUB)\n");
     
     // TODO: Implementar lógica de reconexión
     
@@ -90,7 +284,7 @@ bool mqtt_reconnect(void) {
 }
 
 void fra_mqtt_disconnect(void) {
-    printf("[MQTT] Desconectando... (STUB)\n");
+    DEBUG_PRINT(2, "[MQTT] Desconectando... (STUB)\n");
     
     // TODO: Implementar desconexión limpia
     
@@ -0,0 +1,624 @@
+/**
+ * @file multitone.c
+ * @brief Implementación de la excitación multitono
+ */
+
+#include "multitone.h"
+#include "ad9833.h"
+#include "adc_dma.h"
+#include "debug.h"
+#include "hal.h"
+#include "json_writer.h"
+#include "monitor.h"
+#include "mqtt_client.h"
+#include "settle.h"
+#include "sweep.h"
+#include "sweep_average.h"
+#include "sweep_frame.h"
+#include "sweep_store.h"
+#include <math.h>
+#include <string.h>
+
+#if MULTITONE_PERIOD_BLOCKS_MAX < 1 || MULTITONE_PERIOD_BLOCKS_MAX > UINT8_MAX
+#error "MULTITONE_PERIOD_BLOCKS_MAX debe estar entre 1 y 255"
+#endif
+
+#if MULTITONE_TONES_MAX < 1 || MULTITONE_TONES_MAX > SWEEP_FRAME_MAX_POINTS
+#error "MULTITONE_TONES_MAX no entra en una trama de barrido"
+#endif
+
+#if SWEEP_ADAPTIVE && SWEEP_MULTITONE
+#error "SWEEP_ADAPTIVE y SWEEP_MULTITONE son excluyentes"
+#endif
+
+// Refinamiento del factor de cresta (multitone_plan_build()): pasadas
+// sobre el período y paso inicial de fase del tono con mayor gradiente
+#define MULTITONE_CREST_ITERATIONS 60
+#define MULTITONE_CREST_STEP_RAD 0.1f
+
+// Puntos por muestra de cada pasada del refinamiento: solo sobre la grilla
+// el descenso baja el pico ahí y lo sube entre muestras
+#define MULTITONE_CREST_OVERSAMPLE 2u
+
+// Puntos por muestra al buscar el pico entre muestras: el generador
+// reconstruye una señal continua que puede pasar el pico de la grilla
+#define MULTITONE_PEAK_OVERSAMPLE 8u
+
+// Margen sobre la duración prevista antes de dar la captura por trabada
+#define MULTITONE_TIMEOUT_MS 1000u
+
+static multitone_plan_t multitone_plan;
+static multitone_params_t multitone_planned_params;
+static bool multitone_planned = false;
+static sweep_frame_t multitone_frame;
+
+#if ADC_CHANNELS == 2
+// Estado de multitone_measure(): bines del bloque, sumas del período en
+// curso (re, im por tono) y promedio de H entre períodos
+static float block_ref[2 * MULTITONE_TONES_MAX];
+static float block_resp[2 * MULTITONE_TONES_MAX];
+static float period_ref[2 * MULTITONE_TONES_MAX];
+static float period_resp[2 * MULTITONE_TONES_MAX];
+static sweep_average_t tone_avg[MULTITONE_TONES_MAX];
+
+#if FFT_SIZE_SUPPORTED(WINDOW_SIZE)
+// Trabajo de fft_pair_bins(): solo hace falta con bloques de largo
+// potencia de dos
+static float fft_scratch[2 * WINDOW_SIZE];
+#endif
+#endif
+
+// Refinamiento de las fases al planificar: un bloque de la excitación,
+// los bines de y^15, el gradiente actual y el del paso a evaluar, y las
+// fases antes de ese paso
+static float synth_block[WINDOW_SIZE];
+static float bin_re[MULTITONE_TONES_MAX];
+static float bin_im[MULTITONE_TONES_MAX];
+static float grad[MULTITONE_TONES_MAX];
+static float candidate_grad[MULTITONE_TONES_MAX];
+static float prev_phase[MULTITONE_TONES_MAX];
+
+void multitone_default_params(multitone_params_t *params) {
+    params->grid = SWEEP_GRID_LOG;
+    params->start_hz = SWEEP_FREQ_MIN;
+    params->stop_hz = SWEEP_FREQ_MAX;
+    params->tones = MULTITONE_TONES;
+    params->list_hz = NULL;
+    params->period_blocks = MULTITONE_PERIOD_BLOCKS;
+    params->periods = MULTITONE_PERIODS;
+    params->peak = MULTITONE_PEAK;
+}
+
+/**
+ * @brief Tono pedido número k
+ */
+static float multitone_requested(const multitone_params_t *params, uint16_t k) {
+    if (params->grid == SWEEP_GRID_LIST) {
+        return params->list_hz[k];
+    }
+    if (params->tones == 1) {
+        return params->start_hz;
+    }
+
+    float t = (float)k / (float)(params->tones - 1);
+    if (params->grid == SWEEP_GRID_LOG) {
+        return params->start_hz * powf(params->stop_hz / params->start_hz, t);
+    }
+    return params->start_hz + t * (params->stop_hz - params->start_hz);
+}
+
+static uint32_t multitone_gcd(uint32_t a, uint32_t b) {
+    while (b != 0) {
+        uint32_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/**
+ * @brief Excitación desplazada una fracción de muestra
+ *
+ * @param frac Corrimiento en muestras, 0 <= frac < 1 (0 es la grilla)
+ */
+static void multitone_synth(const multitone_plan_t *plan, uint32_t first, float frac, float *dst,
+                            uint32_t num_samples) {
+    uint32_t length = plan->period_samples;
+    uint32_t offset = first % length;
+
+    memset(dst, 0, num_samples * sizeof(float));
+
+    // Un rotor por tono: arranca exacto en el índice pedido ((m·n) mod N en
+    // enteros) y avanza por multiplicación, sin un sinf por muestra
+    for (uint16_t i = 0; i < plan->count; i++) {
+        float w = 2.0f * (float)M_PI / (float)length;
+        float angle = w * ((float)((plan->cycles[i] * offset) % length) + (float)plan->cycles[i] * frac)
+                      + plan->phase_rad[i];
+        float re = plan->amplitude * cosf(angle);
+        float im = plan->amplitude * sinf(angle);
+        float step_re = cosf(w * (float)plan->cycles[i]);
+        float step_im = sinf(w * (float)plan->cycles[i]);
+
+        for (uint32_t n = 0; n < num_samples; n++) {
+            dst[n] += im;
+            float next = re * step_re - im * step_im;
+            im = re * step_im + im * step_re;
+            re = next;
+        }
+    }
+}
+
+void multitone_excitation(const multitone_plan_t *plan, uint32_t first, float *dst,
+                          uint32_t num_samples) {
+    multitone_synth(plan, first, 0.0f, dst, num_samples);
+}
+
+/**
+ * @brief Una pasada sobre el período de la suma de tonos unitarios
+ *
+ * Evalúa J = Σ y[n]^16 con y = x/rms (la norma L16 sigue de cerca al pico
+ * pero es derivable) y su gradiente respecto de la fase de cada tono:
+ * ∂J/∂φ_i ∝ Σ y^15·cos(θ_i[n] + φ_i), que sale del bin m_i de y^15. Las
+ * sumas corren sobre MULTITONE_CREST_OVERSAMPLE puntos por muestra.
+ *
+ * @param plan Plan con las fases a evaluar (amplitude = 1)
+ * @param scale 1/rms de la suma
+ * @param norm Salida: J
+ * @param grad Salida: gradiente por tono (escala arbitraria)
+ * @return Pico de la suma en los puntos evaluados
+ */
+static float multitone_norm_pass(const multitone_plan_t *plan, float scale, double *norm,
+                                 float *grad) {
+    uint32_t length = plan->period_samples;
+    float w = 2.0f * (float)M_PI / (float)length;
+    float peak = 0.0f;
+    double sum = 0.0;
+
+    memset(bin_re, 0, plan->count * sizeof(float));
+    memset(bin_im, 0, plan->count * sizeof(float));
+
+    for (uint32_t point = 0; point < MULTITONE_CREST_OVERSAMPLE * length; point += WINDOW_SIZE) {
+        uint32_t first = point % length;
+        float frac = (float)(point / length) / (float)MULTITONE_CREST_OVERSAMPLE;
+
+        multitone_synth(plan, first, frac, synth_block, WINDOW_SIZE);
+        for (uint32_t n = 0; n < WINDOW_SIZE; n++) {
+            float y = synth_block[n] * scale;
+            float y2 = y * y;
+            float y4 = y2 * y2;
+            float y8 = y4 * y4;
+
+            peak = fmaxf(peak, fabsf(synth_block[n]));
+            sum += (double)(y8 * y8);
+            synth_block[n] = y8 * y4 * y2 * y;
+        }
+
+        // Bin m_i del tramo, con la fase referida al inicio del período
+        for (uint16_t i = 0; i < plan->count; i++) {
+            float angle = -w * ((float)((plan->cycles[i] * first) % length)
+                                + (float)plan->cycles[i] * frac);
+            float re = cosf(angle);
+            float im = sinf(angle);
+            float step_re = cosf(w * (float)plan->cycles[i]);
+            float step_im = -sinf(w * (float)plan->cycles[i]);
+            float acc_re = 0.0f;
+            float acc_im = 0.0f;
+
+            for (uint32_t n = 0; n < WINDOW_SIZE; n++) {
+                acc_re += synth_block[n] * re;
+                acc_im += synth_block[n] * im;
+                float next = re * step_re - im * step_im;
+                im = re * step_im + im * step_re;
+                re = next;
+            }
+            bin_re[i] += acc_re;
+            bin_im[i] += acc_im;
+        }
+    }
+
+    // Σ y^15·cos(θ + φ) = Re(e^{jφ}·conj(D)) con D = Σ y^15·e^{-jθ}
+    for (uint16_t i = 0; i < plan->count; i++) {
+        grad[i] = bin_re[i] * cosf(plan->phase_rad[i]) + bin_im[i] * sinf(plan->phase_rad[i]);
+    }
+    *norm = sum;
+    return peak;
+}
+
+/**
+ * @brief Pico de la suma entre muestras
+ *
+ * Recorre el período corrido k/MULTITONE_PEAK_OVERSAMPLE de muestra. Con
+ * tonos cerca de Nyquist la señal reconstruida pasa bastante el pico de
+ * la grilla, y la captura no arranca necesariamente sobre esa grilla.
+ *
+ * @param grid_peak Pico en los puntos de multitone_norm_pass()
+ */
+static float multitone_interpolated_peak(const multitone_plan_t *plan, float grid_peak) {
+    float peak = grid_peak;
+
+    for (uint32_t k = 1; k < MULTITONE_PEAK_OVERSAMPLE; k++) {
+        float frac = (float)k / (float)MULTITONE_PEAK_OVERSAMPLE;
+        for (uint32_t first = 0; first < plan->period_samples; first += WINDOW_SIZE) {
+            multitone_synth(plan, first, frac, synth_block, WINDOW_SIZE);
+            for (uint32_t n = 0; n < WINDOW_SIZE; n++) {
+                peak = fmaxf(peak, fabsf(synth_block[n]));
+            }
+        }
+    }
+    return peak;
+}
+
+bool multitone_plan_build(multitone_plan_t *plan, const multitone_params_t *params) {
+    plan->count = 0;
+
+    if (params->tones == 0 || params->tones > MULTITONE_TONES_MAX
+        || params->period_blocks < 1 || params->period_blocks > MULTITONE_PERIOD_BLOCKS_MAX
+        || params->periods == 0 || !(params->peak > 0.0f && params->peak <= 0.5f)
+        || (params->grid == SWEEP_GRID_LIST && params->list_hz == NULL)
+        || (params->grid == SWEEP_GRID_LOG && !(params->start_hz > 0.0f && params->stop_hz > 0.0f))) {
+        DEBUG_PRINT(0, "[MULTI] ERROR: Pedido de multiseno inválido\n");
+        return false;
+    }
+
+    uint32_t length = (uint32_t)params->period_blocks * WINDOW_SIZE;
+    plan->period_blocks = params->period_blocks;
+    plan->period_samples = length;
+
+    for (uint16_t k = 0; k < params->tones; k++) {
+        float requested = multitone_requested(params, k);
+        float m = rintf(requested * (float)length / SAMPLE_RATE);
+
+        if (!(m >= 1.0f) || m >= (float)(length / 2)) {
+            DEBUG_PRINT(0, "[MULTI] ERROR: %.2f Hz no tiene bin en un período de %lu muestras\n",
+                        requested, (unsigned long)length);
+            plan->count = 0;
+            return false;
+        }
+        // Dos tonos en el mismo bin se sumarían: queda el primero
+        if (plan->count > 0 && (uint16_t)m <= plan->cycles[plan->count - 1]) {
+            continue;
+        }
+
+        uint16_t i = plan->count++;
+        plan->cycles[i] = (uint16_t)m;
+        plan->freq_hz[i] = m * SAMPLE_RATE / (float)length;
+        plan->skew_rad[i] = -2.0f * (float)M_PI * plan->freq_hz[i] * ADC_DMA_CHANNEL_SKEW_S;
+        goertzel_coeffs_init(&plan->coeffs[i], plan->freq_hz[i], SAMPLE_RATE);
+    }
+
+    // Un tono cae en un bin exacto del bloque si completa ciclos enteros en
+    // cada uno (m_i múltiplo de B); con todos exactos y bastantes tonos la
+    // FFT del bloque es más barata que un Goertzel por tono
+    bool exact = true;
+    for (uint16_t i = 0; i < plan->count; i++) {
+        exact = exact && plan->cycles[i] % plan->period_blocks == 0;
+        plan->fft_bins[i] = (uint16_t)(plan->cycles[i] / plan->period_blocks);
+    }
+    plan->detector = fft_choose_detector(WINDOW_SIZE, plan->count, exact);
+
+    // Schroeder con bines arbitrarios: el retardo de grupo del tono i es la
+    // fracción i/K del período de la suma (N/g, con g el mcd de los bines),
+    // así que la fase avanza φ_i = φ_{i-1} - 2π·((m_i - m_{i-1})/g)·i/K. Con
+    // bines consecutivos es la fórmula clásica -π·i·(i+1)/K. Se acumula en
+    // enteros módulo K (unidades de 2π/K) para no perder precisión
+    uint32_t g = 0;
+    for (uint16_t i = 0; i < plan->count; i++) {
+        g = multitone_gcd(g, plan->cycles[i]);
+    }
+    uint32_t units = 0;
+    for (uint16_t i = 0; i < plan->count; i++) {
+        if (i > 0) {
+            uint32_t delta = (uint32_t)(plan->cycles[i] - plan->cycles[i - 1]) / g;
+            units = (uint32_t)((units + (uint64_t)delta * i) % plan->count);
+        }
+        plan->phase_rad[i] = -2.0f * (float)M_PI * (float)units / (float)plan->count;
+    }
+
+    // Con bines dispersos (grilla logarítmica) Schroeder ya no alcanza: se
+    // refina por descenso de gradiente sobre la norma L16, con un paso que
+    // crece mientras J baja y se achica cuando un paso la sube (se deshace)
+    float rms = sqrtf(0.5f * (float)plan->count);
+    float step = MULTITONE_CREST_STEP_RAD;
+    double norm;
+    plan->amplitude = 1.0f;
+    float peak = multitone_norm_pass(plan, 1.0f / rms, &norm, grad);
+    for (uint16_t it = 0; it < MULTITONE_CREST_ITERATIONS; it++) {
+        float largest = 0.0f;
+        for (uint16_t i = 0; i < plan->count; i++) {
+            largest = fmaxf(largest, fabsf(grad[i]));
+            prev_phase[i] = plan->phase_rad[i];
+        }
+        if (!(largest > 0.0f)) {
+            break;
+        }
+        for (uint16_t i = 0; i < plan->count; i++) {
+            plan->phase_rad[i] -= step * grad[i] / largest;
+        }
+
+        double candidate;
+        float current = multitone_norm_pass(plan, 1.0f / rms, &candidate, candidate_grad);
+        if (candidate < norm) {
+            norm = candidate;
+            peak = current;
+            memcpy(grad, candidate_grad, plan->count * sizeof(float));
+            step *= 1.5f;
+        } else {
+            memcpy(plan->phase_rad, prev_phase, plan->count * sizeof(float));
+            step *= 0.5f;
+        }
+    }
+    for (uint16_t i = 0; i < plan->count; i++) {
+        plan->phase_rad[i] = remainderf(plan->phase_rad[i], 2.0f * (float)M_PI);
+    }
+    peak = multitone_interpolated_peak(plan, peak);
+
+    plan->crest_factor = peak / rms;
+    plan->amplitude = params->peak / peak;
+    plan->tone_db = -20.0f * log10f(peak);
+
+    DEBUG_PRINT(2, "[MULTI] %u tonos %.1f-%.1f Hz, período %lu muestras, cresta %.2f, %.1f dB por tono, %s\n",
+                plan->count, plan->freq_hz[0], plan->freq_hz[plan->count - 1],
+                (unsigned long)length, plan->crest_factor, plan->tone_db,
+                plan->detector == FFT_DETECTOR_FFT ? "FFT" : "Goertzel");
+    return true;
+}
+
+#if ADC_CHANNELS == 2
+
+/**
+ * @brief Bines de un bloque, rotados a la referencia del período y
+ *        sumados al período en curso
+ */
+static void multitone_consume(const multitone_plan_t *plan, const adc_dma_block_t *block,
+                              const float *root_re, const float *root_im) {
+    uint8_t b = plan->period_blocks;
+    uint32_t slot = block->sequence % b;
+
+    bool detected = false;
+#if FFT_SIZE_SUPPORTED(WINDOW_SIZE)
+    if (plan->detector == FFT_DETECTOR_FFT && block->num_samples == WINDOW_SIZE) {
+        detected = fft_pair_bins(block->samples, WINDOW_SIZE, plan->fft_bins, plan->count,
+                                 fft_scratch, block_ref, block_resp);
+    }
+#endif
+    if (!detected) {
+        goertzel_pair_bins(block->samples, block->num_samples, plan->coeffs, plan->count,
+                           block_ref, block_resp);
+    }
+
+    for (uint16_t i = 0; i < plan->count; i++) {
+        // e^{-j·2π·m_i·slot/B}: B raíces de la unidad para todos los tonos
+        uint32_t r = (plan->cycles[i] * slot) % b;
+        float c = root_re[r];
+        float s = root_im[r];
+        float re = block_ref[2 * i];
+        float im = block_ref[2 * i + 1];
+
+        period_ref[2 * i] += re * c - im * s;
+        period_ref[2 * i + 1] += re * s + im * c;
+        re = block_resp[2 * i];
+        im = block_resp[2 * i + 1];
+        period_resp[2 * i] += re * c - im * s;
+        period_resp[2 * i + 1] += re * s + im * c;
+    }
+}
+
+/**
+ * @brief H = Y/X de cada tono en el período completo
+ */
+static void multitone_close_period(const multitone_plan_t *plan) {
+    for (uint16_t i = 0; i < plan->count; i++) {
+        float x_re = period_ref[2 * i];
+        float x_im = period_ref[2 * i + 1];
+        float y_re = period_resp[2 * i];
+        float y_im = period_resp[2 * i + 1];
+        float den = fmaxf(x_re * x_re + x_im * x_im, 1e-20f);
+
+        sweep_average_add(&tone_avg[i], (y_re * x_re + y_im * x_im) / den,
+                          (y_im * x_re - y_re * x_im) / den);
+    }
+}
+
+#endif // ADC_CHANNELS == 2
+
+bool multitone_measure(const multitone_plan_t *plan, uint16_t periods,
+                       multitone_result_t *result) {
+#if ADC_CHANNELS != 2
+    (void)plan;
+    (void)periods;
+    (void)result;
+    DEBUG_PRINT(0, "[MULTI] ERROR: La multiseno se mide contra el canal de referencia (ADC_CHANNELS = 2)\n");
+    return false;
+#else
+    sweep_status_t status = frequency_sweep_status();
+    if (plan->count == 0 || periods == 0 || status == SWEEP_RUNNING || status == SWEEP_PAUSED
+        || monitor_active()) {
+        return false;
+    }
+
+    uint32_t start_ms = hal_time_ms();
+    uint8_t b = plan->period_blocks;
+    float root_re[MULTITONE_PERIOD_BLOCKS_MAX];
+    float root_im[MULTITONE_PERIOD_BLOCKS_MAX];
+    for (uint8_t r = 0; r < b; r++) {
+        float angle = -2.0f * (float)M_PI * (float)r / (float)b;
+        root_re[r] = cosf(angle);
+        root_im[r] = sinf(angle);
+    }
+    for (uint16_t i = 0; i < plan->count; i++) {
+        sweep_average_init(&tone_avg[i]);
+    }
+    memset(period_ref, 0, sizeof(period_ref));
+    memset(period_resp, 0, sizeof(period_resp));
+
+    // El tono más bajo es el que más tarda en asentar
+    settle_params_t settle;
+    settle_params_init(&settle, plan->freq_hz[0], SAMPLE_RATE);
+    uint64_t block_us = (uint64_t)WINDOW_SIZE * 1000000u / (uint64_t)SAMPLE_RATE;
+    uint32_t settle_left = (uint32_t)((settle.max_us + block_us - 1) / block_us);
+    uint64_t expected_us = ((uint64_t)settle_left + (uint64_t)periods * b) * block_us;
+    uint32_t deadline_ms = (uint32_t)(2u * expected_us / 1000u) + MULTITONE_TIMEOUT_MS;
+
+    result->count = 0;
+    result->periods = 0;
+    result->settle_blocks = settle_left;
+    result->gaps = 0;
+
+    // La excitación viene de afuera: el DDS no tiene que sumarse. Al salir
+    // la salida vuelve a como estaba, para los barridos y puntos que siguen
+    bool output_was_enabled = ad9833_is_output_enabled();
+    ad9833_enable_output(false);
+    if (!adc_dma_start_continuous()) {
+        ad9833_enable_output(output_was_enabled);
+        return false;
+    }
+
+    uint32_t next_sequence = 0;
+    uint8_t filled = 0;
+    adc_dma_block_t block;
+
+    while (result->periods < periods) {
+        if (!adc_dma_acquire_ready_buffer(&block)) {
+            if (hal_time_ms() - start_ms > deadline_ms) {
+                break;
+            }
+            hal_cpu_relax();
+            continue;
+        }
+
+        if (block.sequence != next_sequence) {
+            // Overrun: el período en curso queda incompleto y se descarta
+            result->gaps++;
+            filled = 0;
+            memset(period_ref, 0, sizeof(period_ref));
+            memset(period_resp, 0, sizeof(period_resp));
+        }
+        next_sequence = block.sequence + 1;
+
+        if (settle_left > 0) {
+            settle_left--;
+        } else {
+            multitone_consume(plan, &block, root_re, root_im);
+            if (++filled == b) {
+                multitone_close_period(plan);
+                result->periods++;
+                filled = 0;
+                memset(period_ref, 0, sizeof(period_ref));
+                memset(period_resp, 0, sizeof(period_resp));
+            }
+        }
+        adc_dma_release_buffer(&block);
+    }
+    adc_dma_stop_continuous();
+    ad9833_enable_output(output_was_enabled);
+
+    result->total_time_ms = hal_time_ms() - start_ms;
+    if (result->periods < periods) {
+        DEBUG_PRINT(0, "[MULTI] ERROR: La captura no entregó los bloques (%u de %u períodos)\n",
+                    result->periods, periods);
+        return false;
+    }
+
+    for (uint16_t i = 0; i < plan->count; i++) {
+        const sweep_average_t *avg = &tone_avg[i];
+        float power = avg->mean_re * avg->mean_re + avg->mean_im * avg->mean_im;
+
+        result->frequency_hz[i] = plan->freq_hz[i];
+        result->magnitude_db[i] = 10.0f * log10f(fmaxf(power, 1e-18f));
+        result->phase_deg[i] = remainderf(atan2f(avg->mean_im, avg->mean_re) + plan->skew_rad[i],
+                                          2.0f * (float)M_PI) * (180.0f / (float)M_PI);
+
+        // Dispersión de H entre períodos: la media de k tiene varianza s²/k
+        if (avg->windows >= 2) {
+            float k = (float)avg->windows;
+            float variance = fmaxf(avg->m2 / (k - 1.0f), 1e-30f);
+            result->snr_db[i] = 10.0f * log10f(k * power / variance);
+        } else {
+            result->snr_db[i] = NAN;
+        }
+    }
+    result->count = plan->count;
+
+    DEBUG_PRINT(1, "[MULTI] %u tonos en %lu ms (%u períodos, %lu huecos)\n",
+                result->count, (unsigned long)result->total_time_ms, result->periods,
+                (unsigned long)result->gaps);
+    return true;
+#endif
+}
+
+/**
+ * @brief Compara dos pedidos campo a campo (el relleno del struct no cuenta)
+ */
+static bool multitone_same_params(const multitone_params_t *a, const multitone_params_t *b) {
+    return a->grid == b->grid && a->start_hz == b->start_hz && a->stop_hz == b->stop_hz
+        && a->tones == b->tones && a->list_hz == b->list_hz
+        && a->period_blocks == b->period_blocks && a->peak == b->peak;
+}
+
+bool multitone_execute(const multitone_params_t *params, multitone_result_t *result) {
+    uint32_t start_ms = hal_time_ms();
+
+    // Refinar las fases lleva decenas de pasadas por el período: el plan se
+    // rehace solo si cambia el pedido
+    if (!multitone_planned || !multitone_same_params(&multitone_planned_params, params)) {
+        multitone_planned = multitone_plan_build(&multitone_plan, params);
+        multitone_planned_params = *params;
+    }
+    if (!multitone_planned || !multitone_measure(&multitone_plan, params->periods, result)) {
+        return false;
+    }
+
+    uint32_t id = frequency_sweep_next_id();
+    sweep_frame_begin(&multitone_frame, id, start_ms, result->frequency_hz[0], 0.0f, 0);
+    for (uint16_t i = 0; i < result->count; i++) {
+        sweep_frame_add_at(&multitone_frame, result->frequency_hz[i],
+                           result->magnitude_db[i], result->phase_deg[i]);
+    }
+    multitone_frame.header.flags |= SWEEP_FRAME_FLAG_LAST;
+
+    bool queued = mqtt_publish_sweep_frame(&multitone_frame);
+    if (!queued || !mqtt_is_connected()) {
+        // Mismo criterio que el barrido del plan: sin broker va a la flash
+        if (sweep_store_append(&multitone_frame)) {
+            DEBUG_PRINT(1, "[MULTI] Barrido %lu guardado en flash\n", (unsigned long)id);
+        }
+    }
+    if (!mqtt_publish_multitone(&multitone_plan, result, id)) {
+        DEBUG_PRINT(1, "[MULTI] No entró el detalle de la multiseno en la cola\n");
+    }
+
+    mqtt_publish_status("sweep_complete");
+    return queued;
+}
+
+size_t multitone_format_json(const multitone_plan_t *plan, const multitone_result_t *result,
+                             uint32_t sweep_id, char *buf, size_t capacity) {
+    json_writer_t w;
+    json_writer_init(&w, buf, capacity);
+    json_writer_begin_object(&w);
+    json_writer_key(&w, "id");
+    json_writer_uint(&w, sweep_id);
+    json_writer_key(&w, "tones");
+    json_writer_uint(&w, result->count);
+    json_writer_key(&w, "period");
+    json_writer_uint(&w, plan->period_blocks);
+    json_writer_key(&w, "periods");
+    json_writer_uint(&w, result->periods);
+    json_writer_key(&w, "crest");
+    json_writer_fixed(&w, plan->crest_factor, 2);
+    json_writer_key(&w, "tone_db");
+    json_writer_fixed(&w, plan->tone_db, 1);
+    json_writer_key(&w, "snr_db");
+    json_writer_begin_array(&w);
+    for (uint16_t i = 0; i < result->count; i++) {
+        // Recortada: cada valor ocupa a lo sumo 6 caracteres con la coma
+        float snr = result->snr_db[i];
+        if (isfinite(snr)) {
+            snr = fminf(fmaxf(snr, MULTITONE_SNR_MIN_DB), MULTITONE_SNR_MAX_DB);
+        }
+        json_writer_fixed(&w, snr, 1);
+    }
+    json_writer_end_array(&w);
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
+}
@@ -0,0 +1,212 @@
+/**
+ * @file publish_queue.c
+ * @brief Implementación de la cola de publicación
+ */
+
+#include "publish_queue.h"
+#include "debug.h"
+#include "hal.h"
+
+#if PUBLISH_QUEUE_SLOTS < 3
+#error "PUBLISH_QUEUE_SLOTS debe ser al menos 3 (productor + red + uno en espera)"
+#endif
+
+typedef enum {
+    SLOT_FREE = 0,
+    SLOT_FILLING,
+    SLOT_READY,
+    SLOT_SENDING
+} slot_state_t;
+
+static publish_msg_t slots[PUBLISH_QUEUE_SLOTS];
+static slot_state_t slot_state[PUBLISH_QUEUE_SLOTS];
+
+// Cola FIFO de slots READY (índices en orden de encolado)
+static uint8_t ready_fifo[PUBLISH_QUEUE_SLOTS];
+static uint8_t ready_head = 0;
+static uint8_t ready_count = 0;
+
+// Avisos de entrega sin tomar
+typedef struct {
+    uint32_t receipt;
+    bool sent;
+} publish_receipt_t;
+
+static publish_receipt_t receipts[PUBLISH_QUEUE_SLOTS];
+static uint8_t receipt_head = 0;
+static uint8_t receipt_count = 0;
+
+static publish_overflow_t overflow_policy = PUBLISH_DROP_OLDEST;
+static publish_queue_stats_t queue_stats;
+
+static uint8_t slot_index_of(const publish_msg_t *msg) {
+    return (uint8_t)(msg - slots);
+}
+
+/**
+ * @brief Deja el aviso de entrega del slot (dentro de la sección crítica)
+ */
+static void receipt_post(uint8_t idx, bool sent) {
+    if (slots[idx].receipt == 0 || receipt_count == PUBLISH_QUEUE_SLOTS) {
+        return;
+    }
+    receipts[(receipt_head + receipt_count) % PUBLISH_QUEUE_SLOTS] =
+        (publish_receipt_t){ slots[idx].receipt, sent };
+    receipt_count++;
+}
+
+void publish_queue_init(publish_overflow_t policy) {
+    for (uint8_t i = 0; i < PUBLISH_QUEUE_SLOTS; i++) {
+        slot_state[i] = SLOT_FREE;
+    }
+    ready_head = 0;
+    ready_count = 0;
+    receipt_head = 0;
+    receipt_count = 0;
+    overflow_policy = policy;
+    queue_stats = (publish_queue_stats_t){0};
+}
+
+void publish_queue_set_policy(publish_overflow_t policy) {
+    hal_critical_enter();
+    overflow_policy = policy;
+    hal_critical_exit();
+}
+
+publish_msg_t *publish_queue_reserve(const char *topic) {
+    bool waited = false;
+
+    while (true) {
+        uint8_t idx = PUBLISH_QUEUE_SLOTS;
+
+        hal_critical_enter();
+        for (uint8_t i = 0; i < PUBLISH_QUEUE_SLOTS; i++) {
+            if (slot_state[i] == SLOT_FREE) {
+                idx = i;
+                break;
+            }
+        }
+
+        if (idx == PUBLISH_QUEUE_SLOTS && overflow_policy == PUBLISH_DROP_OLDEST && ready_count > 0) {
+            // Reciclar el mensaje listo más antiguo
+            idx = ready_fifo[ready_head];
+            ready_head = (ready_head + 1) % PUBLISH_QUEUE_SLOTS;
+            ready_count--;
+            queue_stats.depth--;
+            queue_stats.dropped_oldest++;
+            receipt_post(idx, false);
+        }
+
+        if (idx < PUBLISH_QUEUE_SLOTS) {
+            slot_state[idx] = SLOT_FILLING;
+            if (waited) {
+                queue_stats.block_waits++;
+            }
+            hal_critical_exit();
+
+            slots[idx].topic = topic;
+            slots[idx].receipt = 0;
+            slots[idx].len = 0;
+            return &slots[idx];
+        }
+
+        if (overflow_policy != PUBLISH_BLOCK) {
+            // DROP_NEWEST, o DROP_OLDEST sin mensajes listos que reciclar
+            queue_stats.dropped_newest++;
+            hal_critical_exit();
+            DEBUG_PRINT(1, "[PUBQ] Cola llena: mensaje descartado\n");
+            return NULL;
+        }
+
+        hal_critical_exit();
+        waited = true;
+        hal_cpu_relax();
+    }
+}
+
+void publish_queue_commit(publish_msg_t *msg, uint16_t len) {
+    uint8_t idx = slot_index_of(msg);
+
+    hal_critical_enter();
+    if (len == 0 || len > PUBLISH_QUEUE_MSG_MAX) {
+        slot_state[idx] = SLOT_FREE;
+        hal_critical_exit();
+        return;
+    }
+
+    msg->len = len;
+    slot_state[idx] = SLOT_READY;
+    ready_fifo[(ready_head + ready_count) % PUBLISH_QUEUE_SLOTS] = idx;
+    ready_count++;
+
+    queue_stats.enqueued++;
+    queue_stats.depth++;
+    if (queue_stats.depth > queue_stats.high_water) {
+        queue_stats.high_water = queue_stats.depth;
+    }
+    hal_critical_exit();
+}
+
+publish_msg_t *publish_queue_acquire(void) {
+    publish_msg_t *msg = NULL;
+
+    hal_critical_enter();
+    if (ready_count > 0) {
+        uint8_t idx = ready_fifo[ready_head];
+        ready_head = (ready_head + 1) % PUBLISH_QUEUE_SLOTS;
+        ready_count--;
+        slot_state[idx] = SLOT_SENDING;
+        msg = &slots[idx];
+    }
+    hal_critical_exit();
+
+    return msg;
+}
+
+void publish_queue_release(publish_msg_t *msg, bool sent) {
+    uint8_t idx = slot_index_of(msg);
+
+    hal_critical_enter();
+    if (idx < PUBLISH_QUEUE_SLOTS && slot_state[idx] == SLOT_SENDING) {
+        slot_state[idx] = SLOT_FREE;
+        queue_stats.depth--;
+        receipt_post(idx, sent);
+        if (sent) {
+            queue_stats.sent++;
+        } else {
+            queue_stats.failed++;
+        }
+    }
+    hal_critical_exit();
+}
+
+bool publish_queue_take_receipt(uint32_t *receipt, bool *sent) {
+    bool found = false;
+
+    hal_critical_enter();
+    if (receipt_count > 0) {
+        *receipt = receipts[receipt_head].receipt;
+        *sent = receipts[receipt_head].sent;
+        receipt_head = (receipt_head + 1) % PUBLISH_QUEUE_SLOTS;
+        receipt_count--;
+        found = true;
+    }
+    hal_critical_exit();
+
+    return found;
+}
+
+void publish_queue_get_stats(publish_queue_stats_t *stats) {
+    hal_critical_enter();
+    *stats = queue_stats;
+    hal_critical_exit();
+}
+
+void publish_queue_reset_stats(void) {
+    hal_critical_enter();
+    uint32_t depth = queue_stats.depth;
+    queue_stats = (publish_queue_stats_t){0};
+    queue_stats.depth = depth;
+    queue_stats.high_water = depth;
+    hal_critical_exit();
+}
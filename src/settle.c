@@ -0,0 +1,198 @@
+/**
+ * @file settle.c
+ * @brief Implementación del detector de asentamiento
+ */
+
+#include "settle.h"
+#include "config.h"
+#include "adc_dma.h"
+#include "debug.h"
+#include "hal.h"
+#include <math.h>
+
+// Resto de ciclo aceptable en una pre-ventana
+#define SETTLE_CYCLE_ERR_OK 0.02f
+
+// Captura contigua de asentamiento (no pisa adc_sample_buffer)
+static uint16_t settle_buffer[SETTLE_MAX_SAMPLES * ADC_CHANNELS];
+
+#if SETTLE_TAU_BAND_COUNT > 0
+// Fila de SETTLE_TAU_BANDS
+typedef struct {
+    float upper_hz;
+    float tau_ms;
+} settle_tau_band_t;
+
+static const settle_tau_band_t settle_tau_bands[SETTLE_TAU_BAND_COUNT] = SETTLE_TAU_BANDS;
+#endif
+
+float settle_tau_ms(float freq_hz) {
+#if SETTLE_TAU_BAND_COUNT > 0
+    for (uint16_t i = 0; i < SETTLE_TAU_BAND_COUNT; i++) {
+        if (freq_hz <= settle_tau_bands[i].upper_hz) {
+            return settle_tau_bands[i].tau_ms;
+        }
+    }
+#else
+    (void)freq_hz;
+#endif
+    return SETTLE_DUT_TAU_MS;
+}
+
+void settle_params_init(settle_params_t *params, float freq_hz, float sample_rate_hz) {
+    float cycles_per_sample = freq_hz / sample_rate_hz;
+    uint16_t length = WINDOW_SIZE;
+    float best_err = 1.0f;
+    
+    // El largo más corto desde SETTLE_PRE_WINDOW_MIN que abarca un número
+    // casi entero de ciclos: el resto de ciclo es lo que hace diferir
+    // estimaciones en régimen. Si ninguno alcanza SETTLE_CYCLE_ERR_OK se
+    // usa el de menor resto.
+    for (uint16_t n = SETTLE_PRE_WINDOW_MIN; n <= WINDOW_SIZE; n++) {
+        float cycles = n * cycles_per_sample;
+        float err = fabsf(cycles - roundf(cycles));
+        if (cycles >= 1.0f && err < best_err) {
+            best_err = err;
+            length = n;
+            if (err < SETTLE_CYCLE_ERR_OK) {
+                break;
+            }
+        }
+    }
+    
+    params->pre_window = length;
+    params->phase_step_rad = remainderf(2.0f * (float)M_PI * freq_hz * length / sample_rate_hz,
+                                        2.0f * (float)M_PI);
+    
+    // Cota: SETTLE_TAU_MULTIPLE·τ(f) más las pre-ventanas mínimas para
+    // decidir, redondeada a pre-ventanas completas y limitada por el buffer
+    uint32_t tau_samples = (uint32_t)(SETTLE_TAU_MULTIPLE * settle_tau_ms(freq_hz) * sample_rate_hz / 1000.0f);
+    uint32_t windows = (tau_samples + length - 1) / length + SETTLE_CONSECUTIVE + 1;
+    uint32_t max_windows = SETTLE_MAX_SAMPLES / length;
+    if (windows > max_windows) {
+        windows = max_windows;
+    }
+    
+    params->max_samples = (uint16_t)(windows * length);
+    params->max_us = (uint32_t)(params->max_samples * 1e6f / sample_rate_hz);
+}
+
+void settle_start(settle_state_t *state, const settle_params_t *params,
+                  const goertzel_coeffs_t *coeffs) {
+    state->params = params;
+    state->coeffs = coeffs;
+    state->start_us = hal_time_us();
+    state->prev = (goertzel_result_t){0};
+    state->offset = 0;
+    state->estimates = 0;
+    state->streak = 0;
+    state->converged = false;
+    state->done = false;
+    
+    // Una sola captura: las pre-ventanas son tramos contiguos, así la fase
+    // entre ellas es comparable (capturas separadas tienen huecos arbitrarios)
+    state->capture_us = hal_time_us();
+    adc_dma_start_capture_into(settle_buffer, params->max_samples);
+}
+
+bool settle_poll(settle_state_t *state) {
+    const settle_params_t *params = state->params;
+    float phase_tol = SETTLE_PHASE_TOL_DEG * (float)M_PI / 180.0f;
+    
+    // Con dos canales la fase se toma respecto de la referencia, que avanza
+    // igual que la respuesta: entre pre-ventanas no hay avance que descontar
+#if ADC_CHANNELS == 2
+    float phase_step = 0.0f;
+#else
+    float phase_step = params->phase_step_rad;
+#endif
+    
+    while (!state->done) {
+        uint16_t offset = state->offset;
+        uint16_t end = offset + params->pre_window;
+        if (end > params->max_samples) {
+            state->done = true;
+            break;
+        }
+        if (adc_dma_samples_ready() < end) {
+            return false;
+        }
+        
+        goertzel_result_t est;
+#if ADC_CHANNELS == 2
+        goertzel_pair_t pair;
+        goertzel_result_t ref;
+        goertzel_pair_init(&pair, state->coeffs, params->pre_window);
+        goertzel_pair_push(&pair, &settle_buffer[offset * ADC_CHANNELS], params->pre_window);
+        goertzel_pair_result(&pair, &ref, &est);
+        est.phase_rad = remainderf(est.phase_rad - ref.phase_rad, 2.0f * (float)M_PI);
+#else
+        goertzel_stream_t stream;
+        goertzel_stream_init(&stream, state->coeffs, params->pre_window);
+        goertzel_stream_push(&stream, &settle_buffer[offset], params->pre_window);
+        goertzel_stream_result(&stream, &est);
+#endif
+        
+        if (state->estimates > 0) {
+            const goertzel_result_t *prev = &state->prev;
+            float mag_ref = fmaxf(est.magnitude, prev->magnitude);
+            bool mag_ok = fabsf(est.magnitude - prev->magnitude)
+                       <= SETTLE_MAG_TOL * mag_ref + SETTLE_MAG_FLOOR;
+            
+            // Descontar el avance propio de la señal entre pre-ventanas. El
+            // piso se aplica al arco (fase por magnitud): con señales chicas
+            // la fase es ruidosa y no debe frenar la convergencia
+            float dphase = remainderf(est.phase_rad - prev->phase_rad - phase_step,
+                                      2.0f * (float)M_PI);
+            bool phase_ok = fabsf(dphase) * mag_ref <= phase_tol * mag_ref + SETTLE_MAG_FLOOR;
+            
+            state->streak = (mag_ok && phase_ok) ? state->streak + 1 : 0;
+        }
+        state->prev = est;
+        state->estimates++;
+        state->offset = end;
+        
+        if (state->streak >= SETTLE_CONSECUTIVE) {
+            state->converged = true;
+            state->done = true;
+        }
+    }
+    return true;
+}
+
+uint64_t settle_wake_us(const settle_state_t *state) {
+    uint32_t end = (uint32_t)state->offset + state->params->pre_window;
+    return state->capture_us + (uint64_t)ceilf((float)end * 1e6f / SAMPLE_RATE);
+}
+
+bool settle_finish(settle_state_t *state, settle_report_t *report) {
+    if (state->converged || !state->done) {
+        adc_dma_abort_capture();
+    } else {
+        adc_dma_wait_complete();
+    }
+    
+    uint32_t elapsed_us = (uint32_t)(hal_time_us() - state->start_us);
+    
+    if (!state->converged) {
+        DEBUG_PRINT(1, "[SETTLE] WARNING: %.0f Hz sin converger en %lu us\n",
+                    state->coeffs->freq_hz, (unsigned long)elapsed_us);
+    }
+    
+    if (report) {
+        report->elapsed_us = elapsed_us;
+        report->estimates = state->estimates;
+        report->converged = state->converged;
+    }
+    return state->converged;
+}
+
+bool settle_wait(const settle_params_t *params, const goertzel_coeffs_t *coeffs,
+                 settle_report_t *report) {
+    settle_state_t state;
+    
+    settle_start(&state, params, coeffs);
+    while (!settle_poll(&state)) {
+    }
+    return settle_finish(&state, report);
+}
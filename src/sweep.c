@@ -2,8 +2,9 @@
  * @file sweep.c
  * @brief Implementación del orquestador de barrido
  * 
- * ESTADO: STUB - Implementación mínima funcional
- * TODO: Optimizar timing y manejo de errores
+ * Usa únicamente la HAL (hal.h) para tiempo y la traza de etapas
+ * (trace.h, que maneja también los GPIO de debug), por lo que compila
+ * tanto en el firmware como en el simulador nativo.
  */
 
 #include "sweep.h"
@@ -12,162 +13,1107 @@
 #include "adc_dma.h"
 #include "goertzel.h"
 #include "mqtt_client.h"
-#include <stdio.h>
-#include "pico/stdlib.h"
+#include "debug.h"
+#include "hal.h"
+#include "spsc_queue.h"
+#include "settle.h"
+#include "sweep_average.h"
+#include "sweep_frame.h"
+#include "sweep_plan.h"
+#include "sweep_store.h"
+#include "trace.h"
+#include <math.h>
 
-#ifdef DEBUG_GPIO_ENABLED
-#include "hardware/gpio.h"
+// Bloque mínimo que se procesa mientras el DMA sigue capturando
+// (48 muestras = 1 ms a 48 kHz): tras la última muestra solo queda
+// pendiente el último bloque
+#define SWEEP_STREAM_BLOCK 48
+
+// sweep_capture_start() sin punto siguiente que precargar
+#define SWEEP_NO_PRELOAD UINT16_MAX
+
+// Puntos del barrido (frecuencia coherente, ventana, coeficientes y
+// asentamiento), construidos en frequency_sweep_set_plan()
+static sweep_plan_t sweep_plan;
+
+// Pedido del plan vigente: frequency_sweep_measure() elige la ventana de
+// cada frecuencia suelta con el mismo criterio (sin la lista, que es del
+// llamador)
+static sweep_plan_spec_t sweep_spec;
+
+// Asentamiento y ventanas acumulados durante un barrido
+typedef struct {
+    uint64_t total_us;
+    uint32_t max_us;
+    uint32_t timeouts;
+    uint32_t windows;
+    uint32_t max_windows;
+    uint32_t unconverged;
+    uint32_t saturated;
+} sweep_point_totals_t;
+
+// Handle que marca el fin del barrido en la cola hacia el core 1
+#define SWEEP_PIPELINE_END 0xFF
+
+#if SWEEP_PIPELINE_BUFFERS < 2 || SWEEP_PIPELINE_BUFFERS >= SPSC_QUEUE_CAPACITY
+#error "SWEEP_PIPELINE_BUFFERS debe estar entre 2 y SPSC_QUEUE_CAPACITY - 1"
 #endif
 
-void frequency_sweep_execute(void) {
-    printf("\n========================================\n");
-    printf("  INICIANDO BARRIDO DE FRECUENCIA\n");
-    printf("========================================\n\n");
+#if SWEEP_PIPELINED && (SWEEP_ADAPTIVE || SWEEP_MULTITONE)
+#error "SWEEP_PIPELINED es excluyente con SWEEP_ADAPTIVE y SWEEP_MULTITONE"
+#endif
+
+// Ventana en vuelo del barrido pipeline
+typedef struct {
+    uint16_t samples[ADC_CAPTURE_MAX_SAMPLES * ADC_CHANNELS];
+    uint16_t point;                 // Índice en el plan
+} sweep_slot_t;
+
+static sweep_slot_t pipeline_slots[SWEEP_PIPELINE_BUFFERS];
+static spsc_queue_t pipeline_captured;  // core 0 -> core 1
+static spsc_queue_t pipeline_free;      // core 1 -> core 0
+
+// Resultados del core 1; se leen después de hal_core1_join()
+static uint32_t pipeline_successful;
+static uint32_t pipeline_failed;
+static uint32_t pipeline_saturated;
+
+// Puntos por trama publicada al arrancar
+#if SWEEP_FRAME_POINTS > 0 && SWEEP_FRAME_POINTS < SWEEP_NUM_POINTS
+#define SWEEP_FRAME_CHUNK SWEEP_FRAME_POINTS
+#else
+#define SWEEP_FRAME_CHUNK SWEEP_NUM_POINTS
+#endif
+
+// Puntos por trama vigentes (frequency_sweep_set_frame_points()); cambia
+// solo sin barrido en curso, así el core 1 del pipeline lo lee sin carrera
+static uint16_t sweep_frame_chunk = SWEEP_FRAME_CHUNK;
+
+// Trama en armado. Solo la toca quien publica: el core 0 en el barrido
+// secuencial, el core 1 en el pipeline
+static sweep_frame_t sweep_frame;
+static uint32_t sweep_id = 0;
+static uint32_t sweep_start_ms = 0;
+
+// Barrido completo, por si alguna trama no llega al broker y hay que
+// guardarlo en flash (mismo dueño que sweep_frame)
+static sweep_frame_t sweep_record;
+static bool sweep_undelivered = false;
+
+/**
+ * @brief Muestras de la captura de un punto: sus ventanas coherentes
+ *        consecutivas
+ */
+static uint16_t sweep_point_samples(const sweep_point_t *point) {
+    return (uint16_t)(point->window * point->averages);
+}
+
+// Detector de un punto: con dos canales, Goertzel sobre referencia y
+// respuesta en la misma pasada y resultado H = respuesta/referencia; con
+// uno, Goertzel sobre la respuesta. Guarda los bines acumulados al cierre
+// de la ventana anterior para estimar cada ventana por diferencia
+typedef struct {
+#if ADC_CHANNELS == 2
+    goertzel_pair_t pair;
+    float ref_re, ref_im;
+#else
+    goertzel_stream_t stream;
+#endif
+    float resp_re, resp_im;
+    const sweep_point_t *point;
+} sweep_detector_t;
+
+// Captura en curso de un punto (sweep_capture_start())
+typedef struct {
+    const sweep_point_t *point;
+    sweep_detector_t det;
+    sweep_average_t avg;
+    uint16_t num_samples;           // Muestras por captura
+    uint16_t consumed;              // Muestras de la captura ya procesadas
+    uint64_t window_us;             // Arranque de la captura en curso
+    uint32_t goertzel_ticks;        // CPU de Goertzel acumulado
+    uint32_t saturated;             // Códigos saturados de las capturas integradas
+    uint32_t validated;             // Muestras por canal contadas en saturated
+    uint32_t validate_ticks;        // CPU de la validación acumulado
+    uint32_t trace_t0;
+} sweep_capture_t;
+
+// Trabajo del motor
+typedef enum {
+    SWEEP_JOB_PLAN = 0,             // Barrido del plan (frequency_sweep_start())
+    SWEEP_JOB_POINT                 // Punto suelto (frequency_sweep_start_point())
+} sweep_job_t;
+
+// Paso del punto en curso
+typedef enum {
+    SWEEP_STEP_TUNE = 0,            // Programar el DDS; acá se atiende la pausa
+    SWEEP_STEP_SETTLE,              // Asentamiento en curso
+    SWEEP_STEP_CAPTURE,             // Captura en curso
+    SWEEP_STEP_FINISH               // Cerrar el trabajo
+} sweep_step_t;
+
+// Motor de barrido: un trabajo a la vez, avanzado por frequency_sweep_poll()
+typedef struct {
+    sweep_status_t status;
+    sweep_job_t job;
+    sweep_step_t step;
+    bool pause_requested;
+    uint16_t index;                 // Punto del plan en curso
+    sweep_point_t point;            // Punto del trabajo SWEEP_JOB_POINT
+    bool publish;                   // SWEEP_JOB_POINT: publicar la medición
+    bool published;                 // SWEEP_JOB_POINT: medición encolada
+    settle_state_t settle;
+    uint32_t settle_t0;
+    sweep_capture_t capture;
+    sweep_point_totals_t totals;
+    sweep_stats_t stats;
+    sweep_measurement_t measurement;
+    uint32_t start_ms;
+    uint32_t sweep_t0;
+} sweep_engine_t;
+
+static sweep_engine_t sweep_engine = { .status = SWEEP_IDLE };
+
+/**
+ * @brief Prepara el detector para hasta max_windows capturas del punto
+ */
+static void sweep_detector_init(sweep_detector_t *det, const sweep_point_t *point,
+                                uint16_t max_windows) {
+    uint32_t expected = (uint32_t)sweep_point_samples(point) * max_windows;
+    
+    det->point = point;
+    det->resp_re = 0.0f;
+    det->resp_im = 0.0f;
+#if ADC_CHANNELS == 2
+    det->ref_re = 0.0f;
+    det->ref_im = 0.0f;
+    goertzel_pair_init(&det->pair, &point->coeffs, expected);
+#else
+    goertzel_stream_init(&det->stream, &point->coeffs, expected);
+#endif
+}
+
+/**
+ * @brief Consume los instantes [first, first + count) de una captura
+ */
+static void sweep_detector_push(sweep_detector_t *det, const uint16_t *samples,
+                                uint16_t first, uint16_t count) {
+#if ADC_CHANNELS == 2
+    goertzel_pair_push(&det->pair, &samples[first * ADC_CHANNELS], count);
+#else
+    goertzel_stream_push(&det->stream, &samples[first], count);
+#endif
+}
+
+/**
+ * @brief Magnitud y fase del punto: H corregida por el desfase entre
+ *        canales, o la respuesta sola con un canal
+ */
+static void sweep_detector_result(const sweep_detector_t *det, goertzel_result_t *result) {
+#if ADC_CHANNELS == 2
+    goertzel_result_t reference;
+    goertzel_result_t response;
+    goertzel_pair_result(&det->pair, &reference, &response);
+    goertzel_transfer(&reference, &response, det->point->skew_rad, result);
+#else
+    goertzel_stream_result(&det->stream, result);
+#endif
+}
+
+/**
+ * @brief Estimación compleja de la ventana recién cerrada
+ * 
+ * Diferencia entre el bin acumulado y el del cierre anterior: H de la
+ * ventana con dos canales (sin la corrección de desfase, que no cambia la
+ * dispersión), la respuesta sin normalizar con uno.
+ */
+static void sweep_detector_window(sweep_detector_t *det, float *re, float *im) {
+    float resp_re, resp_im;
+#if ADC_CHANNELS == 2
+    float ref_re, ref_im;
+    goertzel_stream_bin(&det->pair.reference, &ref_re, &ref_im);
+    goertzel_stream_bin(&det->pair.response, &resp_re, &resp_im);
     
-#ifdef DEBUG_GPIO_ENABLED
-    gpio_put(DEBUG_PIN_SWEEP_START, 1);
+    float x_re = ref_re - det->ref_re;
+    float x_im = ref_im - det->ref_im;
+    float y_re = resp_re - det->resp_re;
+    float y_im = resp_im - det->resp_im;
+    det->ref_re = ref_re;
+    det->ref_im = ref_im;
+    
+    float den = x_re * x_re + x_im * x_im;
+    *re = den > 0.0f ? (y_re * x_re + y_im * x_im) / den : 0.0f;
+    *im = den > 0.0f ? (y_im * x_re - y_re * x_im) / den : 0.0f;
+#else
+    goertzel_stream_bin(&det->stream, &resp_re, &resp_im);
+    *re = resp_re - det->resp_re;
+    *im = resp_im - det->resp_im;
 #endif
+    det->resp_re = resp_re;
+    det->resp_im = resp_im;
+}
+
+/**
+ * @brief Goertzel sobre una captura completa del punto
+ */
+static void sweep_point_compute(const sweep_point_t *point, const uint16_t *samples,
+                                goertzel_result_t *result) {
+    sweep_detector_t det;
     
-    uint32_t start_time = to_ms_since_boot(get_absolute_time());
-    uint32_t successful_points = 0;
+    sweep_detector_init(&det, point, 1);
+    sweep_detector_push(&det, samples, 0, sweep_point_samples(point));
+    sweep_detector_result(&det, result);
+}
+
+/**
+ * @brief Lleva el DDS al punto index del plan
+ * 
+ * Si el punto ya está precargado en el registro inactivo basta una palabra
+ * de control; si no, se programa completo.
+ */
+static void sweep_tune_point(uint16_t index) {
+    float preloaded;
     
-    // Iterar sobre todas las frecuencias
-    for (uint16_t k = 1; k <= SWEEP_NUM_POINTS; k++) {
-        // Calcular frecuencia objetivo
-        float freq = SWEEP_FREQ_MIN + (k - 1) * FREQ_RESOLUTION;
-        
-        printf("[SWEEP] Punto %d/%d: %.0f Hz\n", k, SWEEP_NUM_POINTS, freq);
-        
-        // 1. Configurar generador AD9833
+    float freq = sweep_plan.points[index].freq_hz;
+    
+    uint32_t t0 = trace_begin(TRACE_DDS_WRITE);
+    if (ad9833_get_preloaded(&preloaded) && preloaded == freq) {
+        ad9833_switch_preloaded();
+    } else {
         ad9833_set_frequency(freq);
-        sleep_ms(100);  // Esperar estabilización
-        
-        // 2. Adquirir datos con ADC+DMA
-#ifdef DEBUG_GPIO_ENABLED
-        gpio_put(DEBUG_PIN_ADC_ACQUIRE, 1);
-#endif
+    }
+    trace_end(TRACE_DDS_WRITE, t0);
+}
+
+/**
+ * @brief Precarga el punto siguiente a index, si existe
+ * 
+ * Las palabras salen como lote asíncrono: el CPU vuelve enseguida a
+ * procesar la captura en curso mientras el DMA las envía al AD9833.
+ */
+static void sweep_preload_next(uint16_t index) {
+    if (index + 1 < sweep_plan.count) {
+        ad9833_batch_begin();
+        ad9833_preload_frequency(sweep_plan.points[index + 1].freq_hz);
+        ad9833_batch_commit();
+    }
+}
+
+/**
+ * @brief Arranca la captura de las ventanas del punto
+ * 
+ * La captura se procesa con Goertzel por bloques a medida que avanza el
+ * DMA (sweep_capture_poll()), así el resultado está listo casi
+ * inmediatamente después de la última muestra. Mientras captura, precarga
+ * en el AD9833 el punto siguiente a preload. La traza registra la captura
+ * completa y, aparte, la suma del CPU de Goertzel de todos los bloques.
+ * 
+ * @param cap Captura en curso
+ * @param point Punto a medir
+ * @param preload Índice del plan en curso (SWEEP_NO_PRELOAD: no precargar)
+ * @return false si el ADC rechazó la captura (no hay nada que consultar)
+ */
+static bool sweep_capture_start(sweep_capture_t *cap, const sweep_point_t *point, uint16_t preload) {
+    cap->point = point;
+    cap->num_samples = sweep_point_samples(point);
+    cap->consumed = 0;
+    cap->goertzel_ticks = 0;
+    cap->saturated = 0;
+    cap->validated = 0;
+    cap->validate_ticks = 0;
+    sweep_detector_init(&cap->det, point, sweep_spec.average.max_windows);
+    sweep_average_init(&cap->avg);
+    
+    cap->trace_t0 = trace_begin(TRACE_ADC_CAPTURE);
+    cap->window_us = hal_time_us();
+    if (!adc_dma_start_capture(cap->num_samples)) {
+        return false;
+    }
+    if (preload != SWEEP_NO_PRELOAD) {
+        sweep_preload_next(preload);
+    }
+    return true;
+}
+
+/**
+ * @brief Consume los bloques que ya completó el DMA
+ * 
+ * Con promedio (sweep_spec.average.max_windows > 1) la captura se repite
+ * encadenada sin reiniciar el Goertzel. Cada repetición se rearma apenas
+ * termina la anterior y recién después se evalúa el corte: si ya converge,
+ * la captura recién lanzada se corta sin haber esperado por ella.
+ * 
+ * @return true cuando no quedan capturas por integrar
+ */
+static bool sweep_capture_poll(sweep_capture_t *cap) {
+    const sweep_average_params_t *params = &sweep_spec.average;
+    
+    while (true) {
+        if (cap->consumed < cap->num_samples) {
+            uint16_t ready = adc_dma_samples_ready();
+            if (ready - cap->consumed < SWEEP_STREAM_BLOCK && ready < cap->num_samples) {
+                return false;
+            }
+            
+            uint16_t count = ready - cap->consumed;
+            uint32_t t0 = trace_begin(TRACE_GOERTZEL);
+            sweep_detector_push(&cap->det, adc_sample_buffer, cap->consumed, count);
+            cap->goertzel_ticks += trace_lap(TRACE_GOERTZEL, t0);
+            
+            // La validación va con cada bloque, igual que Goertzel: una
+            // captura rearmada y cortada deja muestras nuevas en el buffer
+            // que no se integraron
+            t0 = trace_begin(TRACE_VALIDATE);
+            cap->saturated += adc_dma_count_saturated(&adc_sample_buffer[cap->consumed * ADC_CHANNELS],
+                                                      count);
+            cap->validated += count;
+            cap->validate_ticks += trace_lap(TRACE_VALIDATE, t0);
+            cap->consumed = ready;
+            continue;
+        }
         
-        adc_dma_start_capture();
-        adc_dma_wait_complete();
+        // Rearmar antes de estimar: la FIFO del ADC cubre solo unos µs
+        bool chained = cap->avg.windows + 1 < params->max_windows
+            && adc_dma_continue_capture(cap->num_samples);
         
-#ifdef DEBUG_GPIO_ENABLED
-        gpio_put(DEBUG_PIN_ADC_ACQUIRE, 0);
-#endif
+        float re, im;
+        sweep_detector_window(&cap->det, &re, &im);
+        sweep_average_add(&cap->avg, re, im);
         
-        // 3. Validar muestras
-        if (!adc_dma_validate_samples(adc_sample_buffer, WINDOW_SIZE)) {
-            printf("[SWEEP] WARNING: Muestras inválidas en %.0f Hz\n", freq);
-            // Continuar de todos modos en modo stub
+        if (!chained) {
+            return true;
+        }
+        if (sweep_average_converged(&cap->avg, params)) {
+            adc_dma_abort_capture();
+            return true;
+        }
+        cap->consumed = 0;
+        cap->window_us = hal_time_us();
+    }
+}
+
+/**
+ * @brief Instante (hal_time_us()) en que estará listo el bloque que espera
+ *        sweep_capture_poll()
+ */
+static uint64_t sweep_capture_wake_us(const sweep_capture_t *cap) {
+    uint32_t need = (uint32_t)cap->consumed + SWEEP_STREAM_BLOCK;
+    if (need > cap->num_samples) {
+        need = cap->num_samples;
+    }
+    return cap->window_us + (uint64_t)ceilf((float)need * 1e6f / SAMPLE_RATE);
+}
+
+/**
+ * @brief Cierra la captura terminada y calcula el resultado del punto
+ * 
+ * @param cap Captura en curso
+ * @param result Resultado de todas las capturas integradas
+ * @param totals Acumulados del barrido donde sumar las ventanas (o NULL)
+ * @return Capturas integradas
+ */
+static uint16_t sweep_capture_finish(sweep_capture_t *cap, goertzel_result_t *result,
+                                     sweep_point_totals_t *totals) {
+    const sweep_average_params_t *params = &sweep_spec.average;
+    
+    adc_dma_wait_complete();
+    trace_end(TRACE_ADC_CAPTURE, cap->trace_t0);
+    
+    uint32_t t0 = trace_begin(TRACE_GOERTZEL);
+    sweep_detector_result(&cap->det, result);
+    trace_record(TRACE_GOERTZEL, cap->goertzel_ticks + trace_lap(TRACE_GOERTZEL, t0));
+    
+    if (params->max_windows > 1) {
+        bool converged = sweep_average_converged(&cap->avg, params);
+        float mag_db = 0.0f;
+        float phase_deg = 0.0f;
+        sweep_average_stderr(&cap->avg, &mag_db, &phase_deg);
+        DEBUG_PRINT(3, "[SWEEP] %.2f Hz: %d ventanas, error estándar %.4f dB / %.3f°%s\n",
+                    cap->point->freq_hz, cap->avg.windows, mag_db, phase_deg,
+                    converged ? "" : " (sin converger)");
+        if (totals != NULL && !converged) {
+            totals->unconverged++;
+        }
+    }
+    if (totals != NULL) {
+        totals->windows += cap->avg.windows;
+        if (cap->avg.windows > totals->max_windows) {
+            totals->max_windows = cap->avg.windows;
+        }
+    }
+    return cap->avg.windows;
+}
+
+/**
+ * @brief Suma a totals el asentamiento de un punto
+ */
+static void sweep_settle_account(sweep_point_totals_t *totals, const settle_report_t *report) {
+    if (!report->converged) {
+        totals->timeouts++;
+    }
+    totals->total_us += report->elapsed_us;
+    if (report->elapsed_us > totals->max_us) {
+        totals->max_us = report->elapsed_us;
+    }
+}
+
+/**
+ * @brief Espera el asentamiento del punto index y lo suma a totals
+ */
+static void sweep_settle_point(uint16_t index, sweep_point_totals_t *totals) {
+    const sweep_point_t *point = &sweep_plan.points[index];
+    settle_report_t report;
+    
+    uint32_t t0 = trace_begin(TRACE_SETTLE);
+    settle_wait(&point->settle, &point->coeffs, &report);
+    trace_end(TRACE_SETTLE, t0);
+    sweep_settle_account(totals, &report);
+}
+
+/**
+ * @brief Prepara una trama del barrido en curso desde el punto first_index
+ * 
+ * Con un plan uniforme la trama describe la grilla con inicio y paso; si
+ * no, cada punto lleva su frecuencia (sweep_frame_put()).
+ */
+static void sweep_frame_start(sweep_frame_t *frame, uint16_t first_index) {
+    sweep_frame_begin(frame, sweep_id, sweep_start_ms, sweep_plan.points[0].freq_hz,
+                      sweep_plan.uniform ? sweep_plan.step_hz : 0.0f, first_index);
+}
+
+/**
+ * @brief Agrega a la trama el resultado del punto index
+ */
+static void sweep_frame_put(sweep_frame_t *frame, uint16_t index, const goertzel_result_t *result) {
+    if (sweep_plan.uniform) {
+        sweep_frame_add(frame, result->magnitude_db, result->phase_deg);
+    } else {
+        sweep_frame_add_at(frame, sweep_plan.points[index].freq_hz,
+                           result->magnitude_db, result->phase_deg);
+    }
+}
+
+/**
+ * @brief Numera el barrido que empieza; sus tramas llevan este id
+ */
+static void sweep_frame_open(void) {
+    frequency_sweep_next_id();
+    sweep_start_ms = hal_time_ms();
+    sweep_frame_start(&sweep_record, 0);
+    sweep_undelivered = false;
+}
+
+/**
+ * @brief Agrega el punto index a la trama y la publica al completarse
+ * 
+ * La trama sale cada sweep_frame_chunk puntos y con el último punto del
+ * barrido; el resultado de la publicación cuenta para todos sus puntos.
+ * Publicar solo la encola: el barrido no espera a la red.
+ * 
+ * @param published Contador de puntos publicados
+ * @param lost Contador de puntos cuya trama no se pudo publicar
+ */
+static void sweep_frame_record(uint16_t index, const goertzel_result_t *result,
+                               uint32_t *published, uint32_t *lost) {
+    if (index % sweep_frame_chunk == 0) {
+        sweep_frame_start(&sweep_frame, index);
+    }
+    sweep_frame_put(&sweep_frame, index, result);
+    sweep_frame_put(&sweep_record, index, result);
+    
+    bool last = (index + 1 == sweep_plan.count);
+    if (sweep_frame.header.count < sweep_frame_chunk && !last) {
+        return;
+    }
+    if (last) {
+        sweep_frame.header.flags |= SWEEP_FRAME_FLAG_LAST;
+    }
+    
+    uint32_t t0 = trace_begin(TRACE_PUBLISH);
+    if (mqtt_publish_sweep_frame(&sweep_frame)) {
+        *published += sweep_frame.header.count;
+    } else {
+        *lost += sweep_frame.header.count;
+        DEBUG_PRINT(0, "[SWEEP] ERROR: Trama rechazada por la cola de publicación\n");
+        sweep_undelivered = true;
+    }
+    if (!mqtt_is_connected()) {
+        // Encolada, pero sin broker que la reciba: puede descartarse
+        sweep_undelivered = true;
+    }
+    trace_end(TRACE_PUBLISH, t0);
+}
+
+/**
+ * @brief Cierra el barrido: si alguna trama no llegó al broker, lo guarda
+ *        completo en flash para reenviarlo al reconectar
+ * 
+ * Corre en el core 0 con el core 1 ya detenido, fuera de la medición: la
+ * escritura en flash frena el XIP.
+ */
+static void sweep_frame_close(void) {
+    if (!sweep_undelivered) {
+        return;
+    }
+    if (sweep_store_append(&sweep_record)) {
+        DEBUG_PRINT(1, "[SWEEP] Barrido %lu guardado en flash (%lu pendientes)\n",
+                    (unsigned long)sweep_id, (unsigned long)sweep_store_pending());
+    } else {
+        DEBUG_PRINT(0, "[SWEEP] ERROR: No se pudo guardar el barrido %lu en flash\n",
+                    (unsigned long)sweep_id);
+    }
+}
+
+/**
+ * @brief Vuelca el asentamiento y las ventanas acumulados en las
+ *        estadísticas del barrido
+ */
+static void sweep_totals_to_stats(const sweep_point_totals_t *totals, sweep_stats_t *stats) {
+    stats->avg_settle_ms = (float)totals->total_us / 1000.0f / sweep_plan.count;
+    stats->max_settle_ms = (float)totals->max_us / 1000.0f;
+    stats->settle_timeouts = totals->timeouts;
+    stats->avg_windows_per_point = (float)totals->windows / sweep_plan.count;
+    stats->max_windows_per_point = totals->max_windows;
+    stats->unconverged_points = totals->unconverged;
+    stats->saturated_points = totals->saturated;
+}
+
+/**
+ * @brief Trabajo del core 1: Goertzel, validación y publicación por ventana
+ */
+static void sweep_pipeline_worker(void) {
+    while (true) {
+        uint8_t handle;
+        while (!spsc_queue_pop(&pipeline_captured, &handle)) {
+            hal_cpu_relax();
+        }
+        if (handle == SWEEP_PIPELINE_END) {
+            break;
         }
         
-        // 4. Procesar con Goertzel
-#ifdef DEBUG_GPIO_ENABLED
-        gpio_put(DEBUG_PIN_DSP_PROCESS, 1);
-#endif
+        sweep_slot_t *slot = &pipeline_slots[handle];
+        const sweep_point_t *plan_point = &sweep_plan.points[slot->point];
+        float freq = plan_point->freq_hz;
         
         goertzel_result_t result;
-        goertzel_compute(
-            adc_sample_buffer,
-            WINDOW_SIZE,
-            freq,
-            SAMPLE_RATE,
-            &result
-        );
+        uint32_t t0 = trace_begin(TRACE_GOERTZEL);
+        sweep_point_compute(plan_point, slot->samples, &result);
+        trace_end(TRACE_GOERTZEL, t0);
         
-#ifdef DEBUG_GPIO_ENABLED
-        gpio_put(DEBUG_PIN_DSP_PROCESS, 0);
-#endif
+        t0 = trace_begin(TRACE_VALIDATE);
+        bool valid = adc_dma_validate_samples(slot->samples, sweep_point_samples(plan_point));
+        trace_end(TRACE_VALIDATE, t0);
         
-        // 5. Transmitir via MQTT
-#ifdef DEBUG_GPIO_ENABLED
-        gpio_put(DEBUG_PIN_MQTT_TX, 1);
-#endif
+        // La ventana ya no se necesita: devolverla antes de publicar para
+        // que el core 0 no espere a MQTT
+        uint16_t point = slot->point;
+        spsc_queue_push(&pipeline_free, handle);
         
-        if (mqtt_publish_measurement(freq, result.magnitude_db, result.phase_deg)) {
-            successful_points++;
-        } else {
-            printf("[SWEEP] ERROR: Fallo en transmisión MQTT\n");
+        if (!valid) {
+            DEBUG_PRINT(1, "[SWEEP] WARNING: Muestras inválidas en %.0f Hz\n", freq);
+            pipeline_saturated++;
         }
         
-#ifdef DEBUG_GPIO_ENABLED
-        gpio_put(DEBUG_PIN_MQTT_TX, 0);
-#endif
-        
-        // Pequeña pausa entre puntos para no saturar el broker
-        sleep_ms(5);
+        sweep_frame_record(point, &result, &pipeline_successful, &pipeline_failed);
+    }
+}
+
+/**
+ * @brief Punto que mide el trabajo en curso
+ */
+static const sweep_point_t *sweep_engine_point(void) {
+    if (sweep_engine.job == SWEEP_JOB_PLAN) {
+        return &sweep_plan.points[sweep_engine.index];
     }
+    return &sweep_engine.point;
+}
+
+/**
+ * @brief Programa el DDS del punto en curso y arranca el asentamiento
+ */
+static void sweep_engine_tune(void) {
+    const sweep_point_t *point = sweep_engine_point();
     
-#ifdef DEBUG_GPIO_ENABLED
-    gpio_put(DEBUG_PIN_SWEEP_START, 0);
-#endif
+    if (sweep_engine.job == SWEEP_JOB_PLAN) {
+        DEBUG_PRINT(2, "[SWEEP] Punto %d/%d: %.2f Hz\n", sweep_engine.index + 1, sweep_plan.count,
+                    point->freq_hz);
+        // Precargado durante el punto anterior
+        sweep_tune_point(sweep_engine.index);
+    } else {
+        uint32_t t0 = trace_begin(TRACE_DDS_WRITE);
+        ad9833_set_frequency(point->freq_hz);
+        trace_end(TRACE_DDS_WRITE, t0);
+    }
+    
+    sweep_engine.settle_t0 = trace_begin(TRACE_SETTLE);
+    settle_start(&sweep_engine.settle, &point->settle, &point->coeffs);
+    sweep_engine.step = SWEEP_STEP_SETTLE;
+}
+
+/**
+ * @brief Cierra el asentamiento y arranca la captura del punto
+ */
+static void sweep_engine_capture(void) {
+    const sweep_point_t *point = sweep_engine_point();
+    settle_report_t report;
+    
+    settle_finish(&sweep_engine.settle, &report);
+    trace_end(TRACE_SETTLE, sweep_engine.settle_t0);
+    
+    bool started;
+    if (sweep_engine.job == SWEEP_JOB_PLAN) {
+        sweep_settle_account(&sweep_engine.totals, &report);
+        started = sweep_capture_start(&sweep_engine.capture, point, sweep_engine.index);
+    } else {
+        started = sweep_capture_start(&sweep_engine.capture, point, SWEEP_NO_PRELOAD);
+    }
+    sweep_engine.step = SWEEP_STEP_CAPTURE;
+    
+    // Sin captura el punto no termina nunca: el trabajo se corta como con
+    // "stop" (un barrido publica sweep_aborted)
+    if (!started) {
+        DEBUG_PRINT(0, "[SWEEP] ERROR: El ADC rechazó la captura de %.2f Hz\n", point->freq_hz);
+        frequency_sweep_abort();
+    }
+}
+
+/**
+ * @brief Valida y entrega el resultado del punto; pasa al siguiente
+ */
+static void sweep_engine_deliver(void) {
+    const sweep_point_t *point = sweep_engine_point();
+    bool plan = (sweep_engine.job == SWEEP_JOB_PLAN);
+    
+    goertzel_result_t result;
+    uint16_t windows = sweep_capture_finish(&sweep_engine.capture, &result,
+                                            plan ? &sweep_engine.totals : NULL);
     
-    uint32_t elapsed_ms = to_ms_since_boot(get_absolute_time()) - start_time;
-    float avg_time = (float)elapsed_ms / SWEEP_NUM_POINTS;
+    // Sobre las capturas integradas, contadas bloque a bloque
+    const sweep_capture_t *cap = &sweep_engine.capture;
+    uint32_t t0 = trace_begin(TRACE_VALIDATE);
+    bool valid = adc_dma_saturation_valid(cap->saturated, cap->validated);
+    trace_record(TRACE_VALIDATE, cap->validate_ticks + trace_lap(TRACE_VALIDATE, t0));
+    // Un punto saturado se entrega igual (H = respuesta/referencia suele
+    // seguir siendo útil y la trama no tiene marca de punto inválido): queda
+    // el aviso y la cuenta en saturated_points
+    if (!valid) {
+        DEBUG_PRINT(1, "[SWEEP] WARNING: Muestras inválidas en %.0f Hz\n", point->freq_hz);
+        if (plan) {
+            sweep_engine.totals.saturated++;
+        }
+    }
+    
+    if (plan) {
+        // A la trama del barrido; se publica por MQTT al completarse (un
+        // mensaje por barrido o por tramo)
+        sweep_frame_record(sweep_engine.index, &result, &sweep_engine.stats.successful_points,
+                           &sweep_engine.stats.failed_points);
+        sweep_engine.index++;
+        sweep_engine.step = sweep_engine.index < sweep_plan.count ? SWEEP_STEP_TUNE : SWEEP_STEP_FINISH;
+        return;
+    }
+    
+    sweep_engine.measurement.frequency_hz = point->freq_hz;
+    sweep_engine.measurement.magnitude_db = result.magnitude_db;
+    sweep_engine.measurement.phase_deg = result.phase_deg;
+    sweep_engine.measurement.windows = windows;
+    if (sweep_engine.publish) {
+        t0 = trace_begin(TRACE_PUBLISH);
+        sweep_engine.published = mqtt_publish_measurement(point->freq_hz, result.magnitude_db,
+                                                     result.phase_deg);
+        trace_end(TRACE_PUBLISH, t0);
+    }
+    sweep_engine.step = SWEEP_STEP_FINISH;
+}
+
+/**
+ * @brief Cierra las estadísticas del barrido del plan hasta el punto en
+ *        curso
+ */
+static void sweep_engine_close_stats(void) {
+    sweep_stats_t *stats = &sweep_engine.stats;
     
-    printf("\n========================================\n");
-    printf("  BARRIDO COMPLETADO\n");
-    printf("========================================\n");
-    printf("  Puntos exitosos: %lu/%d\n", successful_points, SWEEP_NUM_POINTS);
-    printf("  Tiempo total: %lu ms (%.2f s)\n", elapsed_ms, elapsed_ms / 1000.0f);
-    printf("  Tiempo por punto: %.2f ms\n", avg_time);
-    printf("========================================\n\n");
+    stats->total_time_ms = hal_time_ms() - sweep_engine.start_ms;
+    stats->avg_time_per_point_ms = (float)stats->total_time_ms / stats->total_points;
+    sweep_totals_to_stats(&sweep_engine.totals, stats);
+}
+
+/**
+ * @brief Termina el trabajo en curso
+ */
+static void sweep_engine_finish(void) {
+    sweep_engine.status = SWEEP_DONE;
+    if (sweep_engine.job != SWEEP_JOB_PLAN) {
+        return;
+    }
+    
+    trace_end(TRACE_SWEEP, sweep_engine.sweep_t0);
+    sweep_engine_close_stats();
+    sweep_frame_close();
+    
+    const sweep_stats_t *stats = &sweep_engine.stats;
+    DEBUG_PRINT(1, "\n========================================\n");
+    DEBUG_PRINT(1, "  BARRIDO COMPLETADO\n");
+    DEBUG_PRINT(1, "========================================\n");
+    DEBUG_PRINT(1, "  Puntos exitosos: %lu/%d\n", (unsigned long)stats->successful_points,
+                sweep_plan.count);
+    DEBUG_PRINT(1, "  Tiempo total: %lu ms (%.2f s)\n", (unsigned long)stats->total_time_ms,
+                stats->total_time_ms / 1000.0f);
+    DEBUG_PRINT(1, "  Tiempo por punto: %.2f ms\n", stats->avg_time_per_point_ms);
+    DEBUG_PRINT(1, "  Asentamiento: %.2f ms/punto (máx %.2f ms, %lu sin converger)\n",
+                stats->avg_settle_ms, stats->max_settle_ms, (unsigned long)stats->settle_timeouts);
+    DEBUG_PRINT(1, "  Ventanas: %.2f/punto (máx %lu, %lu sin converger)\n",
+                stats->avg_windows_per_point, (unsigned long)stats->max_windows_per_point,
+                (unsigned long)stats->unconverged_points);
+    DEBUG_PRINT(1, "  Saturados: %lu\n", (unsigned long)stats->saturated_points);
+    DEBUG_PRINT(1, "========================================\n\n");
     
     // Publicar mensaje de finalización
     mqtt_publish_status("sweep_complete");
 }
 
+/**
+ * @brief Avanza el trabajo en curso hasta que termine, sin dormir
+ * 
+ * Consulta el DMA en bucle como lo hacían los barridos bloqueantes; en el
+ * simulador cada consulta avanza el reloj virtual igual que antes.
+ */
+static void sweep_engine_run(void) {
+    while (frequency_sweep_poll() == SWEEP_RUNNING) {
+    }
+}
+
+bool frequency_sweep_init(void) {
+    sweep_plan_spec_t spec;
+    sweep_plan_default_spec(&spec);
+    return frequency_sweep_set_plan(&spec);
+}
+
+bool frequency_sweep_set_plan(const sweep_plan_spec_t *spec) {
+    if (sweep_engine.status == SWEEP_RUNNING || sweep_engine.status == SWEEP_PAUSED) {
+        DEBUG_PRINT(0, "[SWEEP] ERROR: Plan rechazado durante un barrido\n");
+        return false;
+    }
+    
+    if (sweep_plan_build(&sweep_plan, spec)) {
+        sweep_spec = *spec;
+        sweep_spec.list_hz = NULL;
+        DEBUG_PRINT(2, "[SWEEP] Plan listo: %d puntos, %.2f-%.2f Hz\n", sweep_plan.count,
+                    sweep_plan.points[0].freq_hz, sweep_plan.points[sweep_plan.count - 1].freq_hz);
+        return true;
+    }
+    
+    // Nunca dejar el barrido sin puntos: volver a la grilla de config.h
+    DEBUG_PRINT(0, "[SWEEP] ERROR: Plan rechazado, se usa la grilla por defecto\n");
+    sweep_plan_spec_t fallback;
+    sweep_plan_default_spec(&fallback);
+    sweep_plan_build(&sweep_plan, &fallback);
+    sweep_spec = fallback;
+    return false;
+}
+
+const sweep_plan_t *frequency_sweep_get_plan(void) {
+    return &sweep_plan;
+}
+
+bool frequency_sweep_set_frame_points(uint16_t points) {
+    if (sweep_engine.status == SWEEP_RUNNING || sweep_engine.status == SWEEP_PAUSED) {
+        DEBUG_PRINT(0, "[SWEEP] ERROR: Tramas no se cambian durante un barrido\n");
+        return false;
+    }
+    
+    sweep_frame_chunk = (points > 0 && points < SWEEP_NUM_POINTS) ? points : SWEEP_NUM_POINTS;
+    return true;
+}
+
+uint16_t frequency_sweep_get_frame_points(void) {
+    return sweep_frame_chunk == SWEEP_NUM_POINTS ? 0 : sweep_frame_chunk;
+}
+
+uint32_t frequency_sweep_next_id(void) {
+    return ++sweep_id;
+}
+
+bool frequency_sweep_start(void) {
+    if (sweep_engine.status == SWEEP_RUNNING || sweep_engine.status == SWEEP_PAUSED) {
+        return false;
+    }
+    
+    sweep_engine.job = SWEEP_JOB_PLAN;
+    sweep_engine.step = SWEEP_STEP_TUNE;
+    sweep_engine.pause_requested = false;
+    sweep_engine.index = 0;
+    sweep_engine.totals = (sweep_point_totals_t){0};
+    sweep_engine.stats = (sweep_stats_t){0};
+    sweep_engine.stats.total_points = sweep_plan.count;
+    sweep_engine.sweep_t0 = trace_begin(TRACE_SWEEP);
+    sweep_engine.start_ms = hal_time_ms();
+    sweep_frame_open();
+    sweep_engine.status = SWEEP_RUNNING;
+    return true;
+}
+
+bool frequency_sweep_start_point(float frequency_hz, bool publish) {
+    if (sweep_engine.status == SWEEP_RUNNING || sweep_engine.status == SWEEP_PAUSED) {
+        return false;
+    }
+    
+    // Misma corrección coherente que los puntos del plan
+    if (!sweep_plan_point_init(&sweep_engine.point, frequency_hz, &sweep_spec)) {
+        DEBUG_PRINT(0, "[SWEEP] ERROR: %.2f Hz fuera de rango\n", frequency_hz);
+        return false;
+    }
+    
+    sweep_engine.job = SWEEP_JOB_POINT;
+    sweep_engine.step = SWEEP_STEP_TUNE;
+    sweep_engine.pause_requested = false;
+    sweep_engine.publish = publish;
+    sweep_engine.published = false;
+    sweep_engine.status = SWEEP_RUNNING;
+    return true;
+}
+
+sweep_status_t frequency_sweep_poll(void) {
+    while (sweep_engine.status == SWEEP_RUNNING) {
+        switch (sweep_engine.step) {
+            case SWEEP_STEP_TUNE:
+                if (sweep_engine.pause_requested) {
+                    DEBUG_PRINT(2, "[SWEEP] En pausa antes del punto %d\n", sweep_engine.index + 1);
+                    sweep_engine.status = SWEEP_PAUSED;
+                    break;
+                }
+                sweep_engine_tune();
+                break;
+            case SWEEP_STEP_SETTLE:
+                if (!settle_poll(&sweep_engine.settle)) {
+                    return sweep_engine.status;
+                }
+                sweep_engine_capture();
+                break;
+            case SWEEP_STEP_CAPTURE:
+                if (!sweep_capture_poll(&sweep_engine.capture)) {
+                    return sweep_engine.status;
+                }
+                sweep_engine_deliver();
+                break;
+            case SWEEP_STEP_FINISH:
+                sweep_engine_finish();
+                break;
+        }
+    }
+    return sweep_engine.status;
+}
+
+uint64_t frequency_sweep_wake_us(void) {
+    if (sweep_engine.status == SWEEP_RUNNING) {
+        if (sweep_engine.step == SWEEP_STEP_SETTLE) {
+            return settle_wake_us(&sweep_engine.settle);
+        }
+        if (sweep_engine.step == SWEEP_STEP_CAPTURE) {
+            return sweep_capture_wake_us(&sweep_engine.capture);
+        }
+    }
+    return hal_time_us();
+}
+
+void frequency_sweep_wait(void) {
+    hal_wait_event_until_us(frequency_sweep_wake_us());
+}
+
+void frequency_sweep_pause(void) {
+    if (sweep_engine.status == SWEEP_RUNNING) {
+        sweep_engine.pause_requested = true;
+    }
+}
+
+void frequency_sweep_resume(void) {
+    sweep_engine.pause_requested = false;
+    if (sweep_engine.status == SWEEP_PAUSED) {
+        DEBUG_PRINT(2, "[SWEEP] Reanudando en el punto %d\n", sweep_engine.index + 1);
+        sweep_engine.status = SWEEP_RUNNING;
+    }
+}
+
+void frequency_sweep_abort(void) {
+    if (sweep_engine.status != SWEEP_RUNNING && sweep_engine.status != SWEEP_PAUSED) {
+        return;
+    }
+    
+    // Cortar la captura en vuelo y bajar los pines de las etapas abiertas
+    if (sweep_engine.status == SWEEP_RUNNING && sweep_engine.step == SWEEP_STEP_SETTLE) {
+        adc_dma_abort_capture();
+        trace_lap(TRACE_SETTLE, sweep_engine.settle_t0);
+    } else if (sweep_engine.status == SWEEP_RUNNING && sweep_engine.step == SWEEP_STEP_CAPTURE) {
+        adc_dma_abort_capture();
+        trace_lap(TRACE_ADC_CAPTURE, sweep_engine.capture.trace_t0);
+    }
+    sweep_engine.status = SWEEP_ABORTED;
+    
+    if (sweep_engine.job != SWEEP_JOB_PLAN) {
+        return;
+    }
+    
+    // La trama a medio armar se descarta: el barrido no se guarda en flash
+    trace_lap(TRACE_SWEEP, sweep_engine.sweep_t0);
+    sweep_engine_close_stats();
+    DEBUG_PRINT(1, "[SWEEP] Barrido %lu abortado en el punto %d/%d\n", (unsigned long)sweep_id,
+                sweep_engine.index + 1, sweep_plan.count);
+    mqtt_publish_status("sweep_aborted");
+}
+
+sweep_status_t frequency_sweep_status(void) {
+    return sweep_engine.status;
+}
+
+void frequency_sweep_get_stats(sweep_stats_t *stats) {
+    *stats = sweep_engine.stats;
+}
+
+bool frequency_sweep_get_measurement(sweep_measurement_t *measurement) {
+    if (sweep_engine.job != SWEEP_JOB_POINT || sweep_engine.status != SWEEP_DONE) {
+        return false;
+    }
+    *measurement = sweep_engine.measurement;
+    return true;
+}
+
+void frequency_sweep_execute(void) {
+    DEBUG_PRINT(2, "\n========================================\n");
+    DEBUG_PRINT(2, "  INICIANDO BARRIDO DE FRECUENCIA\n");
+    DEBUG_PRINT(2, "========================================\n\n");
+    
+    if (!frequency_sweep_start()) {
+        DEBUG_PRINT(0, "[SWEEP] ERROR: Hay un trabajo en curso\n");
+        return;
+    }
+    sweep_engine_run();
+}
+
 void frequency_sweep_execute_with_stats(sweep_stats_t *stats) {
-    printf("[SWEEP] Ejecutando con recolección de estadísticas...\n");
+    DEBUG_PRINT(2, "[SWEEP] Ejecutando con recolección de estadísticas...\n");
+    
+    if (!frequency_sweep_start()) {
+        DEBUG_PRINT(0, "[SWEEP] ERROR: Hay un trabajo en curso\n");
+        *stats = (sweep_stats_t){0};
+        stats->total_points = sweep_plan.count;
+        stats->failed_points = sweep_plan.count;
+        return;
+    }
+    sweep_engine_run();
+    frequency_sweep_get_stats(stats);
+}
+
+void frequency_sweep_execute_pipelined(sweep_stats_t *stats) {
+    DEBUG_PRINT(2, "[SWEEP] Ejecutando barrido pipeline (%d buffers)...\n",
+                SWEEP_PIPELINE_BUFFERS);
     
-    uint32_t start_time = to_ms_since_boot(get_absolute_time());
+    // Comparte el ADC, el AD9833 y la trama con el motor
+    if (sweep_engine.status == SWEEP_RUNNING || sweep_engine.status == SWEEP_PAUSED) {
+        DEBUG_PRINT(0, "[SWEEP] ERROR: Hay un trabajo en curso\n");
+        *stats = (sweep_stats_t){0};
+        stats->total_points = sweep_plan.count;
+        stats->failed_points = sweep_plan.count;
+        return;
+    }
+    
+    stats->total_points = sweep_plan.count;
+    stats->max_queue_depth = 0;
+    stats->producer_stalls = 0;
     
-    stats->total_points = SWEEP_NUM_POINTS;
-    stats->successful_points = 0;
-    stats->failed_points = 0;
+    spsc_queue_init(&pipeline_captured);
+    spsc_queue_init(&pipeline_free);
+    for (uint8_t i = 0; i < SWEEP_PIPELINE_BUFFERS; i++) {
+        spsc_queue_push(&pipeline_free, i);
+    }
+    pipeline_successful = 0;
+    pipeline_failed = 0;
+    pipeline_saturated = 0;
+    sweep_point_totals_t totals = {0};
+    sweep_frame_open();
     
-    // Ejecutar barrido (versión simplificada con conteo de errores)
-    for (uint16_t k = 1; k <= SWEEP_NUM_POINTS; k++) {
-        float freq = SWEEP_FREQ_MIN + (k - 1) * FREQ_RESOLUTION;
+    uint32_t start_time = hal_time_ms();
+    
+    if (!hal_core1_launch(sweep_pipeline_worker)) {
+        DEBUG_PRINT(0, "[SWEEP] ERROR: No se pudo lanzar el core 1\n");
+        stats->successful_points = 0;
+        stats->failed_points = sweep_plan.count;
+        stats->total_time_ms = 0;
+        stats->avg_time_per_point_ms = 0.0f;
+        sweep_totals_to_stats(&totals, stats);
+        return;
+    }
+    
+    uint32_t sweep_t0 = trace_begin(TRACE_SWEEP);
+    
+    for (uint16_t k = 0; k < sweep_plan.count; k++) {
+        // Cambiar de frecuencia mientras el core 1 procesa el punto anterior
+        sweep_tune_point(k);
+        sweep_settle_point(k, &totals);
+        
+        uint8_t handle;
+        if (!spsc_queue_pop(&pipeline_free, &handle)) {
+            stats->producer_stalls++;
+            while (!spsc_queue_pop(&pipeline_free, &handle)) {
+                hal_cpu_relax();
+            }
+        }
+        
+        sweep_slot_t *slot = &pipeline_slots[handle];
+        slot->point = k;
         
-        if (frequency_sweep_single_point(freq)) {
-            stats->successful_points++;
-        } else {
-            stats->failed_points++;
+        uint32_t t0 = trace_begin(TRACE_ADC_CAPTURE);
+        adc_dma_start_capture_into(slot->samples, sweep_point_samples(&sweep_plan.points[k]));
+        sweep_preload_next(k);
+        adc_dma_wait_complete();
+        trace_end(TRACE_ADC_CAPTURE, t0);
+        
+        // Una sola captura por punto: el corte del promedio depende de un
+        // resultado que recién calcula el core 1
+        totals.windows++;
+        totals.max_windows = 1;
+        
+        spsc_queue_push(&pipeline_captured, handle);
+        
+        uint32_t depth = spsc_queue_depth(&pipeline_captured);
+        if (depth > stats->max_queue_depth) {
+            stats->max_queue_depth = depth;
         }
     }
     
-    stats->total_time_ms = to_ms_since_boot(get_absolute_time()) - start_time;
+    // Siempre hay lugar: a lo sumo SWEEP_PIPELINE_BUFFERS ventanas en cola
+    spsc_queue_push(&pipeline_captured, SWEEP_PIPELINE_END);
+    hal_core1_join();
+    
+    trace_end(TRACE_SWEEP, sweep_t0);
+    
+    stats->successful_points = pipeline_successful;
+    stats->failed_points = pipeline_failed;
+    totals.saturated = pipeline_saturated;
+    stats->total_time_ms = hal_time_ms() - start_time;
     stats->avg_time_per_point_ms = (float)stats->total_time_ms / stats->total_points;
+    sweep_totals_to_stats(&totals, stats);
+    sweep_frame_close();
     
-    printf("[SWEEP] Estadísticas:\n");
-    printf("  - Total: %lu puntos\n", stats->total_points);
-    printf("  - Exitosos: %lu\n", stats->successful_points);
-    printf("  - Fallidos: %lu\n", stats->failed_points);
-    printf("  - Tiempo total: %lu ms\n", stats->total_time_ms);
-    printf("  - Tiempo promedio: %.2f ms/punto\n", stats->avg_time_per_point_ms);
+    DEBUG_PRINT(1, "[SWEEP] Pipeline: %lu/%lu puntos en %lu ms, cola máx %lu, esperas %lu\n",
+                (unsigned long)stats->successful_points, (unsigned long)stats->total_points,
+                (unsigned long)stats->total_time_ms, (unsigned long)stats->max_queue_depth,
+                (unsigned long)stats->producer_stalls);
+}
+
+bool frequency_sweep_measure(float frequency_hz, sweep_measurement_t *measurement) {
+    if (!frequency_sweep_start_point(frequency_hz, false)) {
+        return false;
+    }
+    sweep_engine_run();
+    return frequency_sweep_get_measurement(measurement);
 }
 
 bool frequency_sweep_single_point(float frequency_hz) {
-    printf("[SWEEP] Midiendo punto único: %.2f Hz\n", frequency_hz);
-    
-    // Configurar generador
-    ad9833_set_frequency(frequency_hz);
-    sleep_ms(100);
+    DEBUG_PRINT(2, "[SWEEP] Midiendo punto único: %.2f Hz\n", frequency_hz);
     
-    // Adquirir
-    adc_dma_start_capture();
-    adc_dma_wait_complete();
-    
-    // Procesar
-    goertzel_result_t result;
-    goertzel_compute(
-        adc_sample_buffer,
-        WINDOW_SIZE,
-        frequency_hz,
-        SAMPLE_RATE,
-        &result
-    );
-    
-    // Transmitir
-    return mqtt_publish_measurement(frequency_hz, result.magnitude_db, result.phase_deg);
+    if (!frequency_sweep_start_point(frequency_hz, true)) {
+        return false;
+    }
+    sweep_engine_run();
+    return sweep_engine.status == SWEEP_DONE && sweep_engine.published;
 }
@@ -0,0 +1,235 @@
+/**
+ * @file sweep_adaptive.c
+ * @brief Implementación del barrido adaptativo
+ *
+ * Los puntos se mantienen ordenados por frecuencia en el resultado; cada
+ * inserción desplaza la cola de los arreglos (a lo sumo SWEEP_NUM_POINTS
+ * elementos, despreciable frente a una medición). Los errores estimados se
+ * recalculan completos tras cada punto por la misma razón.
+ */
+
+#include "sweep_adaptive.h"
+#include "sweep.h"
+#include "sweep_frame.h"
+#include "sweep_store.h"
+#include "mqtt_client.h"
+#include "debug.h"
+#include "hal.h"
+#include <math.h>
+#include <string.h>
+
+#if SWEEP_ADAPTIVE_COARSE_POINTS < 3 || SWEEP_ADAPTIVE_COARSE_POINTS > SWEEP_NUM_POINTS
+#error "SWEEP_ADAPTIVE_COARSE_POINTS debe estar entre 3 y SWEEP_NUM_POINTS"
+#endif
+
+// Intervalos que no se pueden partir más (la frecuencia coherente del
+// punto medio cae sobre un extremo): closed[j] cierra el intervalo j, j+1
+static bool adaptive_closed[SWEEP_NUM_POINTS];
+
+// Trama del barrido adaptativo (solo la toca el hilo principal)
+static sweep_frame_t adaptive_frame;
+
+void sweep_adaptive_default_params(sweep_adaptive_params_t *params) {
+    params->start_hz = SWEEP_FREQ_MIN;
+    params->stop_hz = SWEEP_FREQ_MAX;
+    params->coarse_points = SWEEP_ADAPTIVE_COARSE_POINTS;
+    params->max_points = SWEEP_NUM_POINTS;
+    params->max_time_ms = SWEEP_ADAPTIVE_MAX_MS;
+    params->mag_tol_db = SWEEP_ADAPTIVE_MAG_TOL_DB;
+#if ADC_CHANNELS == 2
+    params->phase_tol_deg = SWEEP_ADAPTIVE_PHASE_TOL_DEG;
+#else
+    // Sin referencia la fase depende del arranque de cada captura
+    params->phase_tol_deg = 0.0f;
+#endif
+    params->min_step = SWEEP_ADAPTIVE_MIN_STEP;
+}
+
+/**
+ * @brief Inserta una medición en orden; false si su frecuencia ya está
+ */
+static bool adaptive_insert(sweep_adaptive_result_t *result, const sweep_measurement_t *m) {
+    uint16_t pos = 0;
+    while (pos < result->count && result->frequency_hz[pos] < m->frequency_hz) {
+        pos++;
+    }
+    if (pos < result->count && result->frequency_hz[pos] == m->frequency_hz) {
+        return false;
+    }
+
+    uint16_t tail = result->count - pos;
+    memmove(&result->frequency_hz[pos + 1], &result->frequency_hz[pos], tail * sizeof(float));
+    memmove(&result->magnitude_db[pos + 1], &result->magnitude_db[pos], tail * sizeof(float));
+    memmove(&result->phase_deg[pos + 1], &result->phase_deg[pos], tail * sizeof(float));
+    memmove(&adaptive_closed[pos + 1], &adaptive_closed[pos], tail * sizeof(bool));
+
+    result->frequency_hz[pos] = m->frequency_hz;
+    result->magnitude_db[pos] = m->magnitude_db;
+    result->phase_deg[pos] = m->phase_deg;
+    adaptive_closed[pos] = false;
+    result->count++;
+    return true;
+}
+
+/**
+ * @brief Segunda derivada de valores[] respecto de log f en el punto
+ *        interior i (diferencias divididas sobre los dos vecinos)
+ */
+static float adaptive_curvature(const float *freq, const float *value, uint16_t i, bool wrap) {
+    float x0 = logf(freq[i - 1]);
+    float x1 = logf(freq[i]);
+    float x2 = logf(freq[i + 1]);
+
+    float d01 = value[i] - value[i - 1];
+    float d12 = value[i + 1] - value[i];
+    if (wrap) {
+        // Fases: saltos de más de media vuelta son el desenvolvimiento
+        d01 = remainderf(d01, 360.0f);
+        d12 = remainderf(d12, 360.0f);
+    }
+
+    return 2.0f * (d12 / (x2 - x1) - d01 / (x1 - x0)) / (x2 - x0);
+}
+
+/**
+ * @brief Error estimado de interpolar el intervalo (j, j+1), en múltiplos
+ *        de la tolerancia (> 1: hay que refinar)
+ *
+ * El error de la interpolación lineal es h²·|f''|/8; f'' se toma como la
+ * mayor curvatura de los extremos del intervalo que sean interiores.
+ */
+static float adaptive_interval_error(const sweep_adaptive_params_t *params,
+                                     const sweep_adaptive_result_t *result, uint16_t j) {
+    float h = logf(result->frequency_hz[j + 1] / result->frequency_hz[j]);
+    float mag = 0.0f;
+    float phase = 0.0f;
+
+    for (uint16_t i = j; i <= j + 1; i++) {
+        if (i == 0 || i + 1 >= result->count) {
+            continue;
+        }
+        mag = fmaxf(mag, fabsf(adaptive_curvature(result->frequency_hz, result->magnitude_db, i, false)));
+        if (params->phase_tol_deg > 0.0f) {
+            phase = fmaxf(phase, fabsf(adaptive_curvature(result->frequency_hz, result->phase_deg, i, true)));
+        }
+    }
+
+    float err = h * h / 8.0f * mag / params->mag_tol_db;
+    if (params->phase_tol_deg > 0.0f) {
+        err = fmaxf(err, h * h / 8.0f * phase / params->phase_tol_deg);
+    }
+    return err;
+}
+
+/**
+ * @brief Intervalo a partir: el de mayor error estimado por encima de la
+ *        tolerancia, entre los que todavía admiten un punto medio
+ *
+ * @return Índice j del intervalo (j, j+1), o -1 si no queda ninguno
+ */
+static int adaptive_pick_interval(const sweep_adaptive_params_t *params,
+                                  const sweep_adaptive_result_t *result) {
+    int best = -1;
+    float best_err = 1.0f;
+
+    for (uint16_t j = 0; j + 1 < result->count; j++) {
+        if (adaptive_closed[j]
+            || result->frequency_hz[j + 1] / result->frequency_hz[j] - 1.0f <= params->min_step) {
+            continue;
+        }
+        float err = adaptive_interval_error(params, result, j);
+        if (err > best_err) {
+            best = j;
+            best_err = err;
+        }
+    }
+    return best;
+}
+
+bool sweep_adaptive_measure(const sweep_adaptive_params_t *params,
+                            sweep_adaptive_result_t *result) {
+    result->count = 0;
+    result->coarse = 0;
+    result->budget_hit = false;
+    result->total_time_ms = 0;
+
+    uint16_t max_points = params->max_points < SWEEP_NUM_POINTS ? params->max_points : SWEEP_NUM_POINTS;
+    if (params->coarse_points < 3 || params->coarse_points > max_points
+        || !(params->start_hz > 0.0f) || !(params->stop_hz > params->start_hz)
+        || !(params->mag_tol_db > 0.0f)) {
+        DEBUG_PRINT(0, "[ADAPT] ERROR: Parámetros inválidos\n");
+        return false;
+    }
+
+    uint32_t start_ms = hal_time_ms();
+    sweep_measurement_t m;
+
+    // 1. Pasada gruesa logarítmica
+    float ratio = powf(params->stop_hz / params->start_hz, 1.0f / (params->coarse_points - 1));
+    for (uint16_t k = 0; k < params->coarse_points; k++) {
+        float freq = k + 1 == params->coarse_points
+            ? params->stop_hz
+            : params->start_hz * powf(ratio, (float)k);
+        if (!frequency_sweep_measure(freq, &m)) {
+            return false;
+        }
+        adaptive_insert(result, &m);
+    }
+    result->coarse = result->count;
+
+    // 2. Refinamiento: un punto por vuelta donde peor interpola
+    while (true) {
+        if (result->count >= max_points
+            || (params->max_time_ms > 0 && hal_time_ms() - start_ms >= params->max_time_ms)) {
+            result->budget_hit = true;
+            break;
+        }
+
+        int j = adaptive_pick_interval(params, result);
+        if (j < 0) {
+            break;
+        }
+
+        float mid = sqrtf(result->frequency_hz[j] * result->frequency_hz[j + 1]);
+        if (!frequency_sweep_measure(mid, &m)
+            || !(m.frequency_hz > result->frequency_hz[j] && m.frequency_hz < result->frequency_hz[j + 1])
+            || !adaptive_insert(result, &m)) {
+            adaptive_closed[j] = true;
+        }
+    }
+
+    result->total_time_ms = hal_time_ms() - start_ms;
+
+    DEBUG_PRINT(1, "[ADAPT] %d puntos (%d gruesos + %d refinados) en %lu ms%s\n",
+                result->count, result->coarse, result->count - result->coarse,
+                (unsigned long)result->total_time_ms, result->budget_hit ? ", presupuesto agotado" : "");
+    return true;
+}
+
+bool sweep_adaptive_execute(const sweep_adaptive_params_t *params,
+                            sweep_adaptive_result_t *result) {
+    uint32_t start_ms = hal_time_ms();
+    uint32_t id = frequency_sweep_next_id();
+
+    if (!sweep_adaptive_measure(params, result)) {
+        return false;
+    }
+
+    sweep_frame_begin(&adaptive_frame, id, start_ms, result->frequency_hz[0], 0.0f, 0);
+    for (uint16_t i = 0; i < result->count; i++) {
+        sweep_frame_add_at(&adaptive_frame, result->frequency_hz[i],
+                           result->magnitude_db[i], result->phase_deg[i]);
+    }
+    adaptive_frame.header.flags |= SWEEP_FRAME_FLAG_LAST;
+
+    bool queued = mqtt_publish_sweep_frame(&adaptive_frame);
+    if (!queued || !mqtt_is_connected()) {
+        // Mismo criterio que el barrido del plan: sin broker va a la flash
+        if (sweep_store_append(&adaptive_frame)) {
+            DEBUG_PRINT(1, "[ADAPT] Barrido %lu guardado en flash\n", (unsigned long)id);
+        }
+    }
+
+    mqtt_publish_status("sweep_complete");
+    return queued;
+}
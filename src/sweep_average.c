@@ -0,0 +1,61 @@
+/**
+ * @file sweep_average.c
+ * @brief Implementación del promedio coherente con corte anticipado
+ */
+
+#include "sweep_average.h"
+#include "config.h"
+#include <math.h>
+
+#if SWEEP_AVG_MAX_WINDOWS < 1 || SWEEP_AVG_MIN_WINDOWS < 2
+#error "SWEEP_AVG_MAX_WINDOWS debe ser al menos 1 y SWEEP_AVG_MIN_WINDOWS al menos 2"
+#endif
+
+void sweep_average_default_params(sweep_average_params_t *params) {
+    params->max_windows = SWEEP_AVG_MAX_WINDOWS;
+    params->min_windows = SWEEP_AVG_MIN_WINDOWS;
+    params->stderr_db = SWEEP_AVG_STDERR_DB;
+    params->stderr_deg = SWEEP_AVG_STDERR_DEG;
+}
+
+void sweep_average_init(sweep_average_t *avg) {
+    avg->windows = 0;
+    avg->mean_re = 0.0f;
+    avg->mean_im = 0.0f;
+    avg->m2 = 0.0f;
+}
+
+void sweep_average_add(sweep_average_t *avg, float re, float im) {
+    avg->windows++;
+
+    float d_re = re - avg->mean_re;
+    float d_im = im - avg->mean_im;
+    avg->mean_re += d_re / (float)avg->windows;
+    avg->mean_im += d_im / (float)avg->windows;
+    avg->m2 += d_re * (re - avg->mean_re) + d_im * (im - avg->mean_im);
+}
+
+bool sweep_average_stderr(const sweep_average_t *avg, float *mag_db, float *phase_deg) {
+    float mean = sqrtf(avg->mean_re * avg->mean_re + avg->mean_im * avg->mean_im);
+    if (avg->windows < 2 || !(mean > 0.0f)) {
+        return false;
+    }
+
+    // s²/k de la media, repartido entre magnitud y fase
+    float k = (float)avg->windows;
+    float r = sqrtf(avg->m2 / ((k - 1.0f) * k * 2.0f)) / mean;
+
+    *mag_db = (20.0f / logf(10.0f)) * r;
+    *phase_deg = r * (180.0f / (float)M_PI);
+    return true;
+}
+
+bool sweep_average_converged(const sweep_average_t *avg, const sweep_average_params_t *params) {
+    float mag_db, phase_deg;
+    uint16_t min_windows = params->min_windows > 2 ? params->min_windows : 2;
+
+    return avg->windows >= min_windows
+        && sweep_average_stderr(avg, &mag_db, &phase_deg)
+        && mag_db <= params->stderr_db
+        && phase_deg <= params->stderr_deg;
+}
@@ -0,0 +1,196 @@
+/**
+ * @file sweep_frame.c
+ * @brief Implementación de la trama binaria de barrido
+ *
+ * La serialización escribe byte a byte en little-endian, así el formato no
+ * depende del orden de bytes ni del padding de sweep_frame_t.
+ */
+
+#include "sweep_frame.h"
+#include <math.h>
+#include <string.h>
+
+#define SWEEP_FRAME_MAGIC0 'F'
+#define SWEEP_FRAME_MAGIC1 'R'
+
+// Escala de cuantización: centésimas
+#define SWEEP_FRAME_SCALE 100.0f
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void put_f32(uint8_t *p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put_u32(p, bits);
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static float get_f32(const uint8_t *p) {
+    uint32_t bits = get_u32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief Cuantiza a centésimas saturando (INT16_MIN queda reservado)
+ */
+static int16_t sweep_frame_quantize(float value) {
+    float scaled = roundf(value * SWEEP_FRAME_SCALE);
+    if (scaled > (float)INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (scaled < (float)(INT16_MIN + 1)) {
+        return INT16_MIN + 1;
+    }
+    return (int16_t)scaled;
+}
+
+void sweep_frame_begin(sweep_frame_t *frame, uint32_t sweep_id, uint32_t timestamp_ms,
+                       float start_hz, float step_hz, uint16_t first_index) {
+    frame->header.sweep_id = sweep_id;
+    frame->header.timestamp_ms = timestamp_ms;
+    frame->header.start_hz = start_hz;
+    frame->header.step_hz = step_hz;
+    frame->header.first_index = first_index;
+    frame->header.count = 0;
+    frame->header.flags = 0;
+}
+
+bool sweep_frame_add(sweep_frame_t *frame, float magnitude_db, float phase_deg) {
+    uint16_t i = frame->header.count;
+    if (i >= SWEEP_FRAME_MAX_POINTS) {
+        return false;
+    }
+
+    if (isfinite(magnitude_db) && isfinite(phase_deg)) {
+        frame->magnitude_cdb[i] = sweep_frame_quantize(magnitude_db);
+        frame->phase_cdeg[i] = sweep_frame_quantize(phase_deg);
+    } else {
+        frame->magnitude_cdb[i] = SWEEP_FRAME_INVALID;
+        frame->phase_cdeg[i] = SWEEP_FRAME_INVALID;
+    }
+    frame->header.count++;
+    return true;
+}
+
+bool sweep_frame_add_at(sweep_frame_t *frame, float frequency_hz,
+                        float magnitude_db, float phase_deg) {
+    uint16_t i = frame->header.count;
+    if (!sweep_frame_add(frame, magnitude_db, phase_deg)) {
+        return false;
+    }
+
+    frame->frequency_hz[i] = frequency_hz;
+    frame->header.flags |= SWEEP_FRAME_FLAG_FREQS;
+    return true;
+}
+
+bool sweep_frame_point_valid(const sweep_frame_t *frame, uint16_t i) {
+    return frame->magnitude_cdb[i] != SWEEP_FRAME_INVALID;
+}
+
+float sweep_frame_magnitude_db(const sweep_frame_t *frame, uint16_t i) {
+    return frame->magnitude_cdb[i] / SWEEP_FRAME_SCALE;
+}
+
+float sweep_frame_phase_deg(const sweep_frame_t *frame, uint16_t i) {
+    return frame->phase_cdeg[i] / SWEEP_FRAME_SCALE;
+}
+
+float sweep_frame_frequency_hz(const sweep_frame_t *frame, uint16_t i) {
+    if (frame->header.flags & SWEEP_FRAME_FLAG_FREQS) {
+        return frame->frequency_hz[i];
+    }
+    return frame->header.start_hz + (float)(frame->header.first_index + i) * frame->header.step_hz;
+}
+
+size_t sweep_frame_encode(const sweep_frame_t *frame, uint8_t *buf, size_t capacity) {
+    uint16_t count = frame->header.count;
+    bool freqs = (frame->header.flags & SWEEP_FRAME_FLAG_FREQS) != 0;
+    size_t size = freqs ? SWEEP_FRAME_SIZE_FREQS((size_t)count) : SWEEP_FRAME_SIZE((size_t)count);
+    if (size > capacity) {
+        return 0;
+    }
+
+    buf[0] = SWEEP_FRAME_MAGIC0;
+    buf[1] = SWEEP_FRAME_MAGIC1;
+    buf[2] = SWEEP_FRAME_VERSION;
+    buf[3] = frame->header.flags;
+    put_u32(&buf[4], frame->header.sweep_id);
+    put_u32(&buf[8], frame->header.timestamp_ms);
+    put_f32(&buf[12], frame->header.start_hz);
+    put_f32(&buf[16], frame->header.step_hz);
+    put_u16(&buf[20], frame->header.first_index);
+    put_u16(&buf[22], count);
+
+    uint8_t *mag = &buf[SWEEP_FRAME_HEADER_SIZE];
+    uint8_t *phase = mag + 2 * (size_t)count;
+    for (uint16_t i = 0; i < count; i++) {
+        put_u16(&mag[2 * i], (uint16_t)frame->magnitude_cdb[i]);
+        put_u16(&phase[2 * i], (uint16_t)frame->phase_cdeg[i]);
+    }
+
+    if (freqs) {
+        uint8_t *freq = phase + 2 * (size_t)count;
+        for (uint16_t i = 0; i < count; i++) {
+            put_f32(&freq[4 * i], frame->frequency_hz[i]);
+        }
+    }
+
+    return size;
+}
+
+bool sweep_frame_decode(const uint8_t *buf, size_t len, sweep_frame_t *frame) {
+    if (len < SWEEP_FRAME_HEADER_SIZE
+        || buf[0] != SWEEP_FRAME_MAGIC0 || buf[1] != SWEEP_FRAME_MAGIC1
+        || buf[2] != SWEEP_FRAME_VERSION) {
+        return false;
+    }
+
+    uint16_t count = get_u16(&buf[22]);
+    bool freqs = (buf[3] & SWEEP_FRAME_FLAG_FREQS) != 0;
+    size_t size = freqs ? SWEEP_FRAME_SIZE_FREQS((size_t)count) : SWEEP_FRAME_SIZE((size_t)count);
+    if (count > SWEEP_FRAME_MAX_POINTS || len != size) {
+        return false;
+    }
+
+    frame->header.flags = buf[3];
+    frame->header.sweep_id = get_u32(&buf[4]);
+    frame->header.timestamp_ms = get_u32(&buf[8]);
+    frame->header.start_hz = get_f32(&buf[12]);
+    frame->header.step_hz = get_f32(&buf[16]);
+    frame->header.first_index = get_u16(&buf[20]);
+    frame->header.count = count;
+
+    const uint8_t *mag = &buf[SWEEP_FRAME_HEADER_SIZE];
+    const uint8_t *phase = mag + 2 * (size_t)count;
+    for (uint16_t i = 0; i < count; i++) {
+        frame->magnitude_cdb[i] = (int16_t)get_u16(&mag[2 * i]);
+        frame->phase_cdeg[i] = (int16_t)get_u16(&phase[2 * i]);
+    }
+
+    if (freqs) {
+        const uint8_t *freq = phase + 2 * (size_t)count;
+        for (uint16_t i = 0; i < count; i++) {
+            frame->frequency_hz[i] = get_f32(&freq[4 * i]);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,238 @@
+/**
+ * @file sweep_plan.c
+ * @brief Implementación del planificador de grilla
+ *
+ * Todo el cálculo ocurre al construir el plan, fuera del barrido: el
+ * barrido solo lee puntos ya resueltos.
+ */
+
+#include "sweep_plan.h"
+#include "adc_dma.h"
+#include "debug.h"
+#include <math.h>
+
+#if SWEEP_AVERAGES < 1 || SWEEP_AVERAGES > ADC_CAPTURE_MAX_SAMPLES
+#error "SWEEP_AVERAGES debe estar entre 1 y ADC_CAPTURE_MAX_SAMPLES"
+#endif
+
+#if SWEEP_PLAN_MIN_CYCLES < 1
+#error "SWEEP_PLAN_MIN_CYCLES debe ser al menos 1"
+#endif
+
+// Diferencia admitida entre una frecuencia del plan y la grilla uniforme
+// para publicar la trama sin lista de frecuencias
+#define SWEEP_PLAN_UNIFORM_TOL_HZ 0.001f
+
+void sweep_plan_default_spec(sweep_plan_spec_t *spec) {
+    spec->grid = SWEEP_GRID;
+    spec->start_hz = SWEEP_FREQ_MIN;
+    spec->stop_hz = SWEEP_FREQ_MAX;
+    spec->list_hz = NULL;
+    spec->averages = SWEEP_AVERAGES;
+    spec->max_window = ADC_CAPTURE_MAX_SAMPLES;
+    spec->freq_tol = SWEEP_PLAN_FREQ_TOL;
+    spec->target_snr_db = SWEEP_PLAN_TARGET_SNR_DB;
+    spec->min_amplitude = SWEEP_PLAN_MIN_AMPLITUDE;
+    spec->noise_rms = SWEEP_PLAN_NOISE_RMS;
+    spec->min_cycles = SWEEP_PLAN_MIN_CYCLES;
+    sweep_average_default_params(&spec->average);
+
+    if (spec->grid == SWEEP_GRID_LOG) {
+        float decades = log10f(SWEEP_FREQ_MAX / SWEEP_FREQ_MIN);
+        long points = lroundf(decades * SWEEP_LOG_POINTS_PER_DECADE) + 1;
+        spec->points = (uint16_t)(points < SWEEP_NUM_POINTS ? points : SWEEP_NUM_POINTS);
+    } else {
+        spec->grid = SWEEP_GRID_LINEAR;
+        spec->points = (uint16_t)lroundf((SWEEP_FREQ_MAX - SWEEP_FREQ_MIN) / FREQ_RESOLUTION) + 1;
+        if (spec->points > SWEEP_NUM_POINTS) {
+            spec->points = SWEEP_NUM_POINTS;
+        }
+    }
+}
+
+/**
+ * @brief Muestras por ventana que pide el objetivo de SNR
+ *
+ * @return 0 si no hay objetivo (o faltan amplitud o ruido)
+ */
+static uint32_t sweep_plan_snr_window(const sweep_plan_spec_t *spec) {
+    if (!(spec->target_snr_db > 0.0f) || !(spec->min_amplitude > 0.0f)
+        || !(spec->noise_rms > 0.0f)) {
+        return 0;
+    }
+
+    float total = 2.0f * spec->noise_rms * spec->noise_rms * powf(10.0f, spec->target_snr_db / 10.0f)
+        / (spec->min_amplitude * spec->min_amplitude);
+    float per_window = ceilf(total / (float)spec->averages);
+    return per_window < (float)UINT16_MAX ? (uint32_t)per_window : UINT16_MAX;
+}
+
+/**
+ * @brief Ciclos coherentes de n muestras y su desvío relativo
+ *
+ * @return false si la ventana no llega a un ciclo
+ */
+static bool sweep_plan_window_error(float freq_hz, uint16_t n, float *cycles, float *err) {
+    *cycles = roundf(freq_hz * (float)n / SAMPLE_RATE);
+    if (*cycles < 1.0f) {
+        return false;
+    }
+    *err = fabsf(*cycles * SAMPLE_RATE / (float)n - freq_hz) / freq_hz;
+    return true;
+}
+
+bool sweep_plan_point_init(sweep_point_t *point, float freq_hz, const sweep_plan_spec_t *spec) {
+    if (spec->averages < 1 || spec->max_window > ADC_CAPTURE_MAX_SAMPLES
+        || !(freq_hz > 0.0f) || freq_hz >= SAMPLE_RATE / 2.0f) {
+        return false;
+    }
+
+    uint16_t longest = spec->max_window / spec->averages;
+    uint16_t best_window = 0;
+    uint16_t best_cycles = 0;
+    float best_err = INFINITY;
+    float cycles, err;
+    uint32_t required = sweep_plan_snr_window(spec);
+
+    if (required == 0) {
+        // Sin objetivo de SNR: ventanas entre la mitad y el total
+        // disponible, de la más larga a la más corta; gana la primera
+        // dentro de tolerancia y si ninguna lo está, la de menor desvío
+        uint16_t shortest = longest / 2 > 0 ? longest / 2 : 1;
+        for (uint16_t n = longest; n >= shortest; n--) {
+            if (!sweep_plan_window_error(freq_hz, n, &cycles, &err)) {
+                continue;
+            }
+            if (err < best_err) {
+                best_err = err;
+                best_window = n;
+                best_cycles = (uint16_t)cycles;
+            }
+            if (err <= spec->freq_tol) {
+                break;
+            }
+        }
+    } else {
+        // Con objetivo: de la ventana mínima (SNR y ciclos) hacia arriba;
+        // gana la primera dentro de tolerancia. Si el mínimo no entra en
+        // la captura se usa la más larga y el punto queda con menos SNR
+        float min_cycles = (float)(spec->min_cycles > 0 ? spec->min_cycles : 1);
+        uint32_t by_cycles = (uint32_t)ceilf(min_cycles * SAMPLE_RATE / freq_hz);
+        if (by_cycles > required) {
+            required = by_cycles;
+        }
+        uint16_t first = required < longest ? (uint16_t)required : longest;
+
+        for (uint16_t n = first; n <= longest && n > 0; n++) {
+            if (!sweep_plan_window_error(freq_hz, n, &cycles, &err)) {
+                continue;
+            }
+            if (err < best_err) {
+                best_err = err;
+                best_window = n;
+                best_cycles = (uint16_t)cycles;
+            }
+            if (err <= spec->freq_tol) {
+                break;
+            }
+        }
+    }
+
+    if (best_window == 0) {
+        return false;
+    }
+
+    point->window = best_window;
+    point->cycles = best_cycles;
+    point->averages = spec->averages;
+    point->freq_hz = (float)best_cycles * SAMPLE_RATE / (float)best_window;
+    point->snr_db = spec->min_amplitude > 0.0f && spec->noise_rms > 0.0f
+        ? 10.0f * log10f(spec->min_amplitude * spec->min_amplitude * (float)best_window
+                         * (float)spec->averages / (2.0f * spec->noise_rms * spec->noise_rms))
+        : INFINITY;
+    point->skew_rad = -2.0f * (float)M_PI * point->freq_hz * ADC_DMA_CHANNEL_SKEW_S;
+    goertzel_coeffs_init(&point->coeffs, point->freq_hz, SAMPLE_RATE);
+    settle_params_init(&point->settle, point->freq_hz, SAMPLE_RATE);
+    return true;
+}
+
+/**
+ * @brief Frecuencia pedida número k del plan
+ */
+static float sweep_plan_requested(const sweep_plan_spec_t *spec, uint16_t k) {
+    if (spec->grid == SWEEP_GRID_LIST) {
+        return spec->list_hz[k];
+    }
+    if (spec->points == 1) {
+        return spec->start_hz;
+    }
+
+    float t = (float)k / (float)(spec->points - 1);
+    if (spec->grid == SWEEP_GRID_LOG) {
+        return spec->start_hz * powf(spec->stop_hz / spec->start_hz, t);
+    }
+    return spec->start_hz + t * (spec->stop_hz - spec->start_hz);
+}
+
+/**
+ * @brief Marca el plan como uniforme si las frecuencias corregidas siguen
+ *        cayendo en pasos iguales
+ */
+static void sweep_plan_check_uniform(sweep_plan_t *plan) {
+    plan->uniform = false;
+    plan->step_hz = 0.0f;
+
+    if (plan->grid != SWEEP_GRID_LINEAR) {
+        return;
+    }
+
+    float start = plan->points[0].freq_hz;
+    float step = plan->count > 1
+        ? (plan->points[plan->count - 1].freq_hz - start) / (float)(plan->count - 1)
+        : 0.0f;
+
+    for (uint16_t k = 0; k < plan->count; k++) {
+        if (fabsf(plan->points[k].freq_hz - (start + (float)k * step)) > SWEEP_PLAN_UNIFORM_TOL_HZ) {
+            return;
+        }
+    }
+
+    plan->uniform = true;
+    plan->step_hz = step;
+}
+
+bool sweep_plan_build(sweep_plan_t *plan, const sweep_plan_spec_t *spec) {
+    plan->count = 0;
+    plan->grid = spec->grid;
+
+    if (spec->points == 0 || spec->points > SWEEP_NUM_POINTS || spec->average.max_windows == 0
+        || (spec->grid == SWEEP_GRID_LIST && spec->list_hz == NULL)
+        || (spec->grid == SWEEP_GRID_LOG && !(spec->start_hz > 0.0f && spec->stop_hz > 0.0f))) {
+        DEBUG_PRINT(0, "[PLAN] ERROR: Pedido de grilla inválido\n");
+        return false;
+    }
+
+    for (uint16_t k = 0; k < spec->points; k++) {
+        float requested = sweep_plan_requested(spec, k);
+        sweep_point_t *point = &plan->points[plan->count];
+
+        if (!sweep_plan_point_init(point, requested, spec)) {
+            DEBUG_PRINT(0, "[PLAN] ERROR: %.2f Hz no es medible con %d muestras\n",
+                        requested, spec->max_window);
+            plan->count = 0;
+            return false;
+        }
+
+        if (plan->count > 0 && point->freq_hz == plan->points[plan->count - 1].freq_hz) {
+            continue;
+        }
+        plan->count++;
+    }
+
+    sweep_plan_check_uniform(plan);
+
+    DEBUG_PRINT(2, "[PLAN] %d puntos (%s), %.2f-%.2f Hz\n", plan->count,
+                plan->uniform ? "uniforme" : "con lista de frecuencias",
+                plan->points[0].freq_hz, plan->points[plan->count - 1].freq_hz);
+    return true;
+}
@@ -0,0 +1,532 @@
+/**
+ * @file sweep_store.c
+ * @brief Implementación del almacén de barridos en flash
+ *
+ * El estado del log vive en sectors[]: se reconstruye en sweep_store_init()
+ * leyendo la región y después se mantiene en RAM. Los registros se recorren
+ * leyendo solo sus encabezados; el CRC se verifica al arrancar y al leer un
+ * payload para reenviarlo.
+ */
+
+#include "sweep_store.h"
+#include "debug.h"
+#include "hal.h"
+#include <string.h>
+
+#define STORE_SECTOR_MAGIC 0x53535246u  // "FRSS" en little-endian
+#define STORE_RECORD_MAGIC 0x5253u      // "SR" en little-endian
+
+// Encabezados de sector y de registro (16 bytes cada uno)
+#define STORE_HEADER_SIZE 16
+#define STORE_SECTOR_CRC_OFFSET 12
+#define STORE_RECORD_CRC_OFFSET 8
+#define STORE_ACKED_OFFSET 12           // Byte "entregado" del registro
+
+#define STORE_ALIGN(n) (((n) + 3u) & ~3u)
+#define STORE_RECORD_MAX STORE_ALIGN(STORE_HEADER_SIZE + SWEEP_STORE_PAYLOAD_MAX)
+
+#if SWEEP_STORE_SECTORS < 2
+#error "SWEEP_STORE_SECTORS debe ser al menos 2"
+#endif
+
+#if STORE_HEADER_SIZE + STORE_RECORD_MAX > HAL_FLASH_SECTOR_SIZE
+#error "Un barrido completo no entra en un sector del almacén"
+#endif
+
+typedef enum {
+    SECTOR_BLANK = 0,   // Todo en 0xFF, listo para el encabezado
+    SECTOR_DIRTY,       // Sin encabezado válido ni borrado: hay que borrarlo
+    SECTOR_LOG          // Parte del log
+} sector_state_t;
+
+typedef struct {
+    sector_state_t state;
+    uint32_t seq;           // Orden del sector en el log (solo SECTOR_LOG)
+    uint32_t erase_count;   // Borrados (estimado si el encabezado se perdió)
+    uint16_t records_end;   // Fin del último registro válido
+    uint16_t pending;       // Registros sin confirmar
+    bool closed;            // No admite más registros
+} sector_info_t;
+
+// Encabezado de registro ya decodificado
+typedef struct {
+    uint32_t offset;        // Offset del registro dentro de la región
+    uint16_t len;           // Bytes de payload
+    uint32_t number;
+    uint32_t crc;
+    bool acked;
+} store_record_t;
+
+typedef enum {
+    RECORD_END = 0,         // Espacio borrado: no hay más registros
+    RECORD_OK,
+    RECORD_TORN             // Encabezado inconsistente o CRC inválido
+} record_status_t;
+
+static sector_info_t sectors[SWEEP_STORE_SECTORS];
+static int16_t head_sector = -1;
+static uint32_t next_record = 1;
+static uint32_t next_sector_seq = 1;
+static bool store_ready = false;
+static sweep_store_stats_t store_stats;
+
+// Registro en armado y página de programación
+static uint8_t record_buf[STORE_RECORD_MAX];
+static uint8_t page_buf[HAL_FLASH_PAGE_SIZE];
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+/**
+ * @brief CRC-32 (IEEE 802.3) con tabla de 16 entradas
+ */
+static uint32_t store_crc32(uint32_t crc, const uint8_t *data, uint32_t len) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static uint32_t store_sector_base(uint16_t sector) {
+    return (uint32_t)sector * HAL_FLASH_SECTOR_SIZE;
+}
+
+static bool store_is_erased(const uint8_t *data, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        if (data[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Programa len bytes en un offset cualquiera, página por página
+ *
+ * Fuera de los bytes nuevos la página va en 0xFF, que no altera lo ya
+ * programado.
+ */
+static bool store_program(uint32_t offset, const uint8_t *data, uint32_t len) {
+    while (len > 0) {
+        uint32_t page = offset & ~(HAL_FLASH_PAGE_SIZE - 1u);
+        uint32_t start = offset - page;
+        uint32_t chunk = HAL_FLASH_PAGE_SIZE - start;
+        if (chunk > len) {
+            chunk = len;
+        }
+
+        memset(page_buf, 0xFF, sizeof(page_buf));
+        memcpy(&page_buf[start], data, chunk);
+        if (!hal_flash_program(page, page_buf, HAL_FLASH_PAGE_SIZE)) {
+            store_stats.write_errors++;
+            return false;
+        }
+
+        offset += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+    return true;
+}
+
+/**
+ * @brief Decodifica el encabezado del registro en offset del sector
+ */
+static record_status_t store_read_header(uint16_t sector, uint32_t offset, store_record_t *rec) {
+    uint8_t hdr[STORE_HEADER_SIZE];
+
+    if (offset + STORE_HEADER_SIZE > HAL_FLASH_SECTOR_SIZE) {
+        return RECORD_END;
+    }
+    if (!hal_flash_read(store_sector_base(sector) + offset, hdr, sizeof(hdr))) {
+        return RECORD_TORN;
+    }
+    if (store_is_erased(hdr, sizeof(hdr))) {
+        return RECORD_END;
+    }
+
+    rec->offset = store_sector_base(sector) + offset;
+    rec->len = get_u16(&hdr[2]);
+    rec->number = get_u32(&hdr[4]);
+    rec->crc = get_u32(&hdr[STORE_RECORD_CRC_OFFSET]);
+    rec->acked = hdr[STORE_ACKED_OFFSET] != 0xFF;
+
+    if (get_u16(&hdr[0]) != STORE_RECORD_MAGIC || rec->len == 0
+        || rec->len > SWEEP_STORE_PAYLOAD_MAX
+        || offset + STORE_ALIGN(STORE_HEADER_SIZE + rec->len) > HAL_FLASH_SECTOR_SIZE) {
+        return RECORD_TORN;
+    }
+    return RECORD_OK;
+}
+
+/**
+ * @brief Lee el payload del registro y verifica su CRC
+ */
+static bool store_read_payload(const store_record_t *rec, uint8_t *payload) {
+    uint8_t hdr[STORE_RECORD_CRC_OFFSET];
+
+    if (!hal_flash_read(rec->offset, hdr, sizeof(hdr))
+        || !hal_flash_read(rec->offset + STORE_HEADER_SIZE, payload, rec->len)) {
+        return false;
+    }
+    uint32_t crc = store_crc32(0, hdr, sizeof(hdr));
+    return store_crc32(crc, payload, rec->len) == rec->crc;
+}
+
+static uint16_t store_record_size(const store_record_t *rec) {
+    return (uint16_t)STORE_ALIGN(STORE_HEADER_SIZE + rec->len);
+}
+
+/**
+ * @brief Lee el encabezado de un sector; false si no es un sector del log
+ */
+static bool store_read_sector_header(uint16_t sector, uint32_t *erase_count, uint32_t *seq) {
+    uint8_t hdr[STORE_HEADER_SIZE];
+
+    if (!hal_flash_read(store_sector_base(sector), hdr, sizeof(hdr))) {
+        return false;
+    }
+    if (get_u32(&hdr[0]) != STORE_SECTOR_MAGIC
+        || store_crc32(0, hdr, STORE_SECTOR_CRC_OFFSET) != get_u32(&hdr[STORE_SECTOR_CRC_OFFSET])) {
+        return false;
+    }
+    *erase_count = get_u32(&hdr[4]);
+    *seq = get_u32(&hdr[8]);
+    return true;
+}
+
+/**
+ * @brief Sectores del log ordenados del más antiguo al más nuevo
+ *
+ * @return Cantidad de sectores en order
+ */
+static uint16_t store_log_order(uint16_t order[SWEEP_STORE_SECTORS]) {
+    uint16_t count = 0;
+
+    for (uint16_t s = 0; s < SWEEP_STORE_SECTORS; s++) {
+        if (sectors[s].state != SECTOR_LOG) {
+            continue;
+        }
+        uint16_t i = count++;
+        while (i > 0 && sectors[order[i - 1]].seq > sectors[s].seq) {
+            order[i] = order[i - 1];
+            i--;
+        }
+        order[i] = s;
+    }
+    return count;
+}
+
+/**
+ * @brief Recorre los registros de un sector del log al arrancar
+ */
+static void store_scan_sector(uint16_t sector) {
+    sector_info_t *info = &sectors[sector];
+    uint32_t offset = STORE_HEADER_SIZE;
+
+    while (true) {
+        store_record_t rec;
+        record_status_t status = store_read_header(sector, offset, &rec);
+        if (status == RECORD_OK && !store_read_payload(&rec, record_buf)) {
+            status = RECORD_TORN;
+        }
+        if (status == RECORD_END) {
+            break;
+        }
+        if (status == RECORD_TORN) {
+            // Escritura cortada: el resto del sector no se usa más
+            store_stats.torn++;
+            info->closed = true;
+            break;
+        }
+
+        if (!rec.acked) {
+            info->pending++;
+        }
+        if (rec.number >= next_record) {
+            next_record = rec.number + 1;
+        }
+        offset += store_record_size(&rec);
+    }
+    info->records_end = (uint16_t)offset;
+}
+
+bool sweep_store_init(void) {
+    uint32_t max_erase = 0;
+
+    store_ready = false;
+    head_sector = -1;
+    next_record = 1;
+    next_sector_seq = 1;
+    store_stats = (sweep_store_stats_t){0};
+
+    for (uint16_t s = 0; s < SWEEP_STORE_SECTORS; s++) {
+        sector_info_t *info = &sectors[s];
+        *info = (sector_info_t){0};
+
+        if (store_read_sector_header(s, &info->erase_count, &info->seq)) {
+            info->state = SECTOR_LOG;
+            store_scan_sector(s);
+            store_stats.pending += info->pending;
+            if (info->erase_count > max_erase) {
+                max_erase = info->erase_count;
+            }
+            if (info->seq >= next_sector_seq) {
+                next_sector_seq = info->seq + 1;
+                head_sector = (int16_t)s;
+            }
+            continue;
+        }
+
+        // Sin encabezado: borrado de fábrica, o corte durante un borrado o
+        // durante la escritura del encabezado
+        info->state = SECTOR_BLANK;
+        for (uint32_t off = 0; off < HAL_FLASH_SECTOR_SIZE; off += HAL_FLASH_PAGE_SIZE) {
+            if (!hal_flash_read(store_sector_base(s) + off, page_buf, HAL_FLASH_PAGE_SIZE)) {
+                return false;
+            }
+            if (!store_is_erased(page_buf, HAL_FLASH_PAGE_SIZE)) {
+                info->state = SECTOR_DIRTY;
+                break;
+            }
+        }
+    }
+
+    // Solo el sector más nuevo admite registros; los sin encabezado heredan
+    // el máximo de borrados conocido para no favorecerlos
+    for (uint16_t s = 0; s < SWEEP_STORE_SECTORS; s++) {
+        if (sectors[s].state == SECTOR_LOG) {
+            sectors[s].closed |= ((int16_t)s != head_sector);
+        } else {
+            sectors[s].erase_count = max_erase;
+        }
+    }
+
+    store_ready = true;
+    DEBUG_PRINT(2, "[STORE] %lu barridos pendientes en flash (%lu registros descartados)\n",
+                (unsigned long)store_stats.pending, (unsigned long)store_stats.torn);
+    return true;
+}
+
+/**
+ * @brief Elige, borra y encabeza el próximo sector del log
+ *
+ * Prefiere el sector reutilizable con menos borrados; sin ninguno, pisa el
+ * más antiguo del log.
+ */
+static bool store_open_sector(void) {
+    int16_t best = -1;
+    uint16_t start = head_sector < 0 ? SWEEP_STORE_SECTORS - 1 : (uint16_t)head_sector;
+
+    for (uint16_t i = 1; i <= SWEEP_STORE_SECTORS; i++) {
+        uint16_t s = (uint16_t)((start + i) % SWEEP_STORE_SECTORS);
+        if ((int16_t)s == head_sector) {
+            continue;
+        }
+        bool reusable = sectors[s].state != SECTOR_LOG || sectors[s].pending == 0;
+        if (reusable && (best < 0 || sectors[s].erase_count < sectors[best].erase_count)) {
+            best = (int16_t)s;
+        }
+    }
+
+    if (best < 0) {
+        uint16_t order[SWEEP_STORE_SECTORS];
+        store_log_order(order);
+        best = (int16_t)order[0];
+        store_stats.overwritten += sectors[best].pending;
+        store_stats.pending -= sectors[best].pending;
+        DEBUG_PRINT(1, "[STORE] WARNING: Almacén lleno, se pierden %u barridos\n",
+                    sectors[best].pending);
+    }
+
+    sector_info_t *info = &sectors[best];
+    uint32_t base = store_sector_base((uint16_t)best);
+
+    if (info->state != SECTOR_BLANK) {
+        info->state = SECTOR_DIRTY;
+        info->pending = 0;
+        if (!hal_flash_erase(base)) {
+            store_stats.write_errors++;
+            return false;
+        }
+        info->erase_count++;
+        store_stats.erases++;
+    }
+
+    uint8_t hdr[STORE_HEADER_SIZE];
+    memset(hdr, 0xFF, sizeof(hdr));
+    put_u32(&hdr[0], STORE_SECTOR_MAGIC);
+    put_u32(&hdr[4], info->erase_count);
+    put_u32(&hdr[8], next_sector_seq);
+    put_u32(&hdr[STORE_SECTOR_CRC_OFFSET], store_crc32(0, hdr, STORE_SECTOR_CRC_OFFSET));
+    if (!store_program(base, hdr, sizeof(hdr))) {
+        info->state = SECTOR_DIRTY;
+        return false;
+    }
+
+    info->state = SECTOR_LOG;
+    info->seq = next_sector_seq++;
+    info->records_end = STORE_HEADER_SIZE;
+    info->pending = 0;
+    info->closed = false;
+
+    if (head_sector >= 0) {
+        sectors[head_sector].closed = true;
+    }
+    head_sector = best;
+    return true;
+}
+
+bool sweep_store_append(const sweep_frame_t *sweep) {
+    if (!store_ready) {
+        return false;
+    }
+
+    uint8_t *payload = &record_buf[STORE_HEADER_SIZE];
+    size_t len = sweep_frame_encode(sweep, payload, SWEEP_STORE_PAYLOAD_MAX);
+    if (len == 0) {
+        return false;
+    }
+    // Flags del encabezado de la trama (byte 3): el reenvío va marcado
+    payload[3] |= SWEEP_FRAME_FLAG_REPLAY | SWEEP_FRAME_FLAG_LAST;
+
+    uint16_t size = (uint16_t)STORE_ALIGN(STORE_HEADER_SIZE + len);
+    if (head_sector < 0 || sectors[head_sector].closed
+        || sectors[head_sector].records_end + size > HAL_FLASH_SECTOR_SIZE) {
+        if (!store_open_sector()) {
+            return false;
+        }
+    }
+
+    put_u16(&record_buf[0], STORE_RECORD_MAGIC);
+    put_u16(&record_buf[2], (uint16_t)len);
+    put_u32(&record_buf[4], next_record);
+    uint32_t crc = store_crc32(0, record_buf, STORE_RECORD_CRC_OFFSET);
+    put_u32(&record_buf[STORE_RECORD_CRC_OFFSET], store_crc32(crc, payload, (uint32_t)len));
+    memset(&record_buf[STORE_ACKED_OFFSET], 0xFF, STORE_HEADER_SIZE - STORE_ACKED_OFFSET);
+    memset(&payload[len], 0xFF, size - STORE_HEADER_SIZE - len);
+    next_record++;
+
+    sector_info_t *info = &sectors[head_sector];
+    if (!store_program(store_sector_base((uint16_t)head_sector) + info->records_end,
+                       record_buf, size)) {
+        // Lo escrito a medias queda fuera de records_end y del log
+        info->closed = true;
+        return false;
+    }
+
+    info->records_end += size;
+    info->pending++;
+    store_stats.pending++;
+    store_stats.appended++;
+    return true;
+}
+
+/**
+ * @brief Busca el registro pendiente más antiguo, o el de número number
+ *
+ * @param number Número buscado, 0 = el pendiente más antiguo
+ * @param sector Sector donde está el registro
+ */
+static bool store_find(uint32_t number, store_record_t *rec, uint16_t *sector) {
+    uint16_t order[SWEEP_STORE_SECTORS];
+    uint16_t count = store_log_order(order);
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t s = order[i];
+        if (number == 0 && sectors[s].pending == 0) {
+            continue;
+        }
+        uint32_t offset = STORE_HEADER_SIZE;
+        while (offset < sectors[s].records_end
+               && store_read_header(s, offset, rec) == RECORD_OK) {
+            if (number == 0 ? !rec->acked : rec->number == number) {
+                *sector = s;
+                return true;
+            }
+            offset += store_record_size(rec);
+        }
+    }
+    return false;
+}
+
+uint16_t sweep_store_read_oldest(uint8_t *payload, uint16_t capacity, uint32_t *record) {
+    store_record_t rec;
+    uint16_t sector;
+
+    if (!store_ready || !store_find(0, &rec, &sector)) {
+        return 0;
+    }
+    if (rec.len > capacity) {
+        // No entra en el buffer y nunca va a entrar: descartarlo en lugar de
+        // devolverlo como el más antiguo en cada llamada
+        DEBUG_PRINT(0, "[STORE] ERROR: Registro %lu de %u bytes no entra en %u\n",
+                    (unsigned long)rec.number, rec.len, capacity);
+        sweep_store_ack(rec.number);
+        return 0;
+    }
+    if (!store_read_payload(&rec, payload)) {
+        // Corrupto después de escrito: darlo por perdido para no trabar el reenvío
+        DEBUG_PRINT(0, "[STORE] ERROR: Registro %lu corrupto\n", (unsigned long)rec.number);
+        sweep_store_ack(rec.number);
+        return 0;
+    }
+
+    *record = rec.number;
+    return rec.len;
+}
+
+bool sweep_store_ack(uint32_t record) {
+    store_record_t rec;
+    uint16_t sector;
+
+    if (!store_ready || record == 0 || !store_find(record, &rec, &sector)) {
+        return false;
+    }
+    if (rec.acked) {
+        return true;
+    }
+
+    uint8_t acked = 0x00;
+    if (!store_program(rec.offset + STORE_ACKED_OFFSET, &acked, 1)) {
+        return false;
+    }
+
+    sectors[sector].pending--;
+    store_stats.pending--;
+    store_stats.acked++;
+    return true;
+}
+
+uint32_t sweep_store_pending(void) {
+    return store_stats.pending;
+}
+
+void sweep_store_get_stats(sweep_store_stats_t *stats) {
+    *stats = store_stats;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file trace.c
+ * @brief Implementación de la traza de etapas
+ */
+
+#include "trace.h"
+#include "config.h"
+#include "hal.h"
+#include "json_writer.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if TRACE_RING_EVENTS < 2 || (TRACE_RING_EVENTS & (TRACE_RING_EVENTS - 1)) != 0
+#error "TRACE_RING_EVENTS debe ser potencia de 2"
+#endif
+
+// Evento del anillo: etapa y duración en cuentas del contador
+typedef struct {
+    uint32_t ticks;
+    uint8_t stage;
+} trace_event_t;
+
+static const char *const trace_names[TRACE_STAGE_COUNT] = {
+    [TRACE_DDS_WRITE] = "dds_write",
+    [TRACE_SETTLE] = "settle",
+    [TRACE_ADC_CAPTURE] = "adc_capture",
+    [TRACE_VALIDATE] = "validate",
+    [TRACE_GOERTZEL] = "goertzel",
+    [TRACE_PUBLISH] = "publish",
+    [TRACE_SWEEP] = "sweep",
+};
+
+#ifdef DEBUG_GPIO_ENABLED
+// Pin de cada etapa (0 = sin pin)
+static const uint8_t trace_pins[TRACE_STAGE_COUNT] = {
+    [TRACE_ADC_CAPTURE] = DEBUG_PIN_ADC_ACQUIRE,
+    [TRACE_GOERTZEL] = DEBUG_PIN_DSP_PROCESS,
+    [TRACE_PUBLISH] = DEBUG_PIN_MQTT_TX,
+    [TRACE_SWEEP] = DEBUG_PIN_SWEEP_START,
+};
+#endif
+
+#if TRACE_ENABLED
+static trace_event_t trace_ring[TRACE_RING_EVENTS];
+static _Atomic uint32_t trace_head = 0;
+
+// Duraciones de una etapa al armar el reporte
+static uint32_t trace_scratch[TRACE_RING_EVENTS];
+#endif
+
+static void trace_pin(trace_stage_t stage, bool value) {
+#ifdef DEBUG_GPIO_ENABLED
+    if (trace_pins[stage] != 0) {
+        hal_debug_pin_put(trace_pins[stage], value);
+    }
+#else
+    (void)stage;
+    (void)value;
+#endif
+}
+
+void trace_init(void) {
+#if TRACE_ENABLED
+    hal_cycle_counter_init();
+#endif
+    trace_reset();
+}
+
+void trace_reset(void) {
+#if TRACE_ENABLED
+    atomic_store_explicit(&trace_head, 0, memory_order_relaxed);
+#endif
+}
+
+uint32_t trace_begin(trace_stage_t stage) {
+    trace_pin(stage, true);
+#if TRACE_ENABLED
+    return hal_cycle_counter();
+#else
+    return 0;
+#endif
+}
+
+uint32_t trace_lap(trace_stage_t stage, uint32_t t0) {
+    trace_pin(stage, false);
+#if TRACE_ENABLED
+    return hal_cycle_counter() - t0;
+#else
+    (void)t0;
+    return 0;
+#endif
+}
+
+uint32_t trace_end(trace_stage_t stage, uint32_t t0) {
+    uint32_t ticks = trace_lap(stage, t0);
+    trace_record(stage, ticks);
+    return ticks;
+}
+
+void trace_record(trace_stage_t stage, uint32_t ticks) {
+#if TRACE_ENABLED
+    uint32_t head = atomic_fetch_add_explicit(&trace_head, 1, memory_order_relaxed);
+    trace_event_t *event = &trace_ring[head & (TRACE_RING_EVENTS - 1)];
+    event->ticks = ticks;
+    event->stage = (uint8_t)stage;
+#else
+    (void)stage;
+    (void)ticks;
+#endif
+}
+
+const char *trace_stage_name(trace_stage_t stage) {
+    return stage < TRACE_STAGE_COUNT ? trace_names[stage] : "?";
+}
+
+#if TRACE_ENABLED
+static int trace_compare(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Valor en el percentil pct de n duraciones ordenadas (rango más
+ *        cercano)
+ */
+static uint32_t trace_percentile(const uint32_t *sorted, uint32_t n, uint32_t pct) {
+    uint32_t rank = (pct * n + 99u) / 100u;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+#endif
+
+void trace_report(trace_report_t *report) {
+    for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+        report->stages[s] = (trace_stage_stats_t){0};
+    }
+    report->events = 0;
+    report->overwritten = 0;
+
+#if TRACE_ENABLED
+    uint32_t head = atomic_load_explicit(&trace_head, memory_order_acquire);
+    uint32_t count = head < TRACE_RING_EVENTS ? head : TRACE_RING_EVENTS;
+    float us_per_tick = 1.0f / (float)hal_cycle_counter_per_us();
+
+    report->events = count;
+    report->overwritten = head - count;
+
+    for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            if (trace_ring[i].stage == s) {
+                trace_scratch[n++] = trace_ring[i].ticks;
+            }
+        }
+        if (n == 0) {
+            continue;
+        }
+
+        qsort(trace_scratch, n, sizeof(trace_scratch[0]), trace_compare);
+        trace_stage_stats_t *stats = &report->stages[s];
+        stats->count = n;
+        stats->p50_us = (float)trace_percentile(trace_scratch, n, 50) * us_per_tick;
+        stats->p95_us = (float)trace_percentile(trace_scratch, n, 95) * us_per_tick;
+        stats->max_us = (float)trace_scratch[n - 1] * us_per_tick;
+    }
+#endif
+}
+
+void trace_print(const trace_report_t *report) {
+    printf("Traza: %lu eventos (%lu sobrescritos), tiempos en us\n",
+           (unsigned long)report->events, (unsigned long)report->overwritten);
+    printf("  %-12s %8s %12s %12s %12s\n", "etapa", "n", "p50", "p95", "máx");
+    for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+        const trace_stage_stats_t *stats = &report->stages[s];
+        if (stats->count == 0) {
+            continue;
+        }
+        printf("  %-12s %8lu %12.1f %12.1f %12.1f\n", trace_names[s], (unsigned long)stats->count,
+               stats->p50_us, stats->p95_us, stats->max_us);
+    }
+}
+
+size_t trace_format_json(const trace_report_t *report, char *buf, size_t capacity) {
+    json_writer_t w;
+    json_writer_init(&w, buf, capacity);
+    json_writer_begin_object(&w);
+    json_writer_key(&w, "events");
+    json_writer_uint(&w, report->events);
+    json_writer_key(&w, "overwritten");
+    json_writer_uint(&w, report->overwritten);
+    json_writer_key(&w, "stages");
+    json_writer_begin_array(&w);
+    for (int s = 0; s < TRACE_STAGE_COUNT; s++) {
+        const trace_stage_stats_t *stats = &report->stages[s];
+        if (stats->count == 0) {
+            continue;
+        }
+        json_writer_begin_object(&w);
+        json_writer_key(&w, "stage");
+        json_writer_string(&w, trace_names[s]);
+        json_writer_key(&w, "n");
+        json_writer_uint(&w, stats->count);
+        json_writer_key(&w, "p50");
+        json_writer_fixed(&w, stats->p50_us, 1);
+        json_writer_key(&w, "p95");
+        json_writer_fixed(&w, stats->p95_us, 1);
+        json_writer_key(&w, "max");
+        json_writer_fixed(&w, stats->max_us, 1);
+        json_writer_end_object(&w);
+    }
+    json_writer_end_array(&w);
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
+}